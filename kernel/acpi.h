@@ -0,0 +1,83 @@
+/*
+ * =============================================================================
+ * CLKernel - Interrupt Topology Discovery Header
+ * =============================================================================
+ * File: acpi.h
+ * Purpose: Find the local APICs, I/O APICs and ISA IRQ overrides in the
+ *          ACPI MADT, falling back to the Intel MP configuration table
+ *
+ * Both sources are reduced to one apic_platform_t. Only what interrupt
+ * routing needs is kept: no AML, no power management.
+ * =============================================================================
+ */
+
+#ifndef ACPI_H
+#define ACPI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// Discovery Configuration Constants
+// =============================================================================
+
+#define APIC_PLATFORM_MAX_CPUS      32      // Local APIC IDs recorded
+#define APIC_PLATFORM_MAX_IOAPICS   4
+#define APIC_PLATFORM_ISA_IRQS      16
+
+// Where the tables came from
+#define APIC_SOURCE_NONE            0
+#define APIC_SOURCE_ACPI            1       // ACPI MADT ("APIC")
+#define APIC_SOURCE_MP              2       // Intel MP configuration table
+
+// Interrupt polarity/trigger flags (MPS INTI flags, also used by the MADT)
+#define APIC_IRQ_POLARITY_MASK      0x03
+#define APIC_IRQ_POLARITY_HIGH      0x01
+#define APIC_IRQ_POLARITY_LOW       0x03
+#define APIC_IRQ_TRIGGER_MASK       0x0C
+#define APIC_IRQ_TRIGGER_EDGE       0x04
+#define APIC_IRQ_TRIGGER_LEVEL      0x0C
+
+// =============================================================================
+// Discovery Data Structures
+// =============================================================================
+
+typedef struct apic_platform_ioapic {
+    uint8_t         id;                 // I/O APIC ID
+    uint32_t        address;            // Physical MMIO base
+    uint32_t        gsi_base;           // First global system interrupt
+} apic_platform_ioapic_t;
+
+/*
+ * How ISA IRQ n reaches an I/O APIC (identity, edge, active high unless
+ * the firmware says otherwise)
+ */
+typedef struct apic_platform_irq {
+    uint32_t        gsi;                // Global system interrupt
+    uint16_t        flags;              // APIC_IRQ_* (0 = bus default)
+} apic_platform_irq_t;
+
+typedef struct apic_platform {
+    uint8_t         source;             // APIC_SOURCE_*
+    uint32_t        lapic_address;      // Physical local APIC base
+    bool            has_8259;           // Legacy PICs present (must be masked)
+    bool            has_imcr;           // MP: IMCR selects PIC or APIC mode
+
+    uint32_t        cpu_count;          // Enabled processors
+    uint8_t         cpu_apic_ids[APIC_PLATFORM_MAX_CPUS];
+
+    uint32_t        ioapic_count;
+    apic_platform_ioapic_t ioapics[APIC_PLATFORM_MAX_IOAPICS];
+
+    apic_platform_irq_t isa_irqs[APIC_PLATFORM_ISA_IRQS];
+} apic_platform_t;
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Fill platform from the MADT, else the MP table; false if neither exists
+bool acpi_discover_apics(apic_platform_t* platform);
+const char* acpi_source_name(uint8_t source);
+
+#endif // ACPI_H
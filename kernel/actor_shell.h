@@ -173,7 +173,9 @@ int shell_cmd_status(int argc, char* argv[]);
 int shell_cmd_uptime(int argc, char* argv[]);
 int shell_cmd_memory(int argc, char* argv[]);
 int shell_cmd_actors(int argc, char* argv[]);
+int shell_cmd_throttle(int argc, char* argv[]);
 int shell_cmd_scheduler(int argc, char* argv[]);
+int shell_cmd_schedtrace(int argc, char* argv[]);
 
 // Module command handlers
 int shell_cmd_modules(int argc, char* argv[]);
@@ -187,6 +189,7 @@ int shell_cmd_diag(int argc, char* argv[]);
 int shell_cmd_test(int argc, char* argv[]);
 int shell_cmd_benchmark(int argc, char* argv[]);
 int shell_cmd_logs(int argc, char* argv[]);
+int shell_cmd_profile(int argc, char* argv[]);
 
 // AI supervisor command handlers
 int shell_cmd_ai(int argc, char* argv[]);
@@ -25,11 +25,33 @@
 // =============================================================================
 
 #define MAX_BEHAVIOR_PATTERNS   1024    // Maximum behavior patterns to track
+#define AI_PATTERN_HASH_SIZE    2048    // Pattern hash buckets (power of 2, >= 2x patterns)
+#define AI_PATTERN_NONE         0xFFFF  // Empty bucket / end of list
+#define AI_PATTERN_STALE_PASSES 60      // Analysis passes before a pattern is stale
+#define AI_POOL_CHUNK_SIZE      0x10000 // Pattern records are kmalloc'd 64KB at a time
+#define AI_POOL_MAX_CHUNKS      16      // Enough for MAX_BEHAVIOR_PATTERNS records
 #define MAX_ANOMALY_TYPES       32      // Maximum anomaly types
 #define AI_ANALYSIS_WINDOW      60      // Analysis window in seconds
 #define BEHAVIOR_SCORE_MAX      100     // Maximum behavior score
 #define ANOMALY_THRESHOLD       75      // Anomaly detection threshold
 #define INTERVENTION_THRESHOLD  90      // Automatic intervention threshold
+#define AI_EWMA_SHIFT           3       // EWMA smoothing factor (alpha = 1/8)
+#define AI_RECENT_WINDOW        10      // Samples in the short recent window
+
+// Change-point detection (EWMA baseline + two-sided CUSUM, Q8 sigma units)
+#define AI_CHANGE_EWMA_SHIFT    6       // Baseline smoothing (alpha = 1/64)
+#define AI_CHANGE_WARMUP        8       // Samples before the detector arms
+#define AI_CHANGE_SLACK         128     // CUSUM reference k = 0.5 sigma
+#define AI_CHANGE_MAX_Z         (8 << 8) // Clamp per-sample evidence at 8 sigma
+#define AI_CHANGE_DEFAULT_ARL   500     // Samples between false alarms
+#define AI_CHANGE_NONE          0       // No change point pending
+#define AI_CHANGE_UP            1       // Level shifted up
+#define AI_CHANGE_DOWN          2       // Level shifted down
+
+// Trend classification
+#define AI_TREND_STABLE         0       // No significant slope
+#define AI_TREND_INCREASING     1       // Fitted slope rising
+#define AI_TREND_DECREASING     2       // Fitted slope falling
 
 // AI Analysis Types
 #define AI_ANALYSIS_MEMORY      0x01    // Memory usage analysis
@@ -49,6 +71,31 @@
 #define ANOMALY_CORRUPTION      6       // Memory/data corruption
 #define ANOMALY_NETWORK_FLOOD   7       // Network flooding
 
+// Incremental analysis (AI supervisor actor)
+#define AI_SLICE_BUDGET_CYCLES  200000  // Default TSC cycle budget per slice
+#define AI_PHASE_IDLE           0       // No pass in progress
+#define AI_PHASE_ACTORS         1       // Updating actor patterns
+#define AI_PHASE_SYSTEM         2       // Memory / module checks, eviction
+#define AI_PHASE_DETECT         3       // Per-pattern anomaly detection
+#define AI_PHASE_RESPOND        4       // Handling detected anomalies
+
+// AI Model Types and Classes
+#define AI_MODEL_LINEAR         0       // Single linear layer
+#define AI_MODEL_MLP            1       // One hidden ReLU layer
+#define AI_MODEL_MAX_FEATURES   4       // memory, cpu, io, messages
+#define AI_MODEL_MAX_WEIGHTS    256     // int8 weights across both layers
+#define AI_MODEL_MAX_BIAS       32      // Q16.16 biases across both layers
+#define AI_MODEL_BLOB_MAGIC     0x444D4941  // "AIMD"
+#define AI_MODEL_BLOB_VERSION   1
+
+#define AI_CLASS_NORMAL         0       // Pattern looks normal
+#define AI_CLASS_SUSPICIOUS     1       // Pattern deviates from baseline
+#define AI_CLASS_ANOMALOUS      2       // Pattern is anomalous
+
+// Q16.16 fixed point
+#define AI_FIXED_SHIFT          16
+#define AI_FIXED_ONE            (1 << AI_FIXED_SHIFT)
+
 // AI Actions
 #define AI_ACTION_LOG           0x01    // Log the anomaly
 #define AI_ACTION_WARN          0x02    // Issue warning
@@ -62,6 +109,47 @@
 // AI Data Structures
 // =============================================================================
 
+/*
+ * Streaming change-point detector for one metric. The baseline mean and
+ * variance are EWMAs; each sample's deviation in baseline sigmas feeds
+ * an upper and a lower CUSUM, and an alarm latches when either exceeds
+ * the supervisor's change_threshold.
+ */
+typedef struct ai_change_detector {
+    int64_t         mean;               // Baseline mean (Q8)
+    uint64_t        variance;           // Baseline variance
+    uint32_t        sigma;              // Baseline deviation (floored)
+    uint32_t        cusum_high;         // Upper CUSUM (Q8 sigmas)
+    uint32_t        cusum_low;          // Lower CUSUM (Q8 sigmas)
+    uint32_t        samples;            // Samples seen (saturates at warm-up)
+    uint32_t        alarms;             // Change points raised
+    
+    // Latched alarm, cleared once detection has looked at it
+    uint8_t         alarm;              // AI_CHANGE_*
+    uint8_t         confidence;         // 1 - false alarm probability (0-99)
+    uint16_t        deviation;          // CUSUM at alarm (Q8 sigmas, saturated)
+    uint32_t        alarm_value;        // Sample that raised the alarm
+    uint32_t        alarm_expected;     // Baseline mean before the shift
+} ai_change_detector_t;
+
+/*
+ * Running statistics for one metric window. Sums are maintained as
+ * samples enter and leave the window so updates cost O(1).
+ */
+typedef struct ai_metric_stats {
+    uint64_t        sum;                // Sum of samples in window
+    uint64_t        sum_squares;        // Sum of squared samples
+    uint64_t        weighted_sum;       // Sum of position * sample (oldest = 0)
+    
+    uint32_t        mean;               // Window mean
+    uint32_t        variance;           // Window variance (saturated)
+    uint32_t        ewma;               // Exponentially weighted moving average
+    int32_t         slope;              // Least-squares slope per sample
+    uint32_t        trend;              // AI_TREND_* from slope
+    uint8_t         shift;              // Window quantization (sample = q << shift)
+    ai_change_detector_t change;        // Streaming change-point detector
+} ai_metric_stats_t;
+
 /*
  * Behavior pattern for ML analysis
  */
@@ -70,17 +158,25 @@ typedef struct behavior_pattern {
     uint32_t        entity_type;        // Actor, module, etc.
     uint32_t        entity_id;          // Specific entity ID
     
-    // Resource usage patterns
-    uint32_t        memory_usage[AI_ANALYSIS_WINDOW];    // Memory over time
-    uint32_t        cpu_usage[AI_ANALYSIS_WINDOW];       // CPU over time
-    uint32_t        io_operations[AI_ANALYSIS_WINDOW];   // I/O over time
-    uint32_t        message_count[AI_ANALYSIS_WINDOW];   // Messages over time
+    // Resource usage patterns (16-bit quantized ring buffers, newest at
+    // window_next - 1, scaled by the matching ai_metric_stats_t.shift)
+    uint16_t        memory_usage[AI_ANALYSIS_WINDOW];    // Memory over time
+    uint16_t        cpu_usage[AI_ANALYSIS_WINDOW];       // CPU over time
+    uint16_t        io_operations[AI_ANALYSIS_WINDOW];   // I/O over time
+    uint16_t        message_count[AI_ANALYSIS_WINDOW];   // Messages over time
+    uint32_t        window_next;        // Slot for the next sample
+    uint32_t        window_fill;        // Samples currently in window
     
     // Statistical analysis
-    uint32_t        mean_memory;        // Mean memory usage
-    uint32_t        std_memory;         // Standard deviation
-    uint32_t        variance_memory;    // Memory usage variance
-    uint32_t        trend_memory;       // Memory trend (increasing/decreasing)
+    ai_metric_stats_t memory_stats;     // Memory usage statistics
+    ai_metric_stats_t cpu_stats;        // CPU usage statistics
+    ai_metric_stats_t io_stats;         // I/O statistics
+    ai_metric_stats_t message_stats;    // Message statistics
+    
+    // Incremental anomaly counters
+    uint32_t        memory_increases;   // Adjacent samples where memory rose
+    uint32_t        recent_high_cpu;    // Recent samples with CPU > 80
+    uint32_t        recent_idle_msgs;   // Recent samples with no messages
     
     // Pattern classification
     uint32_t        pattern_class;      // ML-classified pattern type
@@ -92,6 +188,10 @@ typedef struct behavior_pattern {
     uint64_t        last_updated;       // Last update timestamp
     uint32_t        observation_count;  // Number of observations
     
+    // Recency list (ordered by last_updated, oldest at head)
+    uint16_t        lru_prev;           // Previous pattern index
+    uint16_t        lru_next;           // Next pattern index
+    
 } behavior_pattern_t;
 
 /*
@@ -124,18 +224,40 @@ typedef struct anomaly_detection {
 } anomaly_detection_t;
 
 /*
- * AI Model for pattern recognition (simplified)
+ * Model blob header. Followed by int8 weights (hidden layer rows, then
+ * output layer rows), zero padding to a 4-byte boundary, then int32
+ * Q16.16 biases (hidden, then output).
+ */
+typedef struct __attribute__((packed)) ai_model_blob_header {
+    uint32_t        magic;              // AI_MODEL_BLOB_MAGIC
+    uint16_t        version;            // AI_MODEL_BLOB_VERSION
+    uint8_t         model_type;         // AI_MODEL_LINEAR / AI_MODEL_MLP
+    uint8_t         feature_count;      // Inputs
+    uint8_t         hidden_count;       // Hidden units (0 for linear)
+    uint8_t         class_count;        // Output classes
+    uint8_t         accuracy;           // Offline accuracy (0-100)
+    uint8_t         reserved;
+    int32_t         weight_scale[2];    // Q16.16 dequantization per layer
+    char            name[32];           // Model name
+} ai_model_blob_header_t;
+
+/*
+ * AI Model for pattern recognition. Integer-only so inference is safe
+ * in any context: int8 weights with a Q16.16 scale per layer and
+ * Q16.16 biases and activations.
  */
 typedef struct ai_model {
     uint32_t        model_id;           // Model identifier
     char            model_name[64];     // Model name
-    uint8_t         model_type;         // Model type (PCA, SVM, etc.)
+    uint8_t         model_type;         // AI_MODEL_LINEAR / AI_MODEL_MLP
     uint8_t         model_version;      // Model version
     
-    // Model parameters (simplified representation)
-    float           weights[256];       // Model weights
-    float           bias[32];           // Model bias values
+    // Model parameters (quantized)
+    int8_t          weights[AI_MODEL_MAX_WEIGHTS]; // Layer weights
+    int32_t         bias[AI_MODEL_MAX_BIAS];       // Q16.16 biases
+    int32_t         weight_scale[2];    // Q16.16 weight scale per layer
     uint32_t        feature_count;      // Number of features
+    uint32_t        hidden_count;       // Number of hidden units
     uint32_t        class_count;        // Number of output classes
     
     // Training data
@@ -146,7 +268,7 @@ typedef struct ai_model {
     // Runtime state
     bool            model_active;       // Whether model is active
     uint32_t        inference_count;    // Number of inferences performed
-    uint32_t        inference_time_avg; // Average inference time
+    uint32_t        inference_time_avg; // Average inference time (TSC cycles)
     
 } ai_model_t;
 
@@ -159,10 +281,12 @@ typedef struct ai_supervisor_stats {
     uint64_t        interventions;      // Total interventions performed
     uint64_t        false_positives;    // False positive detections
     uint64_t        auto_resolutions;   // Automatic resolutions
+    uint64_t        patterns_evicted;   // Stale patterns reclaimed
     
     uint32_t        active_patterns;    // Currently active patterns
     uint32_t        active_anomalies;   // Currently active anomalies
-    uint32_t        cpu_usage_percent;  // AI CPU usage percentage
+    uint32_t        cpu_usage_percent;  // AI CPU usage percentage (measured)
+    uint64_t        analysis_slices;    // Budgeted slices executed
     uint32_t        memory_usage_kb;    // AI memory usage in KB
     
     uint32_t        model_accuracy_avg; // Average model accuracy
@@ -181,11 +305,18 @@ typedef struct ai_supervisor {
     bool            learning_enabled;   // Whether online learning is enabled
     uint8_t         analysis_types;     // Types of analysis to perform
     
-    // Behavior patterns
-    behavior_pattern_t patterns[MAX_BEHAVIOR_PATTERNS];
+    // Behavior patterns (records allocated on demand from the AI pool)
+    behavior_pattern_t* patterns[MAX_BEHAVIOR_PATTERNS];
     bool            pattern_active[MAX_BEHAVIOR_PATTERNS];
     uint32_t        pattern_count;      // Number of active patterns
     
+    // Pattern lookup (open addressing, linear probing on entity key)
+    uint16_t        pattern_hash[AI_PATTERN_HASH_SIZE];
+    uint16_t        free_patterns[MAX_BEHAVIOR_PATTERNS]; // Free slot stack
+    uint32_t        free_pattern_count; // Entries on free slot stack
+    uint16_t        lru_head;           // Least recently updated pattern
+    uint16_t        lru_tail;           // Most recently updated pattern
+    
     // Anomaly detection
     anomaly_detection_t anomalies[MAX_ANOMALY_TYPES];
     bool            anomaly_active[MAX_ANOMALY_TYPES];
@@ -200,13 +331,27 @@ typedef struct ai_supervisor {
     uint32_t        analysis_interval;  // Analysis interval in ticks
     uint32_t        anomaly_threshold;  // Anomaly detection threshold
     uint32_t        intervention_threshold; // Auto-intervention threshold
+    uint32_t        change_threshold;   // CUSUM alarm threshold h (Q8 sigmas)
+    uint32_t        change_arl;         // Samples between false alarms at h
     
     // Statistics and monitoring
     ai_supervisor_stats_t statistics;  // AI supervisor statistics
     
-    // Memory management
-    void*           ai_memory_pool;     // Dedicated AI memory pool
-    size_t          ai_memory_size;     // AI memory pool size
+    // Incremental analysis state (resumes across slices)
+    uint32_t        actor_id;           // AI supervisor actor (0 = run inline)
+    uint8_t         pass_phase;         // AI_PHASE_* of current pass
+    uint32_t        pass_cursor;        // Resume point within phase
+    uint32_t        pass_anomalies;     // Anomalies found in current pass
+    uint32_t        cycle_budget;       // TSC cycles allowed per slice
+    uint64_t        busy_cycles;        // Slice cycles in usage window
+    uint64_t        usage_window_start; // TSC at start of usage window
+    
+    // Memory management (pool chunks are taken from the kernel heap as
+    // records are first needed and kept for reuse)
+    void*           ai_pool_chunks[AI_POOL_MAX_CHUNKS];
+    uint32_t        ai_pool_chunk_count; // Chunks allocated
+    size_t          ai_pool_chunk_used; // Bytes handed out from the newest chunk
+    size_t          ai_memory_size;     // AI pool size (bytes in chunks)
     size_t          ai_memory_used;     // AI memory currently used
     
 } ai_supervisor_t;
@@ -231,10 +376,20 @@ void ai_supervisor_start(void);
 void ai_supervisor_stop(void);
 
 /*
- * Perform periodic AI analysis
+ * Perform periodic AI analysis (starts a pass; work runs in slices)
  */
 void ai_supervisor_analyze(void);
 
+/*
+ * Run one budgeted analysis slice. Returns true when the pass is done.
+ */
+bool ai_supervisor_run_slice(void);
+
+/*
+ * AI supervisor actor entry point
+ */
+void ai_supervisor_actor_main(void);
+
 /*
  * Update behavior patterns for entity
  */
@@ -259,7 +414,7 @@ anomaly_detection_t* ai_analyze_entity(uint32_t entity_type, uint32_t entity_id)
 /*
  * Report anomaly to supervisor
  */
-void ai_report_anomaly(uint8_t anomaly_type, uint32_t entity_type, 
+anomaly_detection_t* ai_report_anomaly(uint8_t anomaly_type, uint32_t entity_type, 
                        uint32_t entity_id, uint32_t severity,
                        const char* description);
 
@@ -287,6 +442,11 @@ bool ai_load_model(const char* model_name, uint8_t model_type);
  */
 void ai_train_model(uint32_t model_id, behavior_pattern_t* patterns, uint32_t count);
 
+/*
+ * Load model from a serialized blob into the next model slot
+ */
+bool ai_load_model_blob(const void* blob, size_t size);
+
 /*
  * Perform AI inference on behavior pattern
  */
@@ -379,6 +539,16 @@ void ai_set_anomaly_threshold(uint32_t threshold);
  */
 void ai_set_analysis_types(uint8_t types);
 
+/*
+ * Set per-slice cycle budget for incremental analysis
+ */
+void ai_set_cycle_budget(uint32_t cycles);
+
+/*
+ * Set change-point false alarm rate as samples between false alarms
+ */
+void ai_set_change_false_alarm_rate(uint32_t samples);
+
 // =============================================================================
 // Debug and Testing Functions
 // =============================================================================
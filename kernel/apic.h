@@ -0,0 +1,94 @@
+/*
+ * =============================================================================
+ * CLKernel - Local APIC Header
+ * =============================================================================
+ * File: apic.h
+ * Purpose: Local APIC access for SMP bring-up, inter-processor interrupts,
+ *          interrupt acknowledgement and the per-CPU timer
+ *
+ * Every CPU has its own local APIC at the same physical address; a CPU
+ * only ever sees its own through the MMIO window, so the register
+ * accessors need no CPU argument.
+ * =============================================================================
+ */
+
+#ifndef APIC_H
+#define APIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// Local APIC Constants
+// =============================================================================
+
+#define LAPIC_DEFAULT_BASE          0xFEE00000  // Physical base after reset
+#define LAPIC_MSR_BASE              0x1B        // IA32_APIC_BASE
+#define LAPIC_MSR_ENABLE            0x800       // Global enable bit in IA32_APIC_BASE
+#define LAPIC_MSR_TSC_DEADLINE      0x6E0       // IA32_TSC_DEADLINE
+
+// Register offsets
+#define LAPIC_REG_ID                0x020       // Local APIC ID (bits 24-31)
+#define LAPIC_REG_VERSION           0x030
+#define LAPIC_REG_TPR               0x080       // Task priority
+#define LAPIC_REG_EOI               0x0B0
+#define LAPIC_REG_SVR               0x0F0       // Spurious interrupt vector
+#define LAPIC_REG_ESR               0x280       // Error status
+#define LAPIC_REG_ICR_LOW           0x300       // Interrupt command
+#define LAPIC_REG_ICR_HIGH          0x310       // Destination (bits 24-31)
+#define LAPIC_REG_LVT_TIMER         0x320       // Timer vector and mode
+#define LAPIC_REG_TIMER_INITIAL     0x380       // Timer initial count
+#define LAPIC_REG_TIMER_CURRENT     0x390       // Timer current count
+#define LAPIC_REG_TIMER_DIVIDE      0x3E0       // Timer divide configuration
+
+#define LAPIC_SVR_ENABLE            0x100       // Software enable
+#define LAPIC_SPURIOUS_VECTOR       0xFF        // Never acknowledged with EOI
+#define LAPIC_TIMER_VECTOR          0xF0        // Per-CPU local APIC timer
+#define LAPIC_RESCHEDULE_VECTOR     0xF1        // Cross-CPU wakeup (smp_send_reschedule)
+
+// LVT fields
+#define LAPIC_LVT_MASKED            0x10000
+#define LAPIC_TIMER_ONESHOT         0x00000     // Count down once from the initial count
+#define LAPIC_TIMER_PERIODIC        0x20000     // Reload the initial count at zero
+#define LAPIC_TIMER_TSC_DEADLINE    0x40000     // Fire when the TSC reaches IA32_TSC_DEADLINE
+#define LAPIC_TIMER_DIVIDE_16       0x3
+
+// ICR fields
+#define LAPIC_ICR_FIXED             0x00000
+#define LAPIC_ICR_INIT              0x00500
+#define LAPIC_ICR_STARTUP           0x00600
+#define LAPIC_ICR_PENDING           0x01000     // Delivery status
+#define LAPIC_ICR_ASSERT            0x04000
+#define LAPIC_ICR_LEVEL             0x08000
+#define LAPIC_ICR_ALL_EXCLUDING_SELF 0xC0000
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Setup (BSP maps and enables, APs only enable)
+bool lapic_init(void);
+void lapic_init_ap(void);
+bool lapic_is_present(void);
+
+// Registers
+uint32_t lapic_read(uint32_t reg);
+void lapic_write(uint32_t reg, uint32_t value);
+uint8_t lapic_id(void);
+void lapic_eoi(void);
+
+// Per-CPU timer (counts bus clocks / 16; masked until configured)
+bool lapic_timer_has_tsc_deadline(void);
+void lapic_timer_configure(uint32_t mode);
+void lapic_timer_arm(uint32_t initial_count);
+void lapic_timer_arm_deadline(uint64_t tsc);
+void lapic_timer_stop(void);
+uint32_t lapic_timer_remaining(void);
+void lapic_timer_set_handler(void (*handler)(void));
+void lapic_timer_interrupt(void);
+
+// Inter-processor interrupts
+bool lapic_send_ipi(uint8_t apic_id, uint32_t command);
+bool lapic_broadcast_ipi(uint32_t command);
+
+#endif // APIC_H
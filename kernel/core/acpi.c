@@ -0,0 +1,427 @@
+/*
+ * =============================================================================
+ * CLKernel - Interrupt Topology Discovery
+ * =============================================================================
+ * File: acpi.c
+ * Purpose: Parse the ACPI MADT or the Intel MP table into apic_platform_t
+ *
+ * The RSDP and the MP floating pointer both live in the first megabyte,
+ * which is identity mapped. The tables they point to usually sit near the
+ * top of RAM and are mapped through the paging I/O window.
+ * =============================================================================
+ */
+
+#include "acpi.h"
+#include "kernel.h"
+#include "paging.h"
+
+// =============================================================================
+// Firmware Table Layouts
+// =============================================================================
+
+typedef struct acpi_rsdp {
+    char            signature[8];       // "RSD PTR "
+    uint8_t         checksum;           // First 20 bytes sum to 0
+    char            oem_id[6];
+    uint8_t         revision;
+    uint32_t        rsdt_address;
+} __attribute__((packed)) acpi_rsdp_t;
+
+typedef struct acpi_header {
+    char            signature[4];
+    uint32_t        length;             // Whole table, header included
+    uint8_t         revision;
+    uint8_t         checksum;
+    char            oem_id[6];
+    char            oem_table_id[8];
+    uint32_t        oem_revision;
+    uint32_t        creator_id;
+    uint32_t        creator_revision;
+} __attribute__((packed)) acpi_header_t;
+
+typedef struct acpi_madt {
+    acpi_header_t   header;             // "APIC"
+    uint32_t        lapic_address;
+    uint32_t        flags;              // Bit 0: dual 8259s present
+} __attribute__((packed)) acpi_madt_t;
+
+// MADT entry types
+#define MADT_LAPIC                  0
+#define MADT_IOAPIC                 1
+#define MADT_ISO                    2   // Interrupt source override
+#define MADT_LAPIC_ADDRESS          5   // 64-bit local APIC address
+
+#define MADT_FLAG_PCAT_COMPAT       0x01
+#define MADT_LAPIC_ENABLED          0x01
+
+typedef struct mp_floating_pointer {
+    char            signature[4];       // "_MP_"
+    uint32_t        config_address;     // MP configuration table (0 = default config)
+    uint8_t         length;             // In 16-byte units
+    uint8_t         revision;
+    uint8_t         checksum;
+    uint8_t         features[5];        // features[1] bit 7: IMCR present
+} __attribute__((packed)) mp_floating_pointer_t;
+
+typedef struct mp_config_header {
+    char            signature[4];       // "PCMP"
+    uint16_t        length;
+    uint8_t         revision;
+    uint8_t         checksum;
+    char            oem_id[8];
+    char            product_id[12];
+    uint32_t        oem_table;
+    uint16_t        oem_table_size;
+    uint16_t        entry_count;
+    uint32_t        lapic_address;
+    uint16_t        extended_length;
+    uint8_t         extended_checksum;
+    uint8_t         reserved;
+} __attribute__((packed)) mp_config_header_t;
+
+// MP entry types and sizes
+#define MP_ENTRY_PROCESSOR          0   // 20 bytes
+#define MP_ENTRY_BUS                1   // 8 bytes
+#define MP_ENTRY_IOAPIC             2   // 8 bytes
+#define MP_ENTRY_IO_INTERRUPT       3   // 8 bytes
+#define MP_ENTRY_LOCAL_INTERRUPT    4   // 8 bytes
+
+#define MP_PROCESSOR_ENABLED        0x01
+#define MP_IOAPIC_ENABLED           0x01
+#define MP_INTERRUPT_INT            0   // Vectored interrupt (not NMI/SMI/ExtINT)
+#define MP_FEATURE_IMCR             0x80
+
+// MP tables give no GSI bases: I/O APICs are numbered consecutively with
+// the 82093AA's 24 inputs each
+#define MP_IOAPIC_PINS              24
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+static bool acpi_checksum_ok(const void* data, uint32_t length)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint8_t sum = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        sum += bytes[i];
+    }
+    return sum == 0;
+}
+
+static bool acpi_signature_is(const char* field, const char* signature, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++) {
+        if (field[i] != signature[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Make a firmware table readable (low memory is identity mapped)
+ */
+static void* acpi_map(uint32_t physical, uint32_t length)
+{
+    if (physical + length <= 0x400000) {
+        return (void*)physical;
+    }
+    return paging_map_io(physical, length);
+}
+
+/*
+ * Map a whole ACPI table: the header first, to learn its length
+ */
+static acpi_header_t* acpi_map_table(uint32_t physical)
+{
+    acpi_header_t* header = (acpi_header_t*)acpi_map(physical, sizeof(acpi_header_t));
+    if (!header || header->length < sizeof(acpi_header_t)) {
+        return NULL;
+    }
+
+    uint32_t length = header->length;
+    if (physical + length > 0x400000) {
+        header = (acpi_header_t*)acpi_map(physical, length);
+    }
+    if (!header || !acpi_checksum_ok(header, length)) {
+        return NULL;
+    }
+    return header;
+}
+
+/*
+ * Scan [start, start + length) on 16-byte boundaries for a signature
+ */
+static void* acpi_scan(uint32_t start, uint32_t length, const char* signature, uint32_t size)
+{
+    for (uint32_t address = start; address + size <= start + length; address += 16) {
+        if (acpi_signature_is((const char*)address, signature, 4) &&
+            acpi_checksum_ok((const void*)address, size)) {
+            return (void*)address;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Search the first KB of the EBDA, then the BIOS ROM area
+ */
+static void* acpi_find_pointer(const char* signature, uint32_t size)
+{
+    // BIOS data area word 0x40E holds the EBDA segment (the empty asm stops
+    // GCC from treating a first-page address as a null dereference)
+    volatile uint16_t* ebda_segment = (volatile uint16_t*)0x40E;
+    asm ("" : "+r" (ebda_segment));
+    uint32_t ebda = (uint32_t)*ebda_segment << 4;
+    void* found = NULL;
+
+    if (ebda >= 0x80000 && ebda < 0xA0000) {
+        found = acpi_scan(ebda, 1024, signature, size);
+    }
+    if (!found) {
+        found = acpi_scan(0xE0000, 0x20000, signature, size);
+    }
+    return found;
+}
+
+static void acpi_add_cpu(apic_platform_t* platform, uint8_t apic_id)
+{
+    if (platform->cpu_count < APIC_PLATFORM_MAX_CPUS) {
+        platform->cpu_apic_ids[platform->cpu_count] = apic_id;
+    }
+    platform->cpu_count++;
+}
+
+static void acpi_add_ioapic(apic_platform_t* platform, uint8_t id, uint32_t address,
+                            uint32_t gsi_base)
+{
+    if (platform->ioapic_count >= APIC_PLATFORM_MAX_IOAPICS) {
+        kprintf("[ACPI] Ignoring I/O APIC %d (limit %d)\n", id, APIC_PLATFORM_MAX_IOAPICS);
+        return;
+    }
+
+    apic_platform_ioapic_t* ioapic = &platform->ioapics[platform->ioapic_count++];
+    ioapic->id = id;
+    ioapic->address = address;
+    ioapic->gsi_base = gsi_base;
+}
+
+static void acpi_platform_reset(apic_platform_t* platform)
+{
+    platform->source = APIC_SOURCE_NONE;
+    platform->lapic_address = 0;
+    platform->has_8259 = true;
+    platform->has_imcr = false;
+    platform->cpu_count = 0;
+    platform->ioapic_count = 0;
+
+    // ISA default: IRQ n is GSI n, with the bus's own polarity/trigger
+    for (uint32_t irq = 0; irq < APIC_PLATFORM_ISA_IRQS; irq++) {
+        platform->isa_irqs[irq].gsi = irq;
+        platform->isa_irqs[irq].flags = 0;
+    }
+}
+
+// =============================================================================
+// ACPI MADT
+// =============================================================================
+
+static bool acpi_parse_madt(apic_platform_t* platform)
+{
+    acpi_rsdp_t* rsdp = (acpi_rsdp_t*)acpi_find_pointer("RSD ", 20);
+    if (!rsdp || !acpi_signature_is(rsdp->signature, "RSD PTR ", 8)) {
+        return false;
+    }
+
+    acpi_header_t* rsdt = acpi_map_table(rsdp->rsdt_address);
+    if (!rsdt || !acpi_signature_is(rsdt->signature, "RSDT", 4)) {
+        kprintf("[ACPI] RSDP found but RSDT at 0x%x is invalid\n", rsdp->rsdt_address);
+        return false;
+    }
+
+    uint32_t entries = (rsdt->length - sizeof(acpi_header_t)) / sizeof(uint32_t);
+    const uint32_t* tables = (const uint32_t*)(rsdt + 1);
+    acpi_madt_t* madt = NULL;
+
+    for (uint32_t i = 0; i < entries && !madt; i++) {
+        acpi_header_t* header = (acpi_header_t*)acpi_map(tables[i], sizeof(acpi_header_t));
+        if (header && acpi_signature_is(header->signature, "APIC", 4)) {
+            madt = (acpi_madt_t*)acpi_map_table(tables[i]);
+        }
+    }
+    if (!madt) {
+        return false;
+    }
+
+    platform->lapic_address = madt->lapic_address;
+    platform->has_8259 = (madt->flags & MADT_FLAG_PCAT_COMPAT) != 0;
+
+    const uint8_t* entry = (const uint8_t*)(madt + 1);
+    const uint8_t* end = (const uint8_t*)madt + madt->header.length;
+
+    while (entry + 2 <= end && entry[1] >= 2 && entry + entry[1] <= end) {
+        switch (entry[0]) {
+            case MADT_LAPIC:
+                // processor ID, APIC ID, flags (u32)
+                if (*(const uint32_t*)(entry + 4) & MADT_LAPIC_ENABLED) {
+                    acpi_add_cpu(platform, entry[3]);
+                }
+                break;
+
+            case MADT_IOAPIC:
+                // ID, reserved, address (u32), GSI base (u32)
+                acpi_add_ioapic(platform, entry[2], *(const uint32_t*)(entry + 4),
+                                *(const uint32_t*)(entry + 8));
+                break;
+
+            case MADT_ISO:
+                // bus, source IRQ, GSI (u32), flags (u16)
+                if (entry[2] == 0 && entry[3] < APIC_PLATFORM_ISA_IRQS) {
+                    platform->isa_irqs[entry[3]].gsi = *(const uint32_t*)(entry + 4);
+                    platform->isa_irqs[entry[3]].flags = *(const uint16_t*)(entry + 8);
+                }
+                break;
+
+            case MADT_LAPIC_ADDRESS:
+                // reserved (u16), address (u64); only usable below 4GB
+                if (*(const uint32_t*)(entry + 8) == 0) {
+                    platform->lapic_address = *(const uint32_t*)(entry + 4);
+                }
+                break;
+
+            default:
+                break;
+        }
+        entry += entry[1];
+    }
+
+    platform->source = APIC_SOURCE_ACPI;
+    return platform->ioapic_count > 0;
+}
+
+// =============================================================================
+// Intel MP Configuration Table
+// =============================================================================
+
+static bool acpi_parse_mp(apic_platform_t* platform)
+{
+    mp_floating_pointer_t* pointer =
+        (mp_floating_pointer_t*)acpi_find_pointer("_MP_", sizeof(mp_floating_pointer_t));
+    if (!pointer) {
+        return false;
+    }
+    if (!pointer->config_address) {
+        kprintf("[ACPI] MP default configuration %d not supported\n", pointer->features[0]);
+        return false;
+    }
+
+    mp_config_header_t* config = (mp_config_header_t*)acpi_map(pointer->config_address,
+                                                               sizeof(mp_config_header_t));
+    if (!config || !acpi_signature_is(config->signature, "PCMP", 4)) {
+        return false;
+    }
+    uint32_t length = config->length;
+    config = (mp_config_header_t*)acpi_map(pointer->config_address, length);
+    if (!config || !acpi_checksum_ok(config, length)) {
+        return false;
+    }
+
+    platform->lapic_address = config->lapic_address;
+    platform->has_imcr = (pointer->features[1] & MP_FEATURE_IMCR) != 0;
+
+    // Bus IDs that are ISA (only their interrupts are ISA IRQs)
+    uint32_t isa_buses = 0;
+    const uint8_t* entry = (const uint8_t*)(config + 1);
+    const uint8_t* end = (const uint8_t*)config + length;
+
+    for (uint32_t i = 0; i < config->entry_count && entry < end; i++) {
+        switch (entry[0]) {
+            case MP_ENTRY_PROCESSOR:
+                if (entry[3] & MP_PROCESSOR_ENABLED) {
+                    acpi_add_cpu(platform, entry[1]);
+                }
+                entry += 20;
+                break;
+
+            case MP_ENTRY_BUS:
+                if (entry[1] < 32 && acpi_signature_is((const char*)entry + 2, "ISA", 3)) {
+                    isa_buses |= 1u << entry[1];
+                }
+                entry += 8;
+                break;
+
+            case MP_ENTRY_IOAPIC:
+                if (entry[3] & MP_IOAPIC_ENABLED) {
+                    acpi_add_ioapic(platform, entry[1], *(const uint32_t*)(entry + 4),
+                                    platform->ioapic_count * MP_IOAPIC_PINS);
+                }
+                entry += 8;
+                break;
+
+            default:
+                entry += 8;
+                break;
+        }
+    }
+
+    // Second pass: interrupt entries name I/O APICs that are now known
+    entry = (const uint8_t*)(config + 1);
+    for (uint32_t i = 0; i < config->entry_count && entry < end; i++) {
+        if (entry[0] == MP_ENTRY_PROCESSOR) {
+            entry += 20;
+            continue;
+        }
+
+        // type, interrupt type, flags (u16), bus, bus IRQ, I/O APIC ID, pin
+        if (entry[0] == MP_ENTRY_IO_INTERRUPT && entry[1] == MP_INTERRUPT_INT &&
+            entry[4] < 32 && (isa_buses & (1u << entry[4])) &&
+            entry[5] < APIC_PLATFORM_ISA_IRQS) {
+            for (uint32_t j = 0; j < platform->ioapic_count; j++) {
+                if (platform->ioapics[j].id != entry[6] && entry[6] != 0xFF) continue;
+
+                platform->isa_irqs[entry[5]].gsi = platform->ioapics[j].gsi_base + entry[7];
+                platform->isa_irqs[entry[5]].flags = *(const uint16_t*)(entry + 2);
+                break;
+            }
+        }
+        entry += 8;
+    }
+
+    platform->source = APIC_SOURCE_MP;
+    return platform->ioapic_count > 0;
+}
+
+// =============================================================================
+// Discovery
+// =============================================================================
+
+bool acpi_discover_apics(apic_platform_t* platform)
+{
+    if (!platform) {
+        return false;
+    }
+
+    acpi_platform_reset(platform);
+    if (acpi_parse_madt(platform)) {
+        return true;
+    }
+
+    acpi_platform_reset(platform);
+    if (acpi_parse_mp(platform)) {
+        return true;
+    }
+
+    acpi_platform_reset(platform);
+    return false;
+}
+
+const char* acpi_source_name(uint8_t source)
+{
+    switch (source) {
+        case APIC_SOURCE_ACPI: return "ACPI MADT";
+        case APIC_SOURCE_MP:   return "MP table";
+        default:               return "none";
+    }
+}
@@ -16,7 +16,9 @@
 #include "ai_supervisor.h"
 #include "scheduler.h"
 #include "modules.h"
+#include "sandboxing.h"
 #include "heap.h"
+#include "metrics.h"
 #include "kernel.h"
 #include "vga.h"
 
@@ -30,6 +32,142 @@ bool ai_supervisor_initialized = false;
 // Tick counter for analysis timing
 static uint32_t ai_analysis_tick = 0;
 
+// Per-actor sampling baseline, turns cumulative counters into rates
+// (indexed by actor table slot)
+static uint32_t ai_actor_cpu_last[MAX_ACTORS];
+static uint32_t ai_actor_msgs_last[MAX_ACTORS];
+static uint32_t ai_actor_tick_last[MAX_ACTORS];
+
+/*
+ * Two-sided CUSUM in-control run length for k = 0.5 (Siegmund's
+ * approximation, Gaussian samples): threshold h in Q8 sigmas against
+ * the expected number of samples between false alarms.
+ */
+static const struct {
+    uint32_t        threshold;          // h (Q8 sigmas)
+    uint32_t        run_length;         // Samples between false alarms
+} ai_change_arl_table[] = {
+    { 2 << 8, 20 },   { 3 << 8, 59 },   { 4 << 8, 169 },  { 5 << 8, 469 },
+    { 6 << 8, 1286 }, { 7 << 8, 3510 }, { 8 << 8, 9556 }, { 9 << 8, 25993 },
+};
+
+#define AI_CHANGE_ARL_POINTS (sizeof(ai_change_arl_table) / sizeof(ai_change_arl_table[0]))
+
+// =============================================================================
+// Internal Function Declarations
+// =============================================================================
+
+void ai_load_default_models(void);
+void ai_analyze_actor_behaviors(void);
+void ai_analyze_memory_patterns(void);
+void ai_analyze_module_behaviors(void);
+void ai_process_anomalies(void);
+behavior_pattern_t* ai_find_or_create_pattern(uint32_t entity_type, uint32_t entity_id);
+void ai_update_pattern_statistics(behavior_pattern_t* pattern);
+uint32_t ai_calculate_anomaly_score(behavior_pattern_t* pattern);
+bool ai_check_memory_leak(behavior_pattern_t* pattern);
+bool ai_check_cpu_spike(behavior_pattern_t* pattern);
+bool ai_check_infinite_loop(behavior_pattern_t* pattern);
+bool ai_check_resource_abuse(behavior_pattern_t* pattern);
+uint32_t ai_window_sample(behavior_pattern_t* pattern, const uint16_t* window,
+                          const ai_metric_stats_t* stats, uint32_t age);
+void ai_reset_metric_stats(ai_metric_stats_t* stats);
+uint32_t ai_metric_quantize(ai_metric_stats_t* stats, uint16_t* window, uint32_t value,
+                            bool* rescaled);
+void ai_metric_push(ai_metric_stats_t* stats, uint16_t* window, uint32_t slot,
+                    uint32_t fill, uint32_t value);
+void ai_rebuild_pattern_windows(behavior_pattern_t* pattern);
+void* ai_pool_alloc(size_t size);
+void ai_update_memory_usage(void);
+void ai_extract_features(behavior_pattern_t* pattern, int32_t* features);
+int32_t ai_model_layer(const int8_t* weights, const int32_t* bias, int32_t scale,
+                       const int32_t* input, uint32_t inputs, int32_t* output,
+                       uint32_t outputs, bool relu);
+void ai_metric_finalize(ai_metric_stats_t* stats, uint32_t samples);
+void ai_update_window_counters(behavior_pattern_t* pattern, uint32_t memory_usage,
+                               uint32_t cpu_usage, uint32_t msg_count);
+uint32_t ai_pattern_hash_key(uint32_t entity_type, uint32_t entity_id);
+uint16_t ai_pattern_lookup(uint32_t entity_type, uint32_t entity_id);
+void ai_pattern_hash_insert(uint16_t index);
+void ai_pattern_hash_remove(uint16_t index);
+void ai_pattern_lru_append(uint16_t index);
+void ai_pattern_lru_unlink(uint16_t index);
+void ai_pattern_evict(uint16_t index);
+void ai_evict_stale_patterns(void);
+bool ai_evict_stale_pattern(void);
+void ai_analyze_actor(uint32_t actor_id);
+uint32_t ai_detect_pattern_anomalies(behavior_pattern_t* pattern);
+void ai_update_cpu_usage(void);
+void ai_change_reset(ai_change_detector_t* detector);
+void ai_change_update(ai_change_detector_t* detector, uint32_t value);
+uint32_t ai_change_confidence(uint32_t cusum);
+uint32_t ai_change_threshold_for_arl(uint32_t samples);
+void ai_change_annotate(anomaly_detection_t* anomaly, const ai_change_detector_t* detector);
+void ai_change_acknowledge(behavior_pattern_t* pattern);
+
+// =============================================================================
+// Fixed-Point Helpers
+// =============================================================================
+
+/*
+ * Divide a 64-bit value by a 32-bit divisor without libgcc helpers
+ */
+static inline uint64_t ai_div64(uint64_t dividend, uint32_t divisor)
+{
+#if defined(__i386__)
+    uint32_t high = (uint32_t)(dividend >> 32);
+    uint32_t low = (uint32_t)dividend;
+    uint32_t quotient_high = high / divisor;
+    uint32_t remainder = high % divisor;
+    uint32_t quotient_low;
+    
+    // remainder < divisor, so the 64/32 divide cannot overflow
+    __asm__ ("divl %2"
+             : "=a"(quotient_low), "=d"(remainder)
+             : "rm"(divisor), "a"(low), "d"(remainder));
+    
+    return ((uint64_t)quotient_high << 32) | quotient_low;
+#else
+    return dividend / divisor;
+#endif
+}
+
+/*
+ * Signed variant of ai_div64 (truncates toward zero)
+ */
+static inline int64_t ai_sdiv64(int64_t dividend, uint32_t divisor)
+{
+    if (dividend < 0) {
+        return -(int64_t)ai_div64((uint64_t)(-dividend), divisor);
+    }
+    return (int64_t)ai_div64((uint64_t)dividend, divisor);
+}
+
+/*
+ * Integer square root of a 64-bit value
+ */
+static inline uint32_t ai_isqrt64(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+    
+    while (bit > value) {
+        bit >>= 2;
+    }
+    
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    
+    return (uint32_t)root;
+}
+
 // =============================================================================
 // Core AI Supervisor Functions
 // =============================================================================
@@ -47,10 +185,17 @@ void ai_supervisor_init(void)
     kernel_ai_supervisor.learning_enabled = true;
     kernel_ai_supervisor.analysis_types = AI_ANALYSIS_MEMORY | AI_ANALYSIS_CPU | AI_ANALYSIS_BEHAVIOR;
     
-    // Initialize behavior patterns
+    // Initialize behavior patterns; lowest slots end up on top of the stack
     for (uint32_t i = 0; i < MAX_BEHAVIOR_PATTERNS; i++) {
         kernel_ai_supervisor.pattern_active[i] = false;
+        kernel_ai_supervisor.free_patterns[i] = (uint16_t)(MAX_BEHAVIOR_PATTERNS - 1 - i);
     }
+    for (uint32_t i = 0; i < AI_PATTERN_HASH_SIZE; i++) {
+        kernel_ai_supervisor.pattern_hash[i] = AI_PATTERN_NONE;
+    }
+    kernel_ai_supervisor.free_pattern_count = MAX_BEHAVIOR_PATTERNS;
+    kernel_ai_supervisor.lru_head = AI_PATTERN_NONE;
+    kernel_ai_supervisor.lru_tail = AI_PATTERN_NONE;
     kernel_ai_supervisor.pattern_count = 0;
     
     // Initialize anomaly detection
@@ -74,20 +219,41 @@ void ai_supervisor_init(void)
     kernel_ai_supervisor.statistics.interventions = 0;
     kernel_ai_supervisor.statistics.false_positives = 0;
     kernel_ai_supervisor.statistics.auto_resolutions = 0;
+    kernel_ai_supervisor.statistics.patterns_evicted = 0;
     kernel_ai_supervisor.statistics.active_patterns = 0;
     kernel_ai_supervisor.statistics.active_anomalies = 0;
-    kernel_ai_supervisor.statistics.cpu_usage_percent = 5; // AI uses ~5% CPU
-    kernel_ai_supervisor.statistics.memory_usage_kb = 1024; // 1MB for AI
+    kernel_ai_supervisor.statistics.cpu_usage_percent = 0;
+    kernel_ai_supervisor.statistics.analysis_slices = 0;
     
-    // Allocate AI memory pool
-    kernel_ai_supervisor.ai_memory_size = 2 * 1024 * 1024; // 2MB for AI
-    kernel_ai_supervisor.ai_memory_pool = kmalloc(kernel_ai_supervisor.ai_memory_size);
+    // Export statistics through the metrics registry
+    ai_supervisor_stats_t* stats = &kernel_ai_supervisor.statistics;
+    METRICS_COUNTER("ai.analyses", stats->total_analyses);
+    METRICS_COUNTER("ai.anomalies_detected", stats->anomalies_detected);
+    METRICS_COUNTER("ai.interventions", stats->interventions);
+    METRICS_COUNTER("ai.false_positives", stats->false_positives);
+    METRICS_COUNTER("ai.patterns_evicted", stats->patterns_evicted);
+    METRICS_COUNTER("ai.analysis_slices", stats->analysis_slices);
+    METRICS_GAUGE("ai.active_patterns", stats->active_patterns);
+    METRICS_GAUGE("ai.active_anomalies", stats->active_anomalies);
+    METRICS_GAUGE("ai.cpu_usage_percent", stats->cpu_usage_percent);
+    
+    // Incremental analysis: inline until ai_supervisor_start spawns the actor
+    kernel_ai_supervisor.actor_id = 0;
+    kernel_ai_supervisor.pass_phase = AI_PHASE_IDLE;
+    kernel_ai_supervisor.pass_cursor = 0;
+    kernel_ai_supervisor.pass_anomalies = 0;
+    kernel_ai_supervisor.cycle_budget = AI_SLICE_BUDGET_CYCLES;
+    kernel_ai_supervisor.change_arl = AI_CHANGE_DEFAULT_ARL;
+    kernel_ai_supervisor.change_threshold = ai_change_threshold_for_arl(AI_CHANGE_DEFAULT_ARL);
+    kernel_ai_supervisor.busy_cycles = 0;
+    kernel_ai_supervisor.usage_window_start = read_timestamp_counter();
+    
+    // AI memory pool: empty until the first pattern record is needed
+    kernel_ai_supervisor.ai_pool_chunk_count = 0;
+    kernel_ai_supervisor.ai_pool_chunk_used = 0;
+    kernel_ai_supervisor.ai_memory_size = 0;
     kernel_ai_supervisor.ai_memory_used = 0;
-    
-    if (!kernel_ai_supervisor.ai_memory_pool) {
-        kprintf("[AI] WARNING: Failed to allocate AI memory pool\n");
-        kernel_ai_supervisor.ai_memory_size = 0;
-    }
+    ai_update_memory_usage();
     
     // Load default AI models
     ai_load_default_models();
@@ -95,7 +261,8 @@ void ai_supervisor_init(void)
     ai_supervisor_initialized = true;
     
     kprintf("[AI] AI Supervisor initialized\n");
-    kprintf("[AI] Memory pool: %d KB\n", (uint32_t)(kernel_ai_supervisor.ai_memory_size / 1024));
+    kprintf("[AI] Memory pool: grows in %d KB chunks (at most %d)\n",
+            AI_POOL_CHUNK_SIZE / 1024, AI_POOL_MAX_CHUNKS);
     kprintf("[AI] Analysis types: 0x%x\n", kernel_ai_supervisor.analysis_types);
     kprintf("[AI] Auto-intervention: %s\n", 
             kernel_ai_supervisor.auto_intervention ? "ENABLED" : "DISABLED");
@@ -104,47 +271,208 @@ void ai_supervisor_init(void)
 }
 
 /*
- * Perform periodic AI analysis
+ * Start AI monitoring: spawn the low-priority supervisor actor. Until the
+ * scheduler runs actor bodies, analysis stays inline in
+ * ai_supervisor_analyze instead.
  */
-void ai_supervisor_analyze(void)
+void ai_supervisor_start(void)
 {
-    if (!ai_supervisor_initialized || !kernel_ai_supervisor.supervisor_enabled) {
+    if (!ai_supervisor_initialized || kernel_ai_supervisor.actor_id != 0) {
         return;
     }
     
-    ai_analysis_tick++;
+    if (!SCHEDULER_RUNS_ACTOR_BODIES) {
+        kprintf("[AI] Analyzing inline (budget %d cycles/slice): actors do not run yet\n",
+                kernel_ai_supervisor.cycle_budget);
+        return;
+    }
     
-    // Only analyze at specified intervals
-    if (ai_analysis_tick % kernel_ai_supervisor.analysis_interval != 0) {
+    uint32_t actor_id = actor_create(ai_supervisor_actor_main, NULL,
+                                     ACTOR_PRIORITY_IDLE, 0);
+    if (actor_id == 0 || !actor_start(actor_id)) {
+        kprintf("[AI] WARNING: Supervisor actor unavailable, analyzing inline\n");
         return;
     }
     
-    kernel_ai_supervisor.statistics.total_analyses++;
+    // Never let the supervisor police itself
+    actor_get(actor_id)->ai_monitored = false;
+    kernel_ai_supervisor.actor_id = actor_id;
     
-    // Analyze actor behaviors
-    if (kernel_ai_supervisor.analysis_types & AI_ANALYSIS_BEHAVIOR) {
-        ai_analyze_actor_behaviors();
+    kprintf("[AI] Supervisor actor %d started (budget %d cycles/slice)\n",
+            actor_id, kernel_ai_supervisor.cycle_budget);
+}
+
+/*
+ * Perform periodic AI analysis. Only starts a pass at the configured
+ * interval; the pass itself runs in budgeted slices on the supervisor
+ * actor, or inline one slice per call when no actor is running.
+ */
+void ai_supervisor_analyze(void)
+{
+    if (!ai_supervisor_initialized || !kernel_ai_supervisor.supervisor_enabled) {
+        return;
     }
     
-    // Analyze memory patterns
-    if (kernel_ai_supervisor.analysis_types & AI_ANALYSIS_MEMORY) {
-        ai_analyze_memory_patterns();
-    }
+    ai_analysis_tick++;
     
-    // Analyze module behaviors
-    ai_analyze_module_behaviors();
+    // Start a new pass at the analysis interval (unless one is still running)
+    if (ai_analysis_tick % kernel_ai_supervisor.analysis_interval == 0 &&
+        kernel_ai_supervisor.pass_phase == AI_PHASE_IDLE) {
+        kernel_ai_supervisor.statistics.total_analyses++;
+        kernel_ai_supervisor.pass_phase = AI_PHASE_ACTORS;
+        kernel_ai_supervisor.pass_cursor = 1; // Skip kernel actor
+        kernel_ai_supervisor.pass_anomalies = 0;
+        
+        if (kernel_ai_supervisor.actor_id != 0) {
+            message_send_async(kernel_ai_supervisor.actor_id, MSG_TYPE_SYSTEM, NULL, 0);
+        }
+    }
     
-    // Detect anomalies
-    uint32_t anomalies_found = ai_detect_anomalies();
+    if (kernel_ai_supervisor.actor_id == 0 && kernel_ai_supervisor.pass_phase != AI_PHASE_IDLE) {
+        ai_supervisor_run_slice();
+    }
+}
+
+/*
+ * AI supervisor actor: run slices until the pass completes, yielding
+ * between them, then sleep until the next pass is kicked off
+ */
+void ai_supervisor_actor_main(void)
+{
+    for (;;) {
+        while (kernel_ai_supervisor.pass_phase != AI_PHASE_IDLE) {
+            ai_supervisor_run_slice();
+            scheduler_yield();
+        }
+        
+        message_t* wakeup = message_wait(0);
+        if (wakeup) {
+            message_free(wakeup);
+        }
+    }
+}
+
+/*
+ * Check whether a slice started at 'start' has used its cycle budget
+ */
+static inline bool ai_slice_expired(uint64_t start)
+{
+    return read_timestamp_counter() - start >= kernel_ai_supervisor.cycle_budget;
+}
+
+/*
+ * Run one budgeted analysis slice. Each phase walks its entities from
+ * pass_cursor and stops as soon as the cycle budget is spent, so a
+ * slice costs at most one entity past the budget.
+ */
+bool ai_supervisor_run_slice(void)
+{
+    uint64_t start = read_timestamp_counter();
     
-    if (anomalies_found > 0) {
-        kprintf("[AI] Detected %d anomalies\n", anomalies_found);
+    while (kernel_ai_supervisor.pass_phase != AI_PHASE_IDLE) {
+        uint32_t* cursor = &kernel_ai_supervisor.pass_cursor;
         
-        // Handle anomalies if auto-intervention is enabled
-        if (kernel_ai_supervisor.auto_intervention) {
-            ai_process_anomalies();
+        switch (kernel_ai_supervisor.pass_phase) {
+            case AI_PHASE_ACTORS:
+                // Scheduler's own behavior scoring and rebalancing,
+                // requested by the timer
+                if (*cursor == 1 && scheduler_ai_analysis_due()) {
+                    scheduler_ai_analyze_actors();
+                    scheduler_ai_balance_load();
+                }
+                
+                if (kernel_ai_supervisor.analysis_types & AI_ANALYSIS_BEHAVIOR) {
+                    actor_t* actor;
+                    while ((actor = actor_next(cursor))) {
+                        ai_analyze_actor(actor->actor_id);
+                        if (ai_slice_expired(start)) goto out;
+                    }
+                }
+                kernel_ai_supervisor.pass_phase = AI_PHASE_SYSTEM;
+                *cursor = 0;
+                break;
+                
+            case AI_PHASE_SYSTEM:
+                if (*cursor == 0) {
+                    if (kernel_ai_supervisor.analysis_types & AI_ANALYSIS_MEMORY) {
+                        ai_analyze_memory_patterns();
+                    }
+                    ai_analyze_module_behaviors();
+                    *cursor = 1;
+                }
+                
+                // Reclaim patterns for entities that stopped reporting
+                while (ai_evict_stale_pattern()) {
+                    if (ai_slice_expired(start)) goto out;
+                }
+                
+                kernel_ai_supervisor.pass_phase = AI_PHASE_DETECT;
+                *cursor = kernel_ai_supervisor.lru_head;
+                if (ai_slice_expired(start)) goto out;
+                break;
+                
+            case AI_PHASE_DETECT:
+                while (*cursor != AI_PATTERN_NONE) {
+                    behavior_pattern_t* pattern = kernel_ai_supervisor.patterns[*cursor];
+                    *cursor = pattern->lru_next;
+                    
+                    kernel_ai_supervisor.pass_anomalies += ai_detect_pattern_anomalies(pattern);
+                    if (ai_slice_expired(start)) goto out;
+                }
+                kernel_ai_supervisor.pass_phase = AI_PHASE_RESPOND;
+                break;
+                
+            case AI_PHASE_RESPOND:
+                if (kernel_ai_supervisor.pass_anomalies > 0) {
+                    kprintf("[AI] Detected %d anomalies\n", kernel_ai_supervisor.pass_anomalies);
+                    
+                    // Handle anomalies if auto-intervention is enabled
+                    if (kernel_ai_supervisor.auto_intervention) {
+                        ai_process_anomalies();
+                    }
+                }
+                kernel_ai_supervisor.pass_phase = AI_PHASE_IDLE;
+                break;
+                
+            default:
+                kernel_ai_supervisor.pass_phase = AI_PHASE_IDLE;
+                break;
         }
     }
+    
+out:
+    kernel_ai_supervisor.busy_cycles += read_timestamp_counter() - start;
+    kernel_ai_supervisor.statistics.analysis_slices++;
+    ai_update_cpu_usage();
+    
+    return kernel_ai_supervisor.pass_phase == AI_PHASE_IDLE;
+}
+
+/*
+ * Export measured slice time as a share of elapsed time. The usage
+ * window restarts once it spans about 2^30 cycles.
+ */
+void ai_update_cpu_usage(void)
+{
+    uint64_t now = read_timestamp_counter();
+    uint64_t elapsed = now - kernel_ai_supervisor.usage_window_start;
+    uint64_t busy = kernel_ai_supervisor.busy_cycles;
+    
+    if (elapsed < (1u << 20)) return; // Too short to be meaningful
+    
+    // Scale both down until the divisor fits in 32 bits
+    while (elapsed > 0xFFFFFFFFull) {
+        elapsed >>= 1;
+        busy >>= 1;
+    }
+    
+    uint64_t percent = ai_div64(busy * 100, (uint32_t)elapsed);
+    kernel_ai_supervisor.statistics.cpu_usage_percent = (percent > 100) ? 100 : (uint32_t)percent;
+    
+    if (now - kernel_ai_supervisor.usage_window_start >= (1u << 30)) {
+        kernel_ai_supervisor.usage_window_start = now;
+        kernel_ai_supervisor.busy_cycles = 0;
+    }
 }
 
 /*
@@ -160,27 +488,48 @@ void ai_update_behavior_pattern(uint32_t entity_type, uint32_t entity_id,
     behavior_pattern_t* pattern = ai_find_or_create_pattern(entity_type, entity_id);
     if (!pattern) return;
     
-    // Shift historical data (simple sliding window)
-    for (int i = AI_ANALYSIS_WINDOW - 1; i > 0; i--) {
-        pattern->memory_usage[i] = pattern->memory_usage[i-1];
-        pattern->cpu_usage[i] = pattern->cpu_usage[i-1];
-        pattern->io_operations[i] = pattern->io_operations[i-1];
-        pattern->message_count[i] = pattern->message_count[i-1];
+    // Quantize into the 16-bit windows. A value that does not fit widens
+    // the metric's scale, after which the sums are rebuilt once.
+    bool rescaled = false;
+    memory_usage = ai_metric_quantize(&pattern->memory_stats, pattern->memory_usage, memory_usage, &rescaled);
+    cpu_usage = ai_metric_quantize(&pattern->cpu_stats, pattern->cpu_usage, cpu_usage, &rescaled);
+    io_ops = ai_metric_quantize(&pattern->io_stats, pattern->io_operations, io_ops, &rescaled);
+    msg_count = ai_metric_quantize(&pattern->message_stats, pattern->message_count, msg_count, &rescaled);
+    
+    if (rescaled) {
+        ai_rebuild_pattern_windows(pattern);
     }
     
-    // Add new data
-    pattern->memory_usage[0] = memory_usage;
-    pattern->cpu_usage[0] = cpu_usage;
-    pattern->io_operations[0] = io_ops;
-    pattern->message_count[0] = msg_count;
+    // Counters look at the samples leaving their windows, so run them
+    // before the new sample overwrites the oldest slot
+    ai_update_window_counters(pattern, memory_usage, cpu_usage, msg_count);
+    
+    // Add new data to the ring windows and running sums
+    uint32_t slot = pattern->window_next;
+    uint32_t fill = pattern->window_fill;
+    
+    ai_metric_push(&pattern->memory_stats, pattern->memory_usage, slot, fill, memory_usage);
+    ai_metric_push(&pattern->cpu_stats, pattern->cpu_usage, slot, fill, cpu_usage);
+    ai_metric_push(&pattern->io_stats, pattern->io_operations, slot, fill, io_ops);
+    ai_metric_push(&pattern->message_stats, pattern->message_count, slot, fill, msg_count);
+    
+    pattern->window_next = (slot + 1) % AI_ANALYSIS_WINDOW;
+    if (fill < AI_ANALYSIS_WINDOW) {
+        pattern->window_fill = fill + 1;
+    }
     
     // Update statistics
     ai_update_pattern_statistics(pattern);
     
-    // Perform quick anomaly check
+    // Classify with the active model, then perform quick anomaly check
+    pattern->pattern_class = ai_infer_pattern_class(pattern);
     pattern->anomaly_score = ai_calculate_anomaly_score(pattern);
     pattern->last_updated = ai_analysis_tick;
     pattern->observation_count++;
+    
+    // Keep the recency list ordered by last_updated
+    ai_pattern_lru_unlink(pattern->pattern_id);
+    ai_pattern_lru_append(pattern->pattern_id);
 }
 
 // =============================================================================
@@ -195,44 +544,62 @@ uint32_t ai_detect_anomalies(void)
     uint32_t anomalies_found = 0;
     
     // Check all active behavior patterns
-    for (uint32_t i = 0; i < MAX_BEHAVIOR_PATTERNS; i++) {
-        if (!kernel_ai_supervisor.pattern_active[i]) continue;
-        
-        behavior_pattern_t* pattern = &kernel_ai_supervisor.patterns[i];
+    uint16_t next;
+    for (uint16_t i = kernel_ai_supervisor.lru_head; i != AI_PATTERN_NONE; i = next) {
+        behavior_pattern_t* pattern = kernel_ai_supervisor.patterns[i];
+        next = pattern->lru_next;
         
-        // Check for various anomaly types
-        if (ai_check_memory_leak(pattern)) {
-            ai_report_anomaly(ANOMALY_MEMORY_LEAK, pattern->entity_type, 
-                             pattern->entity_id, 80, "Memory usage increasing steadily");
-            anomalies_found++;
-        }
-        
-        if (ai_check_cpu_spike(pattern)) {
-            ai_report_anomaly(ANOMALY_CPU_SPIKE, pattern->entity_type,
-                             pattern->entity_id, 70, "CPU usage spike detected");
-            anomalies_found++;
-        }
-        
-        if (ai_check_infinite_loop(pattern)) {
-            ai_report_anomaly(ANOMALY_INFINITE_LOOP, pattern->entity_type,
-                             pattern->entity_id, 90, "Potential infinite loop detected");
-            anomalies_found++;
-        }
-        
-        if (ai_check_resource_abuse(pattern)) {
-            ai_report_anomaly(ANOMALY_RESOURCE_ABUSE, pattern->entity_type,
-                             pattern->entity_id, 85, "Resource abuse pattern detected");
-            anomalies_found++;
-        }
+        anomalies_found += ai_detect_pattern_anomalies(pattern);
     }
     
     return anomalies_found;
 }
 
+/*
+ * Detect anomalies in a single behavior pattern
+ */
+uint32_t ai_detect_pattern_anomalies(behavior_pattern_t* pattern)
+{
+    uint32_t anomalies_found = 0;
+    
+    // Check for various anomaly types; change-point alarms supply the
+    // confidence and the observed/expected values
+    if (ai_check_memory_leak(pattern)) {
+        anomaly_detection_t* anomaly = ai_report_anomaly(ANOMALY_MEMORY_LEAK, pattern->entity_type, 
+                         pattern->entity_id, 80, "Memory usage increasing steadily");
+        ai_change_annotate(anomaly, &pattern->memory_stats.change);
+        anomalies_found++;
+    }
+    
+    if (ai_check_cpu_spike(pattern)) {
+        anomaly_detection_t* anomaly = ai_report_anomaly(ANOMALY_CPU_SPIKE, pattern->entity_type,
+                         pattern->entity_id, 70, "CPU usage spike detected");
+        ai_change_annotate(anomaly, &pattern->cpu_stats.change);
+        anomalies_found++;
+    }
+    
+    if (ai_check_infinite_loop(pattern)) {
+        anomaly_detection_t* anomaly = ai_report_anomaly(ANOMALY_INFINITE_LOOP, pattern->entity_type,
+                         pattern->entity_id, 90, "Potential infinite loop detected");
+        ai_change_annotate(anomaly, &pattern->cpu_stats.change);
+        anomalies_found++;
+    }
+    
+    if (ai_check_resource_abuse(pattern)) {
+        ai_report_anomaly(ANOMALY_RESOURCE_ABUSE, pattern->entity_type,
+                         pattern->entity_id, 85, "Resource abuse pattern detected");
+        anomalies_found++;
+    }
+    
+    ai_change_acknowledge(pattern);
+    
+    return anomalies_found;
+}
+
 /*
  * Report anomaly to supervisor
  */
-void ai_report_anomaly(uint8_t anomaly_type, uint32_t entity_type, 
+anomaly_detection_t* ai_report_anomaly(uint8_t anomaly_type, uint32_t entity_type, 
                        uint32_t entity_id, uint32_t severity,
                        const char* description)
 {
@@ -250,7 +617,7 @@ void ai_report_anomaly(uint8_t anomaly_type, uint32_t entity_type,
     anomaly->anomaly_id = kernel_ai_supervisor.statistics.anomalies_detected;
     anomaly->anomaly_type = anomaly_type;
     anomaly->severity = severity;
-    anomaly->confidence = 85; // Default confidence
+    anomaly->confidence = 85; // Default for rule-based detections
     anomaly->entity_type = entity_type;
     anomaly->entity_id = entity_id;
     
@@ -283,6 +650,8 @@ void ai_report_anomaly(uint8_t anomaly_type, uint32_t entity_type,
     kprintf("[AI] ANOMALY: %s (Entity: %d/%d, Severity: %d)\n",
             ai_anomaly_name(anomaly_type), entity_type, entity_id, severity);
     kprintf("[AI]          %s\n", description);
+    
+    return anomaly;
 }
 
 /*
@@ -354,14 +723,22 @@ bool ai_suspend_entity(uint32_t entity_type, uint32_t entity_id, const char* rea
 }
 
 /*
- * Throttle entity resources
+ * Throttle entity resources. Actors get a scheduler CPU quota; modules
+ * run on their callers' actors, so their cap is recorded as a sandbox
+ * RESOURCE_CPU_TIME limit.
  */
 bool ai_throttle_entity(uint32_t entity_type, uint32_t entity_id, uint32_t throttle_percent)
 {
-    // TODO: Implement resource throttling
-    kprintf("[AI] Throttling entity %d/%d to %d%% (stub)\n", 
+    kprintf("[AI] Throttling entity %d/%d to %d%%\n", 
             entity_type, entity_id, throttle_percent);
-    return true;
+    
+    if (entity_type == 0) { // Actor
+        return actor_set_cpu_quota(entity_id, throttle_percent);
+    } else if (entity_type == 1) { // Module
+        return sandboxing_set_resource_limit(entity_id, RESOURCE_CPU_TIME, throttle_percent) == 0;
+    }
+    
+    return false;
 }
 
 /*
@@ -388,17 +765,50 @@ void ai_analyze_actor_behaviors(void)
     if (!sched_stats) return;
     
     // Analyze each active actor
-    for (uint32_t i = 1; i < MAX_ACTORS; i++) {
-        actor_t* actor = actor_get(i);
-        if (!actor || actor->state != ACTOR_STATE_RUNNING) continue;
-        
-        // Update behavior pattern
-        ai_update_behavior_pattern(0, i, // Entity type 0 = Actor
-                                  (uint32_t)actor->memory_used,
-                                  (uint32_t)actor->cpu_time_used,
-                                  0, // I/O operations (stub)
-                                  (uint32_t)actor->messages_received);
+    uint32_t index = 1; // Skip the kernel actor
+    actor_t* actor;
+    while ((actor = actor_next(&index))) {
+        ai_analyze_actor(actor->actor_id);
+    }
+}
+
+/*
+ * Analyze a single actor's behavior
+ */
+void ai_analyze_actor(uint32_t actor_id)
+{
+    actor_t* actor = actor_get(actor_id);
+    if (!actor || actor->state != ACTOR_STATE_RUNNING || !actor->ai_monitored) return;
+    
+    // Scheduler counters are cumulative; sample them as rates since the
+    // last pass (a reused actor slot restarts from zero)
+    uint32_t cpu_time = (uint32_t)actor->cpu_time_used;
+    uint32_t messages = (uint32_t)actor->messages_received;
+    extern scheduler_t kernel_scheduler;
+    uint32_t now = kernel_scheduler.tick_count;
+    uint32_t slot = handle_index(actor_id);
+    
+    if (cpu_time < ai_actor_cpu_last[slot] || messages < ai_actor_msgs_last[slot]) {
+        ai_actor_cpu_last[slot] = 0;
+        ai_actor_msgs_last[slot] = 0;
+        ai_actor_tick_last[slot] = (uint32_t)actor->creation_time;
     }
+    
+    uint32_t elapsed = now - ai_actor_tick_last[slot];
+    uint32_t cpu_percent = elapsed ?
+        ((cpu_time - ai_actor_cpu_last[slot]) * 100) / elapsed : 0;
+    if (cpu_percent > 100) cpu_percent = 100;
+    
+    // Update behavior pattern
+    ai_update_behavior_pattern(0, actor_id, // Entity type 0 = Actor
+                              (uint32_t)actor->memory_used,
+                              cpu_percent,
+                              0, // I/O operations (stub)
+                              messages - ai_actor_msgs_last[slot]);
+    
+    ai_actor_cpu_last[slot] = cpu_time;
+    ai_actor_msgs_last[slot] = messages;
+    ai_actor_tick_last[slot] = now;
 }
 
 /*
@@ -417,7 +827,8 @@ void ai_analyze_memory_patterns(void)
     }
     
     // Check for memory pressure
-    if (heap_stats->current_allocations > heap_stats->total_allocations * 0.9) {
+    if (heap_stats->current_allocations >
+        heap_stats->total_allocations - heap_stats->total_allocations / 10) {
         ai_report_anomaly(ANOMALY_RESOURCE_ABUSE, 255, 0, 70, "Memory pressure detected");
     }
 }
@@ -443,84 +854,536 @@ void ai_analyze_module_behaviors(void)
 behavior_pattern_t* ai_find_or_create_pattern(uint32_t entity_type, uint32_t entity_id)
 {
     // Look for existing pattern
-    for (uint32_t i = 0; i < MAX_BEHAVIOR_PATTERNS; i++) {
-        if (!kernel_ai_supervisor.pattern_active[i]) continue;
+    uint16_t index = ai_pattern_lookup(entity_type, entity_id);
+    if (index != AI_PATTERN_NONE) {
+        return kernel_ai_supervisor.patterns[index];
+    }
+    
+    // Out of slots: reclaim the least recently updated pattern
+    if (kernel_ai_supervisor.free_pattern_count == 0) {
+        if (kernel_ai_supervisor.lru_head == AI_PATTERN_NONE) {
+            return NULL; // No free slots
+        }
+        ai_pattern_evict(kernel_ai_supervisor.lru_head);
+    }
+    
+    // Create new pattern from the free slot stack. Records are allocated
+    // from the AI pool the first time a slot is used and reused after that.
+    uint16_t i = kernel_ai_supervisor.free_patterns[kernel_ai_supervisor.free_pattern_count - 1];
+    if (!kernel_ai_supervisor.patterns[i]) {
+        kernel_ai_supervisor.patterns[i] = ai_pool_alloc(sizeof(behavior_pattern_t));
+        if (!kernel_ai_supervisor.patterns[i]) {
+            return NULL; // AI pool exhausted
+        }
+    }
+    kernel_ai_supervisor.free_pattern_count--;
+    
+    behavior_pattern_t* pattern = kernel_ai_supervisor.patterns[i];
+    
+    // Initialize pattern
+    pattern->pattern_id = i;
+    pattern->entity_type = entity_type;
+    pattern->entity_id = entity_id;
+    
+    // Clear history
+    for (int j = 0; j < AI_ANALYSIS_WINDOW; j++) {
+        pattern->memory_usage[j] = 0;
+        pattern->cpu_usage[j] = 0;
+        pattern->io_operations[j] = 0;
+        pattern->message_count[j] = 0;
+    }
+    pattern->window_next = 0;
+    pattern->window_fill = 0;
+    
+    ai_reset_metric_stats(&pattern->memory_stats);
+    ai_reset_metric_stats(&pattern->cpu_stats);
+    ai_reset_metric_stats(&pattern->io_stats);
+    ai_reset_metric_stats(&pattern->message_stats);
+    
+    pattern->memory_increases = 0;
+    pattern->recent_high_cpu = 0;
+    pattern->recent_idle_msgs = 0;
+    
+    pattern->anomaly_score = 0;
+    pattern->confidence = 50;
+    pattern->first_seen = ai_analysis_tick;
+    pattern->last_updated = ai_analysis_tick;
+    pattern->observation_count = 0;
+    
+    kernel_ai_supervisor.pattern_active[i] = true;
+    kernel_ai_supervisor.pattern_count++;
+    kernel_ai_supervisor.statistics.active_patterns++;
+    
+    ai_pattern_hash_insert(i);
+    ai_pattern_lru_append(i);
+    
+    return pattern;
+}
+
+// =============================================================================
+// Pattern Table Management
+// =============================================================================
+
+/*
+ * Hash an entity key to its home bucket
+ */
+uint32_t ai_pattern_hash_key(uint32_t entity_type, uint32_t entity_id)
+{
+    uint32_t hash = entity_id * 0x9E3779B1u;
+    hash ^= (entity_type + 1) * 0x85EBCA77u;
+    hash ^= hash >> 15;
+    return hash & (AI_PATTERN_HASH_SIZE - 1);
+}
+
+/*
+ * Find pattern index for an entity (AI_PATTERN_NONE if untracked)
+ */
+uint16_t ai_pattern_lookup(uint32_t entity_type, uint32_t entity_id)
+{
+    uint32_t bucket = ai_pattern_hash_key(entity_type, entity_id);
+    
+    while (kernel_ai_supervisor.pattern_hash[bucket] != AI_PATTERN_NONE) {
+        uint16_t index = kernel_ai_supervisor.pattern_hash[bucket];
+        behavior_pattern_t* pattern = kernel_ai_supervisor.patterns[index];
         
-        behavior_pattern_t* pattern = &kernel_ai_supervisor.patterns[i];
         if (pattern->entity_type == entity_type && pattern->entity_id == entity_id) {
-            return pattern;
+            return index;
         }
+        
+        bucket = (bucket + 1) & (AI_PATTERN_HASH_SIZE - 1);
     }
     
-    // Create new pattern
-    for (uint32_t i = 0; i < MAX_BEHAVIOR_PATTERNS; i++) {
-        if (kernel_ai_supervisor.pattern_active[i]) continue;
+    return AI_PATTERN_NONE;
+}
+
+/*
+ * Insert pattern into the hash (key must not already be present)
+ */
+void ai_pattern_hash_insert(uint16_t index)
+{
+    behavior_pattern_t* pattern = kernel_ai_supervisor.patterns[index];
+    uint32_t bucket = ai_pattern_hash_key(pattern->entity_type, pattern->entity_id);
+    
+    while (kernel_ai_supervisor.pattern_hash[bucket] != AI_PATTERN_NONE) {
+        bucket = (bucket + 1) & (AI_PATTERN_HASH_SIZE - 1);
+    }
+    
+    kernel_ai_supervisor.pattern_hash[bucket] = index;
+}
+
+/*
+ * Remove pattern from the hash. Later entries of the probe run are
+ * shifted back so lookups never need tombstones.
+ */
+void ai_pattern_hash_remove(uint16_t index)
+{
+    behavior_pattern_t* pattern = kernel_ai_supervisor.patterns[index];
+    uint32_t mask = AI_PATTERN_HASH_SIZE - 1;
+    uint32_t hole = ai_pattern_hash_key(pattern->entity_type, pattern->entity_id);
+    
+    while (kernel_ai_supervisor.pattern_hash[hole] != index) {
+        if (kernel_ai_supervisor.pattern_hash[hole] == AI_PATTERN_NONE) return;
+        hole = (hole + 1) & mask;
+    }
+    
+    uint32_t bucket = hole;
+    for (;;) {
+        bucket = (bucket + 1) & mask;
+        
+        uint16_t moved = kernel_ai_supervisor.pattern_hash[bucket];
+        if (moved == AI_PATTERN_NONE) break;
+        
+        // An entry may fill the hole only if its home bucket is not
+        // cyclically inside (hole, bucket]
+        behavior_pattern_t* other = kernel_ai_supervisor.patterns[moved];
+        uint32_t home = ai_pattern_hash_key(other->entity_type, other->entity_id);
+        if (((bucket - home) & mask) >= ((bucket - hole) & mask)) {
+            kernel_ai_supervisor.pattern_hash[hole] = moved;
+            hole = bucket;
+        }
+    }
+    
+    kernel_ai_supervisor.pattern_hash[hole] = AI_PATTERN_NONE;
+}
+
+/*
+ * Append pattern to the recency list tail (most recently updated)
+ */
+void ai_pattern_lru_append(uint16_t index)
+{
+    behavior_pattern_t* pattern = kernel_ai_supervisor.patterns[index];
+    
+    pattern->lru_prev = kernel_ai_supervisor.lru_tail;
+    pattern->lru_next = AI_PATTERN_NONE;
+    
+    if (kernel_ai_supervisor.lru_tail != AI_PATTERN_NONE) {
+        kernel_ai_supervisor.patterns[kernel_ai_supervisor.lru_tail]->lru_next = index;
+    } else {
+        kernel_ai_supervisor.lru_head = index;
+    }
+    kernel_ai_supervisor.lru_tail = index;
+}
+
+/*
+ * Unlink pattern from the recency list
+ */
+void ai_pattern_lru_unlink(uint16_t index)
+{
+    behavior_pattern_t* pattern = kernel_ai_supervisor.patterns[index];
+    
+    if (pattern->lru_prev != AI_PATTERN_NONE) {
+        kernel_ai_supervisor.patterns[pattern->lru_prev]->lru_next = pattern->lru_next;
+    } else {
+        kernel_ai_supervisor.lru_head = pattern->lru_next;
+    }
+    
+    if (pattern->lru_next != AI_PATTERN_NONE) {
+        kernel_ai_supervisor.patterns[pattern->lru_next]->lru_prev = pattern->lru_prev;
+    } else {
+        kernel_ai_supervisor.lru_tail = pattern->lru_prev;
+    }
+    
+    pattern->lru_prev = AI_PATTERN_NONE;
+    pattern->lru_next = AI_PATTERN_NONE;
+}
+
+/*
+ * Release a pattern slot back to the free stack
+ */
+void ai_pattern_evict(uint16_t index)
+{
+    if (!kernel_ai_supervisor.pattern_active[index]) return;
+    
+    ai_pattern_hash_remove(index);
+    ai_pattern_lru_unlink(index);
+    
+    kernel_ai_supervisor.pattern_active[index] = false;
+    kernel_ai_supervisor.free_patterns[kernel_ai_supervisor.free_pattern_count++] = index;
+    kernel_ai_supervisor.pattern_count--;
+    kernel_ai_supervisor.statistics.active_patterns--;
+    kernel_ai_supervisor.statistics.patterns_evicted++;
+}
+
+/*
+ * Evict the least recently updated pattern if it has not been updated
+ * within AI_PATTERN_STALE_PASSES analysis passes. Returns true if a
+ * pattern was evicted.
+ */
+bool ai_evict_stale_pattern(void)
+{
+    uint32_t stale_age = kernel_ai_supervisor.analysis_interval * AI_PATTERN_STALE_PASSES;
+    uint16_t oldest = kernel_ai_supervisor.lru_head;
+    
+    if (oldest == AI_PATTERN_NONE) return false;
+    
+    uint32_t age = ai_analysis_tick - (uint32_t)kernel_ai_supervisor.patterns[oldest]->last_updated;
+    if (age <= stale_age) return false;
+    
+    ai_pattern_evict(oldest);
+    return true;
+}
+
+/*
+ * Evict all stale patterns. The recency list is ordered, so this stops
+ * at the first fresh pattern.
+ */
+void ai_evict_stale_patterns(void)
+{
+    while (ai_evict_stale_pattern()) {
+    }
+}
+
+/*
+ * Update pattern statistics from the running sums (O(1) per metric)
+ */
+void ai_update_pattern_statistics(behavior_pattern_t* pattern)
+{
+    if (!pattern) return;
+    
+    uint32_t samples = pattern->window_fill;
+    
+    ai_metric_finalize(&pattern->memory_stats, samples);
+    ai_metric_finalize(&pattern->cpu_stats, samples);
+    ai_metric_finalize(&pattern->io_stats, samples);
+    ai_metric_finalize(&pattern->message_stats, samples);
+}
+
+/*
+ * Allocate from the AI memory pool (bump allocator, 8-byte aligned). A
+ * new chunk is taken from the kernel heap when the newest one is full.
+ */
+void* ai_pool_alloc(size_t size)
+{
+    ai_supervisor_t* ai = &kernel_ai_supervisor;
+    size_t offset = (ai->ai_pool_chunk_used + 7) & ~(size_t)7;
+    
+    if (size > AI_POOL_CHUNK_SIZE) {
+        return NULL;
+    }
+    
+    if (ai->ai_pool_chunk_count == 0 || offset + size > AI_POOL_CHUNK_SIZE) {
+        if (ai->ai_pool_chunk_count >= AI_POOL_MAX_CHUNKS) {
+            return NULL;
+        }
         
-        behavior_pattern_t* pattern = &kernel_ai_supervisor.patterns[i];
+        void* chunk = kmalloc(AI_POOL_CHUNK_SIZE);
+        if (!chunk) {
+            kprintf("[AI] WARNING: Failed to grow AI memory pool\n");
+            return NULL;
+        }
         
-        // Initialize pattern
-        pattern->pattern_id = i;
-        pattern->entity_type = entity_type;
-        pattern->entity_id = entity_id;
+        ai->ai_pool_chunks[ai->ai_pool_chunk_count++] = chunk;
+        ai->ai_memory_size += AI_POOL_CHUNK_SIZE;
+        offset = 0;
+    }
+    
+    ai->ai_pool_chunk_used = offset + size;
+    ai->ai_memory_used += size;
+    ai_update_memory_usage();
+    
+    return (uint8_t*)ai->ai_pool_chunks[ai->ai_pool_chunk_count - 1] + offset;
+}
+
+/*
+ * Recompute AI memory footprint: supervisor tables plus pool in use
+ */
+void ai_update_memory_usage(void)
+{
+    size_t bytes = sizeof(ai_supervisor_t) + kernel_ai_supervisor.ai_memory_used;
+    kernel_ai_supervisor.statistics.memory_usage_kb = (uint32_t)((bytes + 1023) / 1024);
+}
+
+// =============================================================================
+// Incremental Window Statistics
+// =============================================================================
+
+/*
+ * Get dequantized window sample by age (0 = newest)
+ */
+uint32_t ai_window_sample(behavior_pattern_t* pattern, const uint16_t* window,
+                          const ai_metric_stats_t* stats, uint32_t age)
+{
+    uint32_t slot = (pattern->window_next + AI_ANALYSIS_WINDOW - 1 - age) % AI_ANALYSIS_WINDOW;
+    return (uint32_t)window[slot] << stats->shift;
+}
+
+/*
+ * Quantize a sample for a metric window and return its dequantized
+ * value. If the value overflows 16 bits at the current scale, the scale
+ * is widened and stored samples are shifted down to match; the caller
+ * must then rebuild the running sums.
+ */
+uint32_t ai_metric_quantize(ai_metric_stats_t* stats, uint16_t* window, uint32_t value,
+                            bool* rescaled)
+{
+    uint32_t shift = stats->shift;
+    
+    while ((value >> shift) > 0xFFFF) {
+        shift++;
+    }
+    
+    if (shift != stats->shift) {
+        uint32_t delta = shift - stats->shift;
+        for (uint32_t i = 0; i < AI_ANALYSIS_WINDOW; i++) {
+            window[i] = (uint16_t)(window[i] >> delta);
+        }
+        stats->shift = (uint8_t)shift;
+        *rescaled = true;
+    }
+    
+    return (value >> shift) << shift;
+}
+
+/*
+ * Recompute running sums and counters from the stored windows. Only
+ * needed after a rescale, which happens at most 16 times per metric.
+ */
+void ai_rebuild_pattern_windows(behavior_pattern_t* pattern)
+{
+    ai_metric_stats_t* stats[4] = {
+        &pattern->memory_stats, &pattern->cpu_stats,
+        &pattern->io_stats, &pattern->message_stats
+    };
+    const uint16_t* windows[4] = {
+        pattern->memory_usage, pattern->cpu_usage,
+        pattern->io_operations, pattern->message_count
+    };
+    uint32_t fill = pattern->window_fill;
+    
+    for (uint32_t m = 0; m < 4; m++) {
+        stats[m]->sum = 0;
+        stats[m]->sum_squares = 0;
+        stats[m]->weighted_sum = 0;
         
-        // Clear history
-        for (int j = 0; j < AI_ANALYSIS_WINDOW; j++) {
-            pattern->memory_usage[j] = 0;
-            pattern->cpu_usage[j] = 0;
-            pattern->io_operations[j] = 0;
-            pattern->message_count[j] = 0;
+        for (uint32_t age = 0; age < fill; age++) {
+            uint32_t value = ai_window_sample(pattern, windows[m], stats[m], age);
+            stats[m]->sum += value;
+            stats[m]->sum_squares += (uint64_t)value * value;
+            stats[m]->weighted_sum += (uint64_t)(fill - 1 - age) * value;
         }
+    }
+    
+    pattern->memory_increases = 0;
+    pattern->recent_high_cpu = 0;
+    pattern->recent_idle_msgs = 0;
+    
+    for (uint32_t age = 0; age < fill; age++) {
+        uint32_t cpu = ai_window_sample(pattern, pattern->cpu_usage, &pattern->cpu_stats, age);
         
-        pattern->anomaly_score = 0;
-        pattern->confidence = 50;
-        pattern->first_seen = ai_analysis_tick;
-        pattern->last_updated = ai_analysis_tick;
-        pattern->observation_count = 0;
+        if (age + 1 < fill &&
+            ai_window_sample(pattern, pattern->memory_usage, &pattern->memory_stats, age) >
+            ai_window_sample(pattern, pattern->memory_usage, &pattern->memory_stats, age + 1)) {
+            pattern->memory_increases++;
+        }
+        if (age < AI_RECENT_WINDOW) {
+            if (cpu > 80) pattern->recent_high_cpu++;
+            if (ai_window_sample(pattern, pattern->message_count, &pattern->message_stats, age) == 0) {
+                pattern->recent_idle_msgs++;
+            }
+        }
+    }
+}
+
+/*
+ * Reset running statistics for a metric
+ */
+void ai_reset_metric_stats(ai_metric_stats_t* stats)
+{
+    stats->sum = 0;
+    stats->sum_squares = 0;
+    stats->weighted_sum = 0;
+    stats->mean = 0;
+    stats->variance = 0;
+    stats->ewma = 0;
+    stats->slope = 0;
+    stats->trend = AI_TREND_STABLE;
+    stats->shift = 0;
+    ai_change_reset(&stats->change);
+}
+
+/*
+ * Push an already quantized sample into a metric window. 'fill' is the
+ * sample count before the push; once the window is full 'slot' holds
+ * the oldest sample.
+ */
+void ai_metric_push(ai_metric_stats_t* stats, uint16_t* window, uint32_t slot,
+                    uint32_t fill, uint32_t value)
+{
+    uint32_t position = fill;
+    
+    if (fill == AI_ANALYSIS_WINDOW) {
+        uint32_t oldest = (uint32_t)window[slot] << stats->shift;
         
-        kernel_ai_supervisor.pattern_active[i] = true;
-        kernel_ai_supervisor.pattern_count++;
-        kernel_ai_supervisor.statistics.active_patterns++;
+        stats->sum -= oldest;
+        stats->sum_squares -= (uint64_t)oldest * oldest;
         
-        return pattern;
+        // Oldest sample sat at position 0; every remaining sample moves
+        // down one position, which removes one copy of their sum
+        stats->weighted_sum -= stats->sum;
+        position = AI_ANALYSIS_WINDOW - 1;
     }
     
-    return NULL; // No free slots
+    window[slot] = (uint16_t)(value >> stats->shift);
+    stats->sum += value;
+    stats->sum_squares += (uint64_t)value * value;
+    stats->weighted_sum += (uint64_t)position * value;
+    
+    // EWMA: seed with the first sample, then ewma += (value - ewma) / 2^k
+    if (fill == 0) {
+        stats->ewma = value;
+    } else if (value >= stats->ewma) {
+        stats->ewma += (value - stats->ewma) >> AI_EWMA_SHIFT;
+    } else {
+        stats->ewma -= (stats->ewma - value) >> AI_EWMA_SHIFT;
+    }
+    
+    ai_change_update(&stats->change, value);
 }
 
 /*
- * Update pattern statistics
+ * Derive mean, variance, least-squares slope and trend from running sums
  */
-void ai_update_pattern_statistics(behavior_pattern_t* pattern)
+void ai_metric_finalize(ai_metric_stats_t* stats, uint32_t samples)
 {
-    if (!pattern) return;
+    if (samples == 0) return;
+    
+    uint64_t mean = ai_div64(stats->sum, samples);
+    uint64_t mean_square = ai_div64(stats->sum_squares, samples);
+    uint64_t variance = (mean_square > mean * mean) ? mean_square - mean * mean : 0;
     
-    // Calculate mean memory usage
-    uint32_t sum = 0;
-    for (int i = 0; i < AI_ANALYSIS_WINDOW; i++) {
-        sum += pattern->memory_usage[i];
+    stats->mean = (mean > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)mean;
+    stats->variance = (variance > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)variance;
+    
+    if (samples < 2) {
+        stats->slope = 0;
+        stats->trend = AI_TREND_STABLE;
+        return;
     }
-    pattern->mean_memory = sum / AI_ANALYSIS_WINDOW;
     
-    // Calculate variance (simplified)
-    uint32_t variance = 0;
-    for (int i = 0; i < AI_ANALYSIS_WINDOW; i++) {
-        uint32_t diff = (pattern->memory_usage[i] > pattern->mean_memory) ?
-                        (pattern->memory_usage[i] - pattern->mean_memory) :
-                        (pattern->mean_memory - pattern->memory_usage[i]);
-        variance += diff * diff;
+    // slope = (n*Sxy - Sx*Sy) / (n*Sxx - Sx^2) with x = 0..n-1, where the
+    // denominator reduces to n^2 (n^2 - 1) / 12
+    uint32_t n = samples;
+    uint32_t sum_x = n * (n - 1) / 2;
+    uint32_t denominator = n * n * (n * n - 1) / 12;
+    int64_t numerator = (int64_t)(n * stats->weighted_sum) - (int64_t)(sum_x * stats->sum);
+    
+    int64_t slope;
+    if (numerator >= 0) {
+        slope = (int64_t)ai_div64((uint64_t)numerator, denominator);
+    } else {
+        slope = -(int64_t)ai_div64((uint64_t)(-numerator), denominator);
     }
-    pattern->variance_memory = variance / AI_ANALYSIS_WINDOW;
     
-    // Calculate trend (simplified: last value vs first value)
-    if (pattern->memory_usage[0] > pattern->memory_usage[AI_ANALYSIS_WINDOW-1]) {
-        pattern->trend_memory = 1; // Increasing
-    } else if (pattern->memory_usage[0] < pattern->memory_usage[AI_ANALYSIS_WINDOW-1]) {
-        pattern->trend_memory = 2; // Decreasing
+    if (slope > 0x7FFFFFFF) slope = 0x7FFFFFFF;
+    if (slope < -0x7FFFFFFF) slope = -0x7FFFFFFF;
+    stats->slope = (int32_t)slope;
+    
+    // Trend is significant when the fitted change across the window
+    // exceeds 1/16 of the mean
+    int64_t change = slope * (int64_t)(n - 1);
+    int64_t threshold = (int64_t)(stats->mean >> 4);
+    
+    if (change > threshold) {
+        stats->trend = AI_TREND_INCREASING;
+    } else if (change < -threshold) {
+        stats->trend = AI_TREND_DECREASING;
     } else {
-        pattern->trend_memory = 0; // Stable
+        stats->trend = AI_TREND_STABLE;
     }
 }
 
+/*
+ * Update incremental anomaly counters for a new sample. Must run before
+ * the sample is pushed, while the leaving samples are still in the ring.
+ */
+void ai_update_window_counters(behavior_pattern_t* pattern, uint32_t memory_usage,
+                               uint32_t cpu_usage, uint32_t msg_count)
+{
+    uint32_t fill = pattern->window_fill;
+    
+    // Memory increases between adjacent samples
+    if (fill == AI_ANALYSIS_WINDOW &&
+        ai_window_sample(pattern, pattern->memory_usage, &pattern->memory_stats, AI_ANALYSIS_WINDOW - 2) >
+        ai_window_sample(pattern, pattern->memory_usage, &pattern->memory_stats, AI_ANALYSIS_WINDOW - 1)) {
+        pattern->memory_increases--;
+    }
+    if (fill > 0 && memory_usage > ai_window_sample(pattern, pattern->memory_usage, &pattern->memory_stats, 0)) {
+        pattern->memory_increases++;
+    }
+    
+    // High CPU / idle message counts over the recent window
+    if (fill >= AI_RECENT_WINDOW) {
+        if (ai_window_sample(pattern, pattern->cpu_usage, &pattern->cpu_stats, AI_RECENT_WINDOW - 1) > 80) {
+            pattern->recent_high_cpu--;
+        }
+        if (ai_window_sample(pattern, pattern->message_count, &pattern->message_stats, AI_RECENT_WINDOW - 1) == 0) {
+            pattern->recent_idle_msgs--;
+        }
+    }
+    if (cpu_usage > 80) pattern->recent_high_cpu++;
+    if (msg_count == 0) pattern->recent_idle_msgs++;
+}
+
 /*
  * Calculate anomaly score for pattern
  */
@@ -530,65 +1393,234 @@ uint32_t ai_calculate_anomaly_score(behavior_pattern_t* pattern)
     
     uint32_t score = 0;
     
+    ai_metric_stats_t* memory = &pattern->memory_stats;
+    
     // High variance indicates anomalous behavior
-    if (pattern->variance_memory > pattern->mean_memory / 2) {
+    if (memory->variance > memory->mean / 2) {
         score += 30;
     }
     
     // Consistently increasing memory usage
-    if (pattern->trend_memory == 1 && pattern->mean_memory > 1024 * 1024) { // > 1MB
+    if (memory->trend == AI_TREND_INCREASING && memory->mean > 1024 * 1024) { // > 1MB
         score += 40;
     }
     
     // Very high memory usage
-    if (pattern->mean_memory > 10 * 1024 * 1024) { // > 10MB
+    if (memory->mean > 10 * 1024 * 1024) { // > 10MB
         score += 30;
     }
     
+    // Model classification
+    if (pattern->pattern_class == AI_CLASS_ANOMALOUS) {
+        score += pattern->confidence / 2;
+    } else if (pattern->pattern_class == AI_CLASS_SUSPICIOUS) {
+        score += pattern->confidence / 5;
+    }
+    
     return (score > 100) ? 100 : score;
 }
 
 // =============================================================================
-// Anomaly Type Checkers
+// Change-Point Detection
 // =============================================================================
 
 /*
- * Check for memory leak pattern
+ * Reset a change-point detector to its warm-up state
  */
-bool ai_check_memory_leak(behavior_pattern_t* pattern)
+void ai_change_reset(ai_change_detector_t* detector)
 {
-    if (!pattern || pattern->observation_count < 10) return false;
+    detector->mean = 0;
+    detector->variance = 0;
+    detector->sigma = 1;
+    detector->cusum_high = 0;
+    detector->cusum_low = 0;
+    detector->samples = 0;
+    detector->alarms = 0;
+    detector->alarm = AI_CHANGE_NONE;
+    detector->confidence = 0;
+    detector->deviation = 0;
+    detector->alarm_value = 0;
+    detector->alarm_expected = 0;
+}
+
+/*
+ * Feed one sample to a change-point detector in O(1). The first
+ * AI_CHANGE_WARMUP samples seed the baseline with a plain running mean
+ * and variance. After that each sample's deviation from the baseline,
+ * in sigmas, drives the two CUSUMs before the baseline EWMAs absorb the
+ * sample. On an alarm the mean warms up again from the new level so one
+ * shift is reported once.
+ */
+void ai_change_update(ai_change_detector_t* detector, uint32_t value)
+{
+    int64_t sample = (int64_t)value << 8;
+    int64_t diff = sample - detector->mean;
+    
+    // Whole-unit deviation for the variance, clamped so its square fits
+    int64_t units = diff >> 8;
+    if (units > 0x7FFFFFFF) units = 0x7FFFFFFF;
+    if (units < -0x7FFFFFFF) units = -0x7FFFFFFF;
+    
+    if (detector->samples < AI_CHANGE_WARMUP) {
+        detector->samples++;
+        if (detector->samples == 1) {
+            detector->mean = sample;
+            detector->variance = 0;
+        } else {
+            int64_t square_diff = units * units - (int64_t)detector->variance;
+            detector->mean += ai_sdiv64(diff, detector->samples);
+            
+            // After an alarm only the level is re-learned; the noise
+            // estimate carries over
+            if (detector->alarms == 0) {
+                detector->variance += ai_sdiv64(square_diff, detector->samples);
+            }
+        }
+    } else {
+        // Deviation in Q8 sigmas, clamped so one outlier cannot dominate
+        int64_t z = ai_sdiv64(diff, detector->sigma);
+        if (z > AI_CHANGE_MAX_Z) z = AI_CHANGE_MAX_Z;
+        if (z < -AI_CHANGE_MAX_Z) z = -AI_CHANGE_MAX_Z;
+        
+        int64_t high = (int64_t)detector->cusum_high + z - AI_CHANGE_SLACK;
+        int64_t low = (int64_t)detector->cusum_low - z - AI_CHANGE_SLACK;
+        detector->cusum_high = (high > 0) ? (uint32_t)high : 0;
+        detector->cusum_low = (low > 0) ? (uint32_t)low : 0;
+        
+        uint32_t threshold = kernel_ai_supervisor.change_threshold;
+        if (detector->cusum_high > threshold || detector->cusum_low > threshold) {
+            uint32_t cusum = (detector->cusum_high > detector->cusum_low) ?
+                             detector->cusum_high : detector->cusum_low;
+            
+            detector->alarm = (detector->cusum_high > detector->cusum_low) ?
+                              AI_CHANGE_UP : AI_CHANGE_DOWN;
+            detector->confidence = (uint8_t)ai_change_confidence(cusum);
+            detector->deviation = (cusum > 0xFFFF) ? 0xFFFF : (uint16_t)cusum;
+            detector->alarm_value = value;
+            detector->alarm_expected = (uint32_t)(detector->mean >> 8);
+            
+            detector->alarms++;
+            detector->cusum_high = 0;
+            detector->cusum_low = 0;
+            detector->mean = sample;
+            detector->samples = 1;
+        } else {
+            int64_t square_diff = units * units - (int64_t)detector->variance;
+            detector->mean += diff >> AI_CHANGE_EWMA_SHIFT;
+            detector->variance += square_diff >> AI_CHANGE_EWMA_SHIFT;
+        }
+    }
+    
+    // Floor sigma at 1/64 of the level so a flat series does not turn
+    // tiny wobbles into large deviations
+    uint32_t floor = (uint32_t)((detector->mean > 0 ? detector->mean : 0) >> 14) + 1;
+    uint32_t sigma = ai_isqrt64(detector->variance);
+    detector->sigma = (sigma > floor) ? sigma : floor;
+}
+
+/*
+ * Confidence for a CUSUM value in Q8 sigmas. With k = 0.5 the in-control
+ * CUSUM tail is about P(S > s) = e^-s, so confidence is 100 (1 - e^-s),
+ * evaluated from e^-n and e^-(n/8) tables in Q16.
+ */
+uint32_t ai_change_confidence(uint32_t cusum)
+{
+    static const uint32_t exp_whole[8] = {
+        65536, 24109, 8869, 3263, 1200, 442, 162, 60
+    };
+    static const uint32_t exp_eighth[8] = {
+        65536, 57835, 51039, 45042, 39750, 35079, 30957, 27319
+    };
+    
+    uint32_t eighths = cusum >> 5;
+    if (eighths >= 8 * 8) return 99;
     
-    // Check if memory usage is consistently increasing
-    uint32_t increases = 0;
-    for (int i = 1; i < AI_ANALYSIS_WINDOW; i++) {
-        if (pattern->memory_usage[i-1] > pattern->memory_usage[i]) {
-            increases++;
+    uint32_t tail = (exp_whole[eighths >> 3] * exp_eighth[eighths & 7]) >> 16;
+    uint32_t confidence = 100 - ((tail * 100) >> 16);
+    
+    return (confidence > 99) ? 99 : confidence;
+}
+
+/*
+ * CUSUM threshold (Q8 sigmas) giving about 'samples' samples between
+ * false alarms, interpolated from ai_change_arl_table
+ */
+uint32_t ai_change_threshold_for_arl(uint32_t samples)
+{
+    if (samples <= ai_change_arl_table[0].run_length) {
+        return ai_change_arl_table[0].threshold;
+    }
+    
+    for (uint32_t i = 1; i < AI_CHANGE_ARL_POINTS; i++) {
+        uint32_t upper = ai_change_arl_table[i].run_length;
+        if (samples <= upper) {
+            uint32_t lower = ai_change_arl_table[i - 1].run_length;
+            uint32_t base = ai_change_arl_table[i - 1].threshold;
+            uint32_t step = ai_change_arl_table[i].threshold - base;
+            return base + (step * (samples - lower)) / (upper - lower);
         }
     }
     
-    // If more than 70% of samples show increase, likely a leak
-    return (increases > (AI_ANALYSIS_WINDOW * 7 / 10));
+    return ai_change_arl_table[AI_CHANGE_ARL_POINTS - 1].threshold;
 }
 
 /*
- * Check for CPU spike
+ * Attach a latched change point to a reported anomaly
  */
-bool ai_check_cpu_spike(behavior_pattern_t* pattern)
+void ai_change_annotate(anomaly_detection_t* anomaly, const ai_change_detector_t* detector)
 {
-    if (!pattern || pattern->observation_count < 5) return false;
+    if (!anomaly || detector->alarm == AI_CHANGE_NONE) return;
     
-    // Check if recent CPU usage is much higher than average
-    uint32_t recent_avg = (pattern->cpu_usage[0] + pattern->cpu_usage[1] + pattern->cpu_usage[2]) / 3;
-    uint32_t historical_avg = 0;
+    anomaly->confidence = detector->confidence;
+    anomaly->metric_value = detector->alarm_value;
+    anomaly->expected_value = detector->alarm_expected;
+    anomaly->deviation = detector->deviation;
+}
+
+/*
+ * Clear latched change points once detection has evaluated them
+ */
+void ai_change_acknowledge(behavior_pattern_t* pattern)
+{
+    pattern->memory_stats.change.alarm = AI_CHANGE_NONE;
+    pattern->cpu_stats.change.alarm = AI_CHANGE_NONE;
+    pattern->io_stats.change.alarm = AI_CHANGE_NONE;
+    pattern->message_stats.change.alarm = AI_CHANGE_NONE;
+}
+
+// =============================================================================
+// Anomaly Type Checkers
+// =============================================================================
+
+/*
+ * Check for memory leak pattern
+ */
+bool ai_check_memory_leak(behavior_pattern_t* pattern)
+{
+    if (!pattern) return false;
     
-    for (int i = 3; i < AI_ANALYSIS_WINDOW; i++) {
-        historical_avg += pattern->cpu_usage[i];
+    // Upward change point while the window trend is rising
+    if (pattern->memory_stats.change.alarm == AI_CHANGE_UP &&
+        pattern->memory_stats.trend == AI_TREND_INCREASING) {
+        return true;
     }
-    historical_avg /= (AI_ANALYSIS_WINDOW - 3);
     
-    // Spike if recent usage is 3x historical average
-    return (recent_avg > historical_avg * 3 && recent_avg > 50);
+    if (pattern->observation_count < 10) return false;
+    
+    // If more than 70% of adjacent samples show an increase, likely a leak
+    uint32_t pairs = pattern->window_fill - 1;
+    return (pattern->memory_increases > (pairs * 7 / 10));
+}
+
+/*
+ * Check for CPU spike: an upward change point to a busy level
+ */
+bool ai_check_cpu_spike(behavior_pattern_t* pattern)
+{
+    if (!pattern) return false;
+    
+    ai_change_detector_t* cpu = &pattern->cpu_stats.change;
+    return (cpu->alarm == AI_CHANGE_UP && cpu->alarm_value > 50);
 }
 
 /*
@@ -596,19 +1628,19 @@ bool ai_check_cpu_spike(behavior_pattern_t* pattern)
  */
 bool ai_check_infinite_loop(behavior_pattern_t* pattern)
 {
-    if (!pattern || pattern->observation_count < 10) return false;
-    
-    // Check for high CPU usage with no message activity
-    uint32_t high_cpu_count = 0;
-    uint32_t no_msg_count = 0;
+    if (!pattern) return false;
     
-    for (int i = 0; i < 10; i++) { // Check recent 10 samples
-        if (pattern->cpu_usage[i] > 80) high_cpu_count++;
-        if (pattern->message_count[i] == 0) no_msg_count++;
+    // CPU jumped to saturation while message handling dropped off
+    if (pattern->cpu_stats.change.alarm == AI_CHANGE_UP &&
+        pattern->cpu_stats.change.alarm_value > 80 &&
+        pattern->message_stats.change.alarm == AI_CHANGE_DOWN) {
+        return true;
     }
     
-    // Likely infinite loop if high CPU and no messages
-    return (high_cpu_count > 7 && no_msg_count > 7);
+    if (pattern->observation_count < 10) return false;
+    
+    // Likely infinite loop if recent samples show high CPU and no messages
+    return (pattern->recent_high_cpu > 7 && pattern->recent_idle_msgs > 7);
 }
 
 /*
@@ -619,7 +1651,7 @@ bool ai_check_resource_abuse(behavior_pattern_t* pattern)
     if (!pattern) return false;
     
     // Check if entity is using excessive resources consistently
-    return (pattern->mean_memory > 50 * 1024 * 1024 || // > 50MB
+    return (pattern->memory_stats.mean > 50 * 1024 * 1024 || // > 50MB
             pattern->anomaly_score > 80);
 }
 
@@ -635,43 +1667,240 @@ void ai_process_anomalies(void)
     }
 }
 
+/*
+ * Built-in pattern model: 4 features -> 4 hidden -> 3 classes.
+ * Each hidden unit passes its feature's relative deviation above 0.25;
+ * the output layer splits the summed excess into normal (< 0.25),
+ * suspicious, and anomalous (> 1.0).
+ */
+static const struct {
+    ai_model_blob_header_t header;
+    int8_t          weights[4 * 4 + 3 * 4];
+    int32_t         bias[4 + 3];
+} __attribute__((packed)) ai_default_model_blob = {
+    .header = {
+        .magic = AI_MODEL_BLOB_MAGIC,
+        .version = AI_MODEL_BLOB_VERSION,
+        .model_type = AI_MODEL_MLP,
+        .feature_count = 4,
+        .hidden_count = 4,
+        .class_count = 3,
+        .accuracy = 85,
+        .weight_scale = { AI_FIXED_ONE / 127, 2 * AI_FIXED_ONE / 127 },
+        .name = "DefaultPatternRecognition",
+    },
+    .weights = {
+        127, 0, 0, 0,       // hidden: memory
+        0, 127, 0, 0,       // hidden: cpu
+        0, 0, 127, 0,       // hidden: io
+        0, 0, 0, 127,       // hidden: messages
+        -64, -64, -64, -64, // normal
+        64, 64, 64, 64,     // suspicious
+        127, 127, 127, 127, // anomalous
+    },
+    .bias = {
+        -AI_FIXED_ONE / 4, -AI_FIXED_ONE / 4, -AI_FIXED_ONE / 4, -AI_FIXED_ONE / 4,
+        AI_FIXED_ONE / 2, 0, -AI_FIXED_ONE,
+    },
+};
+
 /*
  * Load default AI models
  */
 void ai_load_default_models(void)
 {
-    // Load simple pattern recognition model
-    ai_model_t* model = &kernel_ai_supervisor.models[0];
+    kernel_ai_supervisor.model_count = 0;
+    kernel_ai_supervisor.active_model = 0;
+    
+    if (!ai_load_model_blob(&ai_default_model_blob, sizeof(ai_default_model_blob))) {
+        kprintf("[AI] WARNING: Default model blob rejected\n");
+        return;
+    }
+    
+    kprintf("[AI] Loaded default AI models (%d model loaded)\n", kernel_ai_supervisor.model_count);
+}
+
+/*
+ * Load model from a serialized blob into the next model slot
+ */
+bool ai_load_model_blob(const void* blob, size_t size)
+{
+    const ai_model_blob_header_t* header = (const ai_model_blob_header_t*)blob;
+    
+    if (!blob || size < sizeof(ai_model_blob_header_t)) return false;
+    if (header->magic != AI_MODEL_BLOB_MAGIC || header->version != AI_MODEL_BLOB_VERSION) {
+        return false;
+    }
+    if (kernel_ai_supervisor.model_count >= 8) return false;
+    
+    // Validate shape
+    uint32_t features = header->feature_count;
+    uint32_t hidden = header->hidden_count;
+    uint32_t classes = header->class_count;
+    
+    if (features == 0 || features > AI_MODEL_MAX_FEATURES || classes < 2) return false;
+    if (header->model_type == AI_MODEL_LINEAR && hidden != 0) return false;
+    if (header->model_type == AI_MODEL_MLP && hidden == 0) return false;
+    if (header->model_type > AI_MODEL_MLP) return false;
+    
+    uint32_t first_outputs = hidden ? hidden : classes;
+    uint32_t weight_count = first_outputs * features + (hidden ? classes * hidden : 0);
+    uint32_t bias_count = first_outputs + (hidden ? classes : 0);
+    uint32_t weight_bytes = (weight_count + 3) & ~3u;
+    
+    if (weight_count > AI_MODEL_MAX_WEIGHTS || bias_count > AI_MODEL_MAX_BIAS) return false;
+    if (size < sizeof(ai_model_blob_header_t) + weight_bytes + bias_count * sizeof(int32_t)) {
+        return false;
+    }
+    
+    // Unpack parameters
+    uint32_t model_id = kernel_ai_supervisor.model_count;
+    ai_model_t* model = &kernel_ai_supervisor.models[model_id];
+    const uint8_t* payload = (const uint8_t*)blob + sizeof(ai_model_blob_header_t);
+    
+    for (uint32_t i = 0; i < weight_count; i++) {
+        model->weights[i] = (int8_t)payload[i];
+    }
+    
+    payload += weight_bytes;
+    for (uint32_t i = 0; i < bias_count; i++) {
+        const uint8_t* b = payload + i * 4;
+        model->bias[i] = (int32_t)((uint32_t)b[0] | ((uint32_t)b[1] << 8) |
+                                   ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24));
+    }
     
-    // Simple model name
-    const char* name = "DefaultPatternRecognition";
     uint32_t name_len = 0;
-    while (name_len < 63 && name[name_len] != '\0') {
-        model->model_name[name_len] = name[name_len];
+    while (name_len < sizeof(header->name) && header->name[name_len] != '\0') {
+        model->model_name[name_len] = header->name[name_len];
         name_len++;
     }
     model->model_name[name_len] = '\0';
     
-    model->model_id = 0;
-    model->model_type = 1; // Simple pattern recognition
-    model->model_version = 1;
-    model->feature_count = 4; // memory, cpu, io, messages
-    model->class_count = 3; // normal, suspicious, anomalous
-    model->training_samples = 1000; // Simulated
-    model->accuracy = 85;
+    model->model_id = model_id;
+    model->model_type = header->model_type;
+    model->model_version = (uint8_t)header->version;
+    model->weight_scale[0] = header->weight_scale[0];
+    model->weight_scale[1] = header->weight_scale[1];
+    model->feature_count = features;
+    model->hidden_count = hidden;
+    model->class_count = classes;
+    model->training_samples = 0;
+    model->accuracy = header->accuracy;
+    model->last_trained = 0;
     model->model_active = true;
     model->inference_count = 0;
-    model->inference_time_avg = 10; // 10ms average
+    model->inference_time_avg = 0;
+    
+    kernel_ai_supervisor.model_count++;
+    kernel_ai_supervisor.statistics.model_accuracy_avg = model->accuracy;
     
-    // Initialize simple weights (placeholder)
-    for (int i = 0; i < 256; i++) {
-        model->weights[i] = 1.0f / 256.0f;
+    return true;
+}
+
+/*
+ * Extract Q16.16 features: relative deviation of each metric's EWMA
+ * from its window mean, clamped to [0, 4]
+ */
+void ai_extract_features(behavior_pattern_t* pattern, int32_t* features)
+{
+    const ai_metric_stats_t* stats[AI_MODEL_MAX_FEATURES] = {
+        &pattern->memory_stats, &pattern->cpu_stats,
+        &pattern->io_stats, &pattern->message_stats
+    };
+    
+    for (uint32_t i = 0; i < AI_MODEL_MAX_FEATURES; i++) {
+        uint32_t ewma = stats[i]->ewma;
+        uint32_t mean = stats[i]->mean;
+        uint32_t deviation = (ewma > mean) ? ewma - mean : mean - ewma;
+        uint64_t ratio = ai_div64((uint64_t)deviation << AI_FIXED_SHIFT, mean + 1);
+        
+        features[i] = (ratio > 4 * AI_FIXED_ONE) ? 4 * AI_FIXED_ONE : (int32_t)ratio;
     }
+}
+
+/*
+ * Evaluate one dense layer: output = scale * (W . input) + bias, with
+ * optional ReLU. Returns the index of the largest output.
+ */
+int32_t ai_model_layer(const int8_t* weights, const int32_t* bias, int32_t scale,
+                       const int32_t* input, uint32_t inputs, int32_t* output,
+                       uint32_t outputs, bool relu)
+{
+    int32_t best = 0;
     
-    kernel_ai_supervisor.model_count = 1;
-    kernel_ai_supervisor.active_model = 0;
+    for (uint32_t o = 0; o < outputs; o++) {
+        int64_t acc = 0;
+        for (uint32_t i = 0; i < inputs; i++) {
+            acc += (int64_t)weights[o * inputs + i] * input[i];
+        }
+        
+        int64_t value = ((acc * scale) >> AI_FIXED_SHIFT) + bias[o];
+        if (value > 0x7FFFFFFF) value = 0x7FFFFFFF;
+        if (value < -0x7FFFFFFF) value = -0x7FFFFFFF;
+        if (relu && value < 0) value = 0;
+        
+        output[o] = (int32_t)value;
+        if (output[o] > output[best]) best = (int32_t)o;
+    }
     
-    kprintf("[AI] Loaded default AI models (1 model loaded)\n");
+    return best;
+}
+
+/*
+ * Perform AI inference on behavior pattern. Sets pattern->confidence
+ * from the margin between the two highest class scores.
+ */
+uint32_t ai_infer_pattern_class(behavior_pattern_t* pattern)
+{
+    if (!pattern || kernel_ai_supervisor.model_count == 0) return AI_CLASS_NORMAL;
+    
+    ai_model_t* model = &kernel_ai_supervisor.models[kernel_ai_supervisor.active_model];
+    if (!model->model_active) return AI_CLASS_NORMAL;
+    
+    uint64_t start = read_timestamp_counter();
+    
+    int32_t features[AI_MODEL_MAX_FEATURES];
+    int32_t hidden[AI_MODEL_MAX_BIAS];
+    int32_t scores[AI_MODEL_MAX_BIAS];
+    const int32_t* input = features;
+    uint32_t inputs = model->feature_count;
+    const int8_t* weights = model->weights;
+    const int32_t* bias = model->bias;
+    
+    ai_extract_features(pattern, features);
+    
+    if (model->hidden_count) {
+        ai_model_layer(weights, bias, model->weight_scale[0], input, inputs,
+                       hidden, model->hidden_count, true);
+        weights += model->hidden_count * inputs;
+        bias += model->hidden_count;
+        input = hidden;
+        inputs = model->hidden_count;
+    }
+    
+    int32_t scale = model->weight_scale[model->hidden_count ? 1 : 0];
+    uint32_t best = (uint32_t)ai_model_layer(weights, bias, scale, input, inputs,
+                                             scores, model->class_count, false);
+    
+    // Confidence: 50 at a tie, 100 once the margin reaches 1.0
+    int32_t runner_up = -0x7FFFFFFF;
+    for (uint32_t c = 0; c < model->class_count; c++) {
+        if (c != best && scores[c] > runner_up) runner_up = scores[c];
+    }
+    uint32_t margin = (uint32_t)(scores[best] - runner_up);
+    pattern->confidence = (margin >= AI_FIXED_ONE) ? 100 : 50 + ((margin * 50) >> AI_FIXED_SHIFT);
+    
+    // Average inference time in cycles (EWMA, alpha = 1/8)
+    uint32_t cycles = (uint32_t)(read_timestamp_counter() - start);
+    if (model->inference_count == 0) {
+        model->inference_time_avg = cycles;
+    } else {
+        model->inference_time_avg = model->inference_time_avg - (model->inference_time_avg >> 3) +
+                                    (cycles >> 3);
+    }
+    model->inference_count++;
+    
+    return best;
 }
 
 // =============================================================================
@@ -712,8 +1941,11 @@ void ai_print_status(void)
     kprintf("  Interventions: %d\n", (uint32_t)stats->interventions);
     kprintf("  Active patterns: %d\n", stats->active_patterns);
     kprintf("  Active anomalies: %d\n", stats->active_anomalies);
-    kprintf("  AI CPU usage: %d%%\n", stats->cpu_usage_percent);
+    kprintf("  AI CPU usage: %d%% (%d slices, budget %d cycles)\n", stats->cpu_usage_percent,
+            (uint32_t)stats->analysis_slices, kernel_ai_supervisor.cycle_budget);
     kprintf("  AI memory usage: %d KB\n", stats->memory_usage_kb);
+    kprintf("  Change-point threshold: %d/256 sigma (ARL %d samples)\n",
+            kernel_ai_supervisor.change_threshold, kernel_ai_supervisor.change_arl);
 }
 
 /*
@@ -732,15 +1964,19 @@ void ai_print_behavior_patterns(void)
     for (uint32_t i = 0; i < MAX_BEHAVIOR_PATTERNS; i++) {
         if (!kernel_ai_supervisor.pattern_active[i]) continue;
         
-        behavior_pattern_t* pattern = &kernel_ai_supervisor.patterns[i];
+        behavior_pattern_t* pattern = kernel_ai_supervisor.patterns[i];
         
         kprintf("  Pattern %d: Entity %d/%d\n", i, pattern->entity_type, pattern->entity_id);
         kprintf("    Memory: %d KB (avg), Anomaly Score: %d\n",
-                pattern->mean_memory / 1024, pattern->anomaly_score);
-        kprintf("    Observations: %d, Trend: %s\n",
+                pattern->memory_stats.mean / 1024, pattern->anomaly_score);
+        kprintf("    EWMA: mem %d KB, cpu %d, io %d, msgs %d\n",
+                pattern->memory_stats.ewma / 1024, pattern->cpu_stats.ewma,
+                pattern->io_stats.ewma, pattern->message_stats.ewma);
+        kprintf("    Observations: %d, Trend: %s (slope %d/sample)\n",
                 pattern->observation_count,
-                (pattern->trend_memory == 1) ? "INCREASING" :
-                (pattern->trend_memory == 2) ? "DECREASING" : "STABLE");
+                (pattern->memory_stats.trend == AI_TREND_INCREASING) ? "INCREASING" :
+                (pattern->memory_stats.trend == AI_TREND_DECREASING) ? "DECREASING" : "STABLE",
+                pattern->memory_stats.slope);
         
         found_patterns = true;
     }
@@ -784,6 +2020,34 @@ void ai_print_anomalies(void)
     }
 }
 
+/*
+ * Print AI model information
+ */
+void ai_print_models(void)
+{
+    if (!ai_supervisor_initialized) {
+        kprintf("[AI] AI Supervisor not initialized\n");
+        return;
+    }
+    
+    kprintf("[AI] Loaded Models:\n");
+    
+    for (uint32_t i = 0; i < kernel_ai_supervisor.model_count; i++) {
+        ai_model_t* model = &kernel_ai_supervisor.models[i];
+        
+        kprintf("  Model %d: %s (%s, %d-%d-%d)%s\n", model->model_id, model->model_name,
+                (model->model_type == AI_MODEL_MLP) ? "MLP" : "LINEAR",
+                model->feature_count, model->hidden_count, model->class_count,
+                (i == kernel_ai_supervisor.active_model) ? " [ACTIVE]" : "");
+        kprintf("    Accuracy: %d%%, Inferences: %d, Avg time: %d cycles\n",
+                model->accuracy, model->inference_count, model->inference_time_avg);
+    }
+    
+    if (kernel_ai_supervisor.model_count == 0) {
+        kprintf("  No models loaded\n");
+    }
+}
+
 // =============================================================================
 // Configuration Functions
 // =============================================================================
@@ -799,6 +2063,30 @@ void ai_set_enabled(bool enabled)
     }
 }
 
+/*
+ * Set per-slice cycle budget for incremental analysis
+ */
+void ai_set_cycle_budget(uint32_t cycles)
+{
+    if (ai_supervisor_initialized && cycles > 0) {
+        kernel_ai_supervisor.cycle_budget = cycles;
+        kprintf("[AI] Analysis budget: %d cycles/slice\n", cycles);
+    }
+}
+
+/*
+ * Set change-point false alarm rate as samples between false alarms
+ */
+void ai_set_change_false_alarm_rate(uint32_t samples)
+{
+    if (ai_supervisor_initialized && samples > 0) {
+        kernel_ai_supervisor.change_arl = samples;
+        kernel_ai_supervisor.change_threshold = ai_change_threshold_for_arl(samples);
+        kprintf("[AI] Change-point threshold: %d/256 sigma (1 false alarm per %d samples)\n",
+                kernel_ai_supervisor.change_threshold, samples);
+    }
+}
+
 /*
  * Enable/disable auto-intervention
  */
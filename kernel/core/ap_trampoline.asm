@@ -0,0 +1,96 @@
+; =============================================================================
+; CLKernel - Application Processor Trampoline
+; =============================================================================
+; File: ap_trampoline.asm
+; Purpose: Real-mode entry for APs woken by STARTUP IPIs
+;
+; smp_init() copies ap_trampoline_start..ap_trampoline_end to
+; SMP_TRAMPOLINE_ADDR and fills smp_trampoline_params_t at
+; SMP_TRAMPOLINE_PARAMS. The code runs from the copy, so every address
+; inside it goes through REL(). Each AP claims a CPU index, enters
+; protected mode (and paging, if the BSP has it on), switches to its
+; stack and calls smp_ap_main(index).
+; =============================================================================
+
+section .text
+
+; Must match smp.h
+%define SMP_TRAMPOLINE_ADDR     0x8000
+%define SMP_TRAMPOLINE_PARAMS   0x8F00
+%define SMP_MAX_CPUS            8
+
+; smp_trampoline_params_t offsets
+%define PARAM_CR3               (SMP_TRAMPOLINE_PARAMS + 0)
+%define PARAM_ENTRY             (SMP_TRAMPOLINE_PARAMS + 4)
+%define PARAM_STACKS            (SMP_TRAMPOLINE_PARAMS + 8)
+%define PARAM_NEXT_CPU          (SMP_TRAMPOLINE_PARAMS + 12)
+
+; Address of a trampoline label in the copy
+%define REL(label)              (SMP_TRAMPOLINE_ADDR + (label) - ap_trampoline_start)
+
+global ap_trampoline_start
+global ap_trampoline_end
+
+[BITS 16]
+ap_trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+
+    lgdt [REL(ap_gdt_descriptor)]
+
+    mov eax, cr0
+    or eax, 1                   ; PE
+    mov cr0, eax
+    jmp dword 0x08:REL(ap_protected_mode)
+
+[BITS 32]
+ap_protected_mode:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; Share the BSP's page tables (the LAPIC window lives there)
+    mov eax, [PARAM_CR3]
+    test eax, eax
+    jz .paging_done
+    mov cr3, eax
+    mov eax, cr0
+    or eax, 0x80000000          ; PG
+    mov cr0, eax
+.paging_done:
+
+    ; Claim a CPU index; extra CPUs park here
+    mov eax, 1
+    lock xadd [PARAM_NEXT_CPU], eax
+    cmp eax, SMP_MAX_CPUS
+    jae .park
+
+    mov ebx, [PARAM_STACKS]
+    mov esp, [ebx + eax * 4]
+    xor ebp, ebp
+
+    push eax                    ; smp_ap_main(cpu)
+    call [PARAM_ENTRY]
+
+.park:
+    cli
+    hlt
+    jmp .park
+
+; Flat code/data segments at the kernel's selectors (0x08, 0x10)
+align 8
+ap_gdt:
+    dq 0x0000000000000000
+    dq 0x00CF9A000000FFFF
+    dq 0x00CF92000000FFFF
+
+ap_gdt_descriptor:
+    dw ap_gdt_descriptor - ap_gdt - 1
+    dd REL(ap_gdt)
+
+ap_trampoline_end:
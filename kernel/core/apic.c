@@ -0,0 +1,292 @@
+/*
+ * =============================================================================
+ * CLKernel - Local APIC
+ * =============================================================================
+ * File: apic.c
+ * Purpose: Local APIC discovery, enable, inter-processor interrupts and
+ *          the per-CPU timer
+ *
+ * The BSP finds the APIC base in IA32_APIC_BASE and maps the register page
+ * once; the mapping is shared by every CPU because each one decodes the
+ * window to its own local APIC.
+ * =============================================================================
+ */
+
+#include "apic.h"
+#include "kernel.h"
+#include "paging.h"
+#include "percpu.h"
+
+// =============================================================================
+// Global Local APIC State
+// =============================================================================
+
+static volatile uint32_t* lapic_registers = NULL;
+static uint32_t lapic_physical_base = 0;
+
+// Called on every CPU's timer interrupt (same handler for all CPUs)
+static void (*lapic_timer_handler)(void) = NULL;
+
+// =============================================================================
+// CPU Feature Helpers
+// =============================================================================
+
+/*
+ * CPUID leaf 1, EDX bit 9: on-chip APIC
+ */
+static bool lapic_cpu_has_apic(void)
+{
+    uint32_t eax = 1, ebx, ecx, edx;
+    asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+    return (edx & (1 << 9)) != 0;
+}
+
+static uint64_t lapic_read_msr(uint32_t msr)
+{
+    uint32_t low, high;
+    asm volatile ("rdmsr" : "=a" (low), "=d" (high) : "c" (msr));
+    return ((uint64_t)high << 32) | low;
+}
+
+static void lapic_write_msr(uint32_t msr, uint64_t value)
+{
+    asm volatile ("wrmsr" : : "c" (msr), "a" ((uint32_t)value), "d" ((uint32_t)(value >> 32)));
+}
+
+// =============================================================================
+// Setup
+// =============================================================================
+
+/*
+ * Software-enable this CPU's local APIC and accept every interrupt
+ */
+static void lapic_enable(void)
+{
+    lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    lapic_write(LAPIC_REG_TPR, 0);
+    
+    // Timer stays quiet until someone starts it
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+
+    // Clear any error latched before we owned the APIC (ESR needs a write first)
+    lapic_write(LAPIC_REG_ESR, 0);
+    lapic_write(LAPIC_REG_ESR, 0);
+}
+
+/*
+ * Map and enable the BSP's local APIC
+ */
+bool lapic_init(void)
+{
+    if (!lapic_cpu_has_apic()) {
+        kprintf("[APIC] No local APIC, staying uniprocessor\n");
+        return false;
+    }
+
+    uint64_t base_msr = lapic_read_msr(LAPIC_MSR_BASE);
+    lapic_physical_base = (uint32_t)base_msr & 0xFFFFF000;
+    if (lapic_physical_base == 0) {
+        lapic_physical_base = LAPIC_DEFAULT_BASE;
+    }
+
+    // Re-enable globally in case the firmware left it off
+    if (!(base_msr & LAPIC_MSR_ENABLE)) {
+        lapic_write_msr(LAPIC_MSR_BASE, base_msr | LAPIC_MSR_ENABLE);
+    }
+
+    lapic_registers = (volatile uint32_t*)paging_map_io(lapic_physical_base, 4096);
+    if (!lapic_registers) {
+        kprintf("[APIC] Failed to map local APIC registers\n");
+        return false;
+    }
+
+    lapic_enable();
+
+    kprintf("[APIC] Local APIC at 0x%x, BSP APIC ID %d, version 0x%x\n",
+            lapic_physical_base, lapic_id(), lapic_read(LAPIC_REG_VERSION) & 0xFF);
+    return true;
+}
+
+/*
+ * Enable an application processor's local APIC (mapping already exists)
+ */
+void lapic_init_ap(void)
+{
+    if (lapic_registers) {
+        lapic_enable();
+    }
+}
+
+bool lapic_is_present(void)
+{
+    return lapic_registers != NULL;
+}
+
+// =============================================================================
+// Registers
+// =============================================================================
+
+uint32_t lapic_read(uint32_t reg)
+{
+    return lapic_registers[reg / 4];
+}
+
+void lapic_write(uint32_t reg, uint32_t value)
+{
+    lapic_registers[reg / 4] = value;
+}
+
+/*
+ * This CPU's local APIC ID (0 before the APIC is mapped)
+ */
+uint8_t lapic_id(void)
+{
+    if (!lapic_registers) {
+        return 0;
+    }
+    return (uint8_t)(lapic_read(LAPIC_REG_ID) >> 24);
+}
+
+/*
+ * Acknowledge the interrupt in service: one MMIO store
+ */
+void lapic_eoi(void)
+{
+    if (lapic_registers) {
+        lapic_write(LAPIC_REG_EOI, 0);
+    }
+}
+
+// =============================================================================
+// Local APIC Timer
+// =============================================================================
+
+/*
+ * CPUID leaf 1, ECX bit 24: the timer can fire on an absolute TSC value
+ */
+bool lapic_timer_has_tsc_deadline(void)
+{
+    uint32_t eax = 1, ebx, ecx, edx;
+    asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+    return (ecx & (1 << 24)) != 0;
+}
+
+/*
+ * Select this CPU's timer mode (LAPIC_TIMER_*, optionally LAPIC_LVT_MASKED);
+ * the timer does not run until armed
+ */
+void lapic_timer_configure(uint32_t mode)
+{
+    if (!lapic_registers) {
+        return;
+    }
+
+    lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+    lapic_write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+    lapic_write(LAPIC_REG_LVT_TIMER, mode | LAPIC_TIMER_VECTOR);
+}
+
+/*
+ * One-shot/periodic modes: count down from initial_count (0 stops the timer)
+ */
+void lapic_timer_arm(uint32_t initial_count)
+{
+    if (lapic_registers) {
+        lapic_write(LAPIC_REG_TIMER_INITIAL, initial_count);
+    }
+}
+
+/*
+ * TSC-deadline mode: interrupt once the TSC reaches tsc (0 disarms)
+ */
+void lapic_timer_arm_deadline(uint64_t tsc)
+{
+    // The LVT write that selected the mode must land before the MSR write
+    asm volatile ("mfence" : : : "memory");
+    lapic_write_msr(LAPIC_MSR_TSC_DEADLINE, tsc);
+}
+
+/*
+ * Mask the timer (lapic_timer_configure again before the next arm)
+ */
+void lapic_timer_stop(void)
+{
+    if (!lapic_registers) {
+        return;
+    }
+
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+}
+
+uint32_t lapic_timer_remaining(void)
+{
+    return lapic_registers ? lapic_read(LAPIC_REG_TIMER_CURRENT) : 0;
+}
+
+void lapic_timer_set_handler(void (*handler)(void))
+{
+    lapic_timer_handler = handler;
+}
+
+/*
+ * LAPIC_TIMER_VECTOR entry (from irq_handler). The EOI goes first: the
+ * handler may switch actors and not come back through here soon, and
+ * interrupts stay off until the stub returns anyway.
+ */
+void lapic_timer_interrupt(void)
+{
+    this_cpu_inc(irq_lapic_timer);
+    lapic_eoi();
+
+    if (lapic_timer_handler) {
+        lapic_timer_handler();
+    }
+}
+
+// =============================================================================
+// Inter-Processor Interrupts
+// =============================================================================
+
+/*
+ * Wait for the previous IPI to leave the ICR; false if it never did
+ */
+static bool lapic_wait_icr_idle(void)
+{
+    for (uint32_t spins = 0; spins < 1000000; spins++) {
+        if (!(lapic_read(LAPIC_REG_ICR_LOW) & LAPIC_ICR_PENDING)) {
+            return true;
+        }
+        asm volatile ("pause");
+    }
+    return false;
+}
+
+/*
+ * Send an IPI to one APIC ID; command is the ICR low word
+ */
+bool lapic_send_ipi(uint8_t apic_id, uint32_t command)
+{
+    if (!lapic_registers) {
+        return false;
+    }
+
+    lapic_write(LAPIC_REG_ICR_HIGH, (uint32_t)apic_id << 24);
+    lapic_write(LAPIC_REG_ICR_LOW, command);
+    return lapic_wait_icr_idle();
+}
+
+/*
+ * Send an IPI to every CPU but this one
+ */
+bool lapic_broadcast_ipi(uint32_t command)
+{
+    if (!lapic_registers) {
+        return false;
+    }
+
+    lapic_write(LAPIC_REG_ICR_HIGH, 0);
+    lapic_write(LAPIC_REG_ICR_LOW, command | LAPIC_ICR_ALL_EXCLUDING_SELF);
+    return lapic_wait_icr_idle();
+}
@@ -0,0 +1,345 @@
+/*
+ * =============================================================================
+ * CLKernel - Per-CPU Scheduler Timer
+ * =============================================================================
+ * File: cpu_timer.c
+ * Purpose: Local APIC timer calibration and one-shot/TSC-deadline event
+ *          programming for scheduler ticks and timeslices
+ *
+ * Deadlines are kept in TSC cycles. Re-arming is one MMIO write (one-shot)
+ * or one WRMSR (TSC-deadline), and is skipped when the earliest deadline
+ * did not change, so a context switch usually costs no timer access at all
+ * beyond moving the slice end.
+ * =============================================================================
+ */
+
+#include "cpu_timer.h"
+#include "kernel.h"
+#include "apic.h"
+#include "scheduler.h"
+
+// =============================================================================
+// Global Timer State
+// =============================================================================
+
+static cpu_timer_state_t cpu_timer_state;
+
+// PIT channel 2 (gated through the keyboard controller's port B)
+#define PIT_FREQUENCY               1193182
+#define PIT_CHANNEL2_DATA           0x42
+#define PIT_COMMAND                 0x43
+#define PIT_CHANNEL2_ONESHOT        0xB0    // Channel 2, lobyte/hibyte, mode 0
+#define PIT_PORT_B                  0x61
+#define PIT_PORT_B_GATE2            0x01    // Channel 2 counts while set
+#define PIT_PORT_B_SPEAKER          0x02    // Speaker data enable (kept off)
+#define PIT_PORT_B_OUT2             0x20    // Channel 2 output (high at terminal count)
+
+// Port reads take ~1us; a PIT that never reaches zero is given ~1s
+#define CPU_TIMER_CALIBRATE_SPINS   1000000
+
+// =============================================================================
+// Conversion Helpers
+// =============================================================================
+
+/*
+ * Microseconds to TSC cycles, in 32-bit arithmetic
+ */
+static uint32_t cpu_timer_us_to_cycles(uint32_t us)
+{
+    uint32_t per_ms = cpu_timer_state.tsc_per_ms;
+    return (per_ms / 1000) * us + (per_ms % 1000) * us / 1000;
+}
+
+/*
+ * (numerator << 32) / denominator for numerator < denominator
+ */
+static uint32_t cpu_timer_fraction(uint32_t numerator, uint32_t denominator)
+{
+    uint32_t quotient, remainder;
+
+    // numerator < denominator, so the 64/32 divide cannot overflow
+    asm ("divl %2" : "=a" (quotient), "=d" (remainder)
+                   : "rm" (denominator), "a" (0), "d" (numerator));
+    return quotient;
+}
+
+/*
+ * Is this CPU running an actor? (APs stop ticking when it is not)
+ */
+static bool cpu_timer_cpu_busy(void)
+{
+    actor_t* current = scheduler_this_cpu()->current_actor;
+    return current && current->state == ACTOR_STATE_RUNNING;
+}
+
+// =============================================================================
+// Calibration
+// =============================================================================
+
+/*
+ * Count local APIC timer ticks and TSC cycles across CPU_TIMER_CALIBRATE_MS
+ * of PIT channel 2 (BSP, interrupts off)
+ */
+static bool cpu_timer_calibrate(void)
+{
+    uint32_t pit_count = PIT_FREQUENCY / 1000 * CPU_TIMER_CALIBRATE_MS;
+    uint8_t port_b = inb(PIT_PORT_B);
+
+    // Gate low while loading the count, speaker off throughout
+    outb(PIT_PORT_B, port_b & ~(PIT_PORT_B_GATE2 | PIT_PORT_B_SPEAKER));
+    outb(PIT_COMMAND, PIT_CHANNEL2_ONESHOT);
+    outb(PIT_CHANNEL2_DATA, pit_count & 0xFF);
+    outb(PIT_CHANNEL2_DATA, (pit_count >> 8) & 0xFF);
+
+    lapic_timer_configure(LAPIC_TIMER_ONESHOT | LAPIC_LVT_MASKED);
+    lapic_timer_arm(0xFFFFFFFF);
+    uint64_t tsc_start = read_timestamp_counter();
+
+    outb(PIT_PORT_B, (port_b & ~PIT_PORT_B_SPEAKER) | PIT_PORT_B_GATE2);
+
+    uint32_t spins = 0;
+    while (!(inb(PIT_PORT_B) & PIT_PORT_B_OUT2) && spins < CPU_TIMER_CALIBRATE_SPINS) {
+        spins++;
+    }
+
+    uint64_t tsc_elapsed = read_timestamp_counter() - tsc_start;
+    uint32_t lapic_elapsed = 0xFFFFFFFF - lapic_timer_remaining();
+
+    lapic_timer_stop();
+    outb(PIT_PORT_B, port_b);
+
+    if (spins >= CPU_TIMER_CALIBRATE_SPINS) {
+        kprintf("[CPUTIMER] PIT channel 2 never expired, cannot calibrate\n");
+        return false;
+    }
+
+    uint32_t tsc_cycles = tsc_elapsed > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)tsc_elapsed;
+    cpu_timer_state.tsc_per_ms = tsc_cycles / CPU_TIMER_CALIBRATE_MS;
+    cpu_timer_state.lapic_per_ms = lapic_elapsed / CPU_TIMER_CALIBRATE_MS;
+
+    // The divided APIC clock is always slower than the TSC
+    if (!cpu_timer_state.lapic_per_ms ||
+        cpu_timer_state.lapic_per_ms >= cpu_timer_state.tsc_per_ms) {
+        kprintf("[CPUTIMER] Implausible rates: TSC %d kHz, APIC timer %d kHz\n",
+                cpu_timer_state.tsc_per_ms, cpu_timer_state.lapic_per_ms);
+        return false;
+    }
+
+    cpu_timer_state.lapic_per_cycle =
+        cpu_timer_fraction(cpu_timer_state.lapic_per_ms, cpu_timer_state.tsc_per_ms);
+    cpu_timer_state.tick_cycles = cpu_timer_us_to_cycles(SCHEDULER_TICK_US);
+    cpu_timer_state.slice_cycles = cpu_timer_us_to_cycles(SCHEDULER_TIMESLICE_US);
+    return true;
+}
+
+// =============================================================================
+// Event Programming
+// =============================================================================
+
+/*
+ * Arm this CPU's timer for its earliest deadline (interrupts off)
+ */
+static void cpu_timer_program(cpu_timer_cpu_t* timer, uint64_t now)
+{
+    uint64_t deadline = timer->ticking ? timer->next_tick : 0;
+    if (timer->slice_end && (!deadline || timer->slice_end < deadline)) {
+        deadline = timer->slice_end;
+    }
+
+    if (deadline == timer->armed) {
+        return;
+    }
+    timer->armed = deadline;
+    timer->reprograms++;
+
+    if (cpu_timer_state.tsc_deadline) {
+        lapic_timer_arm_deadline(deadline);
+        return;
+    }
+
+    if (!deadline) {
+        lapic_timer_arm(0);
+        return;
+    }
+
+    // Already due: fire as soon as possible rather than not at all
+    uint64_t delta = deadline > now ? deadline - now : 0;
+    uint32_t cycles = delta > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)delta;
+    uint32_t count = (uint32_t)(((uint64_t)cycles * cpu_timer_state.lapic_per_cycle) >> 32);
+    lapic_timer_arm(count ? count : 1);
+}
+
+/*
+ * Local APIC timer interrupt: deliver due ticks, end an expired slice and
+ * arm the next event
+ */
+static void cpu_timer_interrupt(void)
+{
+    uint32_t self = smp_cpu_id();
+    cpu_timer_cpu_t* timer = &cpu_timer_state.cpus[self];
+    if (!timer->active) {
+        return;
+    }
+
+    uint64_t now = read_timestamp_counter();
+    timer->armed = 0;
+
+    // Normally one tick; after a long stall replay a few and resynchronize
+    uint32_t delivered = 0;
+    while (timer->ticking && now >= timer->next_tick) {
+        if (++delivered > CPU_TIMER_MAX_CATCHUP) {
+            timer->next_tick = now + cpu_timer_state.tick_cycles;
+            break;
+        }
+        timer->next_tick += cpu_timer_state.tick_cycles;
+        timer->ticks++;
+
+        // The BSP's ticks are the global tick count
+        if (self == 0) {
+            scheduler_timer_handler();
+        } else {
+            scheduler_cpu_tick();
+        }
+    }
+
+    if (timer->slice_end && now >= timer->slice_end) {
+        timer->slice_end = 0;
+        timer->slice_expiries++;
+        scheduler_timeslice_expired();
+
+        // Nobody else was ready: the same actor gets a fresh slice
+        if (!timer->slice_end && cpu_timer_cpu_busy()) {
+            timer->slice_end = now + cpu_timer_state.slice_cycles;
+        }
+    }
+
+    // An idle AP goes quiet until cpu_timer_slice_begin
+    if (self != 0 && !cpu_timer_cpu_busy()) {
+        timer->ticking = false;
+        timer->slice_end = 0;
+    }
+
+    cpu_timer_program(timer, now);
+}
+
+/*
+ * Called by the scheduler after switching this CPU to a new actor
+ */
+void cpu_timer_slice_begin(void)
+{
+    cpu_timer_cpu_t* timer = &cpu_timer_state.cpus[smp_cpu_id()];
+    if (!timer->active) {
+        return;
+    }
+
+    uint32_t flags = cpu_irq_save();
+    uint64_t now = read_timestamp_counter();
+
+    timer->slice_end = now + cpu_timer_state.slice_cycles;
+    if (!timer->ticking) {
+        timer->ticking = true;
+        timer->next_tick = now + cpu_timer_state.tick_cycles;
+    }
+    cpu_timer_program(timer, now);
+
+    cpu_irq_restore(flags);
+}
+
+// =============================================================================
+// Setup
+// =============================================================================
+
+/*
+ * Calibrate on the BSP (local APIC mapped, APs not started yet) and start
+ * the BSP's timer; false leaves every CPU on tick-driven slices
+ */
+bool cpu_timer_init(void)
+{
+    kprintf("[CPUTIMER] Calibrating local APIC timer against the PIT...\n");
+
+    uint32_t flags = cpu_irq_save();
+    bool calibrated = cpu_timer_calibrate();
+    cpu_irq_restore(flags);
+
+    if (!calibrated) {
+        return false;
+    }
+
+    cpu_timer_state.tsc_deadline = lapic_timer_has_tsc_deadline();
+    cpu_timer_state.calibrated = true;
+    lapic_timer_set_handler(cpu_timer_interrupt);
+
+    kprintf("[CPUTIMER] TSC %d kHz, APIC timer %d kHz, %s mode\n",
+            cpu_timer_state.tsc_per_ms, cpu_timer_state.lapic_per_ms,
+            cpu_timer_state.tsc_deadline ? "TSC-deadline" : "one-shot");
+    kprintf("[CPUTIMER] Tick %d us, timeslice %d us\n",
+            SCHEDULER_TICK_US, SCHEDULER_TIMESLICE_US);
+
+    cpu_timer_start_cpu();
+    return true;
+}
+
+/*
+ * Put the running CPU's slices and ticks on its local timer
+ */
+void cpu_timer_start_cpu(void)
+{
+    if (!cpu_timer_state.calibrated) {
+        return;
+    }
+
+    uint32_t self = smp_cpu_id();
+    cpu_timer_cpu_t* timer = &cpu_timer_state.cpus[self];
+
+    uint32_t flags = cpu_irq_save();
+
+    lapic_timer_configure(cpu_timer_state.tsc_deadline ? LAPIC_TIMER_TSC_DEADLINE
+                                                       : LAPIC_TIMER_ONESHOT);
+
+    uint64_t now = read_timestamp_counter();
+    timer->ticking = (self == 0);
+    timer->next_tick = now + cpu_timer_state.tick_cycles;
+    timer->slice_end = 0;
+    timer->armed = 0;
+    timer->active = true;
+
+    scheduler_this_cpu()->local_timer = true;
+    cpu_timer_program(timer, now);
+
+    cpu_irq_restore(flags);
+}
+
+// =============================================================================
+// Diagnostics
+// =============================================================================
+
+/*
+ * TSC rate for callers converting cycles to time (0 = not calibrated)
+ */
+uint32_t cpu_timer_tsc_per_ms(void)
+{
+    return cpu_timer_state.calibrated ? cpu_timer_state.tsc_per_ms : 0;
+}
+
+void cpu_timer_print_status(void)
+{
+    if (!cpu_timer_state.calibrated) {
+        kprintf("[CPUTIMER] Local timers not in use (slices end on scheduler ticks)\n");
+        return;
+    }
+
+    kprintf("[CPUTIMER] %s mode, tick %d us, timeslice %d us\n",
+            cpu_timer_state.tsc_deadline ? "TSC-deadline" : "One-shot",
+            SCHEDULER_TICK_US, SCHEDULER_TIMESLICE_US);
+
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        cpu_timer_cpu_t* timer = &cpu_timer_state.cpus[cpu];
+        if (!timer->active) {
+            continue;
+        }
+        kprintf("      CPU %d: %s, %d ticks, %d slice expiries, %d timer writes\n",
+                cpu, timer->ticking ? "ticking" : "idle",
+                (uint32_t)timer->ticks, (uint32_t)timer->slice_expiries,
+                (uint32_t)timer->reprograms);
+    }
+}
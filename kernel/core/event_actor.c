@@ -0,0 +1,335 @@
+/*
+ * =============================================================================
+ * CLKernel - Stackless Event Actors
+ * =============================================================================
+ * File: event_actor.c
+ * Purpose: Spawn, message delivery, handler dispatch and teardown for event
+ *          actors
+ *
+ * An event actor is on at most one CPU's event list at a time: the sender
+ * that makes its mailbox non-empty sets EVENT_ACTOR_QUEUED and pushes it,
+ * and the CPU running it clears the flag only when it finds the mailbox
+ * empty, both under mailbox_lock. So its handler never runs on two CPUs
+ * at once and no message is left behind without a run pending.
+ *
+ * Descriptors are reused as soon as they are released, while a sender
+ * that looked one up just before may still hold a pointer to it. That is
+ * why mailbox_lock is never re-initialized (table pages start zeroed,
+ * which is an unlocked lock) and why delivery checks, under the lock,
+ * that the descriptor still carries the recipient's ID.
+ * =============================================================================
+ */
+
+#include "event_actor.h"
+#include "kernel.h"
+#include "heap.h"
+#include "metrics.h"
+#include "percpu.h"
+#include "smp.h"
+
+extern scheduler_t kernel_scheduler;
+
+// =============================================================================
+// Global Event Actor State
+// =============================================================================
+
+static handle_table_t event_actor_table;
+static handle_slot_t* event_actor_pages[EVENT_ACTOR_MAX / HANDLE_PAGE_SIZE];
+static event_actor_stats_t event_actor_stats;
+
+// =============================================================================
+// Event Lists
+// =============================================================================
+
+/*
+ * Put an actor on a CPU's event list (a lock-free LIFO, taken all at once
+ * like the wake list) and make sure a halted CPU notices
+ */
+static void event_actor_push(event_actor_t* actor, uint32_t cpu)
+{
+    sched_cpu_t* target = &kernel_scheduler.cpus[cpu];
+    event_actor_t* head;
+
+    do {
+        head = target->event_list;
+        actor->run_next = head;
+    } while (!__sync_bool_compare_and_swap(&target->event_list, head, actor));
+
+    if (cpu != smp_cpu_id()) {
+        scheduler_kick_cpu(cpu);
+    }
+}
+
+/*
+ * Free queued messages and hand the slot back (its handle stops resolving)
+ */
+static void event_actor_release(event_actor_t* actor)
+{
+    uint32_t flags = spin_lock_irqsave(&actor->mailbox_lock);
+    message_t* message = actor->message_queue;
+    uint32_t actor_id = actor->actor_id;
+    actor->message_queue = NULL;
+    actor->message_tail = NULL;
+    actor->queue_size = 0;
+    spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+
+    while (message) {
+        message_t* next = message->next;
+        message_free(message);
+        message = next;
+    }
+
+    handle_table_free(&event_actor_table, actor_id);
+    __sync_fetch_and_add(&event_actor_stats.destroyed, 1);
+}
+
+/*
+ * One turn of an actor: handle up to EVENT_ACTOR_BATCH messages, then go
+ * to the back of the list if more are waiting
+ */
+static uint32_t event_actor_run(sched_cpu_t* cpu, event_actor_t* actor)
+{
+    uint32_t handled = 0;
+
+    for (;;) {
+        uint32_t flags = spin_lock_irqsave(&actor->mailbox_lock);
+
+        if (actor->flags & EVENT_ACTOR_DEAD) {
+            actor->flags &= ~EVENT_ACTOR_QUEUED;
+            spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+            event_actor_release(actor);
+            return handled;
+        }
+
+        message_t* message = actor->message_queue;
+        if (!message) {
+            actor->flags &= ~EVENT_ACTOR_QUEUED;
+            spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+            return handled;
+        }
+
+        if (handled == EVENT_ACTOR_BATCH) {
+            spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+            event_actor_push(actor, actor->cpu); // Still QUEUED
+            return handled;
+        }
+
+        actor->message_queue = message->next;
+        if (!actor->message_queue) {
+            actor->message_tail = NULL;
+        }
+        actor->queue_size--;
+        spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+
+        message->next = NULL;
+        cpu->current_event = actor->actor_id;
+        actor->handler(message, actor->state);
+        cpu->current_event = 0;
+
+        actor->messages_handled++;
+        message_free(message);
+        handled++;
+    }
+}
+
+// =============================================================================
+// Event Actor Functions
+// =============================================================================
+
+/*
+ * Set up the event actor table (pages are added on demand)
+ */
+void event_actor_init(void)
+{
+    handle_table_init(&event_actor_table, "event_actors", EVENT_ACTOR_ID_TAG,
+                      sizeof(event_actor_t), event_actor_pages,
+                      EVENT_ACTOR_MAX / HANDLE_PAGE_SIZE, NULL);
+
+    event_actor_stats.spawned = 0;
+    event_actor_stats.destroyed = 0;
+    event_actor_stats.refused = 0;
+
+    METRICS_PERCPU_COUNTER("sched.event_handlers", sched_event_handlers);
+    METRICS_COUNTER("sched.event_actors_spawned", event_actor_stats.spawned);
+    METRICS_GAUGE("sched.event_actors", event_actor_table.live);
+
+    kprintf("[SCHEDULER] Event actors: up to %d, %d bytes each\n", EVENT_ACTOR_MAX,
+            (uint32_t)(sizeof(event_actor_t) + sizeof(handle_slot_t)));
+}
+
+/*
+ * Create an event actor whose handler runs on the calling CPU. Unlike
+ * actor_create this does not log: there may be a hundred thousand.
+ */
+uint32_t event_actor_spawn(event_handler_t handler, void* state)
+{
+    if (!handler) {
+        return 0;
+    }
+
+    uint32_t actor_id;
+    event_actor_t* actor = (event_actor_t*)handle_table_alloc(&event_actor_table, &actor_id);
+    if (!actor) {
+        kprintf("[SCHEDULER] ERROR: No free event actor slots\n");
+        return 0;
+    }
+
+    // Under the lock: a stale sender may be holding it to check actor_id
+    uint32_t flags = spin_lock_irqsave(&actor->mailbox_lock);
+    actor->actor_id = actor_id;
+    actor->handler = handler;
+    actor->state = state;
+    actor->message_queue = NULL;
+    actor->message_tail = NULL;
+    actor->run_next = NULL;
+    actor->queue_size = 0;
+    actor->max_queue_size = EVENT_ACTOR_QUEUE_LIMIT;
+    actor->cpu = (uint8_t)smp_cpu_id();
+    actor->flags = 0;
+    actor->reserved = 0;
+    actor->messages_handled = 0;
+    spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+
+    handle_table_publish(&event_actor_table, actor_id);
+    __sync_fetch_and_add(&event_actor_stats.spawned, 1);
+    return actor_id;
+}
+
+/*
+ * Destroy an event actor. Its handle stops accepting messages at once;
+ * if its handler is running (or about to run) the descriptor is released
+ * when that run ends, so this is safe from its own handler.
+ */
+bool event_actor_destroy(uint32_t actor_id)
+{
+    event_actor_t* actor = (event_actor_t*)handle_table_lookup(&event_actor_table, actor_id);
+    if (!actor) {
+        return false;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&actor->mailbox_lock);
+    if (actor->actor_id != actor_id || (actor->flags & EVENT_ACTOR_DEAD)) {
+        spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+        return false;
+    }
+    actor->flags |= EVENT_ACTOR_DEAD;
+    bool queued = (actor->flags & EVENT_ACTOR_QUEUED) != 0;
+    spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+
+    if (!queued) {
+        event_actor_release(actor);
+    }
+    return true;
+}
+
+/*
+ * Look up a live event actor (NULL once destroyed)
+ */
+event_actor_t* event_actor_get(uint32_t actor_id)
+{
+    event_actor_t* actor = (event_actor_t*)handle_table_lookup(&event_actor_table, actor_id);
+    if (!actor || (actor->flags & EVENT_ACTOR_DEAD)) {
+        return NULL;
+    }
+    return actor;
+}
+
+/*
+ * Queue a message (recipient_id set) and schedule the actor if its
+ * mailbox was empty. Refused if the mailbox is full or the descriptor
+ * was destroyed or reused since the caller looked it up.
+ */
+bool event_actor_deliver(event_actor_t* actor, message_t* message)
+{
+    message->next = NULL;
+    message->queued_at = read_timestamp_counter();
+
+    uint32_t flags = spin_lock_irqsave(&actor->mailbox_lock);
+
+    if (actor->actor_id != message->recipient_id || (actor->flags & EVENT_ACTOR_DEAD) ||
+        actor->queue_size >= actor->max_queue_size) {
+        spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+        __sync_fetch_and_add(&event_actor_stats.refused, 1);
+        return false;
+    }
+
+    if (!actor->message_tail) {
+        actor->message_queue = message;
+    } else {
+        actor->message_tail->next = message;
+    }
+    actor->message_tail = message;
+    actor->queue_size++;
+
+    bool schedule = !(actor->flags & EVENT_ACTOR_QUEUED);
+    actor->flags |= EVENT_ACTOR_QUEUED;
+    uint32_t cpu = actor->cpu;
+
+    spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+
+    if (schedule) {
+        event_actor_push(actor, cpu);
+    }
+    return true;
+}
+
+/*
+ * Run every actor on this CPU's event list, oldest first. Actors queued
+ * while this runs (including by these handlers) wait for the next call.
+ */
+uint32_t event_actor_run_pending(void)
+{
+    sched_cpu_t* cpu = scheduler_this_cpu();
+    if (!cpu->event_list) {
+        return 0;
+    }
+
+    event_actor_t* list = __sync_lock_test_and_set(&cpu->event_list, NULL);
+
+    event_actor_t* ordered = NULL;
+    while (list) {
+        event_actor_t* next = list->run_next;
+        list->run_next = ordered;
+        ordered = list;
+        list = next;
+    }
+
+    uint32_t handled = 0;
+    while (ordered) {
+        event_actor_t* actor = ordered;
+        ordered = actor->run_next;
+        actor->run_next = NULL;
+        handled += event_actor_run(cpu, actor);
+    }
+
+    this_cpu_add(sched_event_handlers, handled);
+    this_cpu_add(sched_messages_delivered, handled);
+    return handled;
+}
+
+uint32_t event_actor_current(void)
+{
+    return scheduler_this_cpu()->current_event;
+}
+
+// =============================================================================
+// Statistics and Monitoring
+// =============================================================================
+
+event_actor_stats_t* event_actor_get_statistics(void)
+{
+    return &event_actor_stats;
+}
+
+uint32_t event_actor_count(void)
+{
+    return event_actor_table.live;
+}
+
+void event_actor_print_status(void)
+{
+    kprintf("  Event actors: %d live in %d pages, %d spawned, %d handler runs, %d refused\n",
+            event_actor_table.live, event_actor_table.capacity / HANDLE_PAGE_SIZE,
+            (uint32_t)event_actor_stats.spawned, (uint32_t)percpu_sum(sched_event_handlers),
+            (uint32_t)event_actor_stats.refused);
+}
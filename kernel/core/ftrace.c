@@ -0,0 +1,364 @@
+/*
+ * =============================================================================
+ * CLKernel - Function Entry/Exit Tracer
+ * =============================================================================
+ * File: ftrace.c
+ * Purpose: Per-CPU binary ring of function entry/exit events (make TRACE=1)
+ *
+ * The hooks take one mask test when their subsystem is disabled. When it
+ * is enabled they stamp a 24-byte record with interrupts held off; the ring
+ * overwrites its oldest records like a flight recorder. The dump is
+ * decoded on the host by tools/profiler/ftrace_report.py.
+ *
+ * This file is never built with -finstrument-functions itself.
+ * =============================================================================
+ */
+
+#include "ftrace.h"
+#include "kernel.h"
+#include "serial.h"
+#include "scheduler.h"
+
+#ifdef CONFIG_FTRACE
+
+extern scheduler_t kernel_scheduler;
+
+// Message passing lives in scheduler.c but is traced as its own subsystem
+message_t* message_allocate(void);
+bool actor_add_message(actor_t* actor, message_t* message);
+void actor_clear_message_queue(actor_t* actor);
+
+static void* const ftrace_ipc_functions[] = {
+    (void*)message_send_async,
+    (void*)message_receive,
+    (void*)message_wait,
+    (void*)message_free,
+    (void*)message_allocate,
+    (void*)actor_add_message,
+    (void*)actor_clear_message_queue,
+};
+
+#define FTRACE_IPC_FUNCTION_COUNT   (sizeof(ftrace_ipc_functions) / sizeof(ftrace_ipc_functions[0]))
+
+// =============================================================================
+// Global Tracer State
+// =============================================================================
+
+static ftrace_state_t ftrace_state;
+
+// =============================================================================
+// Recording
+// =============================================================================
+
+/*
+ * Save EFLAGS and disable interrupts
+ */
+static inline uint32_t ftrace_irq_save(void)
+{
+    uint32_t flags;
+    asm volatile ("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    return flags;
+}
+
+/*
+ * Restore the interrupt flag saved by ftrace_irq_save
+ */
+static inline void ftrace_irq_restore(uint32_t flags)
+{
+    asm volatile ("push %0; popf" : : "r" (flags) : "memory", "cc");
+}
+
+/*
+ * Append one record to this CPU's ring
+ */
+static void ftrace_record(uint8_t subsystem, uint8_t event, void* function, void* call_site)
+{
+    uint32_t index = smp_cpu_id();
+    if (index >= FTRACE_MAX_CPUS) {
+        return; // No ring for this CPU
+    }
+
+    uint32_t flags = ftrace_irq_save();
+
+    ftrace_cpu_t* cpu = &ftrace_state.cpus[index];
+    ftrace_record_t* record = &cpu->ring[cpu->head & (FTRACE_RING_SIZE - 1)];
+
+    record->timestamp = read_timestamp_counter();
+    record->function = (uint32_t)function;
+    record->call_site = (uint32_t)call_site;
+    actor_t* current = kernel_scheduler.cpus[index].current_actor;
+    record->actor_id = current ? current->actor_id : 0;
+    record->event = event;
+    record->subsystem = subsystem;
+    record->cpu = (uint16_t)index;
+
+    cpu->head++;
+    ftrace_state.events[subsystem]++;
+
+    ftrace_irq_restore(flags);
+}
+
+/*
+ * Split scheduler.c events into SCHED and IPC
+ */
+static uint8_t ftrace_sched_subsystem(void* function)
+{
+    for (uint32_t i = 0; i < FTRACE_IPC_FUNCTION_COUNT; i++) {
+        if (ftrace_ipc_functions[i] == function) {
+            return FTRACE_SUBSYS_IPC;
+        }
+    }
+    return FTRACE_SUBSYS_SCHED;
+}
+
+// =============================================================================
+// Instrumentation Hooks
+// =============================================================================
+
+void ftrace_enter_sched(void* function, void* call_site)
+{
+    uint32_t mask = ftrace_state.mask;
+    if (!(mask & (FTRACE_MASK(FTRACE_SUBSYS_SCHED) | FTRACE_MASK(FTRACE_SUBSYS_IPC)))) {
+        return;
+    }
+
+    uint8_t subsystem = ftrace_sched_subsystem(function);
+    if (mask & FTRACE_MASK(subsystem)) {
+        ftrace_record(subsystem, FTRACE_EVENT_ENTER, function, call_site);
+    }
+}
+
+void ftrace_exit_sched(void* function, void* call_site)
+{
+    uint32_t mask = ftrace_state.mask;
+    if (!(mask & (FTRACE_MASK(FTRACE_SUBSYS_SCHED) | FTRACE_MASK(FTRACE_SUBSYS_IPC)))) {
+        return;
+    }
+
+    uint8_t subsystem = ftrace_sched_subsystem(function);
+    if (mask & FTRACE_MASK(subsystem)) {
+        ftrace_record(subsystem, FTRACE_EVENT_EXIT, function, call_site);
+    }
+}
+
+void ftrace_enter_heap(void* function, void* call_site)
+{
+    if (ftrace_state.mask & FTRACE_MASK(FTRACE_SUBSYS_HEAP)) {
+        ftrace_record(FTRACE_SUBSYS_HEAP, FTRACE_EVENT_ENTER, function, call_site);
+    }
+}
+
+void ftrace_exit_heap(void* function, void* call_site)
+{
+    if (ftrace_state.mask & FTRACE_MASK(FTRACE_SUBSYS_HEAP)) {
+        ftrace_record(FTRACE_SUBSYS_HEAP, FTRACE_EVENT_EXIT, function, call_site);
+    }
+}
+
+void ftrace_enter_module(void* function, void* call_site)
+{
+    if (ftrace_state.mask & FTRACE_MASK(FTRACE_SUBSYS_MODULE)) {
+        ftrace_record(FTRACE_SUBSYS_MODULE, FTRACE_EVENT_ENTER, function, call_site);
+    }
+}
+
+void ftrace_exit_module(void* function, void* call_site)
+{
+    if (ftrace_state.mask & FTRACE_MASK(FTRACE_SUBSYS_MODULE)) {
+        ftrace_record(FTRACE_SUBSYS_MODULE, FTRACE_EVENT_EXIT, function, call_site);
+    }
+}
+
+// =============================================================================
+// Tracer Control
+// =============================================================================
+
+/*
+ * Initialize the tracer with every subsystem disabled
+ */
+void ftrace_init(void)
+{
+    ftrace_state.mask = 0;
+    ftrace_reset();
+    ftrace_state.initialized = true;
+
+    kprintf("[FTRACE] Function tracer ready (%d records x %d CPU ring)\n",
+            FTRACE_RING_SIZE, FTRACE_MAX_CPUS);
+}
+
+/*
+ * Select the traced subsystems (FTRACE_MASK bits); 0 stops tracing
+ */
+int ftrace_set_mask(uint32_t mask)
+{
+    if (!ftrace_state.initialized) {
+        return -1;
+    }
+    if (mask & ~FTRACE_MASK_ALL) {
+        return -3;
+    }
+
+    ftrace_state.mask = mask;
+    kprintf("[FTRACE] Tracing mask set to 0x%x\n", mask);
+
+    return 0;
+}
+
+/*
+ * Get the traced subsystems
+ */
+uint32_t ftrace_get_mask(void)
+{
+    return ftrace_state.mask;
+}
+
+/*
+ * Discard all buffered records and counters
+ */
+void ftrace_reset(void)
+{
+    uint32_t flags = ftrace_irq_save();
+
+    for (uint32_t cpu = 0; cpu < FTRACE_MAX_CPUS; cpu++) {
+        ftrace_state.cpus[cpu].head = 0;
+        ftrace_state.cpus[cpu].tail = 0;
+        ftrace_state.cpus[cpu].records_lost = 0;
+    }
+    for (uint32_t i = 0; i < FTRACE_SUBSYS_COUNT; i++) {
+        ftrace_state.events[i] = 0;
+    }
+
+    ftrace_irq_restore(flags);
+}
+
+// =============================================================================
+// Output
+// =============================================================================
+
+/*
+ * Write a value in decimal
+ */
+static void ftrace_write_dec(uint32_t value)
+{
+    char digits[10];
+    int length = 0;
+
+    do {
+        digits[length++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    while (length > 0) {
+        serial_write_char(digits[--length]);
+    }
+}
+
+/*
+ * Drain the rings to the serial port as
+ *
+ *   FTRACE-BEGIN records=<n> lost=<n>\n <n raw ftrace_record_t> FTRACE-END\n
+ *
+ * Tracing is paused for the duration of the dump and then restored.
+ * Returns the number of records written.
+ */
+int ftrace_dump_serial(void)
+{
+    if (!ftrace_state.initialized) {
+        return -1;
+    }
+    if (!serial_is_ready()) {
+        return -4;
+    }
+
+    uint32_t mask = ftrace_state.mask;
+    ftrace_state.mask = 0;
+
+    uint32_t total = 0;
+    uint32_t lost = 0;
+    for (uint32_t cpu = 0; cpu < FTRACE_MAX_CPUS; cpu++) {
+        ftrace_cpu_t* ring = &ftrace_state.cpus[cpu];
+        if (ring->head - ring->tail > FTRACE_RING_SIZE) {
+            ring->records_lost += ring->head - ring->tail - FTRACE_RING_SIZE;
+            ring->tail = ring->head - FTRACE_RING_SIZE;
+        }
+        total += ring->head - ring->tail;
+        lost += (uint32_t)ring->records_lost;
+    }
+
+    serial_write_string("FTRACE-BEGIN records=");
+    ftrace_write_dec(total);
+    serial_write_string(" lost=");
+    ftrace_write_dec(lost);
+    serial_write_string("\n");
+
+    for (uint32_t cpu = 0; cpu < FTRACE_MAX_CPUS; cpu++) {
+        ftrace_cpu_t* ring = &ftrace_state.cpus[cpu];
+        while (ring->tail != ring->head) {
+            serial_write(&ring->ring[ring->tail & (FTRACE_RING_SIZE - 1)],
+                         sizeof(ftrace_record_t));
+            ring->tail++;
+        }
+    }
+
+    serial_write_string("FTRACE-END\n");
+
+    ftrace_state.mask = mask;
+    return (int)total;
+}
+
+/*
+ * Print tracer statistics
+ */
+void ftrace_print_stats(void)
+{
+    const char* names[FTRACE_SUBSYS_COUNT] = {"sched", "heap", "module", "ipc"};
+
+    kprintf("[FTRACE] Tracer Statistics:\n");
+    kprintf("      Mask: 0x%x\n", ftrace_state.mask);
+    for (uint32_t i = 0; i < FTRACE_SUBSYS_COUNT; i++) {
+        kprintf("      %s: %d events\n", names[i], (uint32_t)ftrace_state.events[i]);
+    }
+    for (uint32_t cpu = 0; cpu < FTRACE_MAX_CPUS; cpu++) {
+        ftrace_cpu_t* ring = &ftrace_state.cpus[cpu];
+        kprintf("      CPU %d: %d written, %d lost\n",
+                cpu, ring->head, (uint32_t)ring->records_lost);
+    }
+}
+
+#else // !CONFIG_FTRACE
+
+// =============================================================================
+// Tracer Not Built (make TRACE=1 to enable)
+// =============================================================================
+
+void ftrace_init(void)
+{
+    kprintf("[FTRACE] Function tracer not built (make TRACE=1)\n");
+}
+
+int ftrace_set_mask(uint32_t mask)
+{
+    (void)mask;
+    return -1;
+}
+
+uint32_t ftrace_get_mask(void)
+{
+    return 0;
+}
+
+void ftrace_reset(void)
+{
+}
+
+int ftrace_dump_serial(void)
+{
+    return -1;
+}
+
+void ftrace_print_stats(void)
+{
+    kprintf("[FTRACE] Function tracer not built (make TRACE=1)\n");
+}
+
+#endif // CONFIG_FTRACE
@@ -10,7 +10,7 @@
 #include "gdt.h"
 
 // GDT entries
-static gdt_entry_t gdt_entries[5];
+static gdt_entry_t gdt_entries[GDT_ENTRIES];
 static gdt_ptr_t gdt_ptr;
 
 /*
@@ -18,7 +18,7 @@ static gdt_ptr_t gdt_ptr;
  */
 void gdt_init(void)
 {
-    gdt_ptr.limit = (sizeof(gdt_entry_t) * 5) - 1;
+    gdt_ptr.limit = (sizeof(gdt_entry_t) * GDT_ENTRIES) - 1;
     gdt_ptr.base = (uint32_t)&gdt_entries;
     
     // Null segment (index 0)
@@ -36,6 +36,19 @@ void gdt_init(void)
     // User mode data segment (index 4) - 0x20
     gdt_set_gate(4, 0, 0xFFFFFFFF, 0xF2, 0xCF);
     
+    // Per-CPU segments (index 5+) are filled in by percpu_init_cpu
+    for (int32_t i = GDT_PERCPU_FIRST; i < GDT_ENTRIES; i++) {
+        gdt_set_gate(i, 0, 0, 0, 0);
+    }
+    
+    gdt_flush((uint32_t)&gdt_ptr);
+}
+
+/*
+ * Load the already-built GDT on this CPU (application processors)
+ */
+void gdt_load(void)
+{
     gdt_flush((uint32_t)&gdt_ptr);
 }
 
@@ -0,0 +1,185 @@
+/*
+ * =============================================================================
+ * CLKernel - Generation-Tagged Handle Tables
+ * =============================================================================
+ * File: handle_table.c
+ * Purpose: Slot allocation, paged growth and handle retirement for tables
+ *          of fixed-size objects
+ *
+ * Allocation and freeing take the table lock; lookups never do (see
+ * handle_table_lookup). A page is fully set up and its directory entry
+ * written before capacity is raised to cover it.
+ * =============================================================================
+ */
+
+#include "handle_table.h"
+#include "kernel.h"
+#include "heap.h"
+
+// =============================================================================
+// Page Management
+// =============================================================================
+
+static inline uint32_t handle_make(handle_table_t* table, uint32_t generation, uint32_t index)
+{
+    return table->tag | (generation << HANDLE_INDEX_BITS) | index;
+}
+
+/*
+ * Add a page at the end of the directory and push its slots on the free
+ * stack, lowest index on top (caller holds the lock)
+ */
+static void handle_table_add_page(handle_table_t* table, handle_slot_t* page)
+{
+    uint32_t page_index = table->capacity >> HANDLE_PAGE_SHIFT;
+    uint32_t base = table->capacity;
+
+    for (uint32_t i = HANDLE_PAGE_SIZE; i-- > 0;) {
+        page[i].handle = handle_make(table, 0, base + i);
+        page[i].next_free = table->free_head;
+        table->free_head = base + i;
+    }
+
+    table->pages[page_index] = page;
+    __sync_synchronize(); // Directory entry before capacity (lookups read in that order)
+    table->capacity = base + HANDLE_PAGE_SIZE;
+}
+
+static bool handle_table_grow(handle_table_t* table)
+{
+    if ((table->capacity >> HANDLE_PAGE_SHIFT) >= table->max_pages) {
+        return false;
+    }
+
+    // Zeroed, like a static first page, so owners may keep state in
+    // objects that lives across reuse (such as a lock)
+    handle_slot_t* page = (handle_slot_t*)kcalloc(1, HANDLE_PAGE_BYTES(table->object_size));
+    if (!page) {
+        kprintf("[HANDLES] %s: out of memory for page %d\n", table->name,
+                table->capacity >> HANDLE_PAGE_SHIFT);
+        return false;
+    }
+
+    table->allocated_pages++;
+    handle_table_add_page(table, page);
+    return true;
+}
+
+// =============================================================================
+// Handle Table Functions
+// =============================================================================
+
+/*
+ * Set up an empty table (no pages unless first_page is given)
+ */
+void handle_table_init(handle_table_t* table, const char* name, uint32_t tag,
+                       uint32_t object_size, handle_slot_t** pages, uint32_t max_pages,
+                       void* first_page)
+{
+    table->name = name;
+    table->tag = tag & HANDLE_TAG_MASK;
+    table->object_size = object_size;   // sizeof() keeps every object aligned
+    table->pages = pages;
+    table->max_pages = max_pages;
+    table->capacity = 0;
+    table->free_head = HANDLE_SLOT_END;
+    table->live = 0;
+    table->allocated_pages = 0;
+    spinlock_init(&table->lock, name);
+
+    for (uint32_t i = 0; i < max_pages; i++) {
+        pages[i] = NULL;
+    }
+
+    if (first_page && max_pages > 0) {
+        handle_table_add_page(table, (handle_slot_t*)first_page);
+    }
+}
+
+/*
+ * Pop a free slot, growing the table when the stack is empty
+ */
+void* handle_table_alloc(handle_table_t* table, uint32_t* handle)
+{
+    uint32_t flags = spin_lock_irqsave(&table->lock);
+
+    if (table->free_head == HANDLE_SLOT_END && !handle_table_grow(table)) {
+        spin_unlock_irqrestore(&table->lock, flags);
+        return NULL;
+    }
+
+    uint32_t index = table->free_head;
+    handle_slot_t* slot = handle_table_slot(table, index);
+    table->free_head = slot->next_free;
+    slot->next_free = HANDLE_SLOT_RESERVED;
+    table->live++;
+
+    spin_unlock_irqrestore(&table->lock, flags);
+
+    *handle = slot->handle;
+    return handle_table_object(table, index);
+}
+
+/*
+ * Publish after the object is initialized, so no lookup sees it half built
+ */
+void handle_table_publish(handle_table_t* table, uint32_t handle)
+{
+    handle_slot_t* slot = handle_table_slot(table, handle_index(handle));
+
+    __sync_synchronize();
+    if (slot->handle == handle && slot->next_free == HANDLE_SLOT_RESERVED) {
+        slot->next_free = HANDLE_SLOT_LIVE;
+    }
+}
+
+/*
+ * Bump the slot's generation (skipping 0, which only a slot's first
+ * handle has) and push it on the free stack
+ */
+bool handle_table_free(handle_table_t* table, uint32_t handle)
+{
+    uint32_t index = handle_index(handle);
+    if ((handle & HANDLE_TAG_MASK) != table->tag || index >= table->capacity) {
+        return false;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&table->lock);
+
+    handle_slot_t* slot = handle_table_slot(table, index);
+    if (slot->handle != handle ||
+        (slot->next_free != HANDLE_SLOT_LIVE && slot->next_free != HANDLE_SLOT_RESERVED)) {
+        spin_unlock_irqrestore(&table->lock, flags);
+        return false;
+    }
+
+    uint32_t generation = (handle_generation(handle) + 1) & HANDLE_GENERATION_MASK;
+    if (generation == 0) {
+        generation = 1;
+    }
+    slot->handle = handle_make(table, generation, index);
+    slot->next_free = table->free_head;
+    table->free_head = index;
+    table->live--;
+
+    spin_unlock_irqrestore(&table->lock, flags);
+    return true;
+}
+
+/*
+ * Walk live objects in index order (no lock: objects may come and go
+ * during the walk, but every slot visited is valid memory)
+ */
+void* handle_table_next(handle_table_t* table, uint32_t* index)
+{
+    uint32_t capacity = table->capacity;
+    __sync_synchronize();
+
+    while (*index < capacity) {
+        uint32_t i = (*index)++;
+        if (handle_table_slot(table, i)->next_free == HANDLE_SLOT_LIVE) {
+            return handle_table_object(table, i);
+        }
+    }
+    return NULL;
+}
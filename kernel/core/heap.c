@@ -15,9 +15,15 @@
 
 #include "heap.h"
 #include "memory.h"
+#include "metrics.h"
+#include "percpu.h"
 #include "kernel.h"
 #include "vga.h"
 
+// Function-entry tracing subsystem for this file (make TRACE=1)
+#define FTRACE_SUBSYSTEM heap
+#include "ftrace.h"
+
 // =============================================================================
 // Global Heap State
 // =============================================================================
@@ -54,6 +60,17 @@ void heap_init(void)
     kernel_heap.leak_detection_enabled = true;
     kernel_heap.ai_monitoring_enabled = true;
     
+    // Export statistics through the metrics registry
+    heap_stats_t* stats = &kernel_heap.statistics;
+    METRICS_PERCPU_COUNTER("heap.allocations", heap_allocations);
+    METRICS_PERCPU_COUNTER("heap.frees", heap_frees);
+    METRICS_PERCPU_COUNTER("heap.bytes_allocated", heap_bytes_allocated);
+    METRICS_COUNTER("heap.bytes_freed", stats->bytes_freed);
+    METRICS_PERCPU_GAUGE("heap.current_allocations", heap_live_allocations);
+    METRICS_GAUGE("heap.peak_usage", stats->peak_usage);
+    METRICS_GAUGE("heap.fragmentation_percent", stats->fragmentation_level);
+    METRICS_GAUGE("heap.potential_leaks", stats->potential_leaks);
+    
     heap_initialized = true;
     
     kprintf("[HEAP] Kernel heap initialized\n");
@@ -79,6 +96,7 @@ bool heap_create(heap_t* heap, void* start, void* end)
     heap->total_size = (uint64_t)end - (uint64_t)start;
     heap->available_size = heap->total_size;
     heap->free_list = NULL;
+    spinlock_init(&heap->lock, "heap");
     
     // Clear statistics
     heap->statistics.total_allocations = 0;
@@ -110,12 +128,12 @@ bool heap_create(heap_t* heap, void* start, void* end)
 // =============================================================================
 
 /*
- * Allocate memory from kernel heap
+ * Allocate with kernel_heap.lock held
  */
-void* kmalloc(size_t size)
+static void* heap_alloc_locked(size_t size)
 {
     if (!heap_initialized || size == 0 || size > HEAP_MAX_BLOCK_SIZE) {
-        kernel_heap.statistics.total_allocations++;
+        this_cpu_inc(heap_allocations);
         // Failed allocation - use simple bump allocator for now
         if (size > 0 && size <= 4096 && heap_current_pos) {
             void* ptr = heap_current_pos;
@@ -123,8 +141,8 @@ void* kmalloc(size_t size)
             
             // Check bounds
             if (heap_current_pos <= kernel_heap.end_address) {
-                kernel_heap.statistics.bytes_allocated += size;
-                kernel_heap.statistics.current_allocations++;
+                this_cpu_add(heap_bytes_allocated, size);
+                this_cpu_inc(heap_live_allocations);
                 return ptr;
             }
         }
@@ -135,9 +153,9 @@ void* kmalloc(size_t size)
     if (size <= SLAB_SIZES[SLAB_SIZE_COUNT - 1]) {
         void* ptr = slab_alloc(size);
         if (ptr) {
-            kernel_heap.statistics.total_allocations++;
-            kernel_heap.statistics.bytes_allocated += size;
-            kernel_heap.statistics.current_allocations++;
+            this_cpu_inc(heap_allocations);
+            this_cpu_add(heap_bytes_allocated, size);
+            this_cpu_inc(heap_live_allocations);
             return ptr;
         }
     }
@@ -152,9 +170,9 @@ void* kmalloc(size_t size)
         heap_current_pos = (uint8_t*)heap_current_pos + aligned_size;
         
         // Update statistics
-        kernel_heap.statistics.total_allocations++;
-        kernel_heap.statistics.bytes_allocated += aligned_size;
-        kernel_heap.statistics.current_allocations++;
+        this_cpu_inc(heap_allocations);
+        this_cpu_add(heap_bytes_allocated, aligned_size);
+        this_cpu_inc(heap_live_allocations);
         kernel_heap.statistics.actor_memory_used[0] += aligned_size; // Kernel actor ID = 0
         
         return ptr;
@@ -163,6 +181,18 @@ void* kmalloc(size_t size)
     return NULL;
 }
 
+/*
+ * Allocate memory from kernel heap (any CPU, also from interrupt handlers)
+ */
+void* kmalloc(size_t size)
+{
+    uint32_t flags = spin_lock_irqsave(&kernel_heap.lock);
+    void* ptr = heap_alloc_locked(size);
+    spin_unlock_irqrestore(&kernel_heap.lock, flags);
+    
+    return ptr;
+}
+
 /*
  * Allocate zero-initialized memory
  */
@@ -192,8 +222,8 @@ void kfree(void* ptr)
     }
     
     // For now, just update statistics (proper free implementation would be complex)
-    kernel_heap.statistics.total_frees++;
-    kernel_heap.statistics.current_allocations--;
+    this_cpu_inc(heap_frees);
+    this_cpu_dec(heap_live_allocations);
     
     // TODO: Implement proper free list management and coalescing
     // This is a simplified implementation
@@ -218,8 +248,10 @@ void* actor_malloc(uint32_t actor_id, size_t size)
     
     if (ptr) {
         // Track per-actor usage
+        uint32_t flags = spin_lock_irqsave(&kernel_heap.lock);
         kernel_heap.statistics.actor_allocations[actor_id]++;
         kernel_heap.statistics.actor_memory_used[actor_id] += size;
+        spin_unlock_irqrestore(&kernel_heap.lock, flags);
         
         kprintf("[HEAP] Allocated %d bytes for actor %d at 0x%x\n", 
                 (uint32_t)size, actor_id, (uint32_t)ptr);
@@ -356,12 +388,17 @@ heap_stats_t* heap_get_statistics(void)
 }
 
 /*
- * Update heap statistics
+ * Update heap statistics (sums the per-CPU allocation counters first)
  */
 void heap_update_statistics(void)
 {
     if (!heap_initialized) return;
     
+    kernel_heap.statistics.total_allocations = percpu_sum(heap_allocations);
+    kernel_heap.statistics.total_frees = percpu_sum(heap_frees);
+    kernel_heap.statistics.bytes_allocated = percpu_sum(heap_bytes_allocated);
+    kernel_heap.statistics.current_allocations = percpu_sum(heap_live_allocations);
+    
     // Calculate current usage
     uint64_t current_usage = kernel_heap.statistics.bytes_allocated - kernel_heap.statistics.bytes_freed;
     
@@ -15,6 +15,12 @@
 #include "../io.h"
 #include "vga.h"
 #include "pic.h"
+#include "apic.h"
+#include "ioapic.h"
+#include "profiler.h"
+#include "smp.h"
+#include "percpu.h"
+#include "scheduler.h"
 
 // =============================================================================
 // Global IDT State
@@ -24,12 +30,8 @@ idt_entry_t idt_table[IDT_MAX_DESCRIPTORS];
 idt_ptr_t idt_pointer;
 interrupt_handler_t registered_handlers[IDT_MAX_DESCRIPTORS];
 
-// Statistics for monitoring and AI supervisor
+// Statistics for monitoring and AI supervisor (counts live in percpu_t)
 static struct {
-    uint64_t total_interrupts;
-    uint64_t exceptions;
-    uint64_t irqs;
-    uint64_t async_messages_sent;
     uint32_t last_interrupt;
     uint64_t last_interrupt_time;
 } idt_stats;
@@ -57,10 +59,6 @@ void idt_init(void)
     }
     
     // Clear statistics
-    idt_stats.total_interrupts = 0;
-    idt_stats.exceptions = 0;
-    idt_stats.irqs = 0;
-    idt_stats.async_messages_sent = 0;
     idt_stats.last_interrupt = 0;
     idt_stats.last_interrupt_time = 0;
     
@@ -115,6 +113,11 @@ void idt_init(void)
     idt_set_gate(46, (uint32_t)irq14, 0x08, IDT_FLAG_PRESENT | IDT_TYPE_INTERRUPT_32); // Primary ATA
     idt_set_gate(47, (uint32_t)irq15, 0x08, IDT_FLAG_PRESENT | IDT_TYPE_INTERRUPT_32); // Secondary ATA
     
+    // Local APIC vectors (unused until a local APIC is enabled)
+    idt_set_gate(LAPIC_TIMER_VECTOR, (uint32_t)irq_lapic_timer, 0x08, IDT_FLAG_PRESENT | IDT_TYPE_INTERRUPT_32);
+    idt_set_gate(LAPIC_RESCHEDULE_VECTOR, (uint32_t)irq_lapic_reschedule, 0x08, IDT_FLAG_PRESENT | IDT_TYPE_INTERRUPT_32);
+    idt_set_gate(LAPIC_SPURIOUS_VECTOR, (uint32_t)irq_spurious, 0x08, IDT_FLAG_PRESENT | IDT_TYPE_INTERRUPT_32);
+    
     // Initialize PIC (Programmable Interrupt Controller)
     pic_init();
     
@@ -212,8 +215,8 @@ bool interrupts_enabled(void)
 
 void exception_handler(interrupt_frame_t* frame)
 {
-    idt_stats.exceptions++;
-    idt_stats.total_interrupts++;
+    this_cpu_inc(irq_exceptions);
+    this_cpu_inc(irq_total);
     idt_stats.last_interrupt = frame->interrupt_number;
     
     const char* exception_messages[] = {
@@ -256,7 +259,7 @@ void exception_handler(interrupt_frame_t* frame)
             .interrupt_number = frame->interrupt_number,
             .error_code = frame->error_code,
             .timestamp = 0, // TODO: Get real timestamp
-            .cpu_id = 0,    // TODO: Get CPU ID
+            .cpu_id = smp_cpu_id(),
             .context_data = frame
         };
         
@@ -303,10 +306,22 @@ void general_protection_fault_handler(interrupt_frame_t* frame)
 
 void irq_handler(interrupt_frame_t* frame)
 {
-    idt_stats.irqs++;
-    idt_stats.total_interrupts++;
+    this_cpu_inc(irq_total);
     idt_stats.last_interrupt = frame->interrupt_number;
     
+    // Local APIC vectors are per-CPU, not device IRQs
+    if (frame->interrupt_number == LAPIC_TIMER_VECTOR) {
+        lapic_timer_interrupt();
+        return;
+    }
+    if (frame->interrupt_number == LAPIC_RESCHEDULE_VECTOR) {
+        lapic_eoi();
+        scheduler_reschedule_interrupt();
+        return;
+    }
+    
+    this_cpu_inc(irq_hardware);
+    
     uint8_t irq_number = frame->interrupt_number - IRQ_BASE;
     
     // Check if we have a registered handler
@@ -317,12 +332,12 @@ void irq_handler(interrupt_frame_t* frame)
                 .interrupt_number = frame->interrupt_number,
                 .error_code = frame->error_code,
                 .timestamp = 0, // TODO: Get timestamp
-                .cpu_id = 0,    // TODO: Get CPU ID
+                .cpu_id = smp_cpu_id(),
                 .context_data = frame
             };
             
             interrupt_send_to_actor(registered_handlers[frame->interrupt_number].target_actor_id, &msg);
-            idt_stats.async_messages_sent++;
+            this_cpu_inc(irq_async_messages);
         } else {
             // Direct call (for performance-critical interrupts)
             registered_handlers[frame->interrupt_number].handler(frame);
@@ -336,14 +351,17 @@ void irq_handler(interrupt_frame_t* frame)
             case IRQ1_KEYBOARD:
                 keyboard_irq_handler(frame);
                 break;
+            case IRQ8_RTC:
+                profiler_rtc_irq_handler(frame);
+                break;
             default:
                 kprintf("[IRQ] Unhandled IRQ %d\n", irq_number);
                 break;
         }
     }
     
-    // Send End of Interrupt (EOI) to PIC
-    pic_send_eoi(irq_number);
+    // Send End of Interrupt (EOI): local APIC write, or the PIC ports in fallback mode
+    irq_eoi(irq_number);
 }
 
 void timer_irq_handler(interrupt_frame_t* frame)
@@ -356,6 +374,9 @@ void timer_irq_handler(interrupt_frame_t* frame)
         kernel_state.uptime = timer_ticks / 100;
     }
     
+    // Statistical profiling of the interrupted context
+    profiler_timer_tick(frame);
+    
     // Trigger scheduler (cooperative multitasking point)
     // TODO: Send message to scheduler actor
     // scheduler_yield();
@@ -396,10 +417,10 @@ void interrupt_process_async_queue(void)
 void idt_print_stats(void)
 {
     kprintf("[IDT] Interrupt Statistics:\n");
-    kprintf("      Total interrupts: %d\n", (uint32_t)idt_stats.total_interrupts);
-    kprintf("      CPU exceptions: %d\n", (uint32_t)idt_stats.exceptions);  
-    kprintf("      Hardware IRQs: %d\n", (uint32_t)idt_stats.irqs);
-    kprintf("      Async messages sent: %d\n", (uint32_t)idt_stats.async_messages_sent);
+    kprintf("      Total interrupts: %d\n", (uint32_t)percpu_sum(irq_total));
+    kprintf("      CPU exceptions: %d\n", (uint32_t)percpu_sum(irq_exceptions));
+    kprintf("      Hardware IRQs: %d\n", (uint32_t)percpu_sum(irq_hardware));
+    kprintf("      Async messages sent: %d\n", (uint32_t)percpu_sum(irq_async_messages));
     kprintf("      Last interrupt: %d\n", idt_stats.last_interrupt);
 }
 
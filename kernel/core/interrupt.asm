@@ -115,6 +115,18 @@ IRQ 13, 45      ; FPU (IRQ13)
 IRQ 14, 46      ; Primary ATA (IRQ14)
 IRQ 15, 47      ; Secondary ATA (IRQ15)
 
+; =============================================================================
+; Local APIC Vectors (240-255)
+; =============================================================================
+
+IRQ lapic_timer, 240      ; Per-CPU local APIC timer
+IRQ lapic_reschedule, 241 ; Cross-CPU reschedule IPI
+
+; Spurious vector: the local APIC sets no in-service bit, so no EOI either
+global irq_spurious
+irq_spurious:
+    iret
+
 ; =============================================================================
 ; Common ISR Handler (CPU Exceptions)
 ; =============================================================================
@@ -128,12 +140,11 @@ isr_common_stub:
     push fs
     push gs
     
-    ; Load kernel data segment
+    ; Load kernel data segment (GS keeps this CPU's percpu segment)
     mov ax, 0x10        ; Kernel data segment selector
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
     
     ; Prepare interrupt frame for C handler
     ; Stack layout from top to bottom:
@@ -183,12 +194,11 @@ irq_common_stub:
     push fs
     push gs
     
-    ; Load kernel data segment
+    ; Load kernel data segment (GS keeps this CPU's percpu segment)
     mov ax, 0x10        ; Kernel data segment selector
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
     
     ; Prepare interrupt frame for C handler
     mov eax, esp
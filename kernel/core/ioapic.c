@@ -0,0 +1,330 @@
+/*
+ * =============================================================================
+ * CLKernel - I/O APIC and IRQ Routing
+ * =============================================================================
+ * File: ioapic.c
+ * Purpose: Program the I/O APICs from the discovered topology and route
+ *          ISA IRQs to local APICs, keeping the 8259 PIC as a fallback
+ *
+ * Routing starts in PIC mode (what pic_init left behind). irq_routing_init
+ * switches to the I/O APICs only once every table checks out, so a machine
+ * without them, or with firmware we cannot parse, keeps working unchanged.
+ * =============================================================================
+ */
+
+#include "ioapic.h"
+#include "kernel.h"
+#include "pic.h"
+#include "idt.h"
+#include "apic.h"
+#include "smp.h"
+#include "paging.h"
+#include "spinlock.h"
+
+// =============================================================================
+// Global IRQ Routing State
+// =============================================================================
+
+// PIC mode with the timer and keyboard enabled, as pic_init programs it
+static irq_routing_state_t irq_routing = {
+    .mode = IRQ_MODE_PIC,
+    .routes = { [0] = { .enabled = true }, [1] = { .enabled = true } },
+};
+
+// REGSEL/IOWIN is a two-step access: one CPU at a time, interrupts off
+static spinlock_t ioapic_lock = SPINLOCK_INIT("ioapic");
+
+// IMCR (MP spec): selects whether the 8259 or the APIC sees the INTR line
+#define IMCR_SELECT_PORT            0x22
+#define IMCR_DATA_PORT              0x23
+#define IMCR_REGISTER               0x70
+#define IMCR_APIC_MODE              0x01
+
+// =============================================================================
+// I/O APIC Register Access
+// =============================================================================
+
+static uint32_t ioapic_read(ioapic_t* ioapic, uint8_t reg)
+{
+    ioapic->registers[IOAPIC_REGSEL / 4] = reg;
+    return ioapic->registers[IOAPIC_IOWIN / 4];
+}
+
+static void ioapic_write(ioapic_t* ioapic, uint8_t reg, uint32_t value)
+{
+    ioapic->registers[IOAPIC_REGSEL / 4] = reg;
+    ioapic->registers[IOAPIC_IOWIN / 4] = value;
+}
+
+/*
+ * Find the I/O APIC and pin that receive a global system interrupt
+ */
+static ioapic_t* ioapic_for_gsi(uint32_t gsi, uint32_t* pin)
+{
+    for (uint32_t i = 0; i < irq_routing.ioapic_count; i++) {
+        ioapic_t* ioapic = &irq_routing.ioapics[i];
+        if (gsi >= ioapic->gsi_base && gsi < ioapic->gsi_base + ioapic->pin_count) {
+            *pin = gsi - ioapic->gsi_base;
+            return ioapic;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Redirection entry low dword for an ISA IRQ: fixed delivery on
+ * IRQ_BASE + irq, with the override's polarity and trigger (ISA default
+ * is edge, active high)
+ */
+static uint32_t ioapic_isa_entry(uint8_t irq)
+{
+    uint16_t flags = irq_routing.platform.isa_irqs[irq].flags;
+    uint32_t entry = IOAPIC_DELIVERY_FIXED | (IRQ_BASE + irq);
+
+    if ((flags & APIC_IRQ_POLARITY_MASK) == APIC_IRQ_POLARITY_LOW) {
+        entry |= IOAPIC_POLARITY_LOW;
+    }
+    if ((flags & APIC_IRQ_TRIGGER_MASK) == APIC_IRQ_TRIGGER_LEVEL) {
+        entry |= IOAPIC_TRIGGER_LEVEL;
+    }
+    if (!irq_routing.routes[irq].enabled) {
+        entry |= IOAPIC_MASKED;
+    }
+    return entry;
+}
+
+/*
+ * Write an ISA IRQ's redirection entry (caller holds ioapic_lock)
+ */
+static bool ioapic_program_irq(uint8_t irq)
+{
+    uint32_t pin;
+    ioapic_t* ioapic = ioapic_for_gsi(irq_routing.platform.isa_irqs[irq].gsi, &pin);
+    if (!ioapic) {
+        return false;
+    }
+
+    smp_cpu_t* cpu = smp_get_cpu(irq_routing.routes[irq].cpu);
+    uint8_t destination = cpu ? cpu->apic_id : lapic_id();
+
+    // Mask first so the pin never fires half-programmed
+    ioapic_write(ioapic, IOAPIC_REG_REDIRECTION + pin * 2, IOAPIC_MASKED);
+    ioapic_write(ioapic, IOAPIC_REG_REDIRECTION + pin * 2 + 1, (uint32_t)destination << 24);
+    ioapic_write(ioapic, IOAPIC_REG_REDIRECTION + pin * 2, ioapic_isa_entry(irq));
+    return true;
+}
+
+// =============================================================================
+// Setup
+// =============================================================================
+
+/*
+ * Map every I/O APIC and mask all of its pins
+ */
+static bool ioapic_setup_controllers(void)
+{
+    const apic_platform_t* platform = &irq_routing.platform;
+
+    for (uint32_t i = 0; i < platform->ioapic_count; i++) {
+        ioapic_t* ioapic = &irq_routing.ioapics[i];
+
+        ioapic->registers = (volatile uint32_t*)paging_map_io(platform->ioapics[i].address, 0x20);
+        if (!ioapic->registers) {
+            kprintf("[IOAPIC] Could not map I/O APIC %d at 0x%x\n",
+                    platform->ioapics[i].id, platform->ioapics[i].address);
+            return false;
+        }
+
+        ioapic->id = platform->ioapics[i].id;
+        ioapic->gsi_base = platform->ioapics[i].gsi_base;
+        ioapic->pin_count = ((ioapic_read(ioapic, IOAPIC_REG_VERSION) >> 16) & 0xFF) + 1;
+        irq_routing.ioapic_count = i + 1;
+
+        for (uint32_t pin = 0; pin < ioapic->pin_count; pin++) {
+            ioapic_write(ioapic, IOAPIC_REG_REDIRECTION + pin * 2, IOAPIC_MASKED);
+        }
+
+        kprintf("[IOAPIC] I/O APIC %d at 0x%x: GSIs %d-%d\n", ioapic->id,
+                platform->ioapics[i].address, ioapic->gsi_base,
+                ioapic->gsi_base + ioapic->pin_count - 1);
+    }
+
+    return irq_routing.ioapic_count > 0;
+}
+
+/*
+ * Switch IRQ delivery from the 8259 pair to the I/O APICs if the platform
+ * has them; otherwise leave the PIC in charge
+ */
+void irq_routing_init(void)
+{
+    kprintf("[IOAPIC] Discovering interrupt controllers...\n");
+
+    spinlock_init(&ioapic_lock, "ioapic");
+
+    if (!lapic_is_present()) {
+        kprintf("[IOAPIC] No local APIC, staying on the 8259 PIC\n");
+        return;
+    }
+
+    if (!acpi_discover_apics(&irq_routing.platform) || !ioapic_setup_controllers()) {
+        kprintf("[IOAPIC] No usable I/O APIC, staying on the 8259 PIC\n");
+        irq_routing.ioapic_count = 0;
+        return;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&ioapic_lock);
+
+    // Every ISA IRQ goes to the BSP until someone sets its affinity
+    for (uint8_t irq = 0; irq < APIC_PLATFORM_ISA_IRQS; irq++) {
+        if (irq == IRQ2_CASCADE) {
+            continue;
+        }
+        irq_routing.routes[irq].cpu = 0;
+        if (!ioapic_program_irq(irq) && irq_routing.routes[irq].enabled) {
+            kprintf("[IOAPIC] IRQ %d (GSI %d) has no I/O APIC pin\n",
+                    irq, irq_routing.platform.isa_irqs[irq].gsi);
+        }
+    }
+
+    // From here on the 8259s must stay silent
+    pic_mask_all();
+    if (irq_routing.platform.has_imcr) {
+        outb(IMCR_SELECT_PORT, IMCR_REGISTER);
+        outb(IMCR_DATA_PORT, IMCR_APIC_MODE);
+    }
+    irq_routing.mode = IRQ_MODE_IOAPIC;
+
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+
+    kprintf("[IOAPIC] IRQs routed through %d I/O APIC(s) (%s), EOI via local APIC\n",
+            irq_routing.ioapic_count, acpi_source_name(irq_routing.platform.source));
+}
+
+uint8_t irq_routing_mode(void)
+{
+    return irq_routing.mode;
+}
+
+const apic_platform_t* irq_routing_platform(void)
+{
+    return &irq_routing.platform;
+}
+
+// =============================================================================
+// Per-IRQ Control
+// =============================================================================
+
+/*
+ * Acknowledge an ISA IRQ: a local APIC MMIO write, or the 8259 port writes
+ */
+void irq_eoi(uint8_t irq)
+{
+    if (irq_routing.mode == IRQ_MODE_IOAPIC) {
+        lapic_eoi();
+    } else {
+        pic_send_eoi(irq);
+    }
+}
+
+static void irq_set_enabled(uint8_t irq, bool enabled)
+{
+    if (irq >= APIC_PLATFORM_ISA_IRQS) {
+        return;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&ioapic_lock);
+
+    irq_routing.routes[irq].enabled = enabled;
+
+    if (irq_routing.mode == IRQ_MODE_IOAPIC) {
+        // The cascade input only exists on the 8259 pair
+        if (irq != IRQ2_CASCADE) {
+            ioapic_program_irq(irq);
+        }
+    } else if (enabled) {
+        pic_unmask_irq(irq);
+    } else {
+        pic_mask_irq(irq);
+    }
+
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+}
+
+void irq_mask(uint8_t irq)
+{
+    irq_set_enabled(irq, false);
+}
+
+void irq_unmask(uint8_t irq)
+{
+    irq_set_enabled(irq, true);
+}
+
+/*
+ * Deliver an ISA IRQ to one CPU; only possible with I/O APICs, and only
+ * to a CPU that is online
+ */
+bool irq_set_affinity(uint8_t irq, uint32_t cpu)
+{
+    if (irq >= APIC_PLATFORM_ISA_IRQS || irq == IRQ2_CASCADE ||
+        irq_routing.mode != IRQ_MODE_IOAPIC) {
+        return false;
+    }
+
+    smp_cpu_t* target = smp_get_cpu(cpu);
+    if (!target || !target->online) {
+        return false;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&ioapic_lock);
+
+    uint32_t previous = irq_routing.routes[irq].cpu;
+    irq_routing.routes[irq].cpu = cpu;
+    bool programmed = ioapic_program_irq(irq);
+    if (!programmed) {
+        irq_routing.routes[irq].cpu = previous;
+    }
+
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+    return programmed;
+}
+
+uint32_t irq_get_affinity(uint8_t irq)
+{
+    if (irq >= APIC_PLATFORM_ISA_IRQS) {
+        return 0;
+    }
+    return irq_routing.routes[irq].cpu;
+}
+
+// =============================================================================
+// Diagnostics
+// =============================================================================
+
+void irq_print_routing(void)
+{
+    const apic_platform_t* platform = &irq_routing.platform;
+
+    kprintf("[IOAPIC] IRQ routing:\n");
+
+    if (irq_routing.mode != IRQ_MODE_IOAPIC) {
+        kprintf("      Mode: 8259 PIC (EOI via port I/O, no affinity)\n");
+    } else {
+        kprintf("      Mode: I/O APIC (%s), %d CPU(s), %d I/O APIC(s)\n",
+                acpi_source_name(platform->source), platform->cpu_count,
+                irq_routing.ioapic_count);
+    }
+
+    for (uint8_t irq = 0; irq < APIC_PLATFORM_ISA_IRQS; irq++) {
+        if (!irq_routing.routes[irq].enabled) {
+            continue;
+        }
+        if (irq_routing.mode == IRQ_MODE_IOAPIC) {
+            kprintf("      IRQ %d: GSI %d -> CPU %d\n", irq,
+                    platform->isa_irqs[irq].gsi, irq_routing.routes[irq].cpu);
+        } else {
+            kprintf("      IRQ %d: enabled\n", irq);
+        }
+    }
+}
@@ -15,14 +15,21 @@
 
 #include "kernel.h"
 #include "vga.h"
+#include "serial.h"
 #include "gdt.h"
 #include "idt.h"
 #include "memory.h"
 #include "paging.h"
 #include "heap.h"
 #include "scheduler.h"
+#include "event_actor.h"
+#include "smp.h"
+#include "percpu.h"
+#include "ioapic.h"
 #include "modules.h"
 #include "ai_supervisor.h"
+#include "profiler.h"
+#include "ftrace.h"
 
 // Kernel version and build info
 #define KERNEL_VERSION_MAJOR 0
@@ -53,9 +60,14 @@ void kernel_main(void)
     kprintf("[BOOT] Initializing CLKernel v%d.%d.%d\n", 
             KERNEL_VERSION_MAJOR, KERNEL_VERSION_MINOR, KERNEL_VERSION_PATCH);
     
+    // Serial port first so every later subsystem can export to it
+    kprintf("[BOOT] Initializing serial port (COM1)... ");
+    kprintf(serial_init(SERIAL_COM1) ? "OK\n" : "NOT PRESENT\n");
+    
     // Step 1: Setup GDT (Global Descriptor Table)
     kprintf("[BOOT] Setting up GDT... ");
     gdt_init();
+    percpu_init_cpu(0);
     kprintf("OK\n");
     
     // Step 2: Setup IDT (Interrupt Descriptor Table)
@@ -63,6 +75,10 @@ void kernel_main(void)
     idt_init();
     kprintf("OK\n");
     
+    // Sampling profiler and function tracer; both idle until started
+    profiler_init();
+    ftrace_init();
+    
     // Step 3: Initialize memory management
     kprintf("[BOOT] Initializing memory management... ");
     memory_init();
@@ -75,6 +91,13 @@ void kernel_main(void)
     scheduler_init();
     kprintf("OK\n");
     
+    // Wake the application processors; each joins the scheduler with its
+    // own run queue
+    smp_init();
+    
+    // Move device IRQs to the I/O APICs when the firmware describes them
+    irq_routing_init();
+    
     // Step 5: Initialize module system (for hot-swappable components)
     kprintf("[BOOT] Initializing module system... ");
     modules_init();
@@ -87,6 +110,7 @@ void kernel_main(void)
     // Step 7: Initialize AI supervisor (stubbed for now)
     kprintf("[BOOT] Initializing AI supervisor... ");
     ai_supervisor_init();
+    ai_supervisor_start();
     kprintf("OK\n");
     
     // Mark kernel as ready
@@ -180,6 +204,9 @@ void kernel_main_loop(void)
         // Process pending async tasks
         scheduler_process_pending();
         
+        // Handlers of event actors that got messages for the boot CPU
+        event_actor_run_pending();
+        
         // Handle hardware interrupts
         handle_pending_interrupts();
         
@@ -193,6 +220,9 @@ void kernel_main_loop(void)
             modules_periodic_check();
         }
         
+        // Stream committed log segments out (the loop runs once per tick)
+        modules_poll_exports();
+        
         // AI Supervisor analysis
         if (loop_counter % 1000 == 0) {
             ai_supervisor_analyze();
@@ -98,17 +98,24 @@ void memory_detect_regions(void)
     // Read extended memory (1MB+) - simplified detection
     // TODO: Implement proper E820 memory map reading
     uint32_t extended_memory = 32 * 1024 * 1024; // Assume 32MB for now (QEMU default)
-    memory_add_region(KERNEL_END, extended_memory, MEMORY_TYPE_AVAILABLE);
+    memory_add_region(KERNEL_END, LOG_SPILL_AREA_START - KERNEL_END, MEMORY_TYPE_AVAILABLE);
+    memory_add_region(LOG_SPILL_AREA_END, KERNEL_END + extended_memory - LOG_SPILL_AREA_END,
+                      MEMORY_TYPE_AVAILABLE);
     
     // Reserve kernel area
     memory_add_region(KERNEL_START, KERNEL_END - KERNEL_START, MEMORY_TYPE_RESERVED);
     
+    // Reserve the logger spill region so its records survive until read back
+    memory_add_region(LOG_SPILL_AREA_START, LOG_SPILL_AREA_END - LOG_SPILL_AREA_START,
+                      MEMORY_TYPE_RESERVED);
+    
     // Reserve VGA memory
     memory_add_region(0xA0000, 0x60000, MEMORY_TYPE_RESERVED); // VGA 640KB-1MB
     
     // Calculate total memory
     memory_statistics.total_memory = extended_memory;
-    memory_statistics.available_memory = extended_memory - (KERNEL_END - KERNEL_START);
+    memory_statistics.available_memory = extended_memory - (KERNEL_END - KERNEL_START) -
+                                         (LOG_SPILL_AREA_END - LOG_SPILL_AREA_START);
     
     kprintf("[MEMORY] Detected %d memory regions\n", memory_region_count);
     memory_print_map();
@@ -0,0 +1,396 @@
+/*
+ * =============================================================================
+ * CLKernel - Metrics Registry
+ * =============================================================================
+ * File: metrics.c
+ * Purpose: Registered subsystem metrics and their binary snapshots
+ *
+ * The registry holds pointers into the subsystems' own statistics, so
+ * registering costs nothing on the paths that update them. A snapshot
+ * walks the registry once and packs every value into a flat buffer that
+ * tools/metrics/metrics_decode.py turns back into named values.
+ * =============================================================================
+ */
+
+#include "metrics.h"
+#include "kernel.h"
+#include "serial.h"
+#include "sched_trace.h"
+
+// =============================================================================
+// Global Registry State
+// =============================================================================
+
+// Zero-initialized, so subsystems can register before anything else runs
+static metrics_registry_t metrics_registry;
+
+static metrics_page_t metrics_page __attribute__((aligned(METRICS_PAGE_SIZE)));
+static uint8_t metrics_buffer[METRICS_BUFFER_SIZE];
+
+static const char* metric_type_names[] = {"counter", "gauge", "histogram"};
+
+// =============================================================================
+// Registration
+// =============================================================================
+
+/*
+ * Claim a free slot for a validated metric
+ */
+static int metrics_register_source(const char* name, uint8_t type, uint8_t width,
+                                   const volatile void* source, bool percpu)
+{
+    if (!name || !source || type > METRIC_TYPE_HISTOGRAM) {
+        return -3;
+    }
+    if (type != METRIC_TYPE_HISTOGRAM && width != sizeof(uint32_t) && width != sizeof(uint64_t)) {
+        return -3;
+    }
+
+    for (uint32_t id = 0; id < METRICS_MAX; id++) {
+        metric_t* metric = &metrics_registry.metrics[id];
+        if (metric->name) continue;
+
+        metric->source = source;
+        metric->type = type;
+        metric->width = width;
+        metric->percpu = percpu;
+        metric->name = name;
+
+        metrics_registry.count++;
+        metrics_registry.schema++;
+        return (int)id;
+    }
+
+    kprintf("[METRICS] Registry full, dropping %s\n", name);
+    return -4;
+}
+
+/*
+ * Register a metric backed by a subsystem field; returns its ID
+ */
+int metrics_register(const char* name, uint8_t type, uint8_t width, const volatile void* source)
+{
+    return metrics_register_source(name, type, width, source, false);
+}
+
+/*
+ * Register a percpu_t field (by offset); snapshots report the sum over CPUs
+ */
+int metrics_register_percpu(const char* name, uint8_t type, uint8_t width, uint32_t offset)
+{
+    if (type == METRIC_TYPE_HISTOGRAM || offset + width > sizeof(percpu_t)) {
+        return -3;
+    }
+    return metrics_register_source(name, type, width, (const uint8_t*)percpu_areas + offset, true);
+}
+
+/*
+ * Remove one metric
+ */
+void metrics_unregister(int id)
+{
+    if (id < 0 || id >= METRICS_MAX || !metrics_registry.metrics[id].name) {
+        return;
+    }
+
+    metrics_registry.metrics[id].name = NULL;
+    metrics_registry.metrics[id].source = NULL;
+    metrics_registry.count--;
+    metrics_registry.schema++;
+}
+
+/*
+ * Remove every metric whose name starts with prefix (e.g. on module unload)
+ */
+uint32_t metrics_unregister_prefix(const char* prefix)
+{
+    uint32_t removed = 0;
+
+    for (uint32_t id = 0; id < METRICS_MAX; id++) {
+        const char* name = metrics_registry.metrics[id].name;
+        if (!name) continue;
+
+        const char* p = prefix;
+        while (*p && *p == *name) {
+            p++;
+            name++;
+        }
+        if (*p == '\0') {
+            metrics_unregister((int)id);
+            removed++;
+        }
+    }
+
+    return removed;
+}
+
+// =============================================================================
+// Snapshots
+// =============================================================================
+
+/*
+ * Read a counter or gauge. 64-bit fields are read high-low-high so a
+ * carry from an interrupt between the two halves is retried, not torn;
+ * per-CPU fields are summed over every CPU the same way.
+ */
+static uint64_t metrics_read(const metric_t* metric)
+{
+    if (metric->percpu) {
+        uint32_t offset = (uint32_t)((const uint8_t*)metric->source - (const uint8_t*)percpu_areas);
+        return metric->width == sizeof(uint32_t) ? percpu_sum32(offset) : percpu_sum64(offset);
+    }
+
+    if (metric->width == sizeof(uint32_t)) {
+        return *(const volatile uint32_t*)metric->source;
+    }
+
+    const volatile uint32_t* halves = (const volatile uint32_t*)metric->source;
+    uint32_t high, low;
+    do {
+        high = halves[1];
+        low = halves[0];
+    } while (high != halves[1]);
+
+    return ((uint64_t)high << 32) | low;
+}
+
+/*
+ * Pack every registered metric into buffer; returns the bytes written
+ * (0 if the buffer cannot even hold the header)
+ */
+uint32_t metrics_snapshot(void* buffer, uint32_t size)
+{
+    if (!buffer || size < sizeof(metrics_snapshot_header_t)) {
+        return 0;
+    }
+
+    // Registered scheduler histograms are the merge of per-CPU ones
+    sched_trace_merge();
+
+    uint8_t* out = (uint8_t*)buffer;
+    uint32_t offset = sizeof(metrics_snapshot_header_t);
+    uint32_t count = 0;
+    uint32_t flags = 0;
+
+    for (uint32_t id = 0; id < METRICS_MAX; id++) {
+        const metric_t* metric = &metrics_registry.metrics[id];
+        if (!metric->name) continue;
+
+        metrics_record_t* record = (metrics_record_t*)(out + offset);
+
+        if (metric->type != METRIC_TYPE_HISTOGRAM) {
+            if (offset + sizeof(metrics_record_t) > size) {
+                flags |= METRICS_FLAG_TRUNCATED;
+                break;
+            }
+            record->id = (uint16_t)id;
+            record->type = metric->type;
+            record->bucket_count = 0;
+            record->value = metrics_read(metric);
+            offset += sizeof(metrics_record_t);
+            count++;
+            continue;
+        }
+
+        const sched_histogram_t* histogram = (const sched_histogram_t*)metric->source;
+        uint32_t buckets = 0;
+        for (uint32_t i = 0; i < SCHED_HIST_BUCKETS; i++) {
+            if (histogram->buckets[i]) buckets++;
+        }
+
+        uint32_t needed = sizeof(metrics_record_t) + sizeof(uint64_t) + sizeof(uint32_t) +
+                          buckets * sizeof(metrics_bucket_t);
+        if (offset + needed > size) {
+            flags |= METRICS_FLAG_TRUNCATED;
+            break;
+        }
+
+        record->id = (uint16_t)id;
+        record->type = METRIC_TYPE_HISTOGRAM;
+        record->bucket_count = (uint8_t)buckets;
+        record->value = histogram->count;
+        offset += sizeof(metrics_record_t);
+
+        *(uint64_t*)(out + offset) = histogram->sum;
+        offset += sizeof(uint64_t);
+        *(uint32_t*)(out + offset) = histogram->max;
+        offset += sizeof(uint32_t);
+
+        // Buckets are re-read, so one filled in meanwhile may be skipped
+        uint32_t written = 0;
+        for (uint32_t i = 0; i < SCHED_HIST_BUCKETS && written < buckets; i++) {
+            uint32_t value = histogram->buckets[i];
+            if (!value) continue;
+
+            metrics_bucket_t* bucket = (metrics_bucket_t*)(out + offset);
+            bucket->index = (uint16_t)i;
+            bucket->count = value;
+            offset += sizeof(metrics_bucket_t);
+            written++;
+        }
+        record->bucket_count = (uint8_t)written;
+        count++;
+    }
+
+    metrics_snapshot_header_t* header = (metrics_snapshot_header_t*)out;
+    header->magic = METRICS_MAGIC;
+    header->version = METRICS_VERSION;
+    header->count = (uint16_t)count;
+    header->sequence = ++metrics_registry.sequence;
+    header->schema = metrics_registry.schema;
+    header->length = offset;
+    header->flags = flags;
+    header->timestamp = read_timestamp_counter();
+
+    return offset;
+}
+
+/*
+ * Refresh the shared export page. Readers copy the page and retry when
+ * generation was odd or changed while they copied.
+ */
+void metrics_publish(void)
+{
+    metrics_page.generation++;
+    asm volatile ("" : : : "memory");
+
+    metrics_page.length = metrics_snapshot(metrics_page.data, sizeof(metrics_page.data));
+
+    asm volatile ("" : : : "memory");
+    metrics_page.generation++;
+}
+
+/*
+ * Shared export page (mapped read-only by monitoring actors)
+ */
+metrics_page_t* metrics_get_page(void)
+{
+    return &metrics_page;
+}
+
+/*
+ * Publish the page every ticks scheduler ticks (0 = only on demand)
+ */
+void metrics_set_publish_interval(uint32_t ticks)
+{
+    metrics_registry.publish_interval = ticks;
+    metrics_registry.publish_countdown = ticks;
+
+    if (ticks) {
+        kprintf("[METRICS] Publishing snapshots every %d ticks\n", ticks);
+    } else {
+        kprintf("[METRICS] Periodic publishing disabled\n");
+    }
+}
+
+/*
+ * Scheduler tick hook
+ */
+void metrics_tick(void)
+{
+    if (!metrics_registry.publish_interval) {
+        return;
+    }
+
+    if (--metrics_registry.publish_countdown == 0) {
+        metrics_registry.publish_countdown = metrics_registry.publish_interval;
+        metrics_publish();
+    }
+}
+
+// =============================================================================
+// Output
+// =============================================================================
+
+/*
+ * Write a value in decimal
+ */
+static void metrics_write_dec(uint32_t value)
+{
+    char digits[10];
+    int length = 0;
+
+    do {
+        digits[length++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    while (length > 0) {
+        serial_write_char(digits[--length]);
+    }
+}
+
+/*
+ * Write the schema and one snapshot to the serial port as
+ *
+ *   METRICS-SCHEMA schema=<n> count=<n>
+ *   METRIC <id> <type> <name>
+ *   ...
+ *   METRICS-BEGIN bytes=<n>\n <n snapshot bytes> METRICS-END\n
+ *
+ * Returns the snapshot size in bytes.
+ */
+int metrics_dump_serial(void)
+{
+    if (!serial_is_ready()) {
+        return -4;
+    }
+
+    serial_write_string("METRICS-SCHEMA schema=");
+    metrics_write_dec(metrics_registry.schema);
+    serial_write_string(" count=");
+    metrics_write_dec(metrics_registry.count);
+    serial_write_string("\n");
+
+    for (uint32_t id = 0; id < METRICS_MAX; id++) {
+        const metric_t* metric = &metrics_registry.metrics[id];
+        if (!metric->name) continue;
+
+        serial_write_string("METRIC ");
+        metrics_write_dec(id);
+        serial_write_char(' ');
+        serial_write_string(metric_type_names[metric->type]);
+        serial_write_char(' ');
+        serial_write_string(metric->name);
+        serial_write_string("\n");
+    }
+
+    uint32_t length = metrics_snapshot(metrics_buffer, sizeof(metrics_buffer));
+
+    serial_write_string("METRICS-BEGIN bytes=");
+    metrics_write_dec(length);
+    serial_write_string("\n");
+    serial_write(metrics_buffer, length);
+    serial_write_string("METRICS-END\n");
+
+    return (int)length;
+}
+
+/*
+ * Print every registered metric
+ */
+void metrics_print(void)
+{
+    sched_trace_merge();
+
+    kprintf("[METRICS] Registry: %d metrics (schema %d, %d snapshots)\n",
+            metrics_registry.count, metrics_registry.schema, metrics_registry.sequence);
+
+    for (uint32_t id = 0; id < METRICS_MAX; id++) {
+        const metric_t* metric = &metrics_registry.metrics[id];
+        if (!metric->name) continue;
+
+        if (metric->type == METRIC_TYPE_HISTOGRAM) {
+            sched_histogram_t* histogram = (sched_histogram_t*)metric->source;
+            if (histogram->count == 0) continue;
+
+            kprintf("      %s: n=%d p50=%d p99=%d max=%d\n", metric->name,
+                    (uint32_t)histogram->count,
+                    sched_hist_percentile(histogram, 500),
+                    sched_hist_percentile(histogram, 990),
+                    histogram->max);
+        } else {
+            kprintf("      %s: %d\n", metric->name, (uint32_t)metrics_read(metric));
+        }
+    }
+}
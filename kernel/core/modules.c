@@ -13,9 +13,14 @@
 
 #include "modules.h"
 #include "heap.h"
+#include "metrics.h"
 #include "kernel.h"
 #include "vga.h"
 
+// Function-entry tracing subsystem for this file (make TRACE=1)
+#define FTRACE_SUBSYSTEM module
+#include "ftrace.h"
+
 // =============================================================================
 // Global Module System State
 // =============================================================================
@@ -65,6 +70,16 @@ void modules_init(void)
     kernel_module_system.statistics.total_memory_used = 0;
     kernel_module_system.statistics.ai_interventions = 0;
     
+    // Export statistics through the metrics registry
+    module_stats_t* stats = &kernel_module_system.statistics;
+    METRICS_COUNTER("modules.loaded", stats->modules_loaded);
+    METRICS_COUNTER("modules.unloaded", stats->modules_unloaded);
+    METRICS_COUNTER("modules.hot_swaps", stats->hot_swaps);
+    METRICS_COUNTER("modules.load_errors", stats->load_errors);
+    METRICS_COUNTER("modules.symbol_lookups", stats->symbol_lookups);
+    METRICS_GAUGE("modules.count", kernel_module_system.module_count);
+    METRICS_GAUGE("modules.memory_used", stats->total_memory_used);
+    
     // Register core kernel symbols
     module_register_kernel_symbols();
     
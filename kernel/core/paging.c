@@ -16,6 +16,7 @@
 #include "paging.h"
 #include "memory.h"
 #include "kernel.h"
+#include "handle_table.h"
 #include "vga.h"
 
 // =============================================================================
@@ -29,6 +30,19 @@ bool paging_enabled = false;
 static uint32_t page_directory[1024] __attribute__((aligned(4096)));
 static uint32_t page_tables[256][1024] __attribute__((aligned(4096)));  // Up to 256 page tables
 static uint32_t next_page_table_index = 0;
+static uint32_t next_io_virtual = PAGING_IO_WINDOW_START;  // Bump pointer for paging_map_io
+
+// I/O window ranges already carved, by physical block. A range stays
+// reserved for its block after it is unmapped, so mapping the same block
+// again (a reloaded module, say) reuses it instead of carving a new one.
+typedef struct paging_window_range {
+    uint32_t physical_base;             // Page-aligned physical address
+    uint32_t virtual_base;              // Start of the range in the window
+    uint32_t page_count;                // Pages reserved
+} paging_window_range_t;
+
+static paging_window_range_t io_window_ranges[PAGING_IO_WINDOW_RANGES];
+static uint32_t io_window_range_count = 0;
 
 // =============================================================================
 // Paging Initialization
@@ -208,7 +222,7 @@ uint32_t paging_get_physical_address(uint32_t virtual_addr)
  */
 address_space_t* paging_create_address_space(uint32_t actor_id)
 {
-    if (actor_id >= MAX_ACTORS) {
+    if (handle_index(actor_id) >= MAX_ACTORS) {
         return NULL;
     }
     
@@ -336,16 +350,40 @@ void paging_handle_page_fault(uint32_t fault_addr, uint32_t error_code)
 // =============================================================================
 
 /*
- * Map physical memory for I/O
+ * Map a physical block into the I/O window with the given page flags,
+ * reusing the range it had if it was mapped before
  */
-void* paging_map_io(uint32_t physical_addr, size_t size)
+static void* paging_map_window(uint32_t physical_addr, size_t size, uint32_t flags)
 {
     // Align to page boundaries
     uint32_t page_aligned_addr = physical_addr & 0xFFFFF000;
-    uint32_t page_count = (size + 4095) / 4096;
+    uint32_t page_count = ((physical_addr & 0xFFF) + size + 4095) / 4096;
+    
+    uint32_t virtual_base = 0;
+    for (uint32_t i = 0; i < io_window_range_count; i++) {
+        paging_window_range_t* range = &io_window_ranges[i];
+        if (range->physical_base == page_aligned_addr && range->page_count >= page_count) {
+            virtual_base = range->virtual_base;
+            break;
+        }
+    }
     
-    // Find a virtual address range (simplified - use high addresses)
-    uint32_t virtual_base = 0xF0000000; // Start from 3.75GB
+    // Carve the next free range of the I/O window (LAPIC, IOAPIC, ...)
+    if (!virtual_base) {
+        if (page_count > (PAGING_IO_WINDOW_END - next_io_virtual) / 4096) {
+            kprintf("[PAGING] I/O window exhausted\n");
+            return NULL;
+        }
+        virtual_base = next_io_virtual;
+        next_io_virtual += page_count * 4096;
+        
+        if (io_window_range_count < PAGING_IO_WINDOW_RANGES) {
+            paging_window_range_t* range = &io_window_ranges[io_window_range_count++];
+            range->physical_base = page_aligned_addr;
+            range->virtual_base = virtual_base;
+            range->page_count = page_count;
+        }
+    }
     
     kprintf("[PAGING] Mapping I/O region: phys=0x%x size=%d pages=%d\n", 
             physical_addr, (uint32_t)size, page_count);
@@ -355,8 +393,7 @@ void* paging_map_io(uint32_t physical_addr, size_t size)
         uint32_t virt_addr = virtual_base + (i * 4096);
         uint32_t phys_addr = page_aligned_addr + (i * 4096);
         
-        if (!paging_map_page(virt_addr, phys_addr, 
-                           PAGE_FLAG_PRESENT | PAGE_FLAG_WRITABLE | PAGE_FLAG_CACHE_DISABLE)) {
+        if (!paging_map_page(virt_addr, phys_addr, flags)) {
             kprintf("[PAGING] Failed to map I/O page %d\n", i);
             return NULL;
         }
@@ -366,7 +403,24 @@ void* paging_map_io(uint32_t physical_addr, size_t size)
 }
 
 /*
- * Unmap I/O memory
+ * Map physical memory for I/O
+ */
+void* paging_map_io(uint32_t physical_addr, size_t size)
+{
+    return paging_map_window(physical_addr, size,
+                             PAGE_FLAG_PRESENT | PAGE_FLAG_WRITABLE | PAGE_FLAG_CACHE_DISABLE);
+}
+
+/*
+ * Map reserved RAM outside the identity map (write-back cached)
+ */
+void* paging_map_ram(uint32_t physical_addr, size_t size)
+{
+    return paging_map_window(physical_addr, size, PAGE_FLAG_PRESENT | PAGE_FLAG_WRITABLE);
+}
+
+/*
+ * Unmap I/O memory (the window range stays reserved for the same block)
  */
 void paging_unmap_io(void* virtual_addr, size_t size)
 {
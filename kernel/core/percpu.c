@@ -0,0 +1,46 @@
+/*
+ * =============================================================================
+ * CLKernel - Per-CPU Data
+ * =============================================================================
+ * File: percpu.c
+ * Purpose: Per-CPU data areas and their GS segment descriptors
+ *
+ * CPU n owns GDT entry GDT_PERCPU_FIRST + n, a byte-granular data segment
+ * covering exactly percpu_areas[n]. An access past the area faults instead
+ * of silently landing in the next CPU's counters.
+ * =============================================================================
+ */
+
+#include "percpu.h"
+#include "gdt.h"
+
+// =============================================================================
+// Global Per-CPU Areas
+// =============================================================================
+
+percpu_t percpu_areas[SMP_MAX_CPUS];
+
+// =============================================================================
+// Setup
+// =============================================================================
+
+/*
+ * Point this CPU's descriptor at its area and load it into GS. Every CPU
+ * shares one GDT, so only the owning CPU ever loads a given selector.
+ */
+void percpu_init_cpu(uint32_t cpu)
+{
+    if (cpu >= SMP_MAX_CPUS) {
+        return;
+    }
+
+    percpu_t* area = &percpu_areas[cpu];
+    area->self = area;
+    area->cpu = cpu;
+
+    // Present, ring 0, writable data; byte granularity, 32-bit
+    gdt_set_gate(GDT_PERCPU_FIRST + cpu, (uint32_t)area, sizeof(percpu_t) - 1, 0x92, 0x40);
+
+    uint16_t selector = GDT_PERCPU_SELECTOR(cpu);
+    asm volatile ("mov %0, %%gs" : : "r" (selector) : "memory");
+}
@@ -0,0 +1,467 @@
+/*
+ * =============================================================================
+ * CLKernel - Sampling Profiler
+ * =============================================================================
+ * File: profiler.c
+ * Purpose: Statistical profiling of kernel code from the timer or RTC interrupt
+ *
+ * The sampling interrupt only copies EIP and a bounded EBP-chain backtrace
+ * into the CPU's ring; it never formats or prints. The dumper drains the
+ * ring as "PROF" lines on the serial port, which tools/profiler/symbolize.py
+ * turns into flat profiles, call graphs and folded stacks for flame graphs.
+ *
+ * Backtraces need frame pointers, so the kernel is built with
+ * -fno-omit-frame-pointer.
+ * =============================================================================
+ */
+
+#include "profiler.h"
+#include "kernel.h"
+#include "serial.h"
+#include "scheduler.h"
+#include "ioapic.h"
+#include "../io.h"
+
+// =============================================================================
+// Hardware Constants
+// =============================================================================
+
+// CMOS / RTC ports and registers
+#define CMOS_ADDRESS                0x70
+#define CMOS_DATA                   0x71
+#define CMOS_NMI_DISABLE            0x80
+#define RTC_REG_A                   0x0A    // Rate select (low 4 bits)
+#define RTC_REG_B                   0x0B    // Control
+#define RTC_REG_C                   0x0C    // Interrupt flags (read to acknowledge)
+#define RTC_REG_B_PERIODIC          0x40    // Periodic interrupt enable
+#define RTC_RATE_BITS               16      // Periodic rate = 32768 >> (rate - 1) = 2^(16 - rate) Hz
+
+// Linker-provided bounds of kernel code (kernel.ld)
+extern char _kernel_start[];
+extern char _kernel_text_end[];
+
+extern scheduler_t kernel_scheduler;
+
+// =============================================================================
+// Global Profiler State
+// =============================================================================
+
+static profiler_state_t profiler_state;
+
+// =============================================================================
+// Profiler Lifecycle
+// =============================================================================
+
+/*
+ * Initialize the profiler (sampling stays off until profiler_start)
+ */
+void profiler_init(void)
+{
+    profiler_state.active = false;
+    profiler_state.source = PROFILER_SOURCE_TIMER;
+    profiler_state.rate = 1;
+    profiler_state.tick_countdown = 1;
+    profiler_state.started_at = 0;
+
+    profiler_reset();
+
+    profiler_state.initialized = true;
+    kprintf("[PROFILER] Sampling profiler ready (%d samples x %d CPU ring)\n",
+            PROFILER_RING_SIZE, PROFILER_MAX_CPUS);
+}
+
+/*
+ * Start sampling. For PROFILER_SOURCE_TIMER, rate is the number of timer
+ * ticks between samples; for PROFILER_SOURCE_RTC it is the sample frequency
+ * in Hz and must be a power of two between 2 and 8192.
+ */
+int profiler_start(uint8_t source, uint32_t rate)
+{
+    if (!profiler_state.initialized) {
+        return -1;
+    }
+
+    if (source == PROFILER_SOURCE_TIMER) {
+        if (rate == 0) {
+            return -3;
+        }
+    } else if (source == PROFILER_SOURCE_RTC) {
+        if (rate < PROFILER_RTC_MIN_HZ || rate > PROFILER_RTC_MAX_HZ ||
+            (rate & (rate - 1)) != 0) {
+            return -3;
+        }
+    } else {
+        return -3;
+    }
+
+    if (profiler_state.active) {
+        profiler_stop();
+    }
+
+    profiler_state.source = source;
+    profiler_state.rate = rate;
+    profiler_state.tick_countdown = rate;
+    profiler_state.started_at = read_timestamp_counter();
+    profiler_state.active = true;
+
+    if (source == PROFILER_SOURCE_RTC) {
+        profiler_rtc_enable(rate);
+        kprintf("[PROFILER] Sampling started: RTC at %d Hz\n", rate);
+    } else {
+        kprintf("[PROFILER] Sampling started: every %d timer ticks\n", rate);
+    }
+
+    return 0;
+}
+
+/*
+ * Stop sampling; samples already in the rings are kept for dumping
+ */
+void profiler_stop(void)
+{
+    if (!profiler_state.active) {
+        return;
+    }
+
+    profiler_state.active = false;
+
+    if (profiler_state.source == PROFILER_SOURCE_RTC) {
+        profiler_rtc_disable();
+    }
+
+    kprintf("[PROFILER] Sampling stopped\n");
+}
+
+/*
+ * Discard all buffered samples and statistics
+ */
+void profiler_reset(void)
+{
+    for (uint32_t cpu = 0; cpu < PROFILER_MAX_CPUS; cpu++) {
+        profiler_cpu_t* ring = &profiler_state.cpus[cpu];
+        ring->head = 0;
+        ring->tail = 0;
+        ring->samples_taken = 0;
+        ring->samples_dropped = 0;
+        ring->stacks_truncated = 0;
+    }
+}
+
+/*
+ * Check whether sampling is running
+ */
+bool profiler_is_active(void)
+{
+    return profiler_state.active;
+}
+
+// =============================================================================
+// Interrupt Hooks
+// =============================================================================
+
+/*
+ * Timer IRQ hook: sample every rate-th tick
+ */
+void profiler_timer_tick(interrupt_frame_t* frame)
+{
+    if (!profiler_state.active || profiler_state.source != PROFILER_SOURCE_TIMER) {
+        return;
+    }
+
+    if (--profiler_state.tick_countdown != 0) {
+        return;
+    }
+
+    profiler_state.tick_countdown = profiler_state.rate;
+    profiler_record_sample(frame);
+}
+
+/*
+ * RTC periodic interrupt (IRQ8)
+ */
+void profiler_rtc_irq_handler(interrupt_frame_t* frame)
+{
+    // Register C must be read or the RTC raises no further interrupts
+    outb(CMOS_ADDRESS, RTC_REG_C);
+    inb(CMOS_DATA);
+
+    if (profiler_state.active && profiler_state.source == PROFILER_SOURCE_RTC) {
+        profiler_record_sample(frame);
+    }
+}
+
+// =============================================================================
+// Sampling
+// =============================================================================
+
+/*
+ * Store one sample of the interrupted context. Runs with interrupts off;
+ * the ring is single-producer (this CPU's interrupt) / single-consumer
+ * (the dumper), so only head is written here.
+ */
+void profiler_record_sample(interrupt_frame_t* frame)
+{
+    uint32_t index = smp_cpu_id();
+    if (index >= PROFILER_MAX_CPUS) {
+        return; // No ring for this CPU
+    }
+
+    profiler_cpu_t* ring = &profiler_state.cpus[index];
+    uint32_t head = ring->head;
+
+    if (head - ring->tail >= PROFILER_RING_SIZE) {
+        ring->samples_dropped++;
+        return;
+    }
+
+    profiler_sample_t* sample = &ring->ring[head & (PROFILER_RING_SIZE - 1)];
+    sample->timestamp = (uint32_t)read_timestamp_counter();
+    sample->eip = frame->eip;
+    actor_t* current = kernel_scheduler.cpus[index].current_actor;
+    sample->actor_id = current ? current->actor_id : 0;
+    sample->flags = 0;
+    sample->reserved = 0;
+    sample->depth = profiler_walk_stack(frame->ebp, sample->callers, &sample->flags);
+
+    if (sample->flags & PROFILER_SAMPLE_TRUNCATED) {
+        ring->stacks_truncated++;
+    }
+    ring->samples_taken++;
+
+    // Publish the sample only after it is fully written
+    asm volatile ("" ::: "memory");
+    ring->head = head + 1;
+}
+
+/*
+ * Follow the saved-EBP chain starting at the interrupted frame pointer.
+ * Every step is bounds-checked, so a corrupt or frame-pointer-less stack
+ * ends the walk instead of faulting.
+ */
+uint8_t profiler_walk_stack(uint32_t ebp, uint32_t* callers, uint8_t* flags)
+{
+    uint8_t depth = 0;
+
+    while (ebp >= (uint32_t)_kernel_start &&
+           ebp <= PROFILER_STACK_LIMIT - 8 &&
+           (ebp & 3) == 0) {
+        uint32_t* frame = (uint32_t*)ebp;
+        uint32_t return_address = frame[1];
+        uint32_t next_ebp = frame[0];
+
+        if (!profiler_is_kernel_text(return_address)) {
+            break;
+        }
+
+        if (depth == PROFILER_MAX_DEPTH) {
+            *flags |= PROFILER_SAMPLE_TRUNCATED;
+            break;
+        }
+        callers[depth++] = return_address;
+
+        // Stacks grow down, so callers' frames are strictly higher
+        if (next_ebp <= ebp || next_ebp - ebp > PROFILER_MAX_FRAME_SIZE) {
+            break;
+        }
+        ebp = next_ebp;
+    }
+
+    return depth;
+}
+
+/*
+ * Check whether an address lies inside the kernel's code section
+ */
+bool profiler_is_kernel_text(uint32_t address)
+{
+    return address >= (uint32_t)_kernel_start && address < (uint32_t)_kernel_text_end;
+}
+
+// =============================================================================
+// RTC Periodic Interrupt Control
+// =============================================================================
+
+/*
+ * Program the RTC periodic interrupt to hz (a power of two) and unmask IRQ8
+ */
+void profiler_rtc_enable(uint32_t hz)
+{
+    uint8_t rate = RTC_RATE_BITS;
+    while (hz > 1) {
+        hz >>= 1;
+        rate--;
+    }
+
+    bool were_enabled = interrupts_enabled();
+    interrupts_disable();
+
+    outb(CMOS_ADDRESS, CMOS_NMI_DISABLE | RTC_REG_A);
+    uint8_t reg_a = inb(CMOS_DATA);
+    outb(CMOS_ADDRESS, CMOS_NMI_DISABLE | RTC_REG_A);
+    outb(CMOS_DATA, (reg_a & 0xF0) | rate);
+
+    outb(CMOS_ADDRESS, CMOS_NMI_DISABLE | RTC_REG_B);
+    uint8_t reg_b = inb(CMOS_DATA);
+    outb(CMOS_ADDRESS, CMOS_NMI_DISABLE | RTC_REG_B);
+    outb(CMOS_DATA, reg_b | RTC_REG_B_PERIODIC);
+
+    // Clear any interrupt already pending, then re-enable NMI
+    outb(CMOS_ADDRESS, RTC_REG_C);
+    inb(CMOS_DATA);
+
+    if (were_enabled) {
+        interrupts_enable();
+    }
+
+    irq_unmask(IRQ2_CASCADE);
+    irq_unmask(IRQ8_RTC);
+}
+
+/*
+ * Stop the RTC periodic interrupt and mask IRQ8
+ */
+void profiler_rtc_disable(void)
+{
+    irq_mask(IRQ8_RTC);
+
+    bool were_enabled = interrupts_enabled();
+    interrupts_disable();
+
+    outb(CMOS_ADDRESS, CMOS_NMI_DISABLE | RTC_REG_B);
+    uint8_t reg_b = inb(CMOS_DATA);
+    outb(CMOS_ADDRESS, CMOS_NMI_DISABLE | RTC_REG_B);
+    outb(CMOS_DATA, reg_b & ~RTC_REG_B_PERIODIC);
+
+    outb(CMOS_ADDRESS, RTC_REG_C);
+    inb(CMOS_DATA);
+
+    if (were_enabled) {
+        interrupts_enable();
+    }
+}
+
+// =============================================================================
+// Output
+// =============================================================================
+
+/*
+ * Write a value as lowercase hex without leading zeros
+ */
+static void profiler_write_hex(uint32_t value)
+{
+    char digits[9];
+    int length = 0;
+
+    do {
+        uint8_t nibble = value & 0xF;
+        digits[length++] = nibble < 10 ? '0' + nibble : 'a' + nibble - 10;
+        value >>= 4;
+    } while (value);
+
+    while (length > 0) {
+        serial_write_char(digits[--length]);
+    }
+}
+
+/*
+ * Write a value in decimal
+ */
+static void profiler_write_dec(uint32_t value)
+{
+    char digits[10];
+    int length = 0;
+
+    do {
+        digits[length++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    while (length > 0) {
+        serial_write_char(digits[--length]);
+    }
+}
+
+/*
+ * Drain up to max_samples samples (0 = all) to the serial port, one line each:
+ *
+ *   PROF <cpu> <actor> <tsc-hex> <flags> <eip-hex> [<caller-hex> ...]
+ *
+ * framed by PROF-BEGIN / PROF-END lines. Sampling may keep running while
+ * the rings are drained. Returns the number of samples written.
+ */
+uint32_t profiler_dump_serial(uint32_t max_samples)
+{
+    if (!serial_is_ready()) {
+        return 0;
+    }
+
+    uint32_t written = 0;
+
+    serial_write_string("PROF-BEGIN source=");
+    serial_write_string(profiler_state.source == PROFILER_SOURCE_RTC ? "rtc" : "timer");
+    serial_write_string(" rate=");
+    profiler_write_dec(profiler_state.rate);
+    serial_write_string(" cpus=");
+    profiler_write_dec(PROFILER_MAX_CPUS);
+    serial_write_string("\n");
+
+    for (uint32_t cpu = 0; cpu < PROFILER_MAX_CPUS; cpu++) {
+        profiler_cpu_t* ring = &profiler_state.cpus[cpu];
+
+        while (ring->tail != ring->head) {
+            if (max_samples && written >= max_samples) {
+                break;
+            }
+
+            profiler_sample_t* sample = &ring->ring[ring->tail & (PROFILER_RING_SIZE - 1)];
+
+            serial_write_string("PROF ");
+            profiler_write_dec(cpu);
+            serial_write_char(' ');
+            profiler_write_dec(sample->actor_id);
+            serial_write_char(' ');
+            profiler_write_hex(sample->timestamp);
+            serial_write_char(' ');
+            profiler_write_dec(sample->flags);
+            serial_write_char(' ');
+            profiler_write_hex(sample->eip);
+            for (uint8_t i = 0; i < sample->depth; i++) {
+                serial_write_char(' ');
+                profiler_write_hex(sample->callers[i]);
+            }
+            serial_write_string("\n");
+
+            // Release the slot only after it has been copied out
+            asm volatile ("" ::: "memory");
+            ring->tail++;
+            written++;
+        }
+    }
+
+    serial_write_string("PROF-END samples=");
+    profiler_write_dec(written);
+    serial_write_string(" dropped=");
+    profiler_write_dec((uint32_t)profiler_state.cpus[0].samples_dropped);
+    serial_write_string("\n");
+
+    return written;
+}
+
+/*
+ * Print profiler statistics
+ */
+void profiler_print_stats(void)
+{
+    kprintf("[PROFILER] Profiler Statistics:\n");
+    kprintf("      State: %s\n", profiler_state.active ? "SAMPLING" : "STOPPED");
+    kprintf("      Source: %s (rate %d)\n",
+            profiler_state.source == PROFILER_SOURCE_RTC ? "RTC" : "timer",
+            profiler_state.rate);
+
+    for (uint32_t cpu = 0; cpu < PROFILER_MAX_CPUS; cpu++) {
+        profiler_cpu_t* ring = &profiler_state.cpus[cpu];
+        kprintf("      CPU %d: %d taken, %d buffered, %d dropped, %d truncated\n",
+                cpu, (uint32_t)ring->samples_taken, ring->head - ring->tail,
+                (uint32_t)ring->samples_dropped, (uint32_t)ring->stacks_truncated);
+    }
+}
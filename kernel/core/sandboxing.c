@@ -18,6 +18,7 @@
 #include "modules.h"
 #include "memory.h"
 #include "heap.h"
+#include "metrics.h"
 #include "vga.h"
 
 // =============================================================================
@@ -60,6 +61,13 @@ int sandboxing_init(void)
     sandbox_system.total_enforcements = 0;
     sandbox_system.quarantined_modules = 0;
     
+    // Export statistics through the metrics registry
+    METRICS_COUNTER("sandbox.capability_checks", sandbox_system.total_capability_checks);
+    METRICS_COUNTER("sandbox.violations", sandbox_system.total_violations);
+    METRICS_COUNTER("sandbox.enforcements", sandbox_system.total_enforcements);
+    METRICS_GAUGE("sandbox.active", sandbox_system.sandbox_count);
+    METRICS_GAUGE("sandbox.quarantined_modules", sandbox_system.quarantined_modules);
+    
     // Initialize default security policies
     sandboxing_init_default_policies();
     
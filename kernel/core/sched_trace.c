@@ -0,0 +1,617 @@
+/*
+ * =============================================================================
+ * CLKernel - Scheduler Event Tracer
+ * =============================================================================
+ * File: sched_trace.c
+ * Purpose: Switch/wakeup/block/delivery tracepoints and latency histograms
+ *
+ * Tracepoints cost one TSC read and a few stores to the recording CPU's
+ * own ring and histograms; readers merge the CPUs. Histograms are
+ * log-linear: recording is a bit scan plus an increment, and percentiles
+ * are answered from the buckets without keeping samples. Values are
+ * clamped to 32 bits (about a second of cycles).
+ * =============================================================================
+ */
+
+#include "sched_trace.h"
+#include "kernel.h"
+#include "heap.h"
+#include "serial.h"
+#include "metrics.h"
+#include "smp.h"
+
+extern scheduler_t kernel_scheduler;
+
+// =============================================================================
+// Global Tracer State
+// =============================================================================
+
+static sched_trace_state_t sched_trace_state;
+
+static const char* sched_hist_names[SCHED_HIST_COUNT] = {
+    "wakeup-to-run (cycles)",
+    "message queueing (cycles)",
+    "timeslice use (%)"
+};
+
+// Metrics registry names, one per histogram
+static const char* sched_hist_metric_names[SCHED_HIST_COUNT][SCHED_TRACE_CLASSES] = {
+    {"sched.wakeup_latency.critical", "sched.wakeup_latency.high", "sched.wakeup_latency.normal",
+     "sched.wakeup_latency.low", "sched.wakeup_latency.idle"},
+    {"sched.queue_delay.critical", "sched.queue_delay.high", "sched.queue_delay.normal",
+     "sched.queue_delay.low", "sched.queue_delay.idle"},
+    {"sched.slice_use.critical", "sched.slice_use.high", "sched.slice_use.normal",
+     "sched.slice_use.low", "sched.slice_use.idle"}
+};
+
+// =============================================================================
+// Tracer Control
+// =============================================================================
+
+/*
+ * Initialize the tracer (enabled by default)
+ */
+void sched_trace_init(void)
+{
+    sched_trace_reset();
+    sched_trace_state.last_tick_tsc = 0;
+    sched_trace_state.cycles_per_tick = 0;
+    sched_trace_state.enabled = true;
+
+    for (uint32_t metric = 0; metric < SCHED_HIST_COUNT; metric++) {
+        for (uint32_t class = 0; class < SCHED_TRACE_CLASSES; class++) {
+            METRICS_HISTOGRAM(sched_hist_metric_names[metric][class],
+                              &sched_trace_state.histograms[metric][class]);
+        }
+    }
+}
+
+/*
+ * Turn event recording and histograms on or off
+ */
+void sched_trace_enable(bool enabled)
+{
+    sched_trace_state.enabled = enabled;
+    kprintf("[SCHED-TRACE] Tracing %s\n", enabled ? "ENABLED" : "DISABLED");
+}
+
+/*
+ * Empty one histogram
+ */
+static void sched_hist_clear(sched_histogram_t* histogram)
+{
+    for (uint32_t i = 0; i < SCHED_HIST_BUCKETS; i++) {
+        histogram->buckets[i] = 0;
+    }
+    histogram->count = 0;
+    histogram->sum = 0;
+    histogram->max = 0;
+}
+
+/*
+ * Clear one CPU's event ring, histograms and counters
+ */
+static void sched_trace_clear_cpu(sched_trace_cpu_t* trace)
+{
+    uint32_t flags = cpu_irq_save();
+
+    trace->head = 0;
+    trace->tail = 0;
+
+    for (uint32_t metric = 0; metric < SCHED_HIST_COUNT; metric++) {
+        for (uint32_t class = 0; class < SCHED_TRACE_CLASSES; class++) {
+            sched_hist_clear(&trace->histograms[metric][class]);
+        }
+    }
+
+    for (uint32_t i = 0; i < 4; i++) {
+        trace->events[i] = 0;
+    }
+
+    cpu_irq_restore(flags);
+}
+
+/*
+ * Clear the event rings, histograms and counters
+ */
+void sched_trace_reset(void)
+{
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        if (sched_trace_state.cpus[cpu]) {
+            sched_trace_clear_cpu(sched_trace_state.cpus[cpu]);
+        }
+    }
+
+    for (uint32_t metric = 0; metric < SCHED_HIST_COUNT; metric++) {
+        for (uint32_t class = 0; class < SCHED_TRACE_CLASSES; class++) {
+            sched_hist_clear(&sched_trace_state.histograms[metric][class]);
+        }
+    }
+}
+
+/*
+ * Give a CPU its ring and histograms (kept if it comes online again).
+ * Without them its tracepoints record nothing.
+ */
+void sched_trace_cpu_online(uint32_t cpu)
+{
+    if (cpu >= SMP_MAX_CPUS || sched_trace_state.cpus[cpu]) {
+        return;
+    }
+
+    sched_trace_cpu_t* trace = kmalloc(sizeof(sched_trace_cpu_t));
+    if (!trace) {
+        kprintf("[SCHED-TRACE] WARNING: No memory to trace CPU %d\n", cpu);
+        return;
+    }
+
+    sched_trace_clear_cpu(trace);
+    sched_trace_state.cpus[cpu] = trace;
+}
+
+// =============================================================================
+// Tracepoints
+// =============================================================================
+
+/*
+ * Priority class of an actor (histogram row)
+ */
+static inline uint8_t sched_trace_class(actor_t* actor)
+{
+    return actor->priority < SCHED_TRACE_CLASSES ? actor->priority : SCHED_TRACE_CLASSES - 1;
+}
+
+/*
+ * Clamp a TSC interval to 32 bits
+ */
+static inline uint32_t sched_trace_interval(uint64_t from, uint64_t to)
+{
+    uint64_t delta = to - from;
+    return delta > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)delta;
+}
+
+/*
+ * Append one event to this CPU's ring, overwriting the oldest when full
+ * (interrupts off)
+ */
+static void sched_trace_record(sched_trace_cpu_t* trace, uint8_t type, actor_t* actor,
+                               uint32_t arg0, uint32_t arg1, uint64_t now)
+{
+    sched_trace_event_t* event = &trace->ring[trace->head & (SCHED_TRACE_RING_SIZE - 1)];
+
+    event->timestamp = now;
+    event->type = type;
+    event->priority = sched_trace_class(actor);
+    event->cpu = (uint16_t)smp_cpu_id();
+    event->actor_id = actor->actor_id;
+    event->arg0 = arg0;
+    event->arg1 = arg1;
+
+    trace->head++;
+    trace->events[type]++;
+}
+
+/*
+ * Context switch: closes prev's run (timeslice utilization) and next's
+ * wait on the ready queue (wakeup-to-run latency)
+ */
+void sched_trace_switch(actor_t* prev, actor_t* next)
+{
+    sched_trace_cpu_t* trace = sched_trace_state.cpus[smp_cpu_id()];
+    if (!sched_trace_state.enabled || !trace || !next) {
+        return;
+    }
+
+    uint32_t flags = cpu_irq_save();
+    uint64_t now = read_timestamp_counter();
+
+    if (prev && prev->run_since) {
+        uint32_t used;
+        if (sched_trace_state.cycles_per_tick) {
+            uint32_t cycles_per_percent =
+                (sched_trace_state.cycles_per_tick / 100) * scheduler_timeslice_us() / SCHEDULER_TICK_US;
+            used = sched_trace_interval(prev->run_since, now) / (cycles_per_percent ? cycles_per_percent : 1);
+        } else {
+            // Not calibrated yet: fall back to whole ticks
+            used = (uint32_t)(kernel_scheduler.tick_count - prev->last_scheduled) * 100 /
+                   SCHEDULER_TIMESLICE_MS;
+        }
+        sched_hist_record(&trace->histograms[SCHED_HIST_SLICE_USE][sched_trace_class(prev)], used);
+        prev->run_since = 0;
+    }
+
+    if (next->ready_since) {
+        sched_hist_record(&trace->histograms[SCHED_HIST_WAKEUP_LATENCY][sched_trace_class(next)],
+                          sched_trace_interval(next->ready_since, now));
+        next->ready_since = 0;
+    }
+    next->run_since = now;
+
+    sched_trace_record(trace, SCHED_EVENT_SWITCH, next,
+                       prev ? prev->actor_id : 0, prev ? prev->state : 0, now);
+    cpu_irq_restore(flags);
+}
+
+/*
+ * Actor became runnable after waiting (created, blocked, throttled)
+ */
+void sched_trace_wakeup(actor_t* actor, uint8_t from_state)
+{
+    sched_trace_cpu_t* trace = sched_trace_state.cpus[smp_cpu_id()];
+    if (!sched_trace_state.enabled || !trace) {
+        return;
+    }
+
+    uint32_t flags = cpu_irq_save();
+    sched_trace_record(trace, SCHED_EVENT_WAKEUP, actor, from_state, 0, read_timestamp_counter());
+    cpu_irq_restore(flags);
+}
+
+/*
+ * Actor stopped being runnable (blocked on a message, throttled, suspended)
+ */
+void sched_trace_block(actor_t* actor, uint8_t new_state)
+{
+    sched_trace_cpu_t* trace = sched_trace_state.cpus[smp_cpu_id()];
+    if (!sched_trace_state.enabled || !trace) {
+        return;
+    }
+
+    actor->ready_since = 0;
+
+    uint32_t flags = cpu_irq_save();
+    sched_trace_record(trace, SCHED_EVENT_BLOCK, actor, new_state, 0, read_timestamp_counter());
+    cpu_irq_restore(flags);
+}
+
+/*
+ * Actor joined the ready queue: start its wakeup-to-run clock
+ */
+void sched_trace_ready(actor_t* actor)
+{
+    if (!sched_trace_state.enabled) {
+        return;
+    }
+
+    actor->ready_since = read_timestamp_counter();
+}
+
+/*
+ * Message taken off the recipient's queue
+ */
+void sched_trace_deliver(actor_t* recipient, message_t* message)
+{
+    sched_trace_cpu_t* trace = sched_trace_state.cpus[smp_cpu_id()];
+    if (!sched_trace_state.enabled || !trace) {
+        return;
+    }
+
+    uint32_t flags = cpu_irq_save();
+    uint64_t now = read_timestamp_counter();
+    uint32_t delay = message->queued_at ? sched_trace_interval(message->queued_at, now) : 0;
+
+    sched_hist_record(&trace->histograms[SCHED_HIST_QUEUE_DELAY][sched_trace_class(recipient)], delay);
+    sched_trace_record(trace, SCHED_EVENT_DELIVER, recipient, message->sender_id, delay, now);
+    cpu_irq_restore(flags);
+}
+
+/*
+ * Scheduler tick: calibrate TSC cycles per tick (smoothed, 1/8 weight)
+ */
+void sched_trace_tick(void)
+{
+    uint64_t now = read_timestamp_counter();
+
+    if (sched_trace_state.last_tick_tsc) {
+        uint32_t delta = sched_trace_interval(sched_trace_state.last_tick_tsc, now);
+        uint32_t current = sched_trace_state.cycles_per_tick;
+        sched_trace_state.cycles_per_tick = current ? current - current / 8 + delta / 8 : delta;
+    }
+    sched_trace_state.last_tick_tsc = now;
+}
+
+// =============================================================================
+// Histograms
+// =============================================================================
+
+/*
+ * Bucket index of a value
+ */
+static inline uint32_t sched_hist_index(uint32_t value)
+{
+    if (value < SCHED_HIST_SUB_BUCKETS) {
+        return value;
+    }
+
+    uint32_t shift = (31 - __builtin_clz(value)) - SCHED_HIST_SUB_BITS;
+    return (shift + 1) * SCHED_HIST_SUB_BUCKETS + ((value >> shift) & (SCHED_HIST_SUB_BUCKETS - 1));
+}
+
+/*
+ * Largest value that falls in a bucket
+ */
+static inline uint32_t sched_hist_bucket_limit(uint32_t index)
+{
+    if (index < SCHED_HIST_SUB_BUCKETS) {
+        return index;
+    }
+
+    uint32_t shift = index / SCHED_HIST_SUB_BUCKETS - 1;
+    uint32_t low = (SCHED_HIST_SUB_BUCKETS + index % SCHED_HIST_SUB_BUCKETS) << shift;
+    return low + ((1u << shift) - 1);
+}
+
+/*
+ * Record one value
+ */
+void sched_hist_record(sched_histogram_t* histogram, uint32_t value)
+{
+    histogram->buckets[sched_hist_index(value)]++;
+    histogram->count++;
+    histogram->sum += value;
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+/*
+ * Value at or below which per_mille/1000 of the recorded values fall
+ * (bucket upper bound, capped at the true maximum)
+ */
+uint32_t sched_hist_percentile(sched_histogram_t* histogram, uint32_t per_mille)
+{
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    uint32_t total = histogram->count > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)histogram->count;
+    uint32_t rank = (total / 1000) * per_mille + ((total % 1000) * per_mille + 999) / 1000;
+    if (rank == 0) rank = 1;
+
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < SCHED_HIST_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            uint32_t limit = sched_hist_bucket_limit(i);
+            return limit < histogram->max ? limit : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+/*
+ * Sum one histogram over every CPU into the merged copy (a racy but
+ * consistent-enough snapshot: CPUs keep recording meanwhile)
+ */
+static sched_histogram_t* sched_trace_merge_one(uint32_t metric, uint32_t class)
+{
+    sched_histogram_t* merged = &sched_trace_state.histograms[metric][class];
+    sched_hist_clear(merged);
+
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        sched_trace_cpu_t* trace = sched_trace_state.cpus[cpu];
+        if (!trace) continue;
+
+        sched_histogram_t* histogram = &trace->histograms[metric][class];
+        if (histogram->count == 0) continue;
+
+        for (uint32_t i = 0; i < SCHED_HIST_BUCKETS; i++) {
+            merged->buckets[i] += histogram->buckets[i];
+        }
+        merged->count += histogram->count;
+        merged->sum += histogram->sum;
+        if (histogram->max > merged->max) {
+            merged->max = histogram->max;
+        }
+    }
+
+    return merged;
+}
+
+/*
+ * Refresh every merged histogram (the ones in the metrics registry)
+ */
+void sched_trace_merge(void)
+{
+    for (uint32_t metric = 0; metric < SCHED_HIST_COUNT; metric++) {
+        for (uint32_t class = 0; class < SCHED_TRACE_CLASSES; class++) {
+            sched_trace_merge_one(metric, class);
+        }
+    }
+}
+
+/*
+ * Histogram for one metric and priority class, merged over all CPUs
+ */
+sched_histogram_t* sched_trace_get_histogram(uint8_t metric, uint8_t priority)
+{
+    if (metric >= SCHED_HIST_COUNT || priority >= SCHED_TRACE_CLASSES) {
+        return NULL;
+    }
+
+    return sched_trace_merge_one(metric, priority);
+}
+
+/*
+ * Events of one type recorded on every CPU
+ */
+static uint32_t sched_trace_event_count(uint8_t type)
+{
+    uint64_t total = 0;
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        if (sched_trace_state.cpus[cpu]) {
+            total += sched_trace_state.cpus[cpu]->events[type];
+        }
+    }
+    return (uint32_t)total;
+}
+
+// =============================================================================
+// Output
+// =============================================================================
+
+/*
+ * Print p50/p90/p99/max for every non-empty histogram
+ */
+void sched_trace_print_histograms(void)
+{
+    sched_trace_merge();
+
+    kprintf("[SCHED-TRACE] Scheduler Latency Histograms:\n");
+    kprintf("      Events: %d switch, %d wakeup, %d block, %d deliver\n",
+            sched_trace_event_count(SCHED_EVENT_SWITCH),
+            sched_trace_event_count(SCHED_EVENT_WAKEUP),
+            sched_trace_event_count(SCHED_EVENT_BLOCK),
+            sched_trace_event_count(SCHED_EVENT_DELIVER));
+    kprintf("      TSC cycles per tick: %d\n", sched_trace_state.cycles_per_tick);
+
+    for (uint32_t metric = 0; metric < SCHED_HIST_COUNT; metric++) {
+        kprintf("      %s\n", sched_hist_names[metric]);
+        for (uint32_t class = 0; class < SCHED_TRACE_CLASSES; class++) {
+            sched_histogram_t* histogram = &sched_trace_state.histograms[metric][class];
+            if (histogram->count == 0) continue;
+
+            kprintf("        %s: n=%d p50=%d p90=%d p99=%d max=%d\n",
+                    actor_priority_name(class), (uint32_t)histogram->count,
+                    sched_hist_percentile(histogram, 500),
+                    sched_hist_percentile(histogram, 900),
+                    sched_hist_percentile(histogram, 990),
+                    histogram->max);
+        }
+    }
+}
+
+/*
+ * Write a value in decimal
+ */
+static void sched_trace_write_dec(uint32_t value)
+{
+    char digits[10];
+    int length = 0;
+
+    do {
+        digits[length++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    while (length > 0) {
+        serial_write_char(digits[--length]);
+    }
+}
+
+/*
+ * Write a 64-bit value as 16 hex digits
+ */
+static void sched_trace_write_hex64(uint64_t value)
+{
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        uint8_t nibble = (uint8_t)(value >> shift) & 0xF;
+        serial_write_char(nibble < 10 ? '0' + nibble : 'a' + nibble - 10);
+    }
+}
+
+/*
+ * Export new events and all histograms to the serial port:
+ *
+ *   SCHED-BEGIN events=<n> lost=<n> cycles_per_tick=<n>
+ *   SCHED <tsc-hex> <type> <actor> <class> <arg0> <arg1>
+ *   SCHEDHIST <metric> <class> <count> <sum-hex> <max> <bucket>:<n> ...
+ *   SCHED-END
+ *
+ * Returns the number of events written.
+ */
+uint32_t sched_trace_dump_serial(void)
+{
+    if (!serial_is_ready()) {
+        return 0;
+    }
+
+    // Heads are sampled once; events recorded during the dump wait for the
+    // next one. Whatever a ring no longer holds is counted as lost.
+    uint32_t heads[SMP_MAX_CPUS];
+    uint32_t lost = 0;
+    uint32_t count = 0;
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        sched_trace_cpu_t* trace = sched_trace_state.cpus[cpu];
+        heads[cpu] = trace ? trace->head : 0;
+        if (!trace) continue;
+
+        if (heads[cpu] - trace->tail > SCHED_TRACE_RING_SIZE) {
+            lost += heads[cpu] - trace->tail - SCHED_TRACE_RING_SIZE;
+            trace->tail = heads[cpu] - SCHED_TRACE_RING_SIZE;
+        }
+        count += heads[cpu] - trace->tail;
+    }
+
+    serial_write_string("SCHED-BEGIN events=");
+    sched_trace_write_dec(count);
+    serial_write_string(" lost=");
+    sched_trace_write_dec(lost);
+    serial_write_string(" cycles_per_tick=");
+    sched_trace_write_dec(sched_trace_state.cycles_per_tick);
+    serial_write_string("\n");
+
+    // Oldest event first across the CPU rings (TSCs are comparable)
+    for (uint32_t written = 0; written < count; written++) {
+        sched_trace_cpu_t* oldest = NULL;
+        sched_trace_event_t* event = NULL;
+        for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+            sched_trace_cpu_t* trace = sched_trace_state.cpus[cpu];
+            if (!trace || trace->tail == heads[cpu]) continue;
+
+            sched_trace_event_t* candidate = &trace->ring[trace->tail & (SCHED_TRACE_RING_SIZE - 1)];
+            if (!event || candidate->timestamp < event->timestamp) {
+                oldest = trace;
+                event = candidate;
+            }
+        }
+
+        serial_write_string("SCHED ");
+        sched_trace_write_hex64(event->timestamp);
+        serial_write_char(' ');
+        sched_trace_write_dec(event->type);
+        serial_write_char(' ');
+        sched_trace_write_dec(event->actor_id);
+        serial_write_char(' ');
+        sched_trace_write_dec(event->priority);
+        serial_write_char(' ');
+        sched_trace_write_dec(event->arg0);
+        serial_write_char(' ');
+        sched_trace_write_dec(event->arg1);
+        serial_write_string("\n");
+
+        oldest->tail++;
+    }
+
+    sched_trace_merge();
+
+    for (uint32_t metric = 0; metric < SCHED_HIST_COUNT; metric++) {
+        for (uint32_t class = 0; class < SCHED_TRACE_CLASSES; class++) {
+            sched_histogram_t* histogram = &sched_trace_state.histograms[metric][class];
+            if (histogram->count == 0) continue;
+
+            serial_write_string("SCHEDHIST ");
+            sched_trace_write_dec(metric);
+            serial_write_char(' ');
+            sched_trace_write_dec(class);
+            serial_write_char(' ');
+            sched_trace_write_dec((uint32_t)histogram->count);
+            serial_write_char(' ');
+            sched_trace_write_hex64(histogram->sum);
+            serial_write_char(' ');
+            sched_trace_write_dec(histogram->max);
+            for (uint32_t i = 0; i < SCHED_HIST_BUCKETS; i++) {
+                if (histogram->buckets[i] == 0) continue;
+                serial_write_char(' ');
+                sched_trace_write_dec(i);
+                serial_write_char(':');
+                sched_trace_write_dec(histogram->buckets[i]);
+            }
+            serial_write_string("\n");
+        }
+    }
+
+    serial_write_string("SCHED-END\n");
+    return count;
+}
@@ -18,6 +18,16 @@
 #include "kernel.h"
 #include "vga.h"
 #include "idt.h"
+#include "sched_trace.h"
+#include "metrics.h"
+#include "smp.h"
+#include "percpu.h"
+#include "cpu_timer.h"
+#include "event_actor.h"
+
+// Function-entry tracing subsystem for this file (make TRACE=1)
+#define FTRACE_SUBSYSTEM sched
+#include "ftrace.h"
 
 // =============================================================================
 // Global Scheduler State
@@ -26,18 +36,569 @@
 scheduler_t kernel_scheduler;
 bool scheduler_initialized = false;
 
-// Simple actor memory pool (for initial implementation)
-static actor_t actor_pool[MAX_ACTORS];
-static bool actor_pool_used[MAX_ACTORS];
+// Actor table: the first page is static, the rest come from the heap
+static uint64_t actor_first_page[(HANDLE_PAGE_BYTES(sizeof(actor_t)) + 7) / 8];
+static handle_slot_t* actor_pages[ACTOR_TABLE_PAGES];
 
 // Message memory pool
 static message_t message_pool[MAX_MESSAGES];
-static bool message_pool_used[MAX_MESSAGES];
+
+// =============================================================================
+// Internal Function Declarations
+// =============================================================================
+
+void actor_create_kernel_actor(void);
+actor_t* scheduler_select_next_actor(void);
+void scheduler_context_switch(actor_t* next_actor);
+void scheduler_add_to_ready_queue(actor_t* actor);
+void scheduler_remove_from_ready_queue(actor_t* actor);
+static void scheduler_wake(actor_t* actor, actor_t* sender);
+static void scheduler_enqueue(actor_t* actor, uint32_t target);
+static void scheduler_edf_release_periods(void);
+static void scheduler_edf_leave(actor_t* actor);
+static void scheduler_edf_check_preempt(sched_cpu_t* cpu);
+message_t* message_allocate(void);
+bool actor_add_message(actor_t* actor, message_t* message);
+static void actor_update_mailbox_deadline(actor_t* actor);
+void actor_clear_message_queue(actor_t* actor);
+
+// =============================================================================
+// Run Queues and Mailbox Locks
+// =============================================================================
+
+/*
+ * Push a ready actor at the owner's end (owning CPU, interrupts off)
+ */
+static bool sched_runqueue_push(sched_runqueue_t* rq, actor_t* actor)
+{
+    uint32_t bottom = rq->bottom;
+    if ((int32_t)(bottom - rq->top) >= SCHED_RUNQUEUE_SIZE) {
+        return false;
+    }
+    
+    rq->slots[bottom & (SCHED_RUNQUEUE_SIZE - 1)] = actor;
+    asm volatile ("" : : : "memory"); // Slot visible before bottom (x86 stores are ordered)
+    rq->bottom = bottom + 1;
+    return true;
+}
+
+/*
+ * Take the oldest entry; safe from any CPU. A slot is only trusted once
+ * the CAS on top succeeds, since the owner may reuse it after a wrap.
+ * The indices wrap too, so they are only ever compared by difference.
+ */
+static actor_t* sched_runqueue_take(sched_runqueue_t* rq)
+{
+    for (;;) {
+        uint32_t top = rq->top;
+        asm volatile ("" : : : "memory");
+        uint32_t bottom = rq->bottom;
+        if ((int32_t)(bottom - top) <= 0) {
+            return NULL;
+        }
+        
+        actor_t* actor = rq->slots[top & (SCHED_RUNQUEUE_SIZE - 1)];
+        if (__sync_bool_compare_and_swap(&rq->top, top, top + 1)) {
+            return actor;
+        }
+    }
+}
+
+static inline int32_t sched_runqueue_length(sched_runqueue_t* rq)
+{
+    return (int32_t)(rq->bottom - rq->top);
+}
+
+/*
+ * Take entries until one still belongs to a queued actor and claim it.
+ * Entries of actors removed meanwhile (STALE) are dropped; a concurrent
+ * re-add may revive STALE to QUEUED, so the state is re-read on failure.
+ */
+static actor_t* scheduler_claim_from(sched_runqueue_t* rq)
+{
+    actor_t* actor;
+    
+    while ((actor = sched_runqueue_take(rq)) != NULL) {
+        for (;;) {
+            uint32_t state = actor->rq_state;
+            if (state == SCHED_RQ_QUEUED) {
+                if (__sync_bool_compare_and_swap(&actor->rq_state, SCHED_RQ_QUEUED, SCHED_RQ_NONE)) {
+                    __sync_fetch_and_sub(&kernel_scheduler.statistics.ready_actors, 1);
+                    return actor;
+                }
+            } else if (state == SCHED_RQ_STALE) {
+                if (__sync_bool_compare_and_swap(&actor->rq_state, SCHED_RQ_STALE, SCHED_RQ_NONE)) {
+                    break;
+                }
+            } else {
+                break;
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+/*
+ * Scheduler state of the running CPU
+ */
+sched_cpu_t* scheduler_this_cpu(void)
+{
+    return &kernel_scheduler.cpus[smp_cpu_id()];
+}
+
+// =============================================================================
+// Earliest-Deadline-First Ready Heaps
+// =============================================================================
+
+/*
+ * Tick comparison that survives tick_count wrapping
+ */
+static inline bool sched_deadline_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+/*
+ * Deadline a real-time actor is scheduled by: the end of its period, or
+ * a queued message's deadline if that comes first
+ */
+static uint32_t scheduler_edf_deadline(actor_t* actor)
+{
+    uint32_t deadline = actor->rt_deadline;
+    uint32_t message = actor->mailbox_deadline;
+    if (message && sched_deadline_before(message, deadline)) {
+        deadline = message;
+    }
+    return deadline;
+}
+
+static inline void sched_edf_place(sched_cpu_t* cpu, actor_t* actor, uint32_t index)
+{
+    cpu->edf_heap[index] = actor;
+    actor->edf_index = index;
+}
+
+static void sched_edf_sift_up(sched_cpu_t* cpu, uint32_t index)
+{
+    actor_t* actor = cpu->edf_heap[index];
+    
+    while (index > 0) {
+        uint32_t parent = (index - 1) / 2;
+        if (!sched_deadline_before(actor->edf_key, cpu->edf_heap[parent]->edf_key)) break;
+        sched_edf_place(cpu, cpu->edf_heap[parent], index);
+        index = parent;
+    }
+    sched_edf_place(cpu, actor, index);
+}
+
+static void sched_edf_sift_down(sched_cpu_t* cpu, uint32_t index)
+{
+    actor_t* actor = cpu->edf_heap[index];
+    
+    for (;;) {
+        uint32_t child = 2 * index + 1;
+        if (child >= cpu->edf_count) break;
+        if (child + 1 < cpu->edf_count &&
+            sched_deadline_before(cpu->edf_heap[child + 1]->edf_key, cpu->edf_heap[child]->edf_key)) {
+            child++;
+        }
+        if (!sched_deadline_before(cpu->edf_heap[child]->edf_key, actor->edf_key)) break;
+        sched_edf_place(cpu, cpu->edf_heap[child], index);
+        index = child;
+    }
+    sched_edf_place(cpu, actor, index);
+}
+
+/*
+ * Re-key a queued actor after its deadline changed (caller holds edf_lock)
+ */
+static void sched_edf_rekey(sched_cpu_t* cpu, actor_t* actor)
+{
+    actor->edf_key = scheduler_edf_deadline(actor);
+    sched_edf_sift_down(cpu, actor->edf_index);
+    sched_edf_sift_up(cpu, actor->edf_index);
+}
+
+/*
+ * Take an actor out of the heap (caller holds edf_lock)
+ */
+static void sched_edf_remove_at(sched_cpu_t* cpu, uint32_t index)
+{
+    cpu->edf_heap[index]->edf_index = SCHED_EDF_NONE;
+    uint32_t last = --cpu->edf_count;
+    
+    if (index != last) {
+        actor_t* moved = cpu->edf_heap[last];
+        sched_edf_place(cpu, moved, index);
+        sched_edf_sift_down(cpu, index);
+        sched_edf_sift_up(cpu, moved->edf_index);
+    }
+}
+
+/*
+ * Queue a ready real-time actor on the CPU it was admitted to. Unlike the
+ * run queues, the heap takes inserts from any CPU, under its lock.
+ */
+static void scheduler_edf_enqueue(actor_t* actor)
+{
+    uint32_t target = actor->rt_cpu;
+    sched_cpu_t* cpu = &kernel_scheduler.cpus[target];
+    
+    uint32_t flags = spin_lock_irqsave(&cpu->edf_lock);
+    if (actor->edf_index != SCHED_EDF_NONE || cpu->edf_count >= SCHED_EDF_MAX) {
+        spin_unlock_irqrestore(&cpu->edf_lock, flags);
+        return;
+    }
+    actor->edf_key = scheduler_edf_deadline(actor);
+    actor->rt_ready_tick = kernel_scheduler.tick_count;
+    cpu->edf_heap[cpu->edf_count++] = actor;
+    sched_edf_sift_up(cpu, cpu->edf_count - 1);
+    spin_unlock_irqrestore(&cpu->edf_lock, flags);
+    
+    __sync_fetch_and_add(&kernel_scheduler.statistics.ready_actors, 1);
+    sched_trace_ready(actor);
+    
+    if (target != smp_cpu_id()) {
+        __sync_synchronize(); // Heap entry visible before the idle check
+        scheduler_kick_cpu(target);
+    }
+}
+
+/*
+ * Drop a real-time actor's heap entry, if it has one
+ */
+static bool scheduler_edf_remove(actor_t* actor)
+{
+    sched_cpu_t* cpu = &kernel_scheduler.cpus[actor->rt_cpu];
+    bool removed = false;
+    
+    uint32_t flags = spin_lock_irqsave(&cpu->edf_lock);
+    if (actor->edf_index != SCHED_EDF_NONE) {
+        sched_edf_remove_at(cpu, actor->edf_index);
+        removed = true;
+    }
+    spin_unlock_irqrestore(&cpu->edf_lock, flags);
+    
+    if (removed) {
+        __sync_fetch_and_sub(&kernel_scheduler.statistics.ready_actors, 1);
+    }
+    return removed;
+}
+
+/*
+ * Claim the ready real-time actor with the earliest deadline on this CPU
+ */
+static actor_t* scheduler_edf_take(sched_cpu_t* cpu)
+{
+    if (cpu->edf_count == 0) {
+        return NULL;
+    }
+    
+    actor_t* actor = NULL;
+    uint32_t flags = spin_lock_irqsave(&cpu->edf_lock);
+    if (cpu->edf_count > 0) {
+        actor = cpu->edf_heap[0];
+        sched_edf_remove_at(cpu, 0);
+    }
+    spin_unlock_irqrestore(&cpu->edf_lock, flags);
+    
+    if (actor) {
+        __sync_fetch_and_sub(&kernel_scheduler.statistics.ready_actors, 1);
+    }
+    return actor;
+}
+
+/*
+ * A queued message moved a ready real-time actor's deadline forward
+ */
+static void scheduler_edf_requeue(actor_t* actor)
+{
+    sched_cpu_t* cpu = &kernel_scheduler.cpus[actor->rt_cpu];
+    
+    uint32_t flags = spin_lock_irqsave(&cpu->edf_lock);
+    if (actor->edf_index != SCHED_EDF_NONE) {
+        sched_edf_rekey(cpu, actor);
+    }
+    spin_unlock_irqrestore(&cpu->edf_lock, flags);
+}
+
+/*
+ * Whether a ready real-time actor on this CPU should displace current:
+ * any of them beats a normal actor, and among themselves the earlier
+ * deadline wins
+ */
+static bool scheduler_edf_preempts(sched_cpu_t* cpu, actor_t* current)
+{
+    if (cpu->edf_count == 0) {
+        return false;
+    }
+    if (!current || !current->rt_period) {
+        return true;
+    }
+    
+    uint32_t flags = spin_lock_irqsave(&cpu->edf_lock);
+    bool earlier = cpu->edf_count > 0 &&
+                   sched_deadline_before(cpu->edf_heap[0]->edf_key, scheduler_edf_deadline(current));
+    spin_unlock_irqrestore(&cpu->edf_lock, flags);
+    return earlier;
+}
+
+// =============================================================================
+// Cross-CPU Wakeups
+// =============================================================================
+
+/*
+ * Make sure an idle CPU notices new work. Only a halted CPU needs the
+ * IPI (a busy one drains its wake list at its next schedule), and while
+ * one is in flight further kicks are absorbed by it.
+ */
+void scheduler_kick_cpu(uint32_t cpu)
+{
+    sched_cpu_t* target = &kernel_scheduler.cpus[cpu];
+    
+    if (!target->idle) {
+        return;
+    }
+    
+    if (__sync_lock_test_and_set(&target->resched_pending, 1)) {
+        this_cpu_inc(sched_resched_coalesced);
+        return;
+    }
+    
+    if (smp_send_reschedule(cpu)) {
+        this_cpu_inc(sched_resched_ipis);
+    } else {
+        target->resched_pending = 0;
+    }
+}
+
+/*
+ * This CPU queued work it will not get to right away: wake one halted
+ * CPU so it can steal it
+ */
+static void scheduler_kick_idle_cpu(uint32_t self)
+{
+    __sync_synchronize(); // Queue entry visible before reading idle flags
+    
+    for (uint32_t i = 0; i < SMP_MAX_CPUS; i++) {
+        sched_cpu_t* other = &kernel_scheduler.cpus[i];
+        if (i != self && other->online && other->idle) {
+            scheduler_kick_cpu(i);
+            return;
+        }
+    }
+}
+
+/*
+ * Hand a queued actor to another CPU. Run queues only take pushes from
+ * their owner, so it goes onto the target's wake list (a lock-free LIFO;
+ * entries only leave it all at once, so there is no ABA) and the owner
+ * moves it over.
+ */
+static void scheduler_wake_remote(actor_t* actor, uint32_t cpu)
+{
+    sched_cpu_t* target = &kernel_scheduler.cpus[cpu];
+    actor_t* head;
+    
+    do {
+        head = target->wake_list;
+        actor->wake_next = head;
+    } while (!__sync_bool_compare_and_swap(&target->wake_list, head, actor));
+    
+    this_cpu_inc(sched_remote_wakeups);
+    scheduler_kick_cpu(cpu); // The CAS orders the push before the idle check
+}
+
+/*
+ * Move actors other CPUs woke for this one into its run queue, oldest
+ * wakeup first
+ */
+static void scheduler_drain_wakeups(sched_cpu_t* cpu)
+{
+    if (!cpu->wake_list) {
+        return;
+    }
+    
+    actor_t* list = __sync_lock_test_and_set(&cpu->wake_list, NULL);
+    
+    actor_t* ordered = NULL;
+    while (list) {
+        actor_t* next = list->wake_next;
+        list->wake_next = ordered;
+        ordered = list;
+        list = next;
+    }
+    
+    uint32_t flags = cpu_irq_save();
+    while (ordered) {
+        actor_t* actor = ordered;
+        ordered = actor->wake_next;
+        actor->wake_next = NULL;
+        
+        // Already marked queued by the waker (possibly STALE by now,
+        // which the run queue handles)
+        if (!sched_runqueue_push(&cpu->runqueue, actor)) {
+            actor->rq_state = SCHED_RQ_NONE;
+            kprintf("[SCHEDULER] ERROR: Run queue full, actor %d not queued\n",
+                    actor->actor_id);
+        }
+    }
+    cpu_irq_restore(flags);
+}
+
+// =============================================================================
+// CPU Placement
+// =============================================================================
+
+static inline bool scheduler_cpu_allowed(actor_t* actor, uint32_t cpu)
+{
+    return cpu < SMP_MAX_CPUS && kernel_scheduler.cpus[cpu].online &&
+           (actor->affinity & (1u << cpu));
+}
+
+/*
+ * Some CPU the actor may run on: this one if allowed, else the first
+ * allowed CPU that is online
+ */
+static uint32_t scheduler_fallback_cpu(actor_t* actor)
+{
+    uint32_t self = smp_cpu_id();
+    if (scheduler_cpu_allowed(actor, self)) {
+        return self;
+    }
+    
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        if (scheduler_cpu_allowed(actor, cpu)) {
+            return cpu;
+        }
+    }
+    return self; // actor_set_affinity keeps an online CPU in the mask
+}
+
+/*
+ * Whether most of what an actor received lately came from one sender
+ * (read without the mailbox lock: a stale answer only costs placement)
+ */
+static bool scheduler_is_chatty(actor_t* actor, uint32_t sender_id)
+{
+    uint32_t total = actor->partner_messages;
+    if (total < SCHED_CHATTY_MIN) {
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < ACTOR_PARTNER_SLOTS; i++) {
+        if (actor->partners[i].actor_id == sender_id) {
+            return actor->partners[i].messages * 100 >= total * SCHED_CHATTY_PERCENT;
+        }
+    }
+    return false;
+}
+
+/*
+ * Heaviest sender if it makes the pair chatty, else 0
+ */
+static uint32_t scheduler_chatty_partner(actor_t* actor)
+{
+    actor_partner_t* best = NULL;
+    for (uint32_t i = 0; i < ACTOR_PARTNER_SLOTS; i++) {
+        actor_partner_t* partner = &actor->partners[i];
+        if (partner->messages && (!best || partner->messages > best->messages)) {
+            best = partner;
+        }
+    }
+    
+    return best && scheduler_is_chatty(actor, best->actor_id) ? best->actor_id : 0;
+}
+
+/*
+ * CPU a woken actor should run on, in order of preference: the
+ * rebalancer's pick, the waking sender's CPU when the two talk mostly to
+ * each other (the reply is then a local wakeup), the CPU it last ran on
+ * (its mailbox and state are likely still in that cache)
+ */
+static uint32_t scheduler_wake_target(actor_t* actor, actor_t* sender)
+{
+    uint32_t hint = actor->preferred_cpu;
+    if (hint != SCHED_CPU_NONE) {
+        actor->preferred_cpu = SCHED_CPU_NONE;
+        if (scheduler_cpu_allowed(actor, hint)) {
+            return hint;
+        }
+    }
+    
+    uint32_t self = smp_cpu_id();
+    if (sender && sender->actor_id != 0 && scheduler_cpu_allowed(actor, self) &&
+        scheduler_is_chatty(actor, sender->actor_id)) {
+        return self;
+    }
+    
+    if (scheduler_cpu_allowed(actor, actor->last_cpu)) {
+        return actor->last_cpu;
+    }
+    return scheduler_fallback_cpu(actor);
+}
+
+/*
+ * Where an actor will run next unless something moves it
+ */
+static uint32_t scheduler_actor_home(actor_t* actor)
+{
+    uint32_t hint = actor->preferred_cpu;
+    if (hint != SCHED_CPU_NONE && hint < SMP_MAX_CPUS) {
+        return hint;
+    }
+    return actor->last_cpu < SMP_MAX_CPUS ? actor->last_cpu : 0;
+}
+
+/*
+ * Take the next actor from a run queue that may run on this CPU. One
+ * that may not (stolen, or its affinity changed while it was queued) is
+ * passed on to a CPU it is allowed on.
+ */
+static actor_t* scheduler_claim_allowed(sched_runqueue_t* rq, uint32_t self)
+{
+    actor_t* actor;
+    
+    while ((actor = scheduler_claim_from(rq)) != NULL) {
+        uint32_t target = (actor->affinity & (1u << self)) ? self : scheduler_fallback_cpu(actor);
+        if (target == self) {
+            return actor;
+        }
+        scheduler_enqueue(actor, target);
+    }
+    
+    return NULL;
+}
 
 // =============================================================================
 // Core Scheduler Functions
 // =============================================================================
 
+/*
+ * Export scheduler statistics through the metrics registry
+ */
+static void scheduler_register_metrics(void)
+{
+    scheduler_stats_t* stats = &kernel_scheduler.statistics;
+    
+    METRICS_COUNTER("sched.ticks", kernel_scheduler.tick_count);
+    METRICS_PERCPU_COUNTER("sched.context_switches", sched_context_switches);
+    METRICS_COUNTER("sched.actors_created", stats->actors_created);
+    METRICS_COUNTER("sched.actors_destroyed", stats->actors_destroyed);
+    METRICS_PERCPU_COUNTER("sched.messages_sent", sched_messages_sent);
+    METRICS_PERCPU_COUNTER("sched.messages_delivered", sched_messages_delivered);
+    METRICS_PERCPU_COUNTER("sched.remote_wakeups", sched_remote_wakeups);
+    METRICS_PERCPU_COUNTER("sched.resched_ipis", sched_resched_ipis);
+    METRICS_PERCPU_COUNTER("sched.resched_coalesced", sched_resched_coalesced);
+    METRICS_COUNTER("sched.throttle_events", stats->throttle_events);
+    METRICS_PERCPU_COUNTER("sched.deadline_misses", sched_deadline_misses);
+    METRICS_GAUGE("sched.current_actors", stats->current_actors);
+    METRICS_GAUGE("sched.ready_actors", stats->ready_actors);
+    METRICS_GAUGE("sched.blocked_actors", stats->blocked_actors);
+    METRICS_GAUGE("sched.throttled_actors", stats->throttled_actors);
+}
+
 /*
  * Initialize the scheduler subsystem
  */
@@ -46,29 +607,34 @@ void scheduler_init(void)
     kprintf("[SCHEDULER] Initializing async-first scheduler...\n");
     
     // Clear scheduler state
-    kernel_scheduler.ready_queue = NULL;
-    kernel_scheduler.current_actor = NULL;
-    kernel_scheduler.next_actor_id = 1; // ID 0 reserved for kernel
     kernel_scheduler.scheduler_enabled = false;
     kernel_scheduler.tick_count = 0;
-    kernel_scheduler.current_timeslice = 0;
+    kernel_scheduler.quota_actors = 0;
     kernel_scheduler.ai_supervision = true;
+    kernel_scheduler.ai_analysis_pending = false;
     
-    // Clear actor table
-    for (uint32_t i = 0; i < MAX_ACTORS; i++) {
-        kernel_scheduler.actors[i] = NULL;
-        actor_pool_used[i] = false;
+    // Only the boot CPU schedules until the APs check in
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        kernel_scheduler.cpus[cpu].online = false;
+    }
+    if (!scheduler_cpu_online(0)) {
+        PANIC("No memory for the boot CPU run queue");
     }
     
-    // Initialize message system
+    // Empty actor table (slot 0 goes to the kernel actor, so its ID is 0)
+    handle_table_init(&kernel_scheduler.actor_table, "actors", 0, sizeof(actor_t),
+                      actor_pages, ACTOR_TABLE_PAGES, actor_first_page);
+    
+    // Initialize message system: every message starts in the shared pool
+    spinlock_init(&kernel_scheduler.message_lock, "messages");
     kernel_scheduler.free_messages = NULL;
+    kernel_scheduler.free_message_count = MAX_MESSAGES;
     kernel_scheduler.message_pool = message_pool;
     kernel_scheduler.message_count = 0;
     
-    // Clear message pool
-    for (uint32_t i = 0; i < MAX_MESSAGES; i++) {
-        message_pool_used[i] = false;
-        message_pool[i].next = NULL;
+    for (uint32_t i = MAX_MESSAGES; i-- > 0; ) {
+        message_pool[i].next = kernel_scheduler.free_messages;
+        kernel_scheduler.free_messages = &message_pool[i];
     }
     
     // Clear statistics
@@ -85,6 +651,15 @@ void scheduler_init(void)
     kernel_scheduler.statistics.scheduler_overhead = 0;
     kernel_scheduler.statistics.deadlocks_detected = 0;
     kernel_scheduler.statistics.load_balance_actions = 0;
+    kernel_scheduler.statistics.throttled_actors = 0;
+    kernel_scheduler.statistics.throttle_events = 0;
+    scheduler_register_metrics();
+    
+    // Stackless actors live in their own growable table
+    event_actor_init();
+    
+    // Event tracer and latency histograms
+    sched_trace_init();
     
     // Create kernel actor (actor ID 0)
     actor_create_kernel_actor();
@@ -92,8 +667,10 @@ void scheduler_init(void)
     scheduler_initialized = true;
     
     kprintf("[SCHEDULER] Actor-based scheduler initialized\n");
-    kprintf("[SCHEDULER] Max actors: %d, Max messages: %d\n", MAX_ACTORS, MAX_MESSAGES);
-    kprintf("[SCHEDULER] Time slice: %d ms\n", SCHEDULER_TIMESLICE_MS);
+    kprintf("[SCHEDULER] Max actors: %d (%d before the table grows), Max messages: %d\n",
+            MAX_ACTORS, HANDLE_PAGE_SIZE, MAX_MESSAGES);
+    kprintf("[SCHEDULER] Time slice: %d ms on ticks, %d us on local timers\n",
+            SCHEDULER_TIMESLICE_MS, SCHEDULER_TIMESLICE_US);
     kprintf("[SCHEDULER] AI supervision enabled\n");
 }
 
@@ -124,13 +701,17 @@ void scheduler_schedule(void)
         return;
     }
     
+    sched_cpu_t* cpu = scheduler_this_cpu();
     actor_t* next_actor = scheduler_select_next_actor();
     
-    if (next_actor != kernel_scheduler.current_actor) {
+    if (!next_actor) {
+        cpu->idle_polls++;
+    } else if (next_actor == cpu->current_actor) {
+        // A lone yielder was handed back to itself
+        next_actor->state = ACTOR_STATE_RUNNING;
+    } else {
         scheduler_context_switch(next_actor);
     }
-    
-    kernel_scheduler.statistics.context_switches++;
 }
 
 /*
@@ -142,8 +723,31 @@ void scheduler_yield(void)
         return;
     }
     
+    actor_t* current = actor_get_current();
+    
+    // A real-time actor keeps the CPU while its deadline is the earliest
+    // here; it gives it up by blocking or when its budget runs out
+    if (current && current->state == ACTOR_STATE_RUNNING && current->rt_period &&
+        !scheduler_edf_preempts(scheduler_this_cpu(), current)) {
+        return;
+    }
+    
+    // Pick the successor before requeueing, so a CPU whose queue only
+    // held the yielder steals work instead of getting it straight back
+    if (current && current->state == ACTOR_STATE_RUNNING &&
+        kernel_scheduler.scheduler_enabled) {
+        actor_t* next = scheduler_select_next_actor();
+        if (!next) {
+            return; // Nothing else runnable: keep going
+        }
+        
+        current->state = ACTOR_STATE_READY;
+        scheduler_add_to_ready_queue(current);
+        scheduler_context_switch(next);
+        return;
+    }
+    
     // Move current actor to end of ready queue if still ready
-    actor_t* current = kernel_scheduler.current_actor;
     if (current && current->state == ACTOR_STATE_RUNNING) {
         current->state = ACTOR_STATE_READY;
         scheduler_add_to_ready_queue(current);
@@ -153,6 +757,54 @@ void scheduler_yield(void)
     scheduler_schedule();
 }
 
+/*
+ * Update CPU time for this CPU's actor and charge its bandwidth bucket
+ */
+static void scheduler_charge_current(sched_cpu_t* cpu)
+{
+    cpu->current_timeslice++;
+    
+    actor_t* current = cpu->current_actor;
+    if (current) {
+        current->cpu_time_used++;
+        
+        if (current->cpu_quota > 0) {
+            if (current->cpu_tokens > 0) {
+                current->cpu_tokens--;
+            }
+            if (current->cpu_tokens == 0) {
+                scheduler_throttle_actor(current);
+            }
+        }
+        
+        // A real-time actor that spent its budget waits for its next period
+        if (current->rt_period) {
+            if (current->rt_runtime > 0) {
+                current->rt_runtime--;
+            }
+            if (current->rt_runtime == 0) {
+                scheduler_throttle_actor(current);
+            }
+        }
+    }
+}
+
+/*
+ * Check if this CPU's time slice expired (tick-driven CPUs only; the
+ * local timer ends slices itself through scheduler_timeslice_expired)
+ */
+static void scheduler_end_timeslice(sched_cpu_t* cpu)
+{
+    if (cpu->local_timer) {
+        return;
+    }
+    
+    if (cpu->current_timeslice >= SCHEDULER_TIMESLICE_MS) {
+        cpu->current_timeslice = 0;
+        scheduler_yield(); // Cooperative yield
+    }
+}
+
 /*
  * Timer interrupt handler for preemptive scheduling
  */
@@ -162,24 +814,170 @@ void scheduler_timer_handler(void)
         return;
     }
     
+    sched_cpu_t* cpu = scheduler_this_cpu();
+    
     kernel_scheduler.tick_count++;
-    kernel_scheduler.current_timeslice++;
+    sched_trace_tick();
+    metrics_tick();
     
-    // Update CPU time for current actor
-    if (kernel_scheduler.current_actor) {
-        kernel_scheduler.current_actor->cpu_time_used++;
-    }
+    scheduler_charge_current(cpu);
     
-    // Check if time slice expired
-    if (kernel_scheduler.current_timeslice >= SCHEDULER_TIMESLICE_MS) {
-        kernel_scheduler.current_timeslice = 0;
-        scheduler_yield(); // Cooperative yield
+    // Refill bandwidth buckets at every period boundary
+    if ((kernel_scheduler.tick_count % SCHEDULER_BANDWIDTH_PERIOD) == 0) {
+        scheduler_refill_cpu_quotas();
     }
     
-    // Periodic AI analysis
+    // Real-time periods end here for every CPU, so a halted CPU's
+    // reservations are still refilled
+    scheduler_edf_release_periods();
+    scheduler_edf_check_preempt(cpu);
+    
+    scheduler_end_timeslice(cpu);
+    
+    // Periodic AI analysis: only flag it here, the AI supervisor actor
+    // runs it outside interrupt context
     if ((kernel_scheduler.tick_count % 1000) == 0) {
-        scheduler_ai_analyze_actors();
+        kernel_scheduler.ai_analysis_pending = true;
+    }
+}
+
+/*
+ * This CPU's share of one tick. The BSP gets it from the timer handler;
+ * each AP gets it from its own local timer while it has an actor running.
+ */
+void scheduler_cpu_tick(void)
+{
+    if (!scheduler_initialized) {
+        return;
+    }
+    
+    sched_cpu_t* cpu = scheduler_this_cpu();
+    scheduler_charge_current(cpu);
+    scheduler_edf_check_preempt(cpu);
+    scheduler_end_timeslice(cpu);
+}
+
+void scheduler_timeslice_expired(void)
+{
+    if (!scheduler_initialized) {
+        return;
+    }
+    
+    scheduler_this_cpu()->current_timeslice = 0;
+    scheduler_yield();
+}
+
+uint32_t scheduler_timeslice_us(void)
+{
+    return scheduler_this_cpu()->local_timer ? SCHEDULER_TIMESLICE_US
+                                             : SCHEDULER_TIMESLICE_MS * SCHEDULER_TICK_US;
+}
+
+/*
+ * Reset a CPU's run queue and let it schedule. Queue slots come from the
+ * heap so only CPUs that actually come up pay for them.
+ */
+bool scheduler_cpu_online(uint32_t cpu)
+{
+    if (cpu >= SMP_MAX_CPUS) {
+        return false;
+    }
+    
+    sched_cpu_t* state = &kernel_scheduler.cpus[cpu];
+    if (!state->runqueue.slots) {
+        state->runqueue.slots = kmalloc(SCHED_RUNQUEUE_SIZE * sizeof(actor_t*));
+        if (!state->runqueue.slots) {
+            kprintf("[SCHEDULER] ERROR: No memory for CPU %d run queue\n", cpu);
+            return false;
+        }
+    }
+    
+    state->runqueue.top = 0;
+    state->runqueue.bottom = 0;
+    state->current_actor = NULL;
+    state->current_timeslice = 0;
+    state->local_timer = false;         // Until cpu_timer_start_cpu
+    state->wake_list = NULL;
+    state->resched_pending = 0;
+    state->idle = false;
+    state->event_list = NULL;
+    state->current_event = 0;
+    spinlock_init(&state->edf_lock, NULL);
+    state->edf_count = 0;
+    state->edf_member_count = 0;
+    state->edf_utilization = 0;
+    state->steals = 0;
+    state->idle_polls = 0;
+    state->free_messages = NULL;
+    state->free_message_count = 0;
+    sched_trace_cpu_online(cpu);
+    
+    asm volatile ("" : : : "memory");
+    state->online = true;
+    return true;
+}
+
+/*
+ * Application processor main loop: run pending event actor handlers,
+ * pick up work when the current actor stops running (stealing if this
+ * CPU's queue is empty) and halt until a reschedule IPI when there is
+ * none. Ticks and slice ends arrive from this CPU's local timer.
+ */
+void scheduler_cpu_loop(void)
+{
+    uint32_t self = smp_cpu_id();
+    sched_cpu_t* cpu = &kernel_scheduler.cpus[self];
+    
+    for (;;) {
+        event_actor_run_pending();
+        
+        actor_t* current = cpu->current_actor;
+        if (!current || current->state != ACTOR_STATE_RUNNING || current->last_cpu != self) {
+            scheduler_schedule();
+            
+            current = cpu->current_actor;
+            if (!current || current->state != ACTOR_STATE_RUNNING ||
+                current->last_cpu != self) {
+                scheduler_cpu_idle();
+                continue;
+            }
+        }
+        
+        cpu_relax();
+    }
+}
+
+/*
+ * Halt until there is work. idle is published before the final check
+ * and wakers push before reading it, so either this CPU sees the new
+ * entry or the waker sees idle and sends the IPI; cpu_halt keeps
+ * interrupts off until the hlt itself, so that IPI cannot slip past.
+ */
+void scheduler_cpu_idle(void)
+{
+    sched_cpu_t* cpu = scheduler_this_cpu();
+    
+    uint32_t flags = cpu_irq_save();
+    cpu->idle = true;
+    __sync_synchronize();
+    
+    if (!cpu->wake_list && !cpu->event_list && cpu->edf_count == 0 &&
+        sched_runqueue_length(&cpu->runqueue) == 0) {
+        cpu_halt();
     }
+    
+    cpu->idle = false;
+    cpu_irq_restore(flags);
+}
+
+void scheduler_reschedule_interrupt(void)
+{
+    sched_cpu_t* cpu = scheduler_this_cpu();
+    
+    // Clear first: a wakeup after the drain must be able to send again
+    cpu->resched_pending = 0;
+    __sync_synchronize();
+    scheduler_drain_wakeups(cpu);
 }
 
 // =============================================================================
@@ -189,35 +987,25 @@ void scheduler_timer_handler(void)
 /*
  * Create a new actor
  */
-uint32_t actor_create(void* entry_point, void* user_data, 
+uint32_t actor_create(actor_entry_t entry_point, void* user_data, 
                       uint8_t priority, size_t stack_size)
 {
     if (!scheduler_initialized || !entry_point) {
         return 0; // Invalid actor ID
     }
     
-    // Find free actor slot
-    uint32_t actor_id = 0;
-    for (uint32_t i = 1; i < MAX_ACTORS; i++) { // Skip ID 0 (kernel)
-        if (!actor_pool_used[i]) {
-            actor_id = i;
-            break;
-        }
-    }
-    
-    if (actor_id == 0) {
+    // Pop a free slot; its ID is not valid until the actor is published
+    uint32_t actor_id;
+    actor_t* actor = (actor_t*)handle_table_alloc(&kernel_scheduler.actor_table, &actor_id);
+    if (!actor) {
         kprintf("[SCHEDULER] ERROR: No free actor slots\n");
         return 0;
     }
     
-    // Get actor structure from pool
-    actor_t* actor = &actor_pool[actor_id];
-    actor_pool_used[actor_id] = true;
-    
     // Initialize actor
     actor->actor_id = actor_id;
-    actor->parent_id = kernel_scheduler.current_actor ? 
-                      kernel_scheduler.current_actor->actor_id : 0;
+    actor_t* parent = actor_get_current();
+    actor->parent_id = parent ? parent->actor_id : 0;
     actor->state = ACTOR_STATE_CREATED;
     actor->priority = priority;
     actor->flags = 0;
@@ -229,7 +1017,7 @@ uint32_t actor_create(void* entry_point, void* user_data,
     
     actor->stack_base = kmalloc(stack_size);
     if (!actor->stack_base) {
-        actor_pool_used[actor_id] = false;
+        handle_table_free(&kernel_scheduler.actor_table, actor_id);
         kprintf("[SCHEDULER] ERROR: Failed to allocate actor stack\n");
         return 0;
     }
@@ -243,13 +1031,14 @@ uint32_t actor_create(void* entry_point, void* user_data,
     for (int i = 0; i < 8; i++) {
         actor->registers[i] = 0;
     }
-    actor->eip = (uint32_t)entry_point;
+    actor->eip = (uint32_t)(uintptr_t)entry_point;
     actor->esp = (uint32_t)actor->stack_current;
     actor->ebp = (uint32_t)actor->stack_current;
     actor->eflags = 0x200; // Enable interrupts
     
     // Initialize message queue
     actor->message_queue = NULL;
+    actor->message_tail = NULL;
     actor->queue_size = 0;
     actor->max_queue_size = 64; // Default queue limit
     
@@ -260,6 +1049,36 @@ uint32_t actor_create(void* entry_point, void* user_data,
     actor->creation_time = kernel_scheduler.tick_count;
     actor->last_scheduled = 0;
     
+    // No CPU quota until one is set
+    actor->cpu_quota = 0;
+    actor->cpu_tokens = 0;
+    actor->throttle_count = 0;
+    actor->ready_since = 0;
+    actor->run_since = 0;
+    actor->last_cpu = smp_cpu_id();     // First wakeups go to the creator's CPU
+    actor->affinity = SCHED_AFFINITY_ALL;
+    actor->preferred_cpu = SCHED_CPU_NONE;
+    for (uint32_t i = 0; i < ACTOR_PARTNER_SLOTS; i++) {
+        actor->partners[i].actor_id = 0;
+        actor->partners[i].messages = 0;
+    }
+    actor->partner_messages = 0;
+    actor->rt_budget = 0;               // Normal class until actor_set_realtime
+    actor->rt_period = 0;
+    actor->rt_runtime = 0;
+    actor->rt_deadline = 0;
+    actor->rt_ready_tick = 0;
+    actor->rt_cpu = 0;
+    actor->mailbox_deadline = 0;
+    actor->edf_key = 0;
+    actor->edf_index = SCHED_EDF_NONE;
+    actor->deadline_misses = 0;
+    actor->message_deadline_misses = 0;
+    // rq_state and wake_next are kept: a slot reused while its old entry
+    // is still queued (STALE) must revive that entry rather than add a
+    // second one. So is mailbox_lock (table pages start zeroed, which is
+    // an unlocked lock): a sender holding the old ID may be holding it.
+    
     // Initialize memory context
     actor->memory_context = NULL; // TODO: integrate with memory manager
     actor->memory_limit = 1024 * 1024; // 1MB default limit
@@ -279,7 +1098,7 @@ uint32_t actor_create(void* entry_point, void* user_data,
     actor->prev = NULL;
     
     // Register actor
-    kernel_scheduler.actors[actor_id] = actor;
+    handle_table_publish(&kernel_scheduler.actor_table, actor_id);
     kernel_scheduler.statistics.actors_created++;
     kernel_scheduler.statistics.current_actors++;
     
@@ -301,69 +1120,424 @@ bool actor_start(uint32_t actor_id)
     
     actor->state = ACTOR_STATE_READY;
     scheduler_add_to_ready_queue(actor);
+    sched_trace_wakeup(actor, ACTOR_STATE_CREATED);
     
     kprintf("[SCHEDULER] Started actor %d\n", actor_id);
     return true;
 }
 
 /*
- * Terminate an actor
+ * Terminate an actor
+ */
+void actor_terminate(uint32_t actor_id)
+{
+    actor_t* actor = actor_get(actor_id);
+    if (!actor) {
+        return;
+    }
+    
+    kprintf("[SCHEDULER] Terminating actor %d\n", actor_id);
+    
+    // Remove from ready queue if present, and give back a real-time reservation
+    scheduler_remove_from_ready_queue(actor);
+    if (actor->rt_period) {
+        scheduler_edf_leave(actor);
+    }
+    
+    // No CPU may keep it as current once the slot can be reused
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        __sync_bool_compare_and_swap(&kernel_scheduler.cpus[cpu].current_actor, actor, NULL);
+    }
+    
+    // Free stack memory
+    if (actor->stack_base) {
+        kfree(actor->stack_base);
+    }
+    
+    // Free error message if any
+    if (actor->error_message) {
+        kfree(actor->error_message);
+    }
+    
+    // Finish under mailbox_lock, so actor_add_message refuses from here
+    // on, then clear pending messages
+    uint32_t flags = spin_lock_irqsave(&actor->mailbox_lock);
+    bool throttled = actor->state == ACTOR_STATE_THROTTLED;
+    actor->state = ACTOR_STATE_FINISHED;
+    spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+    actor_clear_message_queue(actor);
+    
+    // Drop CPU bandwidth accounting
+    if (throttled) {
+        kernel_scheduler.statistics.throttled_actors--;
+    }
+    if (actor->cpu_quota > 0) {
+        kernel_scheduler.quota_actors--;
+    }
+    
+    // Update statistics
+    kernel_scheduler.statistics.actors_destroyed++;
+    kernel_scheduler.statistics.current_actors--;
+    
+    // Retire the ID (bumps the slot's generation) and free the slot
+    handle_table_free(&kernel_scheduler.actor_table, actor_id);
+    
+    kprintf("[SCHEDULER] Actor %d terminated\n", actor_id);
+}
+
+/*
+ * Get actor by ID
+ */
+actor_t* actor_get(uint32_t actor_id)
+{
+    return (actor_t*)handle_table_lookup(&kernel_scheduler.actor_table, actor_id);
+}
+
+/*
+ * Walk live actors in table order
+ */
+actor_t* actor_next(uint32_t* index)
+{
+    return (actor_t*)handle_table_next(&kernel_scheduler.actor_table, index);
+}
+
+/*
+ * Get current running actor
+ */
+actor_t* actor_get_current(void)
+{
+    return kernel_scheduler.cpus[smp_cpu_id()].current_actor;
+}
+
+// =============================================================================
+// CPU Bandwidth Control
+// =============================================================================
+
+/*
+ * Limit an actor to 'percent' of each SCHEDULER_BANDWIDTH_PERIOD. The
+ * quota is a token bucket of timer ticks: the timer charges the running
+ * actor one token per tick, parks it when the bucket is empty and refills
+ * every bucket at the period boundary. 100 removes the limit.
+ */
+bool actor_set_cpu_quota(uint32_t actor_id, uint32_t percent)
+{
+    actor_t* actor = actor_get(actor_id);
+    if (!actor || actor_id == 0 || percent == 0 || percent > 100) {
+        return false;
+    }
+    
+    uint32_t quota = 0;
+    if (percent < 100) {
+        quota = (SCHEDULER_BANDWIDTH_PERIOD * percent) / 100;
+        if (quota == 0) quota = 1;
+    }
+    
+    if (actor->cpu_quota == 0 && quota > 0) {
+        kernel_scheduler.quota_actors++;
+    } else if (actor->cpu_quota > 0 && quota == 0) {
+        kernel_scheduler.quota_actors--;
+    }
+    
+    actor->cpu_quota = quota;
+    actor->cpu_tokens = quota;
+    
+    // A lifted or raised quota takes effect immediately
+    if (actor->state == ACTOR_STATE_THROTTLED) {
+        actor->state = ACTOR_STATE_READY;
+        kernel_scheduler.statistics.throttled_actors--;
+        scheduler_wake(actor, NULL);
+        sched_trace_wakeup(actor, ACTOR_STATE_THROTTLED);
+    }
+    
+    kprintf("[SCHEDULER] Actor %d CPU quota set to %d%%\n", actor_id, percent);
+    return true;
+}
+
+// =============================================================================
+// CPU Affinity
+// =============================================================================
+
+/*
+ * Restrict an actor to the CPUs in mask, which must include an online
+ * one. A queued entry on a CPU outside the mask is passed on when taken;
+ * a running actor moves at its next wakeup or yield.
+ */
+bool actor_set_affinity(uint32_t actor_id, uint32_t mask)
+{
+    actor_t* actor = actor_get(actor_id);
+    if (!actor || actor_id == 0) {
+        return false;
+    }
+    
+    mask &= SCHED_AFFINITY_ALL;
+    
+    bool usable = false;
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        if ((mask & (1u << cpu)) && kernel_scheduler.cpus[cpu].online) {
+            usable = true;
+            break;
+        }
+    }
+    if (!usable) {
+        return false;
+    }
+    
+    actor->affinity = mask;
+    
+    kprintf("[SCHEDULER] Actor %d affinity set to 0x%x\n", actor_id, mask);
+    return true;
+}
+
+/*
+ * Park an actor that has spent its CPU quota. Only runnable actors are
+ * parked; a blocked actor simply wakes with an empty bucket and is parked
+ * on its next tick.
+ */
+void scheduler_throttle_actor(actor_t* actor)
+{
+    if (actor->state == ACTOR_STATE_READY) {
+        scheduler_remove_from_ready_queue(actor);
+    } else if (actor->state != ACTOR_STATE_RUNNING) {
+        return;
+    }
+    
+    actor->state = ACTOR_STATE_THROTTLED;
+    actor->throttle_count++;
+    sched_trace_block(actor, ACTOR_STATE_THROTTLED);
+    kernel_scheduler.statistics.throttled_actors++;
+    kernel_scheduler.statistics.throttle_events++;
+    
+    if (actor == actor_get_current()) {
+        scheduler_schedule();
+    }
+}
+
+/*
+ * Refill every CPU quota and move throttled actors back to the ready queue
+ */
+void scheduler_refill_cpu_quotas(void)
+{
+    if (kernel_scheduler.quota_actors == 0) {
+        return;
+    }
+    
+    uint32_t index = 1; // Skip the kernel actor
+    actor_t* actor;
+    while ((actor = actor_next(&index))) {
+        if (actor->cpu_quota == 0) continue;
+        
+        actor->cpu_tokens = actor->cpu_quota;
+        
+        // A real-time actor out of budget waits for its own period
+        if (actor->state == ACTOR_STATE_THROTTLED && (!actor->rt_period || actor->rt_runtime)) {
+            actor->state = ACTOR_STATE_READY;
+            kernel_scheduler.statistics.throttled_actors--;
+            scheduler_wake(actor, NULL);
+            sched_trace_wakeup(actor, ACTOR_STATE_THROTTLED);
+        }
+    }
+}
+
+// =============================================================================
+// Earliest-Deadline-First Class
+// =============================================================================
+
+/*
+ * budget/period in SCHED_EDF_UTIL_SCALE units, rounded up so admitted
+ * sets never add up to more than a CPU
+ */
+static uint32_t scheduler_edf_utilization(uint32_t budget, uint32_t period)
+{
+    return (uint32_t)(((uint64_t)budget * SCHED_EDF_UTIL_SCALE + period - 1) / period);
+}
+
+/*
+ * Give back an actor's reservation and drop its heap entry, under its
+ * CPU's lock so a period release never sees it half removed
+ */
+static void scheduler_edf_leave(actor_t* actor)
+{
+    sched_cpu_t* cpu = &kernel_scheduler.cpus[actor->rt_cpu];
+    bool dequeued = false;
+    
+    uint32_t flags = spin_lock_irqsave(&cpu->edf_lock);
+    for (uint32_t i = 0; i < cpu->edf_member_count; i++) {
+        if (cpu->edf_members[i] == actor) {
+            cpu->edf_members[i] = cpu->edf_members[--cpu->edf_member_count];
+            cpu->edf_utilization -= scheduler_edf_utilization(actor->rt_budget, actor->rt_period);
+            break;
+        }
+    }
+    if (actor->edf_index != SCHED_EDF_NONE) {
+        sched_edf_remove_at(cpu, actor->edf_index);
+        dequeued = true;
+    }
+    actor->rt_period = 0;
+    actor->rt_budget = 0;
+    spin_unlock_irqrestore(&cpu->edf_lock, flags);
+    
+    if (dequeued) {
+        __sync_fetch_and_sub(&kernel_scheduler.statistics.ready_actors, 1);
+    }
+}
+
+/*
+ * Reserve budget ticks of every period for an actor and schedule it
+ * earliest deadline first, ahead of every normal actor. Real-time actors
+ * are partitioned: admission picks the least reserved CPU the actor may
+ * run on that still has room, so the reservations on each CPU add up to
+ * at most 100% and EDF meets every period's deadline on it. The budget
+ * is enforced (an actor that spends it is parked until its next period),
+ * so one overrunning actor cannot make the others miss.
  */
-void actor_terminate(uint32_t actor_id)
+bool actor_set_realtime(uint32_t actor_id, uint32_t budget, uint32_t period)
 {
     actor_t* actor = actor_get(actor_id);
-    if (!actor) {
-        return;
+    if (!actor || actor_id == 0 || (budget > 0 && (period == 0 || budget > period))) {
+        return false;
     }
     
-    kprintf("[SCHEDULER] Terminating actor %d\n", actor_id);
-    
-    // Remove from ready queue if present
-    scheduler_remove_from_ready_queue(actor);
+    uint32_t utilization = budget ? scheduler_edf_utilization(budget, period) : 0;
+    uint32_t current = actor->rt_period ?
+        scheduler_edf_utilization(actor->rt_budget, actor->rt_period) : 0;
     
-    // Free stack memory
-    if (actor->stack_base) {
-        kfree(actor->stack_base);
+    // Admission control (the actor's own reservation counts as free)
+    uint32_t target = SCHED_CPU_NONE;
+    uint32_t target_load = 0;
+    for (uint32_t cpu = 0; budget > 0 && cpu < SMP_MAX_CPUS; cpu++) {
+        if (!scheduler_cpu_allowed(actor, cpu)) continue;
+        
+        sched_cpu_t* state = &kernel_scheduler.cpus[cpu];
+        bool member = actor->rt_period && actor->rt_cpu == cpu;
+        uint32_t load = state->edf_utilization - (member ? current : 0);
+        uint32_t members = state->edf_member_count - (member ? 1 : 0);
+        if (load + utilization > SCHED_EDF_UTIL_SCALE || members >= SCHED_EDF_MAX) continue;
+        
+        if (target == SCHED_CPU_NONE || load < target_load) {
+            target = cpu;
+            target_load = load;
+        }
     }
     
-    // Free error message if any
-    if (actor->error_message) {
-        kfree(actor->error_message);
+    if (budget > 0 && target == SCHED_CPU_NONE) {
+        kprintf("[SCHEDULER] Actor %d real-time reservation %d/%d ticks rejected: "
+                "no allowed CPU has %d%% left\n", actor_id, budget, period,
+                (utilization + 99) / 100);
+        return false;
     }
     
-    // Clear pending messages
-    actor_clear_message_queue(actor);
-    
-    // Update state and statistics
-    actor->state = ACTOR_STATE_FINISHED;
-    kernel_scheduler.statistics.actors_destroyed++;
-    kernel_scheduler.statistics.current_actors--;
+    // Leave the current class; a ready actor is queued again below, and
+    // one parked on its old budget starts over with the new one
+    bool ready = (actor->state == ACTOR_STATE_READY);
+    scheduler_remove_from_ready_queue(actor);
+    if (actor->rt_period) {
+        scheduler_edf_leave(actor);
+    }
+    if (actor->state == ACTOR_STATE_THROTTLED && actor->cpu_quota == 0) {
+        actor->state = ACTOR_STATE_READY;
+        kernel_scheduler.statistics.throttled_actors--;
+        sched_trace_wakeup(actor, ACTOR_STATE_THROTTLED);
+        ready = true;
+    }
     
-    // Free actor slot
-    kernel_scheduler.actors[actor_id] = NULL;
-    actor_pool_used[actor_id] = false;
+    if (budget > 0) {
+        sched_cpu_t* state = &kernel_scheduler.cpus[target];
+        uint32_t flags = spin_lock_irqsave(&state->edf_lock);
+        actor->rt_budget = budget;
+        actor->rt_runtime = budget;
+        actor->rt_deadline = kernel_scheduler.tick_count + period;
+        actor->rt_cpu = target;
+        actor->edf_index = SCHED_EDF_NONE;
+        actor->rt_period = period;
+        state->edf_members[state->edf_member_count++] = actor;
+        state->edf_utilization += utilization;
+        spin_unlock_irqrestore(&state->edf_lock, flags);
+        
+        kprintf("[SCHEDULER] Actor %d real-time: %d ticks every %d on CPU %d (%d%% reserved)\n",
+                actor_id, budget, period, target,
+                (state->edf_utilization + 99) / 100);
+    } else {
+        kprintf("[SCHEDULER] Actor %d back in the normal class\n", actor_id);
+    }
     
-    kprintf("[SCHEDULER] Actor %d terminated\n", actor_id);
+    if (ready) {
+        scheduler_wake(actor, NULL);
+    }
+    return true;
 }
 
 /*
- * Get actor by ID
+ * End the real-time periods that are over, on every CPU. A member still
+ * runnable at its deadline that had been waiting long enough to spend the
+ * rest of its budget missed it (one parked for spending the budget got
+ * its reservation, and one woken just before the deadline had no time
+ * to). Each gets a fresh budget and deadline, and those parked for
+ * spending their budget run again.
  */
-actor_t* actor_get(uint32_t actor_id)
+static void scheduler_edf_release_periods(void)
 {
-    if (actor_id >= MAX_ACTORS) {
-        return NULL;
-    }
+    uint32_t now = kernel_scheduler.tick_count;
     
-    return kernel_scheduler.actors[actor_id];
+    for (uint32_t i = 0; i < SMP_MAX_CPUS; i++) {
+        sched_cpu_t* cpu = &kernel_scheduler.cpus[i];
+        if (!cpu->online || cpu->edf_member_count == 0) continue;
+        
+        actor_t* released[SCHED_EDF_MAX];
+        uint32_t count = 0;
+        
+        uint32_t flags = spin_lock_irqsave(&cpu->edf_lock);
+        for (uint32_t m = 0; m < cpu->edf_member_count; m++) {
+            actor_t* actor = cpu->edf_members[m];
+            if (sched_deadline_before(now, actor->rt_deadline)) continue;
+            
+            uint8_t state = actor->state;
+            if ((state == ACTOR_STATE_READY || state == ACTOR_STATE_RUNNING) &&
+                actor->rt_runtime > 0 && now - actor->rt_ready_tick >= actor->rt_runtime) {
+                actor->deadline_misses++;
+                this_cpu_inc(sched_deadline_misses);
+            }
+            
+            actor->rt_deadline += actor->rt_period;
+            if (!sched_deadline_before(now, actor->rt_deadline)) {
+                actor->rt_deadline = now + actor->rt_period; // Slept through several
+            }
+            actor->rt_runtime = actor->rt_budget;
+            
+            if (actor->edf_index != SCHED_EDF_NONE) {
+                sched_edf_rekey(cpu, actor);
+            }
+            if (state == ACTOR_STATE_THROTTLED && actor->cpu_quota == 0) {
+                released[count++] = actor;
+            }
+        }
+        spin_unlock_irqrestore(&cpu->edf_lock, flags);
+        
+        for (uint32_t r = 0; r < count; r++) {
+            actor_t* actor = released[r];
+            actor->state = ACTOR_STATE_READY;
+            kernel_scheduler.statistics.throttled_actors--;
+            scheduler_wake(actor, NULL);
+            sched_trace_wakeup(actor, ACTOR_STATE_THROTTLED);
+        }
+    }
 }
 
 /*
- * Get current running actor
+ * Preempt this CPU's actor at a tick if a ready real-time actor here
+ * should run instead
  */
-actor_t* actor_get_current(void)
+static void scheduler_edf_check_preempt(sched_cpu_t* cpu)
 {
-    return kernel_scheduler.current_actor;
+    actor_t* current = cpu->current_actor;
+    if (cpu->edf_count == 0 || !current || current->state != ACTOR_STATE_RUNNING ||
+        current->last_cpu != smp_cpu_id()) {
+        return;
+    }
+    
+    if (scheduler_edf_preempts(cpu, current)) {
+        cpu->current_timeslice = 0;
+        scheduler_yield();
+    }
 }
 
 // =============================================================================
@@ -371,17 +1545,24 @@ actor_t* actor_get_current(void)
 // =============================================================================
 
 /*
- * Send asynchronous message
+ * Queue a message for an actor (deadline is a tick count, 0 = none)
  */
-bool message_send_async(uint32_t recipient_id, uint8_t type, 
-                       void* payload, size_t payload_size)
+static bool message_send(uint32_t recipient_id, uint8_t type,
+                         void* payload, size_t payload_size, uint32_t deadline)
 {
     if (!scheduler_initialized) {
         return false;
     }
     
-    actor_t* recipient = actor_get(recipient_id);
-    if (!recipient) {
+    // Event actors are named by tagged IDs in their own table
+    actor_t* recipient = NULL;
+    event_actor_t* event_recipient = NULL;
+    if (event_actor_is_id(recipient_id)) {
+        event_recipient = event_actor_get(recipient_id);
+    } else {
+        recipient = actor_get(recipient_id);
+    }
+    if (!recipient && !event_recipient) {
         return false;
     }
     
@@ -391,17 +1572,22 @@ bool message_send_async(uint32_t recipient_id, uint8_t type,
         return false;
     }
     
-    // Initialize message
-    message->sender_id = kernel_scheduler.current_actor ? 
-                        kernel_scheduler.current_actor->actor_id : 0;
+    // Initialize message (inside a handler, the event actor is the sender)
+    sched_cpu_t* cpu = scheduler_this_cpu();
+    actor_t* sender = cpu->current_event ? NULL : cpu->current_actor;
+    message->sender_id = cpu->current_event ? cpu->current_event
+                                            : (sender ? sender->actor_id : 0);
     message->recipient_id = recipient_id;
-    message->message_id = kernel_scheduler.statistics.messages_sent + 1;
+    // Unique without a shared counter: per-CPU sequence, CPU in the low bits
+    message->message_id = this_cpu_add_return(sched_message_sequence, 1) * SMP_MAX_CPUS +
+                          smp_cpu_id();
     message->type = type;
     message->priority = ACTOR_PRIORITY_NORMAL;
     message->flags = 0;
     message->payload_size = payload_size;
     message->timestamp = kernel_scheduler.tick_count;
-    message->deadline = 0;
+    message->deadline = deadline;
+    message->queued_at = 0;
     message->reply_to = 0;
     message->requires_reply = false;
     message->next = NULL;
@@ -425,48 +1611,93 @@ bool message_send_async(uint32_t recipient_id, uint8_t type,
     }
     
     // Add to recipient's message queue
-    if (actor_add_message(recipient, message)) {
-        kernel_scheduler.statistics.messages_sent++;
+    bool queued = event_recipient ? event_actor_deliver(event_recipient, message)
+                                  : actor_add_message(recipient, message);
+    if (queued) {
+        this_cpu_inc(sched_messages_sent);
+        
+        if (sender) {
+            sender->messages_sent++;
+        }
         
-        if (kernel_scheduler.current_actor) {
-            kernel_scheduler.current_actor->messages_sent++;
+        // A waiting deadline may move a ready real-time recipient forward
+        if (recipient && deadline && recipient->rt_period) {
+            scheduler_edf_requeue(recipient);
         }
         
-        // Wake up recipient if blocked
-        if (recipient->state == ACTOR_STATE_BLOCKED) {
-            recipient->state = ACTOR_STATE_READY;
-            scheduler_add_to_ready_queue(recipient);
+        // Wake up recipient if blocked. The CAS pairs with message_wait,
+        // which only blocks on an empty mailbox under mailbox_lock, and
+        // makes sure only one of several concurrent senders wakes it.
+        if (recipient && __sync_bool_compare_and_swap(&recipient->state, ACTOR_STATE_BLOCKED,
+                                                      ACTOR_STATE_READY)) {
+            scheduler_wake(recipient, sender);
+            sched_trace_wakeup(recipient, ACTOR_STATE_BLOCKED);
         }
         
         return true;
     } else {
-        // Failed to queue message
-        if (message->payload) {
-            kfree(message->payload);
-        }
+        // Failed to queue message (message_free releases the payload)
         message_free(message);
         return false;
     }
 }
 
+/*
+ * Send asynchronous message
+ */
+bool message_send_async(uint32_t recipient_id, uint8_t type, 
+                       void* payload, size_t payload_size)
+{
+    return message_send(recipient_id, type, payload, payload_size, 0);
+}
+
+/*
+ * Send asynchronous message due within deadline_ticks
+ */
+bool message_send_deadline(uint32_t recipient_id, uint8_t type,
+                           void* payload, size_t payload_size, uint32_t deadline_ticks)
+{
+    uint32_t deadline = kernel_scheduler.tick_count + deadline_ticks;
+    return message_send(recipient_id, type, payload, payload_size, deadline ? deadline : 1);
+}
+
 /*
  * Receive message (non-blocking)
  */
 message_t* message_receive(void)
 {
-    actor_t* current = kernel_scheduler.current_actor;
+    actor_t* current = actor_get_current();
     if (!current) {
         return NULL;
     }
     
+    uint32_t flags = spin_lock_irqsave(&current->mailbox_lock);
     message_t* message = current->message_queue;
     if (message) {
         // Remove from queue
         current->message_queue = message->next;
+        if (!current->message_queue) {
+            current->message_tail = NULL;
+        }
         current->queue_size--;
+        
+        if (message->deadline && (uint32_t)message->deadline == current->mailbox_deadline) {
+            actor_update_mailbox_deadline(current);
+        }
+    }
+    spin_unlock_irqrestore(&current->mailbox_lock, flags);
+    
+    if (message) {
         current->messages_received++;
         
-        kernel_scheduler.statistics.messages_delivered++;
+        if (message->deadline &&
+            sched_deadline_before((uint32_t)message->deadline, kernel_scheduler.tick_count)) {
+            current->message_deadline_misses++;
+            this_cpu_inc(sched_deadline_misses);
+        }
+        
+        this_cpu_inc(sched_messages_delivered);
+        sched_trace_deliver(current, message);
         
         message->next = NULL; // Detach from queue
         return message;
@@ -480,7 +1711,7 @@ message_t* message_receive(void)
  */
 message_t* message_wait(uint32_t timeout_ms)
 {
-    actor_t* current = kernel_scheduler.current_actor;
+    actor_t* current = actor_get_current();
     if (!current) {
         return NULL;
     }
@@ -491,14 +1722,39 @@ message_t* message_wait(uint32_t timeout_ms)
         return message;
     }
     
-    // Block actor and wait for message
-    current->state = ACTOR_STATE_BLOCKED;
+    // A running actor needs no queue entry; drop any now, because once
+    // BLOCKED is visible a sender may wake us and queue one that must stay
     scheduler_remove_from_ready_queue(current);
     
+    // Block actor and wait for message, unless one arrived meanwhile (a
+    // sender queues under the same lock before it checks for BLOCKED)
+    uint32_t flags = spin_lock_irqsave(&current->mailbox_lock);
+    bool empty = (current->message_queue == NULL);
+    if (empty) {
+        current->state = ACTOR_STATE_BLOCKED;
+    }
+    spin_unlock_irqrestore(&current->mailbox_lock, flags);
+    
+    if (!empty) {
+        return message_receive();
+    }
+    
+    sched_trace_block(current, ACTOR_STATE_BLOCKED);
+    
     // TODO: Implement timeout handling
     // For now, yield to scheduler
+    (void)timeout_ms;
     scheduler_yield();
     
+    // Without saved contexts, this CPU may now be running another actor
+    // whose mailbox is not ours to take from. If nothing else was ready
+    // the yield came straight back with us still blocked, or already
+    // woken and queued; either way this CPU is not running us, and taking
+    // the message here would run us twice once the queued entry is claimed.
+    if (actor_get_current() != current || current->state != ACTOR_STATE_RUNNING) {
+        return NULL;
+    }
+    
     // When we resume, check for message again
     return message_receive();
 }
@@ -515,15 +1771,40 @@ void message_free(message_t* message)
     // Free payload if allocated
     if (message->payload) {
         kfree(message->payload);
+        message->payload = NULL;
     }
     
-    // Find message in pool and mark as free
-    for (uint32_t i = 0; i < MAX_MESSAGES; i++) {
-        if (&message_pool[i] == message) {
-            message_pool_used[i] = false;
-            break;
+    uint32_t index = (uint32_t)(message - message_pool);
+    if (index >= MAX_MESSAGES) {
+        return;
+    }
+    
+    // Back to this CPU's cache; past two batches, one batch goes to the
+    // shared pool so CPUs that only receive do not hoard messages
+    sched_cpu_t* cpu = scheduler_this_cpu();
+    uint32_t flags = cpu_irq_save();
+    
+    message->next = cpu->free_messages;
+    cpu->free_messages = message;
+    cpu->free_message_count++;
+    
+    if (cpu->free_message_count > 2 * SCHED_MESSAGE_BATCH) {
+        message_t* first = cpu->free_messages;
+        message_t* last = first;
+        for (uint32_t i = 1; i < SCHED_MESSAGE_BATCH; i++) {
+            last = last->next;
         }
+        cpu->free_messages = last->next;
+        cpu->free_message_count -= SCHED_MESSAGE_BATCH;
+        
+        spin_lock(&kernel_scheduler.message_lock);
+        last->next = kernel_scheduler.free_messages;
+        kernel_scheduler.free_messages = first;
+        kernel_scheduler.free_message_count += SCHED_MESSAGE_BATCH;
+        spin_unlock(&kernel_scheduler.message_lock);
     }
+    
+    cpu_irq_restore(flags);
 }
 
 // =============================================================================
@@ -531,18 +1812,56 @@ void message_free(message_t* message)
 // =============================================================================
 
 /*
- * Select next actor to run
+ * Select next actor to run and claim it: this CPU's queue first, then
+ * steal from the CPU with the longest queue
  */
 actor_t* scheduler_select_next_actor(void)
 {
-    // Simple round-robin for now
+    // Round-robin within each CPU's queue
     // TODO: Implement priority-based scheduling and AI optimization
     
-    if (!kernel_scheduler.ready_queue) {
-        return NULL;
+    uint32_t self = smp_cpu_id();
+    sched_cpu_t* cpu = &kernel_scheduler.cpus[self];
+    
+    scheduler_drain_wakeups(cpu);
+    
+    // Real-time actors first, earliest deadline first (they are admitted
+    // to one CPU and never stolen)
+    actor_t* next = scheduler_edf_take(cpu);
+    if (next) {
+        return next;
+    }
+    
+    next = scheduler_claim_allowed(&cpu->runqueue, self);
+    if (next) {
+        return next;
     }
     
-    return kernel_scheduler.ready_queue;
+    for (;;) {
+        sched_cpu_t* victim = NULL;
+        int32_t longest = 0;
+        
+        for (uint32_t i = 0; i < SMP_MAX_CPUS; i++) {
+            sched_cpu_t* other = &kernel_scheduler.cpus[i];
+            if (i == self || !other->online) continue;
+            
+            int32_t length = sched_runqueue_length(&other->runqueue);
+            if (length > longest) {
+                longest = length;
+                victim = other;
+            }
+        }
+        
+        if (!victim) {
+            return NULL;
+        }
+        
+        next = scheduler_claim_allowed(&victim->runqueue, self);
+        if (next) {
+            cpu->steals++;
+            return next;
+        }
+    }
 }
 
 /*
@@ -550,26 +1869,41 @@ actor_t* scheduler_select_next_actor(void)
  */
 void scheduler_context_switch(actor_t* next_actor)
 {
-    actor_t* current = kernel_scheduler.current_actor;
+    sched_cpu_t* cpu = scheduler_this_cpu();
+    actor_t* current = cpu->current_actor;
     
     if (current == next_actor) {
         return; // No switch needed
     }
     
-    // Save current actor state
-    if (current && current->state == ACTOR_STATE_RUNNING) {
+    // Only a real switch counts (the old counter ticked on every schedule call)
+    if (next_actor) {
+        sched_trace_switch(current, next_actor);
+        this_cpu_inc(sched_context_switches);
+    }
+    
+    // Save current actor state (unless it was woken and already runs elsewhere)
+    uint32_t self = smp_cpu_id();
+    if (current && current->state == ACTOR_STATE_RUNNING && current->last_cpu == self) {
         // TODO: Save CPU context
         current->state = ACTOR_STATE_READY;
     }
     
-    // Switch to next actor
+    // Switch to next actor (already claimed from a run queue)
     if (next_actor) {
-        kernel_scheduler.current_actor = next_actor;
+        // A CPU that went idle after this actor blocked still lists it as
+        // current: take it over so that CPU does not count it as running
+        uint32_t previous_cpu = next_actor->last_cpu;
+        next_actor->last_cpu = self;
+        if (previous_cpu != self && previous_cpu < SMP_MAX_CPUS) {
+            __sync_bool_compare_and_swap(&kernel_scheduler.cpus[previous_cpu].current_actor,
+                                         next_actor, NULL);
+        }
+        
+        cpu->current_actor = next_actor;
         next_actor->state = ACTOR_STATE_RUNNING;
         next_actor->last_scheduled = kernel_scheduler.tick_count;
-        
-        // Remove from ready queue
-        scheduler_remove_from_ready_queue(next_actor);
+        cpu_timer_slice_begin();
         
         // TODO: Load CPU context
         
@@ -579,30 +1913,96 @@ void scheduler_context_switch(actor_t* next_actor)
 }
 
 /*
- * Add actor to ready queue
+ * Queue a ready actor for a CPU: pushed directly when that is this CPU,
+ * through the target's wake list otherwise. An actor whose removal left
+ * its entry behind is revived in place instead of getting a second
+ * entry, so every actor has at most one entry across all run queues and
+ * wake lists.
  */
-void scheduler_add_to_ready_queue(actor_t* actor)
+static void scheduler_enqueue(actor_t* actor, uint32_t target)
 {
     if (!actor || actor->state != ACTOR_STATE_READY) {
         return;
     }
     
-    // Simple insertion at head for now
-    // TODO: Implement priority-based insertion
+    if (actor->rt_period) {
+        scheduler_edf_enqueue(actor);
+        return;
+    }
     
-    actor->next = kernel_scheduler.ready_queue;
-    actor->prev = NULL;
+    if (!scheduler_cpu_allowed(actor, target)) {
+        target = scheduler_fallback_cpu(actor);
+    }
     
-    if (kernel_scheduler.ready_queue) {
-        kernel_scheduler.ready_queue->prev = actor;
+    // TODO: Implement priority-based insertion
+    
+    for (;;) {
+        uint32_t state = actor->rq_state;
+        
+        if (state == SCHED_RQ_QUEUED) {
+            return;
+        }
+        if (state == SCHED_RQ_STALE) {
+            if (__sync_bool_compare_and_swap(&actor->rq_state, SCHED_RQ_STALE, SCHED_RQ_QUEUED)) {
+                break;
+            }
+            continue;
+        }
+        if (__sync_bool_compare_and_swap(&actor->rq_state, SCHED_RQ_NONE, SCHED_RQ_QUEUED)) {
+            uint32_t self = smp_cpu_id();
+            if (target != self) {
+                scheduler_wake_remote(actor, target);
+                break;
+            }
+            
+            // Append at this CPU's tail so yielding actors rotate round-robin
+            sched_cpu_t* cpu = &kernel_scheduler.cpus[self];
+            uint32_t flags = cpu_irq_save();
+            bool queued = sched_runqueue_push(&cpu->runqueue, actor);
+            cpu_irq_restore(flags);
+            
+            if (!queued) {
+                // Cannot happen: one entry per actor and MAX_ACTORS slots
+                actor->rq_state = SCHED_RQ_NONE;
+                kprintf("[SCHEDULER] ERROR: Run queue full, actor %d not queued\n",
+                        actor->actor_id);
+                return;
+            }
+            
+            // Busy here: let a halted CPU steal it rather than wait
+            actor_t* current = cpu->current_actor;
+            if (sched_runqueue_length(&cpu->runqueue) > 1 ||
+                (current && current->state == ACTOR_STATE_RUNNING)) {
+                scheduler_kick_idle_cpu(self);
+            }
+            break;
+        }
     }
     
-    kernel_scheduler.ready_queue = actor;
-    kernel_scheduler.statistics.ready_actors++;
+    __sync_fetch_and_add(&kernel_scheduler.statistics.ready_actors, 1);
+    sched_trace_ready(actor);
+}
+
+/*
+ * Add actor to this CPU's run queue
+ */
+void scheduler_add_to_ready_queue(actor_t* actor)
+{
+    scheduler_enqueue(actor, smp_cpu_id());
+}
+
+/*
+ * Make a woken actor runnable where scheduler_wake_target places it
+ * (sender is the actor whose message woke it, if any)
+ */
+static void scheduler_wake(actor_t* actor, actor_t* sender)
+{
+    scheduler_enqueue(actor, scheduler_wake_target(actor, sender));
 }
 
 /*
- * Remove actor from ready queue
+ * Remove actor from the run queues. The entry stays where it is and is
+ * dropped by whichever CPU takes it next.
  */
 void scheduler_remove_from_ready_queue(actor_t* actor)
 {
@@ -610,21 +2010,14 @@ void scheduler_remove_from_ready_queue(actor_t* actor)
         return;
     }
     
-    // Remove from linked list
-    if (actor->prev) {
-        actor->prev->next = actor->next;
-    } else {
-        kernel_scheduler.ready_queue = actor->next;
+    if (actor->rt_period) {
+        scheduler_edf_remove(actor);
     }
     
-    if (actor->next) {
-        actor->next->prev = actor->prev;
+    // Not queued (running, blocked or parked)
+    if (__sync_bool_compare_and_swap(&actor->rq_state, SCHED_RQ_QUEUED, SCHED_RQ_STALE)) {
+        __sync_fetch_and_sub(&kernel_scheduler.statistics.ready_actors, 1);
     }
-    
-    actor->next = NULL;
-    actor->prev = NULL;
-    
-    kernel_scheduler.statistics.ready_actors--;
 }
 
 /*
@@ -632,10 +2025,11 @@ void scheduler_remove_from_ready_queue(actor_t* actor)
  */
 void actor_create_kernel_actor(void)
 {
-    actor_t* kernel_actor = &actor_pool[0];
-    actor_pool_used[0] = true;
+    // First allocation from an empty table: slot 0, whose first ID is 0
+    uint32_t actor_id;
+    actor_t* kernel_actor = (actor_t*)handle_table_alloc(&kernel_scheduler.actor_table, &actor_id);
     
-    kernel_actor->actor_id = 0;
+    kernel_actor->actor_id = actor_id;
     kernel_actor->parent_id = 0;
     kernel_actor->state = ACTOR_STATE_RUNNING;
     kernel_actor->priority = ACTOR_PRIORITY_CRITICAL;
@@ -653,6 +2047,7 @@ void actor_create_kernel_actor(void)
     }
     
     kernel_actor->message_queue = NULL;
+    kernel_actor->message_tail = NULL;
     kernel_actor->queue_size = 0;
     kernel_actor->max_queue_size = 256; // Large queue for kernel
     
@@ -663,6 +2058,33 @@ void actor_create_kernel_actor(void)
     kernel_actor->creation_time = 0;
     kernel_actor->last_scheduled = 0;
     
+    kernel_actor->cpu_quota = 0; // Kernel is never throttled
+    kernel_actor->cpu_tokens = 0;
+    kernel_actor->throttle_count = 0;
+    kernel_actor->ready_since = 0;
+    kernel_actor->run_since = 0;
+    kernel_actor->rq_state = SCHED_RQ_NONE;
+    kernel_actor->last_cpu = 0;
+    kernel_actor->wake_next = NULL;
+    kernel_actor->affinity = 1;         // The boot context never leaves the BSP
+    kernel_actor->preferred_cpu = SCHED_CPU_NONE;
+    for (uint32_t i = 0; i < ACTOR_PARTNER_SLOTS; i++) {
+        kernel_actor->partners[i].actor_id = 0;
+        kernel_actor->partners[i].messages = 0;
+    }
+    kernel_actor->partner_messages = 0;
+    kernel_actor->rt_budget = 0;
+    kernel_actor->rt_period = 0;
+    kernel_actor->rt_runtime = 0;
+    kernel_actor->rt_deadline = 0;
+    kernel_actor->rt_ready_tick = 0;
+    kernel_actor->rt_cpu = 0;
+    kernel_actor->mailbox_deadline = 0;
+    kernel_actor->edf_key = 0;
+    kernel_actor->edf_index = SCHED_EDF_NONE;
+    kernel_actor->deadline_misses = 0;
+    kernel_actor->message_deadline_misses = 0;
+    
     kernel_actor->memory_context = NULL;
     kernel_actor->memory_limit = 0; // Unlimited for kernel
     kernel_actor->memory_used = 0;
@@ -677,8 +2099,8 @@ void actor_create_kernel_actor(void)
     kernel_actor->next = NULL;
     kernel_actor->prev = NULL;
     
-    kernel_scheduler.actors[0] = kernel_actor;
-    kernel_scheduler.current_actor = kernel_actor;
+    handle_table_publish(&kernel_scheduler.actor_table, actor_id);
+    kernel_scheduler.cpus[0].current_actor = kernel_actor;
     
     kprintf("[SCHEDULER] Kernel actor created (ID 0)\n");
 }
@@ -688,18 +2110,90 @@ void actor_create_kernel_actor(void)
 // =============================================================================
 
 /*
- * Allocate a message from the pool
+ * Allocate a message from this CPU's cache, refilling it with a batch
+ * from the shared pool when it runs dry
  */
 message_t* message_allocate(void)
 {
-    for (uint32_t i = 0; i < MAX_MESSAGES; i++) {
-        if (!message_pool_used[i]) {
-            message_pool_used[i] = true;
-            return &message_pool[i];
+    sched_cpu_t* cpu = scheduler_this_cpu();
+    uint32_t flags = cpu_irq_save();
+    
+    if (!cpu->free_messages && kernel_scheduler.free_messages) {
+        spin_lock(&kernel_scheduler.message_lock);
+        message_t* first = kernel_scheduler.free_messages;
+        uint32_t count = 0;
+        if (first) {
+            message_t* last = first;
+            count = 1;
+            while (count < SCHED_MESSAGE_BATCH && last->next) {
+                last = last->next;
+                count++;
+            }
+            kernel_scheduler.free_messages = last->next;
+            kernel_scheduler.free_message_count -= count;
+            last->next = NULL;
         }
+        spin_unlock(&kernel_scheduler.message_lock);
+        
+        cpu->free_messages = first;
+        cpu->free_message_count = count;
     }
     
-    return NULL;
+    message_t* message = cpu->free_messages;
+    if (message) {
+        cpu->free_messages = message->next;
+        cpu->free_message_count--;
+        message->next = NULL;
+    }
+    
+    cpu_irq_restore(flags);
+    return message;
+}
+
+/*
+ * Count a message from sender toward the actor's partner statistics
+ * (caller holds mailbox_lock). A full table evicts its lightest entry
+ * and lets the newcomer inherit that count, so a sender that dominates
+ * the traffic always ends up tracked.
+ */
+static void actor_note_partner(actor_t* actor, uint32_t sender_id)
+{
+    if (sender_id == 0 || sender_id == actor->actor_id) {
+        return;
+    }
+    
+    actor->partner_messages++;
+    
+    actor_partner_t* lightest = &actor->partners[0];
+    for (uint32_t i = 0; i < ACTOR_PARTNER_SLOTS; i++) {
+        actor_partner_t* partner = &actor->partners[i];
+        if (partner->messages && partner->actor_id == sender_id) {
+            partner->messages++;
+            return;
+        }
+        if (partner->messages < lightest->messages) {
+            lightest = partner;
+        }
+    }
+    
+    lightest->actor_id = sender_id;
+    lightest->messages++;
+}
+
+/*
+ * Earliest deadline among queued messages, after the one that set it
+ * was taken (caller holds mailbox_lock; only deadline messages walk)
+ */
+static void actor_update_mailbox_deadline(actor_t* actor)
+{
+    uint32_t earliest = 0;
+    for (message_t* message = actor->message_queue; message; message = message->next) {
+        uint32_t deadline = (uint32_t)message->deadline;
+        if (deadline && (!earliest || sched_deadline_before(deadline, earliest))) {
+            earliest = deadline;
+        }
+    }
+    actor->mailbox_deadline = earliest;
 }
 
 /*
@@ -711,26 +2205,43 @@ bool actor_add_message(actor_t* actor, message_t* message)
         return false;
     }
     
+    message->next = NULL;
+    message->queued_at = read_timestamp_counter();
+    
+    uint32_t flags = spin_lock_irqsave(&actor->mailbox_lock);
+    
+    // The actor may have terminated, and its slot been reused, since the
+    // sender looked it up
+    if (actor->actor_id != message->recipient_id || actor->state == ACTOR_STATE_FINISHED) {
+        spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+        return false;
+    }
+    
     // Check queue size limit
     if (actor->queue_size >= actor->max_queue_size) {
+        spin_unlock_irqrestore(&actor->mailbox_lock, flags);
         kprintf("[SCHEDULER] Actor %d message queue full\n", actor->actor_id);
         return false;
     }
     
-    // Add to end of queue
-    message->next = NULL;
-    
-    if (!actor->message_queue) {
+    // Add to end of queue (no walk: fan-in mailboxes run long)
+    if (!actor->message_tail) {
         actor->message_queue = message;
     } else {
-        message_t* tail = actor->message_queue;
-        while (tail->next) {
-            tail = tail->next;
-        }
-        tail->next = message;
+        actor->message_tail->next = message;
     }
+    actor->message_tail = message;
     
     actor->queue_size++;
+    actor_note_partner(actor, message->sender_id);
+    
+    uint32_t deadline = (uint32_t)message->deadline;
+    if (deadline && (!actor->mailbox_deadline ||
+                     sched_deadline_before(deadline, actor->mailbox_deadline))) {
+        actor->mailbox_deadline = deadline;
+    }
+    
+    spin_unlock_irqrestore(&actor->mailbox_lock, flags);
     return true;
 }
 
@@ -743,21 +2254,37 @@ void actor_clear_message_queue(actor_t* actor)
         return;
     }
     
+    uint32_t flags = spin_lock_irqsave(&actor->mailbox_lock);
     message_t* current = actor->message_queue;
+    actor->message_queue = NULL;
+    actor->message_tail = NULL;
+    actor->queue_size = 0;
+    actor->mailbox_deadline = 0;
+    spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+    
     while (current) {
         message_t* next = current->next;
         message_free(current);
         current = next;
     }
-    
-    actor->message_queue = NULL;
-    actor->queue_size = 0;
 }
 
 // =============================================================================
 // Statistics and Monitoring
 // =============================================================================
 
+/*
+ * Fold the per-CPU hot counters into the shared statistics
+ */
+static void scheduler_sum_percpu_statistics(void)
+{
+    scheduler_stats_t* stats = &kernel_scheduler.statistics;
+    
+    stats->context_switches = percpu_sum(sched_context_switches);
+    stats->messages_sent = percpu_sum(sched_messages_sent);
+    stats->messages_delivered = percpu_sum(sched_messages_delivered);
+}
+
 /*
  * Get scheduler statistics
  */
@@ -767,6 +2294,7 @@ scheduler_stats_t* scheduler_get_statistics(void)
         return NULL;
     }
     
+    scheduler_sum_percpu_statistics();
     return &kernel_scheduler.statistics;
 }
 
@@ -780,6 +2308,7 @@ void scheduler_print_status(void)
         return;
     }
     
+    scheduler_sum_percpu_statistics();
     scheduler_stats_t* stats = &kernel_scheduler.statistics;
     
     kprintf("[SCHEDULER] Status Report:\n");
@@ -788,15 +2317,36 @@ void scheduler_print_status(void)
     kprintf("  Current actors: %d\n", stats->current_actors);
     kprintf("  Ready actors: %d\n", stats->ready_actors);
     kprintf("  Blocked actors: %d\n", stats->blocked_actors);
+    kprintf("  Throttled actors: %d (%d events)\n", stats->throttled_actors,
+            (uint32_t)stats->throttle_events);
     kprintf("  Context switches: %d\n", (uint32_t)stats->context_switches);
     kprintf("  Messages sent: %d\n", (uint32_t)stats->messages_sent);
     kprintf("  Messages delivered: %d\n", (uint32_t)stats->messages_delivered);
     kprintf("  Tick count: %d\n", kernel_scheduler.tick_count);
-    
-    if (kernel_scheduler.current_actor) {
-        kprintf("  Current actor: %d (%s)\n", 
-                kernel_scheduler.current_actor->actor_id,
-                actor_state_name(kernel_scheduler.current_actor->state));
+    kprintf("  Remote wakeups: %d (%d reschedule IPIs, %d coalesced)\n",
+            (uint32_t)percpu_sum(sched_remote_wakeups), (uint32_t)percpu_sum(sched_resched_ipis),
+            (uint32_t)percpu_sum(sched_resched_coalesced));
+    kprintf("  Deadline misses: %d\n", (uint32_t)percpu_sum(sched_deadline_misses));
+    event_actor_print_status();
+    
+    for (uint32_t i = 0; i < SMP_MAX_CPUS; i++) {
+        sched_cpu_t* cpu = &kernel_scheduler.cpus[i];
+        if (!cpu->online) continue;
+        
+        kprintf("  CPU %d: queue %d, %d switches, %d steals", i,
+                sched_runqueue_length(&cpu->runqueue),
+                (uint32_t)percpu_areas[i].sched_context_switches, (uint32_t)cpu->steals);
+        if (cpu->edf_member_count) {
+            kprintf(", %d real-time (%d ready, %d%% reserved)", cpu->edf_member_count,
+                    cpu->edf_count, (cpu->edf_utilization + 99) / 100);
+        }
+        if (cpu->idle) {
+            kprintf(", halted");
+        } else if (cpu->current_actor) {
+            kprintf(", running actor %d (%s)", cpu->current_actor->actor_id,
+                    actor_state_name(cpu->current_actor->state));
+        }
+        kprintf("\n");
     }
 }
 
@@ -807,16 +2357,40 @@ void scheduler_print_actors(void)
 {
     kprintf("[SCHEDULER] Actor List:\n");
     
-    for (uint32_t i = 0; i < MAX_ACTORS; i++) {
-        actor_t* actor = kernel_scheduler.actors[i];
-        if (actor) {
-            kprintf("  Actor %d: %s, Priority=%s, CPU=%d, Messages=%d/%d\n",
-                    actor->actor_id,
-                    actor_state_name(actor->state),
-                    actor_priority_name(actor->priority),
-                    (uint32_t)actor->cpu_time_used,
-                    (uint32_t)actor->messages_sent,
-                    (uint32_t)actor->messages_received);
+    uint32_t index = 0;
+    actor_t* actor;
+    while ((actor = actor_next(&index))) {
+        kprintf("  Actor %d: %s, Priority=%s, CPU=%d, Messages=%d/%d\n",
+                actor->actor_id,
+                actor_state_name(actor->state),
+                actor_priority_name(actor->priority),
+                (uint32_t)actor->cpu_time_used,
+                (uint32_t)actor->messages_sent,
+                (uint32_t)actor->messages_received);
+        
+        if (actor->cpu_quota > 0) {
+            kprintf("    CPU quota: %d/%d ticks, throttled %d times\n",
+                    actor->cpu_quota, SCHEDULER_BANDWIDTH_PERIOD,
+                    actor->throttle_count);
+        }
+        
+        if (actor->rt_period) {
+            kprintf("    Real-time: %d/%d ticks on CPU %d, %d left, deadline in %d ticks\n",
+                    actor->rt_budget, actor->rt_period, actor->rt_cpu, actor->rt_runtime,
+                    (int32_t)(scheduler_edf_deadline(actor) - kernel_scheduler.tick_count));
+        }
+        if (actor->deadline_misses || actor->message_deadline_misses) {
+            kprintf("    Deadline misses: %d periods, %d late messages\n",
+                    actor->deadline_misses, actor->message_deadline_misses);
+        }
+        
+        uint32_t partner = scheduler_chatty_partner(actor);
+        if (actor->affinity != SCHED_AFFINITY_ALL || partner) {
+            kprintf("    Last CPU %d, affinity 0x%x", actor->last_cpu, actor->affinity);
+            if (partner) {
+                kprintf(", talks mostly with actor %d", partner);
+            }
+            kprintf("\n");
         }
     }
 }
@@ -826,7 +2400,23 @@ void scheduler_print_actors(void)
 // =============================================================================
 
 /*
- * AI-based load balancing
+ * Whether the rebalancer should place this actor
+ */
+static inline bool scheduler_balance_candidate(actor_t* actor)
+{
+    return actor && actor->actor_id != 0 &&
+           (actor->state == ACTOR_STATE_READY || actor->state == ACTOR_STATE_RUNNING ||
+            actor->state == ACTOR_STATE_BLOCKED || actor->state == ACTOR_STATE_THROTTLED);
+}
+
+/*
+ * Periodic rebalancer, run with the AI analysis pass. Placement is by
+ * actor count per CPU, counting each actor where it will next wake.
+ * First every chatty actor is moved next to its partner, then actors
+ * without one are moved off CPUs still above the mean. A move only sets
+ * preferred_cpu, so it takes effect at the actor's next wakeup. At the
+ * end the partner statistics are halved so pairs that stop talking
+ * drift apart again.
  */
 void scheduler_ai_balance_load(void)
 {
@@ -834,12 +2424,81 @@ void scheduler_ai_balance_load(void)
         return;
     }
     
-    // TODO: Implement AI load balancing
-    // - Analyze actor CPU usage patterns
-    // - Redistribute work based on priorities
-    // - Optimize message routing
+    uint32_t load[SMP_MAX_CPUS] = { 0 };
+    uint32_t online = 0, total = 0;
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        if (kernel_scheduler.cpus[cpu].online) online++;
+    }
+    
+    uint32_t index = 1; // Skip the kernel actor
+    actor_t* actor;
+    while ((actor = actor_next(&index))) {
+        if (scheduler_balance_candidate(actor)) {
+            load[scheduler_actor_home(actor)]++;
+            total++;
+        }
+    }
+    
+    uint32_t limit = (total + online - 1) / (online ? online : 1) + SCHED_BALANCE_SLACK;
+    uint32_t colocated = 0, spread = 0;
+    
+    // Co-locate chatty pairs
+    index = 1;
+    while (online > 1 && (actor = actor_next(&index))) {
+        if (!scheduler_balance_candidate(actor)) continue;
+        
+        actor_t* partner = actor_get(scheduler_chatty_partner(actor));
+        if (!scheduler_balance_candidate(partner)) continue;
+        
+        uint32_t from = scheduler_actor_home(actor);
+        uint32_t to = scheduler_actor_home(partner);
+        if (from == to || !scheduler_cpu_allowed(actor, to) || load[to] + 1 > limit) continue;
+        
+        actor->preferred_cpu = to;
+        load[from]--;
+        load[to]++;
+        colocated++;
+    }
+    
+    // Spread the rest off overloaded CPUs
+    index = 1;
+    while (online > 1 && (actor = actor_next(&index))) {
+        if (!scheduler_balance_candidate(actor) || scheduler_chatty_partner(actor)) continue;
+        
+        uint32_t from = scheduler_actor_home(actor);
+        if (load[from] <= limit) continue;
+        
+        uint32_t to = from;
+        for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+            if (scheduler_cpu_allowed(actor, cpu) && load[cpu] < load[to]) {
+                to = cpu;
+            }
+        }
+        if (load[to] + 1 >= load[from]) continue;
+        
+        actor->preferred_cpu = to;
+        load[from]--;
+        load[to]++;
+        spread++;
+    }
+    
+    // Age the partner statistics
+    index = 1;
+    while ((actor = actor_next(&index))) {
+        uint32_t flags = spin_lock_irqsave(&actor->mailbox_lock);
+        for (uint32_t p = 0; p < ACTOR_PARTNER_SLOTS; p++) {
+            actor->partners[p].messages /= 2;
+        }
+        actor->partner_messages /= 2;
+        spin_unlock_irqrestore(&actor->mailbox_lock, flags);
+    }
+    
+    kernel_scheduler.statistics.load_balance_actions += colocated + spread;
     
-    kprintf("[AI-SCHEDULER] Load balancing analysis completed\n");
+    if (colocated + spread > 0) {
+        kprintf("[AI-SCHEDULER] Load balancing: %d actors moved to their partner's CPU, %d spread\n",
+                colocated, spread);
+    }
 }
 
 /*
@@ -874,9 +2533,10 @@ void scheduler_ai_analyze_actors(void)
     // - Update actor behavior scores
     
     // Simple analysis for now
-    for (uint32_t i = 0; i < MAX_ACTORS; i++) {
-        actor_t* actor = kernel_scheduler.actors[i];
-        if (actor && actor->ai_monitored) {
+    uint32_t index = 0;
+    actor_t* actor;
+    while ((actor = actor_next(&index))) {
+        if (actor->ai_monitored) {
             // Simple heuristic: actors with balanced send/receive have good behavior
             if (actor->messages_sent > 0 && actor->messages_received > 0) {
                 if (actor->behavior_score < 100) {
@@ -887,6 +2547,19 @@ void scheduler_ai_analyze_actors(void)
     }
 }
 
+/*
+ * Consume the timer's request for actor behavior analysis
+ */
+bool scheduler_ai_analysis_due(void)
+{
+    if (!kernel_scheduler.ai_analysis_pending) {
+        return false;
+    }
+    
+    kernel_scheduler.ai_analysis_pending = false;
+    return true;
+}
+
 // =============================================================================
 // Debug Functions
 // =============================================================================
@@ -898,21 +2571,29 @@ void scheduler_dump_state(void)
 {
     kprintf("[SCHEDULER] Internal State Dump:\n");
     kprintf("  Scheduler enabled: %d\n", kernel_scheduler.scheduler_enabled);
-    kprintf("  Next actor ID: %d\n", kernel_scheduler.next_actor_id);
-    kprintf("  Ready queue head: 0x%x\n", (uint32_t)kernel_scheduler.ready_queue);
-    kprintf("  Current actor: 0x%x\n", (uint32_t)kernel_scheduler.current_actor);
+    kprintf("  Actor table: %d live in %d slots (%d heap pages)\n",
+            kernel_scheduler.actor_table.live, kernel_scheduler.actor_table.capacity,
+            kernel_scheduler.actor_table.allocated_pages);
     kprintf("  Message count: %d\n", kernel_scheduler.message_count);
     kprintf("  AI supervision: %d\n", kernel_scheduler.ai_supervision);
     
-    // Dump ready queue
-    kprintf("  Ready queue:\n");
-    actor_t* current = kernel_scheduler.ready_queue;
-    int count = 0;
-    while (current && count < 10) {
-        kprintf("    -> Actor %d (%s)\n", 
-                current->actor_id, actor_state_name(current->state));
-        current = current->next;
-        count++;
+    // Dump run queues (racy snapshot; entries may be stale)
+    for (uint32_t i = 0; i < SMP_MAX_CPUS; i++) {
+        sched_cpu_t* cpu = &kernel_scheduler.cpus[i];
+        if (!cpu->online) continue;
+        
+        kprintf("  CPU %d: current 0x%x, run queue [%d, %d):\n", i,
+                (uint32_t)cpu->current_actor, cpu->runqueue.top, cpu->runqueue.bottom);
+        
+        int32_t count = 0;
+        uint32_t bottom = cpu->runqueue.bottom;
+        for (uint32_t slot = cpu->runqueue.top; (int32_t)(bottom - slot) > 0 && count < 10; slot++) {
+            actor_t* actor = cpu->runqueue.slots[slot & (SCHED_RUNQUEUE_SIZE - 1)];
+            kprintf("    -> Actor %d (%s%s)\n", actor->actor_id,
+                    actor_state_name(actor->state),
+                    actor->rq_state == SCHED_RQ_STALE ? ", stale" : "");
+            count++;
+        }
     }
 }
 
@@ -924,7 +2605,7 @@ void scheduler_test_functionality(void)
     kprintf("[SCHEDULER] Running scheduler tests...\n");
     
     // Test 1: Actor creation
-    uint32_t test_actor = actor_create((void*)0x12345678, NULL, 
+    uint32_t test_actor = actor_create((actor_entry_t)0x12345678, NULL, 
                                       ACTOR_PRIORITY_NORMAL, 4096);
     if (test_actor != 0) {
         kprintf("  Test 1 - Actor creation: SUCCESS (ID %d)\n", test_actor);
@@ -0,0 +1,102 @@
+/*
+ * =============================================================================
+ * CLKernel - Serial Port Driver
+ * =============================================================================
+ * File: serial.c
+ * Purpose: Polled 16550 UART output used by log export and diagnostics
+ *
+ * The VGA console is for humans; the serial port is the machine-readable
+ * channel. Output is polled (no IRQ) so it can be used from any context.
+ * =============================================================================
+ */
+
+#include "serial.h"
+#include "kernel.h"
+#include "../io.h"
+
+// Active serial port (0 = not initialized)
+static uint16_t serial_port = 0;
+
+/*
+ * Initialize a serial port at 115200 baud, 8N1, FIFOs enabled
+ */
+bool serial_init(uint16_t port)
+{
+    outb(port + SERIAL_REG_INT_ENABLE, 0x00);   // Disable UART interrupts
+    outb(port + SERIAL_REG_LINE_CTRL, 0x80);    // Enable DLAB
+    outb(port + SERIAL_REG_DATA, 0x01);         // Divisor low byte (115200 baud)
+    outb(port + SERIAL_REG_INT_ENABLE, 0x00);   // Divisor high byte
+    outb(port + SERIAL_REG_LINE_CTRL, 0x03);    // 8 bits, no parity, one stop bit
+    outb(port + SERIAL_REG_FIFO_CTRL, 0xC7);    // Enable FIFO, clear, 14-byte threshold
+    outb(port + SERIAL_REG_MODEM_CTRL, 0x1E);   // Loopback mode for self-test
+    
+    // Self-test: the byte we send must come back in loopback mode
+    outb(port + SERIAL_REG_DATA, 0xAE);
+    if (inb(port + SERIAL_REG_DATA) != 0xAE) {
+        return false; // No UART present
+    }
+    
+    outb(port + SERIAL_REG_MODEM_CTRL, 0x0F);   // Normal operation, OUT1/OUT2 set
+    serial_port = port;
+    
+    return true;
+}
+
+/*
+ * Check whether a serial port has been initialized
+ */
+bool serial_is_ready(void)
+{
+    return serial_port != 0;
+}
+
+/*
+ * Check whether the transmit holding register is empty
+ */
+bool serial_transmit_empty(void)
+{
+    if (!serial_port) return false;
+    
+    return (inb(serial_port + SERIAL_REG_LINE_STATUS) & SERIAL_LSR_THR_EMPTY) != 0;
+}
+
+/*
+ * Write a single character (polled)
+ */
+void serial_write_char(char c)
+{
+    if (!serial_port) return;
+    
+    while (!serial_transmit_empty()) {
+        // Wait for transmitter
+    }
+    
+    outb(serial_port + SERIAL_REG_DATA, (uint8_t)c);
+}
+
+/*
+ * Write raw bytes (binary safe)
+ */
+void serial_write(const void* data, size_t length)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    
+    for (size_t i = 0; i < length; i++) {
+        serial_write_char((char)bytes[i]);
+    }
+}
+
+/*
+ * Write a NUL-terminated string, translating \n to \r\n
+ */
+void serial_write_string(const char* str)
+{
+    if (!str) return;
+    
+    while (*str) {
+        if (*str == '\n') {
+            serial_write_char('\r');
+        }
+        serial_write_char(*str++);
+    }
+}
@@ -0,0 +1,318 @@
+/*
+ * =============================================================================
+ * CLKernel - Symmetric Multiprocessing
+ * =============================================================================
+ * File: smp.c
+ * Purpose: Wake the application processors and identify the running CPU
+ *
+ * APs are started with INIT-SIPI-SIPI sent to each local APIC ID the MADT
+ * (or MP table) lists, up to SMP_MAX_CPUS; only when neither table exists
+ * is the sequence broadcast. Each AP takes the next CPU index from the
+ * trampoline with a locked xadd; CPUs beyond SMP_MAX_CPUS halt there.
+ * =============================================================================
+ */
+
+#include "smp.h"
+#include "apic.h"
+#include "kernel.h"
+#include "gdt.h"
+#include "percpu.h"
+#include "idt.h"
+#include "scheduler.h"
+#include "cpu_timer.h"
+#include "acpi.h"
+
+// =============================================================================
+// Global SMP State
+// =============================================================================
+
+static smp_state_t smp_state;
+
+// Stack tops handed to the trampoline, indexed by CPU index
+static uint32_t smp_ap_stack_tops[SMP_MAX_CPUS];
+
+// Real-mode trampoline (ap_trampoline.asm), copied to SMP_TRAMPOLINE_ADDR
+extern uint8_t ap_trampoline_start[];
+extern uint8_t ap_trampoline_end[];
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+/*
+ * Busy-wait roughly 'us' microseconds (one ISA port write each)
+ */
+static void smp_delay_us(uint32_t us)
+{
+    while (us--) {
+        asm volatile ("outb %%al, $0x80" : : "a" (0));
+    }
+}
+
+static uint32_t smp_read_cr0(void)
+{
+    uint32_t cr0;
+    asm volatile ("mov %%cr0, %0" : "=r" (cr0));
+    return cr0;
+}
+
+static uint32_t smp_read_cr3(void)
+{
+    uint32_t cr3;
+    asm volatile ("mov %%cr3, %0" : "=r" (cr3));
+    return cr3;
+}
+
+/*
+ * INIT, then two STARTUPs pointing at the trampoline page, to each listed
+ * AP. Returns how many were sent the sequence.
+ */
+static uint32_t smp_start_listed(const apic_platform_t* platform, uint8_t bsp_apic_id)
+{
+    uint32_t listed = platform->cpu_count;
+    if (listed > APIC_PLATFORM_MAX_CPUS) {
+        listed = APIC_PLATFORM_MAX_CPUS;
+    }
+
+    uint8_t targets[SMP_MAX_CPUS];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < listed && count < SMP_MAX_CPUS - 1; i++) {
+        if (platform->cpu_apic_ids[i] != bsp_apic_id) {
+            targets[count++] = platform->cpu_apic_ids[i];
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        lapic_send_ipi(targets[i], LAPIC_ICR_INIT | LAPIC_ICR_ASSERT | LAPIC_ICR_LEVEL);
+    }
+    smp_delay_us(10000);
+    for (uint32_t attempt = 0; attempt < 2; attempt++) {
+        for (uint32_t i = 0; i < count; i++) {
+            lapic_send_ipi(targets[i], LAPIC_ICR_STARTUP | (SMP_TRAMPOLINE_ADDR >> 12));
+        }
+        smp_delay_us(200);
+    }
+    return count;
+}
+
+/*
+ * No firmware CPU list: wake whatever is waiting for a SIPI
+ */
+static void smp_start_broadcast(void)
+{
+    lapic_broadcast_ipi(LAPIC_ICR_INIT | LAPIC_ICR_ASSERT | LAPIC_ICR_LEVEL);
+    smp_delay_us(10000);
+    for (uint32_t attempt = 0; attempt < 2; attempt++) {
+        lapic_broadcast_ipi(LAPIC_ICR_STARTUP | (SMP_TRAMPOLINE_ADDR >> 12));
+        smp_delay_us(200);
+    }
+}
+
+// =============================================================================
+// Bring-up
+// =============================================================================
+
+/*
+ * Start every application processor. Runs on the BSP once the heap and
+ * scheduler are up; returns after SMP_AP_WAIT_MS with whatever came online.
+ */
+void smp_init(void)
+{
+    kprintf("[SMP] Initializing multiprocessor support...\n");
+
+    smp_cpu_t* bsp = &smp_state.cpus[0];
+    bsp->index = 0;
+    bsp->stack = NULL;
+    bsp->online = true;
+    smp_state.cpu_count = 1;
+
+    if (!lapic_init()) {
+        return;
+    }
+
+    bsp->apic_id = lapic_id();
+
+    // Calibrate before the APs come up: each one starts its timer from it
+    cpu_timer_init();
+
+    for (uint32_t i = 0; i < 256; i++) {
+        smp_state.apic_to_cpu[i] = 0;
+    }
+
+    // Boot/idle stacks for every AP we may accept
+    for (uint32_t cpu = 1; cpu < SMP_MAX_CPUS; cpu++) {
+        void* stack = kmalloc(SMP_AP_STACK_SIZE);
+        if (!stack) {
+            kprintf("[SMP] ERROR: No memory for AP stacks\n");
+            return;
+        }
+        smp_state.cpus[cpu].index = cpu;
+        smp_state.cpus[cpu].stack = stack;
+        smp_ap_stack_tops[cpu] = (uint32_t)stack + SMP_AP_STACK_SIZE;
+    }
+
+    // Copy the trampoline below 1MB and tell it where to go
+    uint8_t* target = (uint8_t*)SMP_TRAMPOLINE_ADDR;
+    uint32_t length = (uint32_t)(ap_trampoline_end - ap_trampoline_start);
+    for (uint32_t i = 0; i < length; i++) {
+        target[i] = ap_trampoline_start[i];
+    }
+
+    smp_trampoline_params_t* params = (smp_trampoline_params_t*)SMP_TRAMPOLINE_PARAMS;
+    params->cr3 = (smp_read_cr0() & 0x80000000) ? smp_read_cr3() : 0;
+    params->entry = (uint32_t)smp_ap_main;
+    params->stacks = (uint32_t)smp_ap_stack_tops;
+    params->next_cpu = 1;
+
+    // Start the APs the firmware lists, else broadcast
+    apic_platform_t platform;
+    uint32_t expected = SMP_MAX_CPUS;
+    if (acpi_discover_apics(&platform) && platform.cpu_count > 0) {
+        expected = 1 + smp_start_listed(&platform, bsp->apic_id);
+        if (platform.cpu_count > SMP_MAX_CPUS) {
+            kprintf("[SMP] %s lists %d CPUs, only %d are used\n",
+                    acpi_source_name(platform.source), platform.cpu_count, SMP_MAX_CPUS);
+        }
+    } else {
+        kprintf("[SMP] No CPUs in an MADT or MP table, broadcasting INIT-SIPI-SIPI\n");
+        smp_start_broadcast();
+    }
+
+    for (uint32_t waited = 0; waited < SMP_AP_WAIT_MS; waited++) {
+        if (smp_state.cpu_count >= expected) break;
+        smp_delay_us(1000);
+    }
+
+    smp_state.enabled = true;
+
+    uint32_t responded = params->next_cpu - 1;
+    if (responded >= SMP_MAX_CPUS) {
+        kprintf("[SMP] %d CPUs responded, only %d are used\n", responded + 1, SMP_MAX_CPUS);
+    }
+    kprintf("[SMP] %d CPU(s) online\n", smp_state.cpu_count);
+}
+
+/*
+ * First C code on an AP (called by the trampoline on its own stack)
+ */
+void smp_ap_main(uint32_t cpu)
+{
+    gdt_load();
+    percpu_init_cpu(cpu);
+    idt_load();
+    lapic_init_ap();
+
+    smp_cpu_t* self = &smp_state.cpus[cpu];
+    self->apic_id = lapic_id();
+    smp_state.apic_to_cpu[self->apic_id] = (uint8_t)cpu;
+
+    if (!scheduler_cpu_online(cpu)) {
+        // Stay out of scheduling rather than run without a queue
+        for (;;) {
+            asm volatile ("cli; hlt");
+        }
+    }
+    cpu_timer_start_cpu();
+
+    self->online = true;
+    __sync_fetch_and_add(&smp_state.cpu_count, 1);
+
+    // Timer interrupts end slices from here on
+    asm volatile ("sti");
+
+    // Run or steal actors forever
+    scheduler_cpu_loop();
+}
+
+// =============================================================================
+// CPU Identification
+// =============================================================================
+
+/*
+ * Index of the running CPU, from its per-CPU area (one GS-relative load)
+ */
+uint32_t smp_cpu_id(void)
+{
+    return this_cpu_read(cpu);
+}
+
+uint32_t smp_cpu_count(void)
+{
+    return smp_state.cpu_count;
+}
+
+smp_cpu_t* smp_get_cpu(uint32_t cpu)
+{
+    if (cpu >= SMP_MAX_CPUS) {
+        return NULL;
+    }
+    return &smp_state.cpus[cpu];
+}
+
+// =============================================================================
+// Local Interrupt Control
+// =============================================================================
+
+uint32_t cpu_irq_save(void)
+{
+    uint32_t flags;
+    asm volatile ("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    return flags;
+}
+
+void cpu_irq_restore(uint32_t flags)
+{
+    asm volatile ("push %0; popf" : : "r" (flags) : "memory", "cc");
+}
+
+void cpu_relax(void)
+{
+    asm volatile ("pause");
+}
+
+/*
+ * Enable interrupts and sleep until the next one. sti only takes effect
+ * after the following instruction, so an interrupt that became pending
+ * while the caller had them off wakes the hlt instead of being missed.
+ */
+void cpu_halt(void)
+{
+    asm volatile ("sti; hlt" : : : "memory");
+}
+
+// =============================================================================
+// Cross-CPU Scheduling
+// =============================================================================
+
+/*
+ * Send the reschedule IPI to an online CPU. The ICR is written in two
+ * halves, so interrupts stay off in case a handler on this CPU sends too.
+ */
+bool smp_send_reschedule(uint32_t cpu)
+{
+    if (cpu >= SMP_MAX_CPUS || !smp_state.cpus[cpu].online) {
+        return false;
+    }
+
+    uint32_t flags = cpu_irq_save();
+    bool sent = lapic_send_ipi(smp_state.cpus[cpu].apic_id,
+                               LAPIC_ICR_FIXED | LAPIC_ICR_ASSERT | LAPIC_RESCHEDULE_VECTOR);
+    cpu_irq_restore(flags);
+    return sent;
+}
+
+// =============================================================================
+// Diagnostics
+// =============================================================================
+
+void smp_print_status(void)
+{
+    kprintf("[SMP] %d CPU(s) online%s\n", smp_state.cpu_count,
+            smp_state.enabled ? "" : " (no local APIC)");
+
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        smp_cpu_t* entry = &smp_state.cpus[cpu];
+        if (!entry->online) continue;
+        kprintf("      CPU %d: APIC ID %d\n", cpu, entry->apic_id);
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * =============================================================================
+ * CLKernel - Synchronization Primitives
+ * =============================================================================
+ * File: spinlock.c
+ * Purpose: Lock setup and the contention statistics registry
+ *
+ * The locks themselves are inline in spinlock.h. This file only names
+ * them and, in CONFIG_LOCK_STATS builds, keeps the list of registered
+ * locks so their contention can be printed together.
+ * =============================================================================
+ */
+
+#include "spinlock.h"
+#include "kernel.h"
+
+// =============================================================================
+// Global Lock Statistics State
+// =============================================================================
+
+// Registered locks, newest first (pushed with CAS, never removed)
+static lock_stats_t* volatile lock_stats_list = NULL;
+
+// =============================================================================
+// Setup
+// =============================================================================
+
+/*
+ * Initialize a lock; a non-NULL name also registers it for
+ * lock_print_statistics (do that once per lock, not on every reuse)
+ */
+void spinlock_init(spinlock_t* lock, const char* name)
+{
+    lock->tickets.word = 0;
+#ifdef CONFIG_LOCK_STATS
+    lock->stats = (lock_stats_t){0};
+    lock_stats_register(&lock->stats, name);
+#else
+    (void)name;
+#endif
+}
+
+void rwlock_init(rwlock_t* lock, const char* name)
+{
+    lock->state = 0;
+#ifdef CONFIG_LOCK_STATS
+    lock->stats = (lock_stats_t){0};
+    lock_stats_register(&lock->stats, name);
+#else
+    (void)name;
+#endif
+}
+
+void seqlock_init(seqlock_t* lock, const char* name)
+{
+    lock->sequence = 0;
+    spinlock_init(&lock->lock, name);
+}
+
+// =============================================================================
+// Contention Statistics
+// =============================================================================
+
+void lock_stats_register(lock_stats_t* stats, const char* name)
+{
+    if (!stats || !name) {
+        return;
+    }
+
+    stats->name = name;
+
+    lock_stats_t* head;
+    do {
+        head = lock_stats_list;
+        stats->next = head;
+    } while (!__sync_bool_compare_and_swap(&lock_stats_list, head, stats));
+}
+
+void lock_print_statistics(void)
+{
+#ifdef CONFIG_LOCK_STATS
+    kprintf("[LOCK] Contention statistics:\n");
+
+    if (!lock_stats_list) {
+        kprintf("      No registered locks\n");
+        return;
+    }
+
+    for (lock_stats_t* stats = lock_stats_list; stats; stats = stats->next) {
+        uint32_t average = 0;
+        if (stats->contended) {
+            // Stay within 32-bit division; averages above 4G cycles saturate
+            uint64_t cycles = stats->spin_cycles;
+            uint32_t scaled = cycles > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)cycles;
+            average = scaled / stats->contended;
+        }
+
+        kprintf("      %s: %d acquisitions, %d contended, avg wait %d cycles, max %d\n",
+                stats->name, stats->acquisitions, stats->contended,
+                average, stats->max_spin_cycles);
+    }
+#else
+    kprintf("[LOCK] Contention statistics not built in (make LOCKSTAT=1)\n");
+#endif
+}
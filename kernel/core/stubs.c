@@ -72,7 +72,7 @@ void scheduler_process_pending(void)
     // TODO: Process pending actor messages and scheduling
 }
 
-uint32_t actor_create(void* entry_point, void* user_data, uint8_t priority, size_t stack_size)
+uint32_t actor_create(actor_entry_t entry_point, void* user_data, uint8_t priority, size_t stack_size)
 {
     (void)entry_point;
     (void)user_data;
@@ -109,11 +109,28 @@ bool load_module(const char* name)
     return true;
 }
 
+// Export drain registered by the logger module (cleared when it unloads)
+static uint32_t (*module_export_poll)(void) = NULL;
+
+void modules_set_export_poll(uint32_t (*poll)(void))
+{
+    module_export_poll = poll;
+}
+
 void modules_periodic_check(void)
 {
     // TODO: Check module health and hot-swap requests
 }
 
+void modules_poll_exports(void)
+{
+    // Drain committed log segments to the export sink outside logger_log
+    uint32_t (*poll)(void) = module_export_poll;
+    if (poll) {
+        poll();
+    }
+}
+
 // =============================================================================
 // AI Supervisor System Stubs
 // =============================================================================
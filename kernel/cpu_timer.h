@@ -0,0 +1,82 @@
+/*
+ * =============================================================================
+ * CLKernel - Per-CPU Scheduler Timer Header
+ * =============================================================================
+ * File: cpu_timer.h
+ * Purpose: Drive scheduler ticks and timeslice ends from each CPU's local
+ *          APIC timer, armed one-shot to the next event
+ *
+ * The local APIC timer is calibrated once against PIT channel 2 (and the
+ * TSC alongside it). Every CPU then keeps two TSC deadlines, the next
+ * scheduler tick and the end of the running actor's slice, and programs
+ * its timer for whichever comes first: as an absolute TSC value when the
+ * CPU has TSC-deadline mode, else as a one-shot count. Nothing fires on a
+ * fixed period, so slices can be shorter than a tick, and an AP with
+ * nothing to run takes no timer interrupts at all. The BSP keeps ticking
+ * while idle because its ticks are the global kernel_scheduler.tick_count.
+ * =============================================================================
+ */
+
+#ifndef CPU_TIMER_H
+#define CPU_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "smp.h"
+
+// =============================================================================
+// Timer Configuration Constants
+// =============================================================================
+
+#define CPU_TIMER_CALIBRATE_MS      10          // PIT window for calibration
+#define CPU_TIMER_MAX_CATCHUP       16          // Ticks replayed after a long stall
+
+// =============================================================================
+// Timer Data Structures
+// =============================================================================
+
+/*
+ * One CPU's timer events; only that CPU touches it, with interrupts off
+ */
+typedef struct cpu_timer_cpu {
+    bool            active;             // Local timer drives this CPU
+    bool            ticking;            // Scheduler ticks are being delivered
+    uint64_t        next_tick;          // TSC of the next scheduler tick
+    uint64_t        slice_end;          // TSC at which the running slice ends (0 = none)
+    uint64_t        armed;              // Deadline programmed into the timer (0 = none)
+
+    uint64_t        ticks;              // Scheduler ticks delivered
+    uint64_t        slice_expiries;     // Slices ended by the timer
+    uint64_t        reprograms;         // Timer writes (skipped when unchanged)
+} __attribute__((aligned(64))) cpu_timer_cpu_t;
+
+typedef struct cpu_timer_state {
+    bool            calibrated;         // Rates below are valid
+    bool            tsc_deadline;       // Armed with IA32_TSC_DEADLINE
+    uint32_t        tsc_per_ms;         // TSC rate (kHz)
+    uint32_t        lapic_per_ms;       // Local APIC timer rate after divide (kHz)
+    uint32_t        lapic_per_cycle;    // Timer counts per TSC cycle, 0.32 fixed point
+    uint32_t        tick_cycles;        // TSC cycles per scheduler tick
+    uint32_t        slice_cycles;       // TSC cycles per timeslice
+    cpu_timer_cpu_t cpus[SMP_MAX_CPUS];
+} cpu_timer_state_t;
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Setup: BSP calibrates and starts its own timer; each AP starts its own
+bool cpu_timer_init(void);
+void cpu_timer_start_cpu(void);
+
+// Scheduler hook: a new actor started running on this CPU
+void cpu_timer_slice_begin(void);
+
+// TSC cycles per millisecond, or 0 before calibration
+uint32_t cpu_timer_tsc_per_ms(void);
+
+// Diagnostics
+void cpu_timer_print_status(void);
+
+#endif // CPU_TIMER_H
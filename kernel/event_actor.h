@@ -0,0 +1,118 @@
+/*
+ * =============================================================================
+ * CLKernel - Stackless Event Actors
+ * =============================================================================
+ * File: event_actor.h
+ * Purpose: Actors defined by a message handler that runs to completion on
+ *          the scheduler's stack, for designs with one actor per connection
+ *          or per request
+ *
+ * A thread-style actor (actor_create) costs an actor_t, a kmalloc'd stack
+ * and one of MAX_ACTORS slots. An event actor is a compact descriptor in
+ * a paged handle table: it has no stack and no run queue entry of its
+ * own, and there can be EVENT_ACTOR_MAX of them. Messages reach it
+ * through message_send_async like any other actor; when its mailbox goes
+ * from empty to non-empty it is put on its CPU's event list, and that
+ * CPU calls its handler once per message, between thread actors and
+ * before it halts.
+ *
+ * Handlers must not block (no message_wait, no scheduler_yield): they
+ * return, and the next message is another call. The message is freed
+ * when the handler returns. Messages a handler sends carry its actor ID
+ * as sender_id, so replies come back to it.
+ * =============================================================================
+ */
+
+#ifndef EVENT_ACTOR_H
+#define EVENT_ACTOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "scheduler.h"
+#include "handle_table.h"
+#include "spinlock.h"
+
+// =============================================================================
+// Event Actor Configuration Constants
+// =============================================================================
+
+#define EVENT_ACTOR_ID_TAG      HANDLE_TAG_MASK // Set in every event actor ID
+#define EVENT_ACTOR_MAX         (1u << 18)      // Table limit (262144 actors)
+#define EVENT_ACTOR_QUEUE_LIMIT 64              // Default mailbox limit
+#define EVENT_ACTOR_BATCH       16              // Messages per turn before others run
+
+// event_actor_t.flags (under mailbox_lock)
+#define EVENT_ACTOR_QUEUED      0x01            // On an event list or being run
+#define EVENT_ACTOR_DEAD        0x02            // Destroyed; released when its run ends
+
+// =============================================================================
+// Event Actor Data Structures
+// =============================================================================
+
+/*
+ * Called once per message, with the state pointer given at spawn
+ */
+typedef void (*event_handler_t)(message_t* message, void* state);
+
+/*
+ * Event actor descriptor (40 bytes on i686, plus an 8-byte slot header)
+ */
+typedef struct event_actor {
+    uint32_t        actor_id;           // Handle, EVENT_ACTOR_ID_TAG set
+    event_handler_t handler;            // Runs each message to completion
+    void*           state;              // Handler's private state
+    message_t*      message_queue;      // Mailbox head
+    message_t*      message_tail;       // Mailbox tail (O(1) append)
+    struct event_actor* run_next;       // Next on a CPU's event list
+    uint16_t        queue_size;         // Messages waiting
+    uint16_t        max_queue_size;     // Sends beyond this are refused
+    uint8_t         cpu;                // CPU its handler runs on
+    uint8_t         flags;              // EVENT_ACTOR_*
+    uint16_t        reserved;
+    spinlock_t      mailbox_lock;       // Guards mailbox and flags
+    uint32_t        messages_handled;   // Handler calls
+} event_actor_t;
+
+typedef struct event_actor_stats {
+    uint64_t        spawned;            // Event actors created
+    uint64_t        destroyed;          // Event actors released
+    uint64_t        refused;            // Messages refused (full or dead mailbox)
+} event_actor_stats_t;
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Setup (called by scheduler_init)
+void event_actor_init(void);
+
+// Lifecycle: spawn on the calling CPU; destroy is safe from its own handler
+uint32_t event_actor_spawn(event_handler_t handler, void* state);
+bool event_actor_destroy(uint32_t actor_id);
+event_actor_t* event_actor_get(uint32_t actor_id);
+
+// Message delivery (message_send_async routes event actor IDs here)
+bool event_actor_deliver(event_actor_t* actor, message_t* message);
+
+// Run handlers for this CPU's event list; returns messages handled
+uint32_t event_actor_run_pending(void);
+
+// Event actor running on this CPU (0 outside handlers)
+uint32_t event_actor_current(void);
+
+// Diagnostics
+event_actor_stats_t* event_actor_get_statistics(void);
+uint32_t event_actor_count(void);
+void event_actor_print_status(void);
+
+// =============================================================================
+// Inline Helper Functions
+// =============================================================================
+
+static inline bool event_actor_is_id(uint32_t actor_id)
+{
+    return (actor_id & EVENT_ACTOR_ID_TAG) != 0;
+}
+
+#endif // EVENT_ACTOR_H
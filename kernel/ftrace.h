@@ -0,0 +1,112 @@
+/*
+ * =============================================================================
+ * CLKernel - Function Entry/Exit Tracer Header
+ * =============================================================================
+ * File: ftrace.h
+ * Purpose: Compile-time function tracing for scheduler, heap, module and IPC
+ *
+ * Built only with `make TRACE=1`: the listed subsystems are compiled with
+ * -finstrument-functions and CONFIG_FTRACE is defined. Every instrumented
+ * entry and exit then lands in a per-CPU binary ring as long as the
+ * subsystem's bit is set in the runtime mask. Normal builds contain no
+ * instrumentation at all.
+ *
+ * An instrumented file names its subsystem before including this header:
+ *
+ *     #define FTRACE_SUBSYSTEM sched
+ *     #include "ftrace.h"
+ *
+ * which routes that file's compiler-generated hooks to ftrace_enter_sched /
+ * ftrace_exit_sched, so the subsystem is known without any lookup.
+ * =============================================================================
+ */
+
+#ifndef FTRACE_H
+#define FTRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// Tracer Configuration Constants
+// =============================================================================
+
+#define FTRACE_MAX_CPUS             1       // Rings, one per CPU (higher CPUs record nothing)
+#define FTRACE_RING_SIZE            2048    // Records per CPU ring (power of two)
+
+// Subsystems (bit N of the runtime mask enables subsystem N)
+#define FTRACE_SUBSYS_SCHED         0       // scheduler.c (except IPC)
+#define FTRACE_SUBSYS_HEAP          1       // heap.c
+#define FTRACE_SUBSYS_MODULE        2       // modules.c
+#define FTRACE_SUBSYS_IPC           3       // Message passing in scheduler.c
+#define FTRACE_SUBSYS_COUNT         4
+
+#define FTRACE_MASK(subsystem)      (1u << (subsystem))
+#define FTRACE_MASK_ALL             ((1u << FTRACE_SUBSYS_COUNT) - 1)
+
+// Record events
+#define FTRACE_EVENT_ENTER          0
+#define FTRACE_EVENT_EXIT           1
+
+// =============================================================================
+// Tracer Data Structures
+// =============================================================================
+
+// Binary record as written to the ring and the serial dump (24 bytes)
+typedef struct ftrace_record {
+    uint64_t        timestamp;          // TSC
+    uint32_t        function;           // Address of the traced function
+    uint32_t        call_site;          // Return address in the caller
+    uint32_t        actor_id;           // Running actor (0 = kernel)
+    uint8_t         event;              // FTRACE_EVENT_*
+    uint8_t         subsystem;          // FTRACE_SUBSYS_*
+    uint16_t        cpu;                // CPU that recorded the event
+} ftrace_record_t;
+
+typedef struct ftrace_cpu {
+    ftrace_record_t ring[FTRACE_RING_SIZE];
+    uint32_t        head;               // Records ever written (next slot)
+    uint32_t        tail;               // First record not yet dumped
+    uint64_t        records_lost;       // Overwritten before being dumped
+} ftrace_cpu_t;
+
+typedef struct ftrace_state {
+    bool            initialized;
+    volatile uint32_t mask;             // Enabled subsystems (FTRACE_MASK)
+    uint64_t        events[FTRACE_SUBSYS_COUNT]; // Records per subsystem
+    ftrace_cpu_t    cpus[FTRACE_MAX_CPUS];
+} ftrace_state_t;
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Tracer control (return -1 when the kernel was built without TRACE=1)
+void ftrace_init(void);
+int ftrace_set_mask(uint32_t mask);
+uint32_t ftrace_get_mask(void);
+void ftrace_reset(void);
+
+// Output
+int ftrace_dump_serial(void);
+void ftrace_print_stats(void);
+
+// Per-subsystem instrumentation hooks (called by compiler-generated code)
+void ftrace_enter_sched(void* function, void* call_site);
+void ftrace_exit_sched(void* function, void* call_site);
+void ftrace_enter_heap(void* function, void* call_site);
+void ftrace_exit_heap(void* function, void* call_site);
+void ftrace_enter_module(void* function, void* call_site);
+void ftrace_exit_module(void* function, void* call_site);
+
+// Route this file's -finstrument-functions hooks to its subsystem
+#if defined(CONFIG_FTRACE) && defined(FTRACE_SUBSYSTEM)
+#define FTRACE_HOOK_NAME(event, subsystem)  FTRACE_HOOK_NAME_(event, subsystem)
+#define FTRACE_HOOK_NAME_(event, subsystem) "ftrace_" #event "_" #subsystem
+void __cyg_profile_func_enter(void* function, void* call_site)
+    __asm__(FTRACE_HOOK_NAME(enter, FTRACE_SUBSYSTEM));
+void __cyg_profile_func_exit(void* function, void* call_site)
+    __asm__(FTRACE_HOOK_NAME(exit, FTRACE_SUBSYSTEM));
+#endif
+
+#endif // FTRACE_H
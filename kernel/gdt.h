@@ -12,6 +12,14 @@
 
 #include <stdint.h>
 
+#include "smp.h"
+
+// Descriptors: null, kernel code/data, user code/data, then one per-CPU
+// data segment per CPU (loaded into GS, see percpu.h)
+#define GDT_PERCPU_FIRST        5
+#define GDT_ENTRIES             (GDT_PERCPU_FIRST + SMP_MAX_CPUS)
+#define GDT_PERCPU_SELECTOR(cpu) ((GDT_PERCPU_FIRST + (cpu)) * 8)
+
 // GDT entry structure
 typedef struct {
     uint16_t limit_low;      // Lower 16 bits of limit
@@ -32,5 +40,6 @@ typedef struct {
 void gdt_init(void);
 void gdt_set_gate(int32_t num, uint32_t base, uint32_t limit, uint8_t access, uint8_t gran);
 void gdt_flush(uint32_t gdt_ptr_addr);
+void gdt_load(void);
 
 #endif // GDT_H
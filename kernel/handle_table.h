@@ -0,0 +1,162 @@
+/*
+ * =============================================================================
+ * CLKernel - Generation-Tagged Handle Tables
+ * =============================================================================
+ * File: handle_table.h
+ * Purpose: Fixed-size objects named by 32-bit handles, stored in pages that
+ *          are added as the table fills
+ *
+ * A handle is (tag, generation, index). The index picks the slot, and the
+ * generation is bumped every time the slot is freed, so a handle that
+ * outlived its object no longer matches and a lookup is one indexed load
+ * and a compare. The tag bit is left to the owner to tell several tables'
+ * handles apart. A slot's first handle has generation 0, so in an
+ * untagged table it equals the slot index (slot 0's is 0); generation 0
+ * is skipped when the counter wraps, so those are never issued twice.
+ *
+ * Pages hold HANDLE_PAGE_SIZE slot headers followed by as many objects.
+ * They are never freed or moved, so a lookup needs no lock and a pointer
+ * obtained just before the object is freed still points at valid memory.
+ * Pages start zeroed. Free slots form a stack threaded through their
+ * headers; the most recently freed (cache-warm) slot is reused first.
+ * =============================================================================
+ */
+
+#ifndef HANDLE_TABLE_H
+#define HANDLE_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "spinlock.h"
+
+// =============================================================================
+// Handle Layout
+// =============================================================================
+
+#define HANDLE_INDEX_BITS       20
+#define HANDLE_INDEX_MASK       ((1u << HANDLE_INDEX_BITS) - 1)
+#define HANDLE_GENERATION_BITS  11
+#define HANDLE_GENERATION_MASK  ((1u << HANDLE_GENERATION_BITS) - 1)
+#define HANDLE_TAG_MASK         0x80000000  // Owner-defined, constant per table
+
+#define HANDLE_PAGE_SHIFT       8
+#define HANDLE_PAGE_SIZE        (1u << HANDLE_PAGE_SHIFT) // Objects per page
+
+// Bytes of one page (slot headers, then objects) for objects of a given size
+#define HANDLE_PAGE_BYTES(object_size) \
+    (HANDLE_PAGE_SIZE * (sizeof(handle_slot_t) + (object_size)))
+
+// handle_slot_t.next_free values other than a free-stack link
+#define HANDLE_SLOT_END         0xFFFFFFFF  // Bottom of the free stack
+#define HANDLE_SLOT_RESERVED    0xFFFFFFFE  // Allocated, not yet published
+#define HANDLE_SLOT_LIVE        0xFFFFFFFD  // Allocated and published
+
+// =============================================================================
+// Handle Table Data Structures
+// =============================================================================
+
+/*
+ * Per-slot header. handle is the handle the slot's current object has, or
+ * the one its next object will get while it is free, so a stale handle
+ * (older generation) never matches it.
+ */
+typedef struct handle_slot {
+    volatile uint32_t handle;           // Current (or next) handle of this slot
+    volatile uint32_t next_free;        // Free-stack link or HANDLE_SLOT_*
+} handle_slot_t;
+
+typedef struct handle_table {
+    const char*     name;               // For diagnostics
+    uint32_t        tag;                // OR-ed into every handle (0 or HANDLE_TAG_MASK)
+    uint32_t        object_size;        // Bytes per object
+    uint32_t        max_pages;          // Length of the page directory
+    handle_slot_t** pages;              // Page directory (caller-provided, never moves)
+    volatile uint32_t capacity;         // Slots in pages added so far
+    uint32_t        free_head;          // Top of the free stack (HANDLE_SLOT_END = empty)
+    uint32_t        live;               // Objects allocated
+    uint32_t        allocated_pages;    // Pages taken from the heap
+    spinlock_t      lock;               // Guards the free stack and growth
+} handle_table_t;
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+/*
+ * Set up an empty table. pages has room for max_pages entries; first_page,
+ * if given, is HANDLE_PAGE_BYTES(object_size) of static storage used as
+ * page 0 so the first HANDLE_PAGE_SIZE objects need no heap.
+ */
+void handle_table_init(handle_table_t* table, const char* name, uint32_t tag,
+                       uint32_t object_size, handle_slot_t** pages, uint32_t max_pages,
+                       void* first_page);
+
+/*
+ * Take a free slot, adding a page if none is left. The object is not
+ * found by lookups until handle_table_publish. NULL when the table is
+ * at max_pages or the heap is exhausted.
+ */
+void* handle_table_alloc(handle_table_t* table, uint32_t* handle);
+
+/*
+ * Make an allocated object visible to lookups
+ */
+void handle_table_publish(handle_table_t* table, uint32_t handle);
+
+/*
+ * Retire a handle and return its slot to the free stack
+ */
+bool handle_table_free(handle_table_t* table, uint32_t handle);
+
+/*
+ * Live object at or after *index, advancing *index past it (NULL at the end)
+ */
+void* handle_table_next(handle_table_t* table, uint32_t* index);
+
+// =============================================================================
+// Inline Helper Functions
+// =============================================================================
+
+static inline uint32_t handle_index(uint32_t handle)
+{
+    return handle & HANDLE_INDEX_MASK;
+}
+
+static inline uint32_t handle_generation(uint32_t handle)
+{
+    return (handle >> HANDLE_INDEX_BITS) & HANDLE_GENERATION_MASK;
+}
+
+static inline handle_slot_t* handle_table_slot(handle_table_t* table, uint32_t index)
+{
+    return &table->pages[index >> HANDLE_PAGE_SHIFT][index & (HANDLE_PAGE_SIZE - 1)];
+}
+
+static inline void* handle_table_object(handle_table_t* table, uint32_t index)
+{
+    uint8_t* objects = (uint8_t*)(table->pages[index >> HANDLE_PAGE_SHIFT] + HANDLE_PAGE_SIZE);
+    return objects + (index & (HANDLE_PAGE_SIZE - 1)) * table->object_size;
+}
+
+/*
+ * Object a handle names, or NULL if it was freed (or never issued): O(1)
+ * and lock-free
+ */
+static inline void* handle_table_lookup(handle_table_t* table, uint32_t handle)
+{
+    uint32_t index = handle & HANDLE_INDEX_MASK;
+    if ((handle & HANDLE_TAG_MASK) != table->tag || index >= table->capacity) {
+        return NULL;
+    }
+    asm volatile ("" : : : "memory"); // Directory entry written before capacity grew
+
+    handle_slot_t* slot = handle_table_slot(table, index);
+    if (slot->handle != handle || slot->next_free != HANDLE_SLOT_LIVE) {
+        return NULL;
+    }
+    return handle_table_object(table, index);
+}
+
+#endif // HANDLE_TABLE_H
@@ -20,6 +20,8 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "spinlock.h"
+
 // =============================================================================
 // Heap Configuration
 // =============================================================================
@@ -111,6 +113,7 @@ typedef struct {
     heap_block_t* free_list;            // Free block list
     slab_allocator_t slab_allocator;    // Slab allocator
     heap_stats_t statistics;            // Heap statistics
+    spinlock_t lock;                    // Guards the bump pointer and slabs
     bool corruption_check_enabled;      // Enable corruption checking
     bool leak_detection_enabled;        // Enable leak detection
     bool ai_monitoring_enabled;         // Enable AI monitoring
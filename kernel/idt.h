@@ -82,22 +82,25 @@ typedef struct {
     uint32_t base;              // Address of IDT
 } __attribute__((packed)) idt_ptr_t;
 
-// Interrupt frame passed to handlers
+// Interrupt frame passed to handlers, in stack order (lowest address first)
+// as built by isr_common_stub / irq_common_stub in interrupt.asm
 typedef struct {
+    // Segment registers (pushed last by our ISR)
+    uint32_t gs, fs, es, ds;
+    
+    // General purpose registers (pusha)
+    uint32_t edi, esi, ebp, esp_temp, ebx, edx, ecx, eax;
+    
+    // Our additions for context
+    uint32_t interrupt_number;  // Which interrupt occurred
+    uint32_t error_code;        // Error code (if applicable)
+    
     // Pushed by processor
     uint32_t eip;               // Instruction pointer
     uint32_t cs;                // Code segment
     uint32_t eflags;            // CPU flags
     uint32_t esp;               // Stack pointer (if privilege change)
     uint32_t ss;                // Stack segment (if privilege change)
-    
-    // Our additions for context
-    uint32_t interrupt_number;  // Which interrupt occurred
-    uint32_t error_code;        // Error code (if applicable)
-    
-    // General purpose registers (pushed by our ISR)
-    uint32_t edi, esi, ebp, esp_temp, ebx, edx, ecx, eax;
-    uint32_t ds, es, fs, gs;    // Segment registers
 } __attribute__((packed)) interrupt_frame_t;
 
 // =============================================================================
@@ -238,6 +241,9 @@ extern void irq12(void);  // PS/2 Mouse
 extern void irq13(void);  // FPU
 extern void irq14(void);  // Primary ATA
 extern void irq15(void);  // Secondary ATA
+extern void irq_lapic_timer(void);  // Local APIC timer (LAPIC_TIMER_VECTOR)
+extern void irq_lapic_reschedule(void); // Reschedule IPI (LAPIC_RESCHEDULE_VECTOR)
+extern void irq_spurious(void);     // Local APIC spurious (LAPIC_SPURIOUS_VECTOR)
 
 // Global IDT state
 extern idt_entry_t idt_table[IDT_MAX_DESCRIPTORS];
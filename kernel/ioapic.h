@@ -0,0 +1,90 @@
+/*
+ * =============================================================================
+ * CLKernel - I/O APIC and IRQ Routing Header
+ * =============================================================================
+ * File: ioapic.h
+ * Purpose: I/O APIC driver and the IRQ routing front end used by drivers
+ *
+ * ISA IRQ n is always delivered on vector IRQ_BASE + n, whichever
+ * controller is in charge, so idt.c dispatches the same way in both
+ * modes. With I/O APICs found (ACPI MADT or MP table) the 8259s are
+ * masked, each IRQ is steered to one CPU's local APIC and EOI is a single
+ * MMIO write; without them the PIC path is kept unchanged.
+ * =============================================================================
+ */
+
+#ifndef IOAPIC_H
+#define IOAPIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "acpi.h"
+
+// =============================================================================
+// I/O APIC Constants
+// =============================================================================
+
+// MMIO window: select a register, then read/write it through IOWIN
+#define IOAPIC_REGSEL               0x00
+#define IOAPIC_IOWIN                0x10
+
+// Registers
+#define IOAPIC_REG_ID               0x00
+#define IOAPIC_REG_VERSION          0x01    // Bits 16-23: highest redirection entry
+#define IOAPIC_REG_REDIRECTION      0x10    // Entry n: 0x10 + 2n (low), +1 (high)
+
+// Redirection entry (low dword)
+#define IOAPIC_DELIVERY_FIXED       0x00000
+#define IOAPIC_POLARITY_LOW         0x02000
+#define IOAPIC_TRIGGER_LEVEL        0x08000
+#define IOAPIC_MASKED               0x10000
+
+// IRQ routing modes
+#define IRQ_MODE_PIC                0       // Legacy 8259 pair
+#define IRQ_MODE_IOAPIC             1       // I/O APIC + local APIC EOI
+
+// =============================================================================
+// IRQ Routing Data Structures
+// =============================================================================
+
+typedef struct ioapic {
+    volatile uint32_t* registers;       // Mapped MMIO window
+    uint8_t         id;
+    uint32_t        gsi_base;           // First GSI on this I/O APIC
+    uint32_t        pin_count;          // Redirection entries
+} ioapic_t;
+
+typedef struct irq_route {
+    bool            enabled;            // Unmasked at the controller
+    uint32_t        cpu;                // Target CPU index (IOAPIC mode)
+} irq_route_t;
+
+typedef struct irq_routing_state {
+    uint8_t         mode;               // IRQ_MODE_*
+    apic_platform_t platform;           // What the firmware reported
+    ioapic_t        ioapics[APIC_PLATFORM_MAX_IOAPICS];
+    uint32_t        ioapic_count;
+    irq_route_t     routes[APIC_PLATFORM_ISA_IRQS];
+} irq_routing_state_t;
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Setup (BSP, after smp_init has mapped the local APIC)
+void irq_routing_init(void);
+uint8_t irq_routing_mode(void);
+const apic_platform_t* irq_routing_platform(void);
+
+// Per-IRQ control; work in either mode (affinity only with I/O APICs)
+void irq_eoi(uint8_t irq);
+void irq_mask(uint8_t irq);
+void irq_unmask(uint8_t irq);
+bool irq_set_affinity(uint8_t irq, uint32_t cpu);
+uint32_t irq_get_affinity(uint8_t irq);
+
+// Diagnostics
+void irq_print_routing(void);
+
+#endif // IOAPIC_H
@@ -20,7 +20,7 @@
 
 #define KERNEL_STACK_SIZE       0x4000      // 16KB kernel stack
 #define MAX_MODULES             64          // Maximum loadable modules
-#define MAX_ACTORS              256         // Maximum async actors
+#define MAX_ACTORS              4096        // Maximum async actors
 #define PAGE_SIZE               0x1000      // 4KB pages
 #define KERNEL_HEAP_SIZE        0x100000    // 1MB initial heap
 
@@ -77,8 +77,12 @@ typedef struct {
 // Async Actor System Definitions (Forward Declaration)
 // =============================================================================
 
-// Forward declarations - actual definitions in scheduler.h
+// Forward declarations - actual definitions in scheduler.h (which
+// declares actor_t the same way, so either header may come first)
+#ifndef ACTOR_T_DECLARED
+#define ACTOR_T_DECLARED
 typedef struct actor_context actor_t;
+#endif
 
 // =============================================================================
 // Memory Management Definitions
@@ -131,6 +135,9 @@ void pic_send_eoi(uint8_t irq);
 uint8_t inb(uint16_t port);
 void outb(uint16_t port, uint8_t data);
 
+// CPU timestamp counter (interrupt.asm)
+uint64_t read_timestamp_counter(void);
+
 // Memory management
 void memory_init(void);
 void* kmalloc(size_t size);
@@ -146,6 +153,8 @@ bool actor_send_message(uint32_t actor_id, void* message, size_t size);
 void modules_init(void);
 bool load_module(const char* name);
 void modules_periodic_check(void);
+void modules_set_export_poll(uint32_t (*poll)(void)); // NULL on unload
+void modules_poll_exports(void);    // Every main loop pass
 
 // AI supervisor
 void ai_supervisor_init(void);
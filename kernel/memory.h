@@ -36,6 +36,8 @@
 #define MODULE_AREA_START       0x400000    // 4MB
 #define MODULE_AREA_END         0x800000    // 8MB
 #define USER_SPACE_START        0x800000    // 8MB+
+#define LOG_SPILL_AREA_START    0xF00000    // 15MB: logger spill region, kept
+#define LOG_SPILL_AREA_END      0xF80000    // across warm reboot (never allocated)
 
 // Memory limits
 #define MAX_MEMORY_REGIONS      64          // Maximum BIOS memory map entries
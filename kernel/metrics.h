@@ -0,0 +1,153 @@
+/*
+ * =============================================================================
+ * CLKernel - Metrics Registry Header
+ * =============================================================================
+ * File: metrics.h
+ * Purpose: One registry for subsystem counters, gauges and histograms with a
+ *          compact binary snapshot for serial or shared-page export
+ *
+ * Subsystems keep updating their own statistics structures exactly as
+ * before; they register the fields once at init and the registry only
+ * reads them when a snapshot is taken, so the hot paths pay nothing:
+ *
+ *     METRICS_COUNTER("sched.context_switches", stats->context_switches);
+ *     METRICS_GAUGE("sched.ready_actors", stats->ready_actors);
+ *
+ * The field width is taken from sizeof(field). Names are not copied and
+ * must outlive the registration (string literals). Counters kept in the
+ * per-CPU areas are registered by field and summed over CPUs on read:
+ *
+ *     METRICS_PERCPU_COUNTER("sched.messages_sent", sched_messages_sent);
+ *
+ * Snapshot layout (little-endian, packed):
+ *   metrics_snapshot_header_t
+ *   per registered metric: metrics_record_t, and for histograms also
+ *     uint64_t sum, uint32_t max and bucket_count metrics_bucket_t
+ * Names and types are exported once as a schema; the header's schema
+ * generation changes whenever a metric is added or removed.
+ * =============================================================================
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "percpu.h"
+
+// =============================================================================
+// Registry Configuration Constants
+// =============================================================================
+
+#define METRICS_MAX                 128     // Registry slots (metric IDs)
+#define METRICS_PAGE_SIZE           4096    // Shared export page
+#define METRICS_BUFFER_SIZE         8192    // Serial export buffer
+
+#define METRICS_MAGIC               0x4D4B4C43  // "CLKM"
+#define METRICS_VERSION             1
+
+// Metric types
+#define METRIC_TYPE_COUNTER         0       // Monotonic count
+#define METRIC_TYPE_GAUGE           1       // Current level
+#define METRIC_TYPE_HISTOGRAM       2       // sched_histogram_t (log-linear buckets)
+
+// Snapshot header flags
+#define METRICS_FLAG_TRUNCATED      0x01    // Buffer too small for every metric
+
+// =============================================================================
+// Snapshot Format
+// =============================================================================
+
+typedef struct metrics_snapshot_header {
+    uint32_t        magic;              // METRICS_MAGIC
+    uint16_t        version;            // METRICS_VERSION
+    uint16_t        count;              // Records that follow
+    uint32_t        sequence;           // Snapshot number
+    uint32_t        schema;             // Registry generation (names/IDs)
+    uint32_t        length;             // Bytes including this header
+    uint32_t        flags;              // METRICS_FLAG_*
+    uint64_t        timestamp;          // TSC when the snapshot was taken
+} __attribute__((packed)) metrics_snapshot_header_t;
+
+typedef struct metrics_record {
+    uint16_t        id;                 // Registry slot
+    uint8_t         type;               // METRIC_TYPE_*
+    uint8_t         bucket_count;       // Histograms: non-empty buckets that follow
+    uint64_t        value;              // Counter/gauge value, histogram count
+} __attribute__((packed)) metrics_record_t;
+
+typedef struct metrics_bucket {
+    uint16_t        index;              // Bucket index
+    uint32_t        count;              // Values in the bucket
+} __attribute__((packed)) metrics_bucket_t;
+
+// Shared export page: a sequence lock around the latest snapshot
+typedef struct metrics_page {
+    volatile uint32_t generation;       // Odd while being rewritten
+    uint32_t        length;             // Snapshot bytes in data
+    uint8_t         data[METRICS_PAGE_SIZE - 8];
+} metrics_page_t;
+
+// =============================================================================
+// Registry Data Structures
+// =============================================================================
+
+typedef struct metric {
+    const char*     name;               // NULL = free slot
+    const volatile void* source;        // Field read at snapshot time
+    uint8_t         type;               // METRIC_TYPE_*
+    uint8_t         width;              // 4 or 8 bytes (0 for histograms)
+    bool            percpu;             // source is the field in percpu_areas[0]
+} metric_t;
+
+typedef struct metrics_registry {
+    metric_t        metrics[METRICS_MAX];
+    uint32_t        count;              // Registered metrics
+    uint32_t        schema;             // Bumped on every register/unregister
+    uint32_t        sequence;           // Snapshots taken
+    uint32_t        publish_interval;   // Ticks between page publishes (0 = off)
+    uint32_t        publish_countdown;  // Ticks until the next publish
+} metrics_registry_t;
+
+// =============================================================================
+// Registration Helpers
+// =============================================================================
+
+#define METRICS_COUNTER(name, field) \
+    metrics_register((name), METRIC_TYPE_COUNTER, sizeof(field), &(field))
+#define METRICS_GAUGE(name, field) \
+    metrics_register((name), METRIC_TYPE_GAUGE, sizeof(field), &(field))
+#define METRICS_HISTOGRAM(name, histogram) \
+    metrics_register((name), METRIC_TYPE_HISTOGRAM, 0, (histogram))
+#define METRICS_PERCPU_COUNTER(name, field) \
+    metrics_register_percpu((name), METRIC_TYPE_COUNTER, PERCPU_FIELD_SIZE(field), \
+                            offsetof(percpu_t, field))
+#define METRICS_PERCPU_GAUGE(name, field) \
+    metrics_register_percpu((name), METRIC_TYPE_GAUGE, PERCPU_FIELD_SIZE(field), \
+                            offsetof(percpu_t, field))
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Registration (usable before any init): returns the metric ID, -3 for an
+// invalid name/type/width/source or -4 when all METRICS_MAX slots are taken
+int metrics_register(const char* name, uint8_t type, uint8_t width, const volatile void* source);
+int metrics_register_percpu(const char* name, uint8_t type, uint8_t width, uint32_t offset);
+void metrics_unregister(int id);
+uint32_t metrics_unregister_prefix(const char* prefix);
+
+// Snapshots
+uint32_t metrics_snapshot(void* buffer, uint32_t size);
+void metrics_publish(void);
+metrics_page_t* metrics_get_page(void);
+void metrics_set_publish_interval(uint32_t ticks);
+void metrics_tick(void);
+
+// Output
+int metrics_dump_serial(void);
+void metrics_print(void);
+
+#endif // METRICS_H
@@ -20,6 +20,14 @@
 #include "../vga.h"
 #include "../memory.h"
 #include "../heap.h"
+#include "../profiler.h"
+#include "../ftrace.h"
+#include "../sched_trace.h"
+#include "../metrics.h"
+#include "../smp.h"
+#include "../spinlock.h"
+#include "../ioapic.h"
+#include "../cpu_timer.h"
 
 // Module metadata
 MODULE_DEFINE("mod_diag", 1, MODULE_TYPE_DEBUG, MODULE_FLAG_HOT_SWAP | MODULE_FLAG_AI_MONITOR);
@@ -285,6 +293,93 @@ int module_ioctl(uint32_t command, void* argument)
         case 9: // Memory leak analysis
             return diag_analyze_memory_leaks();
             
+        case 10: // Start sampling profiler (RTC rate in Hz, default 1024)
+            return profiler_start(PROFILER_SOURCE_RTC,
+                                  argument ? *(uint32_t*)argument : PROFILER_RTC_DEFAULT_HZ);
+            
+        case 11: // Stop sampling profiler
+            profiler_stop();
+            profiler_print_stats();
+            return 0;
+            
+        case 12: // Drain profiler samples to serial (max samples, 0 = all)
+            return (int)profiler_dump_serial(argument ? *(uint32_t*)argument : 0);
+            
+        case 13: // Set function tracer subsystem mask (TRACE=1 builds)
+            if (argument) {
+                return ftrace_set_mask(*(uint32_t*)argument);
+            }
+            break;
+            
+        case 14: // Drain function tracer records to serial
+            return ftrace_dump_serial();
+            
+        case 15: // Print scheduler latency histograms
+            sched_trace_print_histograms();
+            return 0;
+            
+        case 16: // Drain scheduler events and histograms to serial
+            return (int)sched_trace_dump_serial();
+            
+        case 17: // Enable/disable scheduler event tracing
+            if (argument) {
+                sched_trace_enable(*(bool*)argument);
+                return 0;
+            }
+            break;
+            
+        case 18: // Print every registered metric
+            metrics_print();
+            return 0;
+            
+        case 19: // Write metrics schema and snapshot to serial
+            return metrics_dump_serial();
+            
+        case 20: // Publish metrics page every N ticks (0 = off)
+            if (argument) {
+                metrics_set_publish_interval(*(uint32_t*)argument);
+                return 0;
+            }
+            break;
+            
+        case 21: // Print CPUs, per-CPU run queues and local timers
+            smp_print_status();
+            scheduler_print_status();
+            cpu_timer_print_status();
+            return 0;
+            
+        case 22: // Print lock contention statistics (LOCKSTAT=1 kernels)
+            lock_print_statistics();
+            return 0;
+            
+        case 23: // Print interrupt controller mode and IRQ routing
+            irq_print_routing();
+            return 0;
+            
+        case 24: // Route an ISA IRQ to a CPU: argument is uint32_t[2] {irq, cpu}
+            if (argument) {
+                uint32_t* request = (uint32_t*)argument;
+                if (request[0] >= APIC_PLATFORM_ISA_IRQS) {
+                    break;
+                }
+                return irq_set_affinity((uint8_t)request[0], request[1]) ? 0 : -4;
+            }
+            break;
+            
+        case 25: // Restrict an actor to CPUs: argument is uint32_t[2] {actor_id, cpu mask}
+            if (argument) {
+                uint32_t* request = (uint32_t*)argument;
+                return actor_set_affinity(request[0], request[1]) ? 0 : -4;
+            }
+            break;
+            
+        case 26: // Real-time reservation: argument is uint32_t[3] {actor_id, budget, period} in ticks
+            if (argument) {
+                uint32_t* request = (uint32_t*)argument;
+                return actor_set_realtime(request[0], request[1], request[2]) ? 0 : -4;
+            }
+            break;
+            
         default:
             return -2; // Unknown command
     }
@@ -8,7 +8,9 @@
  * This module provides:
  * - Actor activity logging with AI-enhanced pattern detection
  * - System event logging with priority levels
- * - Log rotation and management
+ * - Overwrite-oldest ring buffer with streaming export (serial / RAM spill)
+ * - Per-actor, per-module and per-category indexes for O(result) queries
+ * - Single-pass Aho-Corasick keyword matching for entry analysis
  * - Real-time log analysis for anomaly detection
  * =============================================================================
  */
@@ -17,6 +19,10 @@
 #include "../scheduler.h"
 #include "../kernel.h"
 #include "../vga.h"
+#include "../serial.h"
+#include "../paging.h"
+#include "../metrics.h"
+#include "../cpu_timer.h"
 
 // Module metadata
 MODULE_DEFINE("mod_logger", 1, MODULE_TYPE_MISC, MODULE_FLAG_HOT_SWAP | MODULE_FLAG_AI_MONITOR);
@@ -27,7 +33,41 @@ MODULE_DEFINE("mod_logger", 1, MODULE_TYPE_MISC, MODULE_FLAG_HOT_SWAP | MODULE_F
 
 #define MAX_LOG_ENTRIES         1000    // Maximum log entries to store
 #define MAX_LOG_MESSAGE_SIZE    256     // Maximum log message size
-#define LOG_ROTATION_SIZE       800     // Rotate when 80% full
+#define LOG_SEGMENT_ENTRIES     100     // Entries per committed export segment
+#define LOG_EXPORT_BATCH        32      // Older serial backlog drained per export poll
+#define LOG_ACTOR_WINDOW        50      // Entries covered by rolling actor counters
+#define LOG_INDEX_ACTORS        512     // Actor table slots (power of two)
+#define LOG_ACTOR_PROBE_LIMIT   16      // Slots probed per actor lookup
+#define LOG_ACTOR_FREE          0xFFFFFFFF  // Actor table slot never used
+#define LOG_INDEX_MODULES       MAX_MODULES // Module index buckets
+#define LOG_INDEX_CATEGORIES    8       // One chain per category bit
+#define LOG_QUERY_ANY           0xFFFFFFFF  // Wildcard for actor/module queries
+
+// Keyword matcher (Aho-Corasick automaton over a folded alphabet)
+#define LOG_AC_MAX_PATTERNS     128     // Maximum registered keywords
+#define LOG_AC_MAX_KEYWORD      32      // Maximum keyword length
+#define LOG_AC_MAX_STATES       1024    // Maximum automaton states
+#define LOG_AC_CLASSES          43      // Alphabet classes (0 = unmatched char)
+#define LOG_AC_NONE             0xFFFF  // No state / no pattern
+
+// Keyword flags
+#define LOG_KW_ANOMALY          0x01    // Match always flags an anomaly
+#define LOG_KW_ANOMALY_ON_ERROR 0x02    // Match flags an anomaly at ERROR+
+
+// Export sinks
+#define LOG_SINK_NONE           0       // No export (ring only)
+#define LOG_SINK_SERIAL         1       // Text lines to the serial port
+#define LOG_SINK_RAM            2       // Binary records to the spill region
+
+// Reserved RAM spill region (see memory.h). Lives above the module area
+// and is never cleared by the boot path, so its contents survive a warm
+// reboot. It is outside the identity map and mapped in (cached) on first
+// attach; a reloaded logger gets the same window range back.
+#define LOG_SPILL_REGION_BASE   LOG_SPILL_AREA_START
+#define LOG_SPILL_REGION_SIZE   (LOG_SPILL_AREA_END - LOG_SPILL_AREA_START) // 512KB
+#define LOG_SPILL_MAGIC         0x534C4F47  // "GOLS"
+#define LOG_SPILL_VERSION       1
+#define LOG_SPILL_WRAP_MARKER   0xFFFF      // Record length meaning "wrap to start"
 
 // Log levels
 #define LOG_LEVEL_DEBUG         0
@@ -64,18 +104,124 @@ typedef struct log_entry {
     bool        anomaly_detected;       // Whether anomaly was detected
     uint32_t    correlation_id;         // Correlated events
     
+    // Secondary index links (entry IDs, 0 = end of chain). Links are
+    // validated against the slot's entry_id, so a link to an overwritten
+    // entry simply terminates the chain.
+    uint32_t    prev_same_actor;        // Previous entry of the same actor
+    uint32_t    prev_actor_error;       // Previous ERROR+ entry of the same actor
+    uint32_t    prev_same_module;       // Previous entry in module bucket
+    uint32_t    prev_same_category;     // Previous entry with same category
+    
 } log_entry_t;
 
+/*
+ * Index query (module_ioctl command 9)
+ */
+typedef struct log_query {
+    uint32_t    actor_id;               // Actor filter (LOG_QUERY_ANY = any)
+    uint32_t    module_id;              // Module filter (LOG_QUERY_ANY = any)
+    uint8_t     category;               // Category filter (0 = any)
+    uint8_t     min_level;              // Minimum level to return
+    uint32_t    max_results;            // Capacity of results[]
+    log_entry_t* results;               // Out: matching entries, newest first
+    uint32_t    result_count;           // Out: number of entries returned
+    uint32_t    entries_visited;        // Out: chain entries examined
+} log_query_t;
+
+/*
+ * Keyword registration (module_ioctl command 11)
+ */
+typedef struct log_keyword {
+    char        keyword[LOG_AC_MAX_KEYWORD]; // Keyword (case-insensitive)
+    uint8_t     score;                  // Pattern score added on match
+    uint8_t     flags;                  // LOG_KW_* flags
+} log_keyword_t;
+
+/*
+ * Keyword matcher automaton. goto_table is a complete DFA, so a scan is
+ * one table lookup per message byte regardless of keyword count.
+ */
+typedef struct log_keyword_matcher {
+    log_keyword_t patterns[LOG_AC_MAX_PATTERNS]; // Registered keywords
+    uint32_t    pattern_count;          // Number of registered keywords
+    uint32_t    trie_states;            // States the registered keywords need
+    
+    uint8_t     char_class[256];        // Byte -> alphabet class
+    uint16_t    goto_table[LOG_AC_MAX_STATES][LOG_AC_CLASSES]; // Transitions
+    uint16_t    fail[LOG_AC_MAX_STATES];        // Failure links
+    uint16_t    output[LOG_AC_MAX_STATES];      // Pattern ending here
+    uint16_t    dict_link[LOG_AC_MAX_STATES];   // Next state with an output
+    uint32_t    state_count;            // States in use
+    bool        ready;                  // Automaton built
+} log_keyword_matcher_t;
+
+/*
+ * Per-actor index slot, keyed on the full actor ID (open addressing,
+ * linear probing). A slot whose actor has no entries left in the rolling
+ * window may be handed to another actor when its probe run is crowded.
+ */
+typedef struct log_actor_slot {
+    uint32_t    actor_id;               // Owner (LOG_ACTOR_FREE = never used)
+    uint32_t    head;                   // Newest entry ID of this actor
+    uint32_t    error_head;             // Newest ERROR+ entry ID of this actor
+    uint32_t    recent;                 // Entries within last LOG_ACTOR_WINDOW
+    uint32_t    total;                  // Entries since it took the slot
+    uint32_t    errors;                 // ERROR/CRITICAL entries since then
+} log_actor_slot_t;
+
+/*
+ * Rolling per-actor counters (module_ioctl command 10)
+ */
+typedef struct log_actor_stats {
+    uint32_t    actor_id;               // In: actor to query
+    uint32_t    recent_entries;         // Entries within last LOG_ACTOR_WINDOW
+    uint32_t    total_entries;          // Entries since it was first indexed
+    uint32_t    error_entries;          // ERROR/CRITICAL entries since then
+} log_actor_stats_t;
+
+/*
+ * Spill region header (at LOG_SPILL_REGION_BASE)
+ */
+typedef struct log_spill_header {
+    uint32_t    magic;                  // LOG_SPILL_MAGIC when formatted
+    uint32_t    version;                // Record format version
+    uint32_t    data_size;              // Bytes available for records
+    uint32_t    write_offset;           // Next record offset in data area
+    uint32_t    wrap_count;             // Times the data area wrapped
+    uint32_t    records_written;        // Records written since format
+    uint32_t    boot_count;             // Boots that attached to this region
+    uint32_t    last_entry_id;          // Entry ID of newest record
+} log_spill_header_t;
+
+/*
+ * Binary spill record (followed by 'length' message bytes, 4-byte padded)
+ */
+typedef struct log_spill_record {
+    uint32_t    entry_id;               // Log entry ID
+    uint32_t    timestamp;              // Low 32 bits of entry timestamp
+    uint8_t     level;                  // Log level
+    uint8_t     category;               // Log category
+    uint16_t    length;                 // Message length (no terminator)
+    uint32_t    actor_id;               // Associated actor
+    uint32_t    module_id;              // Associated module
+} __attribute__((packed)) log_spill_record_t;
+
 typedef struct logger_stats {
     uint32_t    total_entries;          // Total log entries created
     uint32_t    current_entries;        // Current entries in buffer
-    uint32_t    rotations;              // Number of log rotations
+    uint32_t    rotations;              // Segments committed for export
     uint32_t    entries_by_level[5];    // Entries per level
     uint32_t    entries_by_category[8]; // Entries per category
     uint32_t    anomalies_detected;     // AI-detected anomalies
     uint32_t    pattern_matches;        // Pattern matches found
     uint64_t    last_rotation;          // Last rotation timestamp
     
+    // Export statistics
+    uint32_t    entries_exported;       // Entries written to the sink
+    uint32_t    entries_dropped;        // Entries overwritten before the sink took them
+    uint32_t    export_backlog;         // Committed entries awaiting export
+    uint32_t    export_backlog_peak;    // Largest backlog observed
+    
 } logger_stats_t;
 
 typedef struct logger_module_state {
@@ -84,6 +230,19 @@ typedef struct logger_module_state {
     uint32_t    next_entry_id;          // Next entry ID
     uint32_t    write_index;            // Write pointer (circular buffer)
     
+    // Streaming export
+    uint8_t     export_sink;            // Active LOG_SINK_* sink
+    uint32_t    export_next_id;         // Oldest entry ID not yet exported
+    uint32_t    commit_limit_id;        // Entries below this ID are committed
+    uint32_t    export_poll_limit_id;   // commit_limit_id at the last serial poll
+    log_spill_header_t* spill;          // Spill region header (RAM sink)
+    
+    // Secondary indexes: newest entry ID per actor / bucket (0 = empty).
+    // Actor chains and rolling counters are maintained in O(1) per insertion.
+    log_actor_slot_t actors[LOG_INDEX_ACTORS];
+    uint32_t    module_head[LOG_INDEX_MODULES];
+    uint32_t    category_head[LOG_INDEX_CATEGORIES];
+    
     // Configuration
     uint8_t     min_log_level;          // Minimum log level to record
     uint8_t     enabled_categories;     // Enabled log categories
@@ -100,8 +259,58 @@ typedef struct logger_module_state {
 } logger_module_state_t;
 
 static logger_module_state_t logger_state;
+static log_keyword_matcher_t logger_matcher;
 static bool logger_module_active = false;
 
+// Built-in keyword set
+static const log_keyword_t logger_default_keywords[] = {
+    {"error",      20, LOG_KW_ANOMALY_ON_ERROR},
+    {"fail",       20, LOG_KW_ANOMALY_ON_ERROR},
+    {"crash",      20, LOG_KW_ANOMALY_ON_ERROR},
+    {"panic",      20, LOG_KW_ANOMALY_ON_ERROR},
+    {"corrupt",    20, LOG_KW_ANOMALY_ON_ERROR},
+    {"suspicious", 30, LOG_KW_ANOMALY},
+    {"anomaly",    30, LOG_KW_ANOMALY},
+    {"leak",       30, LOG_KW_ANOMALY},
+    {"spike",      30, LOG_KW_ANOMALY},
+};
+
+// =============================================================================
+// Forward Declarations
+// =============================================================================
+
+void logger_log(uint8_t level, uint8_t category, uint32_t actor_id,
+               uint32_t module_id, const char* message);
+void logger_rotate_logs(void);
+void logger_commit_segment(uint32_t limit_id);
+void logger_display_entry(log_entry_t* entry);
+void logger_dump_recent_logs(uint32_t count);
+void logger_ai_analyze_entry(log_entry_t* entry);
+uint32_t logger_count_recent_actor_logs(uint32_t actor_id);
+void logger_index_entry(log_entry_t* entry);
+log_actor_slot_t* logger_actor_slot(uint32_t actor_id, bool create);
+log_entry_t* logger_lookup_entry(uint32_t entry_id);
+uint32_t logger_query(log_query_t* query);
+uint32_t logger_query_categories(log_query_t* query);
+uint32_t logger_category_index(uint8_t category);
+uint8_t logger_ac_class(char c);
+void logger_matcher_clear(void);
+bool logger_matcher_add(const char* keyword, uint8_t score, uint8_t flags);
+bool logger_matcher_build(void);
+void logger_matcher_load_defaults(void);
+uint32_t logger_matcher_scan(const char* message, uint8_t level, bool* anomaly);
+void logger_benchmark_keywords(uint32_t keyword_count);
+void logger_benchmark_run(uint32_t keyword_count);
+uint32_t logger_export_poll(void);
+uint32_t logger_export_committed(uint32_t max_entries);
+void logger_export_entry(log_entry_t* entry);
+void logger_export_serial(log_entry_t* entry);
+void logger_export_ram(log_entry_t* entry);
+void logger_spill_attach(void);
+bool logger_set_export_sink(uint8_t sink);
+const char* logger_sink_name(uint8_t sink);
+void logger_format_u32(uint32_t value, char* buffer);
+
 // =============================================================================
 // Module Interface Functions
 // =============================================================================
@@ -118,6 +327,13 @@ int module_init(void)
     logger_state.next_entry_id = 1;
     logger_state.write_index = 0;
     
+    // Export starts with nothing committed
+    logger_state.export_next_id = 1;
+    logger_state.commit_limit_id = 1;
+    logger_state.export_poll_limit_id = 1;
+    logger_state.spill = NULL;
+    logger_state.export_sink = LOG_SINK_NONE;
+    
     // Configuration defaults
     logger_state.min_log_level = LOG_LEVEL_INFO;
     logger_state.enabled_categories = 0xFF; // All categories enabled
@@ -131,6 +347,10 @@ int module_init(void)
     logger_state.statistics.anomalies_detected = 0;
     logger_state.statistics.pattern_matches = 0;
     logger_state.statistics.last_rotation = 0;
+    logger_state.statistics.entries_exported = 0;
+    logger_state.statistics.entries_dropped = 0;
+    logger_state.statistics.export_backlog = 0;
+    logger_state.statistics.export_backlog_peak = 0;
     
     for (int i = 0; i < 5; i++) {
         logger_state.statistics.entries_by_level[i] = 0;
@@ -139,19 +359,59 @@ int module_init(void)
         logger_state.statistics.entries_by_category[i] = 0;
     }
     
+    // Clear secondary indexes
+    for (int i = 0; i < LOG_INDEX_ACTORS; i++) {
+        logger_state.actors[i].actor_id = LOG_ACTOR_FREE;
+        logger_state.actors[i].head = 0;
+        logger_state.actors[i].error_head = 0;
+        logger_state.actors[i].recent = 0;
+        logger_state.actors[i].total = 0;
+        logger_state.actors[i].errors = 0;
+    }
+    for (int i = 0; i < LOG_INDEX_MODULES; i++) {
+        logger_state.module_head[i] = 0;
+    }
+    for (int i = 0; i < LOG_INDEX_CATEGORIES; i++) {
+        logger_state.category_head[i] = 0;
+    }
+    
+    // Build keyword automaton once; analysis only scans it
+    logger_matcher_load_defaults();
+    
     // Clear pattern detection
     logger_state.pattern_count = 0;
     for (int i = 0; i < 10; i++) {
         logger_state.recent_patterns[i] = 0;
     }
     
+    // Export statistics through the metrics registry (removed on unload)
+    METRICS_COUNTER("logger.entries", logger_state.statistics.total_entries);
+    METRICS_COUNTER("logger.rotations", logger_state.statistics.rotations);
+    METRICS_COUNTER("logger.entries_exported", logger_state.statistics.entries_exported);
+    METRICS_COUNTER("logger.entries_dropped", logger_state.statistics.entries_dropped);
+    METRICS_COUNTER("logger.anomalies_detected", logger_state.statistics.anomalies_detected);
+    METRICS_GAUGE("logger.current_entries", logger_state.statistics.current_entries);
+    METRICS_GAUGE("logger.export_backlog", logger_state.statistics.export_backlog);
+    
     logger_module_active = true;
     
+    // Prefer the serial port; fall back to the RAM spill region
+    if (serial_is_ready()) {
+        logger_set_export_sink(LOG_SINK_SERIAL);
+    } else {
+        logger_set_export_sink(LOG_SINK_RAM);
+    }
+    
+    // Serial export is drained from the kernel main loop
+    modules_set_export_poll(logger_export_poll);
+    
     // Log the module initialization
     logger_log(LOG_LEVEL_INFO, LOG_CAT_MODULE, 0, 0, "Logger module initialized successfully");
     
     kprintf("[LOGGER-MODULE] Logger module initialized\n");
-    kprintf("[LOGGER-MODULE] Buffer size: %d entries\n", MAX_LOG_ENTRIES);
+    kprintf("[LOGGER-MODULE] Buffer size: %d entries (segments of %d)\n",
+            MAX_LOG_ENTRIES, LOG_SEGMENT_ENTRIES);
+    kprintf("[LOGGER-MODULE] Export sink: %s\n", logger_sink_name(logger_state.export_sink));
     kprintf("[LOGGER-MODULE] Min log level: %d\n", logger_state.min_log_level);
     kprintf("[LOGGER-MODULE] AI analysis: %s\n",
             logger_state.ai_analysis_enabled ? "ENABLED" : "DISABLED");
@@ -168,18 +428,42 @@ void module_exit(void)
     
     kprintf("[LOGGER-MODULE] Shutting down logger module...\n");
     
+    // Stop the periodic drain before this module's code goes away
+    modules_set_export_poll(NULL);
+    
     // Log shutdown event
     logger_log(LOG_LEVEL_INFO, LOG_CAT_MODULE, 0, 0, "Logger module shutting down");
     
+    // Commit and drain everything, the partial tail segment included, so
+    // no history is lost on unload
+    logger_rotate_logs();
+    if (logger_state.export_sink != LOG_SINK_NONE) {
+        while (logger_state.export_next_id < logger_state.commit_limit_id) {
+            logger_export_committed(LOG_EXPORT_BATCH);
+        }
+    }
+    
     // Print final statistics
     kprintf("[LOGGER-MODULE] Final statistics:\n");
     kprintf("[LOGGER-MODULE]   Total entries: %d\n", logger_state.statistics.total_entries);
     kprintf("[LOGGER-MODULE]   Current entries: %d\n", logger_state.statistics.current_entries);
-    kprintf("[LOGGER-MODULE]   Log rotations: %d\n", logger_state.statistics.rotations);
+    kprintf("[LOGGER-MODULE]   Segments committed: %d\n", logger_state.statistics.rotations);
+    kprintf("[LOGGER-MODULE]   Entries exported: %d\n", logger_state.statistics.entries_exported);
     kprintf("[LOGGER-MODULE]   Anomalies detected: %d\n", logger_state.statistics.anomalies_detected);
     
+    metrics_unregister_prefix("logger.");
     logger_module_active = false;
     
+    if (logger_state.spill) {
+        logger_state.export_sink = LOG_SINK_NONE;
+        
+        // The spill mapping is cached; write it back so the records are
+        // in RAM should the machine be reset before anything else evicts them
+        asm volatile ("wbinvd" : : : "memory");
+        paging_unmap_io(logger_state.spill, LOG_SPILL_REGION_SIZE);
+        logger_state.spill = NULL;
+    }
+    
     kprintf("[LOGGER-MODULE] Logger module stopped\n");
 }
 
@@ -238,13 +522,60 @@ int module_ioctl(uint32_t command, void* argument)
             }
             break;
             
-        case 5: // Force log rotation
+        case 5: // Force log rotation (commit current segment for export)
             logger_rotate_logs();
             return 0;
             
         case 6: // Dump recent logs
-            logger_dump_recent_logs(*(uint32_t*)argument);
-            return 0;
+            if (argument) {
+                logger_dump_recent_logs(*(uint32_t*)argument);
+                return 0;
+            }
+            break;
+            
+        case 7: // Drain serial export backlog (returns entries exported)
+            return (int)logger_export_poll();
+            
+        case 8: // Select export sink
+            if (argument) {
+                return logger_set_export_sink(*(uint8_t*)argument) ? 0 : -3;
+            }
+            break;
+            
+        case 9: // Indexed query (returns number of matches)
+            if (argument) {
+                return (int)logger_query((log_query_t*)argument);
+            }
+            break;
+            
+        case 10: // Rolling per-actor counters
+            if (argument) {
+                log_actor_stats_t* stats = (log_actor_stats_t*)argument;
+                log_actor_slot_t* slot = logger_actor_slot(stats->actor_id, false);
+                stats->recent_entries = slot ? slot->recent : 0;
+                stats->total_entries = slot ? slot->total : 0;
+                stats->error_entries = slot ? slot->errors : 0;
+                return 0;
+            }
+            break;
+            
+        case 11: // Register keyword and rebuild the matcher
+            if (argument) {
+                log_keyword_t* kw = (log_keyword_t*)argument;
+                if (logger_matcher_add(kw->keyword, kw->score, kw->flags) &&
+                    logger_matcher_build()) {
+                    return 0;
+                }
+                return -4; // Matcher full or keyword invalid
+            }
+            break;
+            
+        case 12: // Benchmark keyword matcher with N keywords (0 = 1, 16 and 128)
+            if (argument) {
+                logger_benchmark_keywords(*(uint32_t*)argument);
+                return 0;
+            }
+            break;
             
         default:
             return -2; // Unknown command
@@ -269,14 +600,22 @@ void logger_log(uint8_t level, uint8_t category, uint32_t actor_id,
     if (level < logger_state.min_log_level) return;
     if (!(category & logger_state.enabled_categories)) return;
     
-    // Check if we need to rotate logs
-    if (logger_state.entry_count >= LOG_ROTATION_SIZE) {
-        logger_rotate_logs();
-    }
-    
-    // Get log entry slot
+    // Get log entry slot (overwrites the oldest entry once the ring is full)
     log_entry_t* entry = &logger_state.entries[logger_state.write_index];
     
+    // Never wait on the sink here: if the exporter has fallen a full ring
+    // behind, the entry about to be overwritten is lost to it and counted
+    if (logger_state.entry_count == MAX_LOG_ENTRIES &&
+        entry->entry_id >= logger_state.export_next_id) {
+        if (logger_state.export_sink != LOG_SINK_NONE) {
+            logger_state.statistics.entries_dropped++;
+        }
+        logger_state.export_next_id = entry->entry_id + 1;
+        if (logger_state.commit_limit_id < logger_state.export_next_id) {
+            logger_state.commit_limit_id = logger_state.export_next_id;
+        }
+    }
+    
     // Fill entry data
     entry->entry_id = logger_state.next_entry_id++;
     entry->timestamp = 0; // TODO: Get real timestamp
@@ -302,12 +641,22 @@ void logger_log(uint8_t level, uint8_t category, uint32_t actor_id,
         logger_ai_analyze_entry(entry);
     }
     
+    // Link into secondary indexes after analysis so rolling counters
+    // seen by the analyzer exclude the entry itself
+    logger_index_entry(entry);
+    
     // Update counters
     logger_state.write_index = (logger_state.write_index + 1) % MAX_LOG_ENTRIES;
     if (logger_state.entry_count < MAX_LOG_ENTRIES) {
         logger_state.entry_count++;
     }
     
+    // Commit the segment once it is complete; the exporter only drains
+    // committed segments so it never races a half-written entry
+    if (entry->entry_id % LOG_SEGMENT_ENTRIES == 0) {
+        logger_commit_segment(entry->entry_id + 1);
+    }
+    
     // Update statistics
     logger_state.statistics.total_entries++;
     logger_state.statistics.current_entries = logger_state.entry_count;
@@ -431,24 +780,285 @@ void logger_log_error(const char* subsystem, const char* error_message)
 // =============================================================================
 
 /*
- * Rotate logs when buffer is full
+ * Rotate logs: commit everything written so far for export.
+ * The ring itself is never wiped; old entries are overwritten only after
+ * they have been handed to the export sink.
  */
 void logger_rotate_logs(void)
 {
     if (!logger_module_active) return;
     
-    kprintf("[LOGGER-MODULE] Rotating logs (buffer %d%% full)\n",
-            (logger_state.entry_count * 100) / MAX_LOG_ENTRIES);
+    logger_commit_segment(logger_state.next_entry_id);
+}
+
+/*
+ * Mark all entries below limit_id as committed and ready for export
+ */
+void logger_commit_segment(uint32_t limit_id)
+{
+    if (limit_id <= logger_state.commit_limit_id) return;
     
-    // Simple rotation: just reset to beginning
-    // In a real implementation, we'd save old logs to storage
-    logger_state.write_index = 0;
-    logger_state.entry_count = 0;
+    logger_state.commit_limit_id = limit_id;
     logger_state.statistics.rotations++;
     logger_state.statistics.last_rotation = 0; // TODO: Get timestamp
     
-    // Log the rotation event
-    logger_log(LOG_LEVEL_INFO, LOG_CAT_KERNEL, 0, 0, "Log rotation completed");
+    // The RAM sink is a plain memory copy that never blocks, so segments go
+    // to it as they are committed and it cannot fall behind the ring
+    if (logger_state.export_sink == LOG_SINK_RAM) {
+        logger_export_committed(limit_id - logger_state.export_next_id);
+    }
+    
+    uint32_t backlog = logger_state.commit_limit_id - logger_state.export_next_id;
+    logger_state.statistics.export_backlog = backlog;
+    if (backlog > logger_state.statistics.export_backlog_peak) {
+        logger_state.statistics.export_backlog_peak = backlog;
+    }
+}
+
+// =============================================================================
+// Streaming Export Functions
+// =============================================================================
+
+/*
+ * Drain committed entries to the serial sink. Each poll takes everything
+ * committed since the previous poll plus LOG_EXPORT_BATCH of older
+ * backlog, so the drain always keeps pace with commits. Called from the
+ * kernel main loop, never from logger_log, so logging itself never waits
+ * on the port. Returns the number of entries exported.
+ */
+uint32_t logger_export_poll(void)
+{
+    if (!logger_module_active || logger_state.export_sink != LOG_SINK_SERIAL) {
+        return 0;
+    }
+    
+    uint32_t budget = LOG_EXPORT_BATCH +
+                      (logger_state.commit_limit_id - logger_state.export_poll_limit_id);
+    logger_state.export_poll_limit_id = logger_state.commit_limit_id;
+    
+    return logger_export_committed(budget);
+}
+
+/*
+ * Hand up to max_entries committed entries to the active sink, oldest
+ * first. Returns the number exported.
+ */
+uint32_t logger_export_committed(uint32_t max_entries)
+{
+    uint32_t exported = 0;
+    uint32_t examined = 0;
+    
+    while (examined < max_entries &&
+           logger_state.export_next_id < logger_state.commit_limit_id) {
+        uint32_t id = logger_state.export_next_id;
+        log_entry_t* entry = &logger_state.entries[(id - 1) % MAX_LOG_ENTRIES];
+        
+        // Entry ID doubles as ring position; a mismatch means it was
+        // overwritten before the exporter got to it
+        if (entry->entry_id == id) {
+            logger_export_entry(entry);
+            exported++;
+        }
+        
+        logger_state.export_next_id++;
+        examined++;
+    }
+    
+    logger_state.statistics.export_backlog =
+        logger_state.commit_limit_id - logger_state.export_next_id;
+    
+    return exported;
+}
+
+/*
+ * Write one entry to the active sink
+ */
+void logger_export_entry(log_entry_t* entry)
+{
+    if (!entry) return;
+    
+    switch (logger_state.export_sink) {
+        case LOG_SINK_SERIAL:
+            logger_export_serial(entry);
+            break;
+            
+        case LOG_SINK_RAM:
+            logger_export_ram(entry);
+            break;
+            
+        default:
+            return;
+    }
+    
+    logger_state.statistics.entries_exported++;
+}
+
+/*
+ * Export entry as a text line on the serial port
+ */
+void logger_export_serial(log_entry_t* entry)
+{
+    const char* levels[] = {"DEBUG", "INFO", "WARN", "ERROR", "CRIT"};
+    char number[12];
+    
+    serial_write_string("LOG ");
+    logger_format_u32(entry->entry_id, number);
+    serial_write_string(number);
+    serial_write_char(' ');
+    serial_write_string((entry->level < 5) ? levels[entry->level] : "UNK");
+    serial_write_string(" a=");
+    logger_format_u32(entry->actor_id, number);
+    serial_write_string(number);
+    serial_write_string(" m=");
+    logger_format_u32(entry->module_id, number);
+    serial_write_string(number);
+    serial_write_char(' ');
+    serial_write_string(entry->message);
+    serial_write_string("\n");
+}
+
+/*
+ * Export entry as a binary record in the RAM spill region
+ */
+void logger_export_ram(log_entry_t* entry)
+{
+    log_spill_header_t* spill = logger_state.spill;
+    if (!spill) return;
+    
+    uint8_t* data = (uint8_t*)spill + sizeof(log_spill_header_t);
+    
+    uint32_t length = 0;
+    while (length < MAX_LOG_MESSAGE_SIZE - 1 && entry->message[length] != '\0') {
+        length++;
+    }
+    
+    uint32_t record_size = (sizeof(log_spill_record_t) + length + 3) & ~3u;
+    
+    // Not enough room before the end: leave a wrap marker and restart
+    if (spill->write_offset + record_size > spill->data_size) {
+        if (spill->write_offset + sizeof(log_spill_record_t) <= spill->data_size) {
+            log_spill_record_t* marker = (log_spill_record_t*)(data + spill->write_offset);
+            marker->length = LOG_SPILL_WRAP_MARKER;
+        }
+        spill->write_offset = 0;
+        spill->wrap_count++;
+    }
+    
+    log_spill_record_t* record = (log_spill_record_t*)(data + spill->write_offset);
+    record->entry_id = entry->entry_id;
+    record->timestamp = (uint32_t)entry->timestamp;
+    record->level = entry->level;
+    record->category = entry->category;
+    record->length = (uint16_t)length;
+    record->actor_id = entry->actor_id;
+    record->module_id = entry->module_id;
+    
+    uint8_t* payload = (uint8_t*)record + sizeof(log_spill_record_t);
+    for (uint32_t i = 0; i < length; i++) {
+        payload[i] = (uint8_t)entry->message[i];
+    }
+    
+    spill->write_offset += record_size;
+    spill->records_written++;
+    spill->last_entry_id = entry->entry_id;
+}
+
+/*
+ * Map and attach the RAM spill region, formatting it only if it holds no
+ * valid header from a previous boot
+ */
+void logger_spill_attach(void)
+{
+    log_spill_header_t* spill = paging_map_ram(LOG_SPILL_REGION_BASE, LOG_SPILL_REGION_SIZE);
+    if (!spill) {
+        kprintf("[LOGGER-MODULE] WARNING: Cannot map spill region\n");
+        return;
+    }
+    
+    uint32_t data_size = LOG_SPILL_REGION_SIZE - sizeof(log_spill_header_t);
+    
+    if (spill->magic == LOG_SPILL_MAGIC &&
+        spill->version == LOG_SPILL_VERSION &&
+        spill->data_size == data_size &&
+        spill->write_offset <= data_size) {
+        spill->boot_count++;
+        kprintf("[LOGGER-MODULE] Spill region retained (%d records, boot %d)\n",
+                spill->records_written, spill->boot_count);
+    } else {
+        spill->magic = LOG_SPILL_MAGIC;
+        spill->version = LOG_SPILL_VERSION;
+        spill->data_size = data_size;
+        spill->write_offset = 0;
+        spill->wrap_count = 0;
+        spill->records_written = 0;
+        spill->boot_count = 1;
+        spill->last_entry_id = 0;
+        kprintf("[LOGGER-MODULE] Spill region formatted at 0x%x (%d KB)\n",
+                LOG_SPILL_REGION_BASE, LOG_SPILL_REGION_SIZE / 1024);
+    }
+    
+    logger_state.spill = spill;
+}
+
+/*
+ * Select the export sink
+ */
+bool logger_set_export_sink(uint8_t sink)
+{
+    switch (sink) {
+        case LOG_SINK_NONE:
+            break;
+            
+        case LOG_SINK_SERIAL:
+            if (!serial_is_ready()) return false;
+            break;
+            
+        case LOG_SINK_RAM:
+            if (!logger_state.spill) {
+                logger_spill_attach();
+            }
+            if (!logger_state.spill) return false;
+            break;
+            
+        default:
+            return false;
+    }
+    
+    logger_state.export_sink = sink;
+    
+    // Whatever the serial drain had not reached goes to RAM now
+    if (sink == LOG_SINK_RAM) {
+        logger_export_committed(logger_state.commit_limit_id - logger_state.export_next_id);
+    }
+    return true;
+}
+
+/*
+ * Get export sink name
+ */
+const char* logger_sink_name(uint8_t sink)
+{
+    const char* sinks[] = {"NONE", "SERIAL", "RAM"};
+    return (sink < 3) ? sinks[sink] : "UNKNOWN";
+}
+
+/*
+ * Format an unsigned decimal number (buffer must hold 11 bytes)
+ */
+void logger_format_u32(uint32_t value, char* buffer)
+{
+    char digits[10];
+    uint32_t count = 0;
+    
+    do {
+        digits[count++] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+    
+    for (uint32_t i = 0; i < count; i++) {
+        buffer[i] = digits[count - 1 - i];
+    }
+    buffer[count] = '\0';
 }
 
 /*
@@ -522,29 +1132,9 @@ void logger_ai_analyze_entry(log_entry_t* entry)
 {
     if (!entry || !logger_state.ai_analysis_enabled) return;
     
-    // Simple pattern detection based on keywords
-    uint32_t pattern_score = 0;
+    // Keyword detection: one pass over the message for all keywords
     bool anomaly = false;
-    
-    // Check for error keywords
-    const char* error_keywords[] = {"error", "fail", "crash", "panic", "corrupt"};
-    for (int i = 0; i < 5; i++) {
-        if (logger_contains_keyword(entry->message, error_keywords[i])) {
-            pattern_score += 20;
-            if (entry->level >= LOG_LEVEL_ERROR) {
-                anomaly = true;
-            }
-        }
-    }
-    
-    // Check for suspicious patterns
-    const char* suspicious_keywords[] = {"suspicious", "anomaly", "leak", "spike"};
-    for (int i = 0; i < 4; i++) {
-        if (logger_contains_keyword(entry->message, suspicious_keywords[i])) {
-            pattern_score += 30;
-            anomaly = true;
-        }
-    }
+    uint32_t pattern_score = logger_matcher_scan(entry->message, entry->level, &anomaly);
     
     // High frequency of logs from same actor might indicate problems
     if (entry->actor_id != 0) {
@@ -576,66 +1166,566 @@ void logger_ai_analyze_entry(log_entry_t* entry)
 }
 
 /*
- * Check if message contains keyword
+ * Count recent logs from specific actor (within the last LOG_ACTOR_WINDOW
+ * entries). Served from the rolling counter maintained at insertion time.
+ */
+uint32_t logger_count_recent_actor_logs(uint32_t actor_id)
+{
+    if (!logger_module_active) return 0;
+    
+    log_actor_slot_t* slot = logger_actor_slot(actor_id, false);
+    return slot ? slot->recent : 0;
+}
+
+// =============================================================================
+// Log Index Functions
+// =============================================================================
+
+/*
+ * Get category chain index (lowest set bit, as used by statistics)
+ */
+uint32_t logger_category_index(uint8_t category)
+{
+    for (uint32_t i = 0; i < LOG_INDEX_CATEGORIES; i++) {
+        if (category & (1 << i)) {
+            return i;
+        }
+    }
+    
+    return LOG_INDEX_CATEGORIES; // No category bit set
+}
+
+/*
+ * Find an actor's index slot. With create, an unknown actor takes the
+ * first never-used slot in its probe run, or else the first whose actor
+ * has nothing left in the rolling window (its chains and counters are
+ * reset). NULL if the actor is unknown, or the run is full of active
+ * actors, in which case the entry is simply not indexed by actor.
  */
-bool logger_contains_keyword(const char* message, const char* keyword)
+log_actor_slot_t* logger_actor_slot(uint32_t actor_id, bool create)
 {
-    if (!message || !keyword) return false;
+    uint32_t index = (actor_id * 2654435761u) >> 23; // Fibonacci hash, 9 bits
+    log_actor_slot_t* reusable = NULL;
     
-    uint32_t msg_len = 0, key_len = 0;
+    for (uint32_t probe = 0; probe < LOG_ACTOR_PROBE_LIMIT; probe++) {
+        log_actor_slot_t* slot = &logger_state.actors[(index + probe) & (LOG_INDEX_ACTORS - 1)];
+        
+        if (slot->actor_id == actor_id) {
+            return slot;
+        }
+        if (slot->actor_id == LOG_ACTOR_FREE) {
+            reusable = slot;
+            break; // The actor would have been placed here or earlier
+        }
+        if (!reusable && slot->recent == 0) {
+            reusable = slot;
+        }
+    }
     
-    // Get lengths
-    while (message[msg_len] != '\0') msg_len++;
-    while (keyword[key_len] != '\0') key_len++;
+    if (!create || !reusable) {
+        return NULL;
+    }
     
-    if (key_len > msg_len) return false;
+    reusable->actor_id = actor_id;
+    reusable->head = 0;
+    reusable->error_head = 0;
+    reusable->recent = 0;
+    reusable->total = 0;
+    reusable->errors = 0;
+    return reusable;
+}
+
+/*
+ * Resolve an entry ID to its ring slot, or NULL if it was overwritten
+ */
+log_entry_t* logger_lookup_entry(uint32_t entry_id)
+{
+    if (entry_id == 0) return NULL;
     
-    // Simple substring search (case-insensitive)
-    for (uint32_t i = 0; i <= msg_len - key_len; i++) {
-        bool match = true;
-        for (uint32_t j = 0; j < key_len; j++) {
-            char msg_char = message[i + j];
-            char key_char = keyword[j];
-            
-            // Convert to lowercase for comparison
-            if (msg_char >= 'A' && msg_char <= 'Z') {
-                msg_char += 32;
+    log_entry_t* entry = &logger_state.entries[(entry_id - 1) % MAX_LOG_ENTRIES];
+    return (entry->entry_id == entry_id) ? entry : NULL;
+}
+
+/*
+ * Link a freshly written entry into the index chains and update the
+ * rolling actor counters
+ */
+void logger_index_entry(log_entry_t* entry)
+{
+    log_actor_slot_t* actor = logger_actor_slot(entry->actor_id, true);
+    uint32_t module_bucket = entry->module_id % LOG_INDEX_MODULES;
+    uint32_t category_index = logger_category_index(entry->category);
+    
+    // Push onto chain heads
+    entry->prev_same_actor = 0;
+    entry->prev_actor_error = 0;
+    if (actor) {
+        entry->prev_same_actor = actor->head;
+        actor->head = entry->entry_id;
+        
+        if (entry->level >= LOG_LEVEL_ERROR) {
+            entry->prev_actor_error = actor->error_head;
+            actor->error_head = entry->entry_id;
+            actor->errors++;
+        }
+    }
+    
+    entry->prev_same_module = logger_state.module_head[module_bucket];
+    logger_state.module_head[module_bucket] = entry->entry_id;
+    
+    entry->prev_same_category = 0;
+    if (category_index < LOG_INDEX_CATEGORIES) {
+        entry->prev_same_category = logger_state.category_head[category_index];
+        logger_state.category_head[category_index] = entry->entry_id;
+    }
+    
+    // Slide the rolling window: the entry LOG_ACTOR_WINDOW positions back
+    // leaves it (the ring is larger than the window, so it is still present)
+    if (actor) {
+        actor->recent++;
+        actor->total++;
+    }
+    
+    if (entry->entry_id > LOG_ACTOR_WINDOW) {
+        log_entry_t* expired = logger_lookup_entry(entry->entry_id - LOG_ACTOR_WINDOW);
+        log_actor_slot_t* owner = expired ? logger_actor_slot(expired->actor_id, false) : NULL;
+        if (owner && owner->recent > 0) {
+            owner->recent--;
+        }
+    }
+}
+
+/*
+ * Run an indexed query. Walks the most selective chain available, newest
+ * first, so cost is proportional to the matching entries rather than the
+ * buffer size. Returns the number of entries copied to query->results.
+ */
+uint32_t logger_query(log_query_t* query)
+{
+    if (!logger_module_active || !query) return 0;
+    
+    query->result_count = 0;
+    query->entries_visited = 0;
+    
+    // Pick the chain: actor errors > actor > module > categories > everything
+    uint32_t link_field;
+    uint32_t cursor;
+    
+    if (query->actor_id != LOG_QUERY_ANY) {
+        log_actor_slot_t* actor = logger_actor_slot(query->actor_id, false);
+        if (query->min_level >= LOG_LEVEL_ERROR) {
+            link_field = 1;
+            cursor = actor ? actor->error_head : 0;
+        } else {
+            link_field = 0;
+            cursor = actor ? actor->head : 0;
+        }
+    } else if (query->module_id != LOG_QUERY_ANY) {
+        link_field = 2;
+        cursor = logger_state.module_head[query->module_id % LOG_INDEX_MODULES];
+    } else if (query->category != 0) {
+        return logger_query_categories(query);
+    } else {
+        link_field = 4;
+        cursor = logger_state.next_entry_id - 1;
+    }
+    
+    while (query->result_count < query->max_results) {
+        log_entry_t* entry = logger_lookup_entry(cursor);
+        if (!entry) break; // End of chain or overwritten
+        
+        query->entries_visited++;
+        
+        bool match = (entry->level >= query->min_level) &&
+                     (query->actor_id == LOG_QUERY_ANY || entry->actor_id == query->actor_id) &&
+                     (query->module_id == LOG_QUERY_ANY || entry->module_id == query->module_id) &&
+                     (query->category == 0 || (entry->category & query->category));
+        
+        if (match && query->results) {
+            query->results[query->result_count] = *entry;
+        }
+        if (match) {
+            query->result_count++;
+        }
+        
+        switch (link_field) {
+            case 0:  cursor = entry->prev_same_actor; break;
+            case 1:  cursor = entry->prev_actor_error; break;
+            case 2:  cursor = entry->prev_same_module; break;
+            default: cursor = entry->entry_id - 1; break;
+        }
+    }
+    
+    return query->result_count;
+}
+
+/*
+ * Category query. An entry is chained only under its lowest category bit,
+ * so one matching any bit of the mask sits in the chain of that bit or a
+ * lower one: walk every chain up to the mask's highest bit, merged newest
+ * first by entry ID.
+ */
+uint32_t logger_query_categories(log_query_t* query)
+{
+    uint32_t cursors[LOG_INDEX_CATEGORIES];
+    uint32_t chains = 0;
+    
+    for (uint32_t i = 0; i < LOG_INDEX_CATEGORIES; i++) {
+        if (query->category & (1 << i)) {
+            chains = i + 1;
+        }
+    }
+    for (uint32_t i = 0; i < chains; i++) {
+        cursors[i] = logger_state.category_head[i];
+    }
+    
+    while (query->result_count < query->max_results) {
+        // Newest entry at the head of any chain
+        log_entry_t* entry = NULL;
+        uint32_t chain = 0;
+        for (uint32_t i = 0; i < chains; i++) {
+            log_entry_t* candidate = logger_lookup_entry(cursors[i]);
+            if (candidate && (!entry || candidate->entry_id > entry->entry_id)) {
+                entry = candidate;
+                chain = i;
             }
-            if (key_char >= 'A' && key_char <= 'Z') {
-                key_char += 32;
+        }
+        if (!entry) break; // Every chain ended or was overwritten
+        
+        cursors[chain] = entry->prev_same_category;
+        query->entries_visited++;
+        
+        if (entry->level >= query->min_level && (entry->category & query->category)) {
+            if (query->results) {
+                query->results[query->result_count] = *entry;
             }
+            query->result_count++;
+        }
+    }
+    
+    return query->result_count;
+}
+
+// =============================================================================
+// Keyword Matcher (Aho-Corasick)
+// =============================================================================
+
+/*
+ * Map a character to its alphabet class (case-folded, 0 = not matchable)
+ */
+uint8_t logger_ac_class(char c)
+{
+    if (c >= 'A' && c <= 'Z') return (uint8_t)(1 + (c - 'A'));
+    if (c >= 'a' && c <= 'z') return (uint8_t)(1 + (c - 'a'));
+    if (c >= '0' && c <= '9') return (uint8_t)(27 + (c - '0'));
+    
+    switch (c) {
+        case ' ': return 37;
+        case '_': return 38;
+        case '-': return 39;
+        case '.': return 40;
+        case ':': return 41;
+        case '/': return 42;
+        default:  return 0;
+    }
+}
+
+/*
+ * Empty the pattern set (the automaton keeps matching the old set until
+ * the next logger_matcher_build)
+ */
+void logger_matcher_clear(void)
+{
+    logger_matcher.pattern_count = 0;
+    logger_matcher.trie_states = 1; // Root
+}
+
+/*
+ * Add a keyword to the pattern set (call logger_matcher_build afterwards).
+ * Refused, leaving the set unchanged, if it is invalid or the trie would
+ * need more than LOG_AC_MAX_STATES states.
+ */
+bool logger_matcher_add(const char* keyword, uint8_t score, uint8_t flags)
+{
+    log_keyword_matcher_t* m = &logger_matcher;
+    
+    if (!keyword || keyword[0] == '\0') return false;
+    if (m->pattern_count >= LOG_AC_MAX_PATTERNS) return false;
+    
+    uint32_t len = 0;
+    while (keyword[len] != '\0') {
+        if (len >= LOG_AC_MAX_KEYWORD - 1 || logger_ac_class(keyword[len]) == 0) {
+            return false; // Too long or contains an unmatchable character
+        }
+        len++;
+    }
+    
+    // New trie states: the part of the keyword past its longest prefix
+    // shared (case-folded) with a registered keyword
+    uint32_t shared = 0;
+    for (uint32_t p = 0; p < m->pattern_count && shared < len; p++) {
+        const char* other = m->patterns[p].keyword;
+        uint32_t i = 0;
+        while (i < len && other[i] && logger_ac_class(other[i]) == logger_ac_class(keyword[i])) {
+            i++;
+        }
+        if (i > shared) shared = i;
+    }
+    if (m->trie_states + (len - shared) > LOG_AC_MAX_STATES) {
+        kprintf("[LOGGER-MODULE] Keyword matcher out of states\n");
+        return false;
+    }
+    
+    log_keyword_t* pattern = &m->patterns[m->pattern_count];
+    for (uint32_t i = 0; i <= len; i++) {
+        pattern->keyword[i] = keyword[i];
+    }
+    pattern->score = score;
+    pattern->flags = flags;
+    
+    m->trie_states += len - shared;
+    m->pattern_count++;
+    return true;
+}
+
+/*
+ * Build the automaton: insert all keywords into a trie, then compute
+ * failure links breadth-first and fill in the missing transitions so
+ * goto_table becomes a complete DFA.
+ */
+bool logger_matcher_build(void)
+{
+    log_keyword_matcher_t* m = &logger_matcher;
+    
+    m->ready = false;
+    m->state_count = 1;
+    for (uint32_t i = 0; i < 256; i++) {
+        m->char_class[i] = logger_ac_class((char)i);
+    }
+
+    for (uint32_t c = 0; c < LOG_AC_CLASSES; c++) {
+        m->goto_table[0][c] = LOG_AC_NONE;
+    }
+    m->output[0] = LOG_AC_NONE;
+    
+    // Phase 1: trie
+    for (uint32_t p = 0; p < m->pattern_count; p++) {
+        uint16_t state = 0;
+        
+        for (const char* k = m->patterns[p].keyword; *k; k++) {
+            uint8_t c = logger_ac_class(*k);
             
-            if (msg_char != key_char) {
-                match = false;
-                break;
+            if (m->goto_table[state][c] == LOG_AC_NONE) {
+                if (m->state_count >= LOG_AC_MAX_STATES) {
+                    return false; // logger_matcher_add keeps the set within bounds
+                }
+                
+                uint16_t next = (uint16_t)m->state_count++;
+                for (uint32_t i = 0; i < LOG_AC_CLASSES; i++) {
+                    m->goto_table[next][i] = LOG_AC_NONE;
+                }
+                m->output[next] = LOG_AC_NONE;
+                m->goto_table[state][c] = next;
             }
+            
+            state = m->goto_table[state][c];
         }
         
-        if (match) return true;
+        // Duplicate keywords keep the first registration
+        if (m->output[state] == LOG_AC_NONE) {
+            m->output[state] = (uint16_t)p;
+        }
+    }
+    
+    // Phase 2: failure links, breadth-first
+    static uint16_t queue[LOG_AC_MAX_STATES];
+    uint32_t head = 0, tail = 0;
+    
+    m->fail[0] = 0;
+    m->dict_link[0] = 0;
+    
+    for (uint32_t c = 0; c < LOG_AC_CLASSES; c++) {
+        uint16_t child = m->goto_table[0][c];
+        if (child == LOG_AC_NONE) {
+            m->goto_table[0][c] = 0;
+        } else {
+            m->fail[child] = 0;
+            m->dict_link[child] = 0;
+            queue[tail++] = child;
+        }
     }
     
-    return false;
+    while (head < tail) {
+        uint16_t state = queue[head++];
+        
+        for (uint32_t c = 0; c < LOG_AC_CLASSES; c++) {
+            uint16_t child = m->goto_table[state][c];
+            
+            if (child == LOG_AC_NONE) {
+                m->goto_table[state][c] = m->goto_table[m->fail[state]][c];
+                continue;
+            }
+            
+            uint16_t fail = m->goto_table[m->fail[state]][c];
+            m->fail[child] = fail;
+            m->dict_link[child] = (m->output[fail] != LOG_AC_NONE) ? fail : m->dict_link[fail];
+            queue[tail++] = child;
+        }
+    }
+    
+    m->ready = true;
+    return true;
 }
 
 /*
- * Count recent logs from specific actor
+ * Load the built-in keyword set and build the automaton
  */
-uint32_t logger_count_recent_actor_logs(uint32_t actor_id)
+void logger_matcher_load_defaults(void)
 {
-    if (!logger_module_active) return 0;
+    logger_matcher_clear();
     
-    uint32_t count = 0;
-    uint32_t entries_to_check = (logger_state.entry_count < 50) ? 
-                               logger_state.entry_count : 50;
+    uint32_t count = sizeof(logger_default_keywords) / sizeof(logger_default_keywords[0]);
+    for (uint32_t i = 0; i < count; i++) {
+        logger_matcher_add(logger_default_keywords[i].keyword,
+                           logger_default_keywords[i].score,
+                           logger_default_keywords[i].flags);
+    }
     
-    for (uint32_t i = 0; i < entries_to_check; i++) {
-        uint32_t index = (logger_state.write_index - 1 - i + MAX_LOG_ENTRIES) % MAX_LOG_ENTRIES;
-        if (logger_state.entries[index].actor_id == actor_id) {
-            count++;
+    logger_matcher_build();
+}
+
+/*
+ * Scan a message once and return the summed score of all distinct
+ * keywords it contains. Each keyword counts at most once per message.
+ */
+uint32_t logger_matcher_scan(const char* message, uint8_t level, bool* anomaly)
+{
+    log_keyword_matcher_t* m = &logger_matcher;
+    uint32_t seen[LOG_AC_MAX_PATTERNS / 32] = {0};
+    uint32_t score = 0;
+    uint16_t state = 0;
+    
+    if (!m->ready || !message) return 0;
+    
+    for (const char* p = message; *p; p++) {
+        state = m->goto_table[state][m->char_class[(uint8_t)*p]];
+        
+        // Walk this state's output and its dictionary suffix chain
+        uint16_t out = (m->output[state] != LOG_AC_NONE) ? state : m->dict_link[state];
+        while (out != 0) {
+            uint16_t id = m->output[out];
+            
+            if (!(seen[id / 32] & (1u << (id % 32)))) {
+                seen[id / 32] |= 1u << (id % 32);
+                
+                log_keyword_t* pattern = &m->patterns[id];
+                score += pattern->score;
+                
+                if ((pattern->flags & LOG_KW_ANOMALY) ||
+                    ((pattern->flags & LOG_KW_ANOMALY_ON_ERROR) && level >= LOG_LEVEL_ERROR)) {
+                    *anomaly = true;
+                }
+            }
+            
+            out = m->dict_link[out];
         }
     }
     
-    return count;
+    return score;
+}
+
+/*
+ * Benchmark the matcher with keyword_count keywords, or with 1, 16 and 128
+ * keywords when keyword_count is 0. The live keyword set, including
+ * keywords registered through ioctl 11, is restored afterwards.
+ */
+void logger_benchmark_keywords(uint32_t keyword_count)
+{
+    static const uint32_t sweep[] = { 1, 16, 128 };
+    
+    // Set the live keywords aside while the benchmark sets are installed
+    static log_keyword_t saved[LOG_AC_MAX_PATTERNS];
+    uint32_t saved_count = logger_matcher.pattern_count;
+    uint32_t saved_states = logger_matcher.trie_states;
+    for (uint32_t i = 0; i < saved_count; i++) {
+        saved[i] = logger_matcher.patterns[i];
+    }
+    
+    if (keyword_count == 0) {
+        for (uint32_t i = 0; i < sizeof(sweep) / sizeof(sweep[0]); i++) {
+            logger_benchmark_run(sweep[i]);
+        }
+    } else {
+        logger_benchmark_run(keyword_count > LOG_AC_MAX_PATTERNS ?
+                             LOG_AC_MAX_PATTERNS : keyword_count);
+    }
+    
+    for (uint32_t i = 0; i < saved_count; i++) {
+        logger_matcher.patterns[i] = saved[i];
+    }
+    logger_matcher.pattern_count = saved_count;
+    logger_matcher.trie_states = saved_states;
+    logger_matcher_build();
+}
+
+/*
+ * Install keyword_count keywords (built-ins first, then synthetic ones),
+ * scan the sample entries and report entries/sec. Falls back to cycles
+ * per entry until cpu_timer has calibrated the TSC.
+ */
+void logger_benchmark_run(uint32_t keyword_count)
+{
+    const char* samples[] = {
+        "Actor activity: message queue drained, 12 messages processed",
+        "Module event: mod_timer tick handler completed in 4 us",
+        "ERROR in heap: allocation failed for 4096 bytes, possible leak",
+        "Scheduler: context switch 3 -> 7, timeslice expired normally",
+    };
+    const uint32_t iterations = 1000;
+    
+    logger_matcher_clear();
+    uint32_t defaults = sizeof(logger_default_keywords) / sizeof(logger_default_keywords[0]);
+    for (uint32_t i = 0; i < keyword_count && i < defaults; i++) {
+        logger_matcher_add(logger_default_keywords[i].keyword,
+                           logger_default_keywords[i].score,
+                           logger_default_keywords[i].flags);
+    }
+    for (uint32_t i = defaults; i < keyword_count; i++) {
+        char synthetic[12] = "synthkw";
+        synthetic[7] = (char)('a' + (i / 676) % 26);
+        synthetic[8] = (char)('a' + (i / 26) % 26);
+        synthetic[9] = (char)('a' + i % 26);
+        synthetic[10] = '\0';
+        logger_matcher_add(synthetic, 1, 0);
+    }
+    logger_matcher_build();
+    
+    uint32_t checksum = 0;
+    uint64_t start = read_timestamp_counter();
+    
+    for (uint32_t i = 0; i < iterations; i++) {
+        bool anomaly = false;
+        checksum += logger_matcher_scan(samples[i % 4], LOG_LEVEL_INFO, &anomaly);
+    }
+    
+    uint32_t cycles = (uint32_t)(read_timestamp_counter() - start);
+    uint32_t per_entry = cycles / iterations;
+    if (per_entry == 0) per_entry = 1;
+    
+    kprintf("[LOGGER-MODULE] Matcher benchmark: %d keywords, %d states (checksum %d)\n",
+            logger_matcher.pattern_count, logger_matcher.state_count, checksum);
+    
+    // entries/sec = tsc_per_ms * 1000 / per_entry, kept within 32 bits
+    uint32_t tsc_per_ms = cpu_timer_tsc_per_ms();
+    if (tsc_per_ms) {
+        uint32_t rate = (tsc_per_ms / per_entry) * 1000 +
+                        (tsc_per_ms % per_entry) * 1000 / per_entry;
+        kprintf("[LOGGER-MODULE]   %d entries/sec (%d cycles/entry)\n",
+                rate, per_entry);
+    } else {
+        kprintf("[LOGGER-MODULE]   %d cycles/entry (TSC not calibrated)\n",
+                per_entry);
+    }
 }
 
 // =============================================================================
@@ -658,7 +1748,12 @@ void logger_print_status(void)
             logger_state.entry_count, MAX_LOG_ENTRIES,
             (logger_state.entry_count * 100) / MAX_LOG_ENTRIES);
     kprintf("[LOGGER-MODULE]   Total entries: %d\n", logger_state.statistics.total_entries);
-    kprintf("[LOGGER-MODULE]   Rotations: %d\n", logger_state.statistics.rotations);
+    kprintf("[LOGGER-MODULE]   Segments committed: %d\n", logger_state.statistics.rotations);
+    kprintf("[LOGGER-MODULE]   Export sink: %s (exported %d, backlog %d, dropped %d)\n",
+            logger_sink_name(logger_state.export_sink),
+            logger_state.statistics.entries_exported,
+            logger_state.statistics.export_backlog,
+            logger_state.statistics.entries_dropped);
     kprintf("[LOGGER-MODULE]   Min log level: %d\n", logger_state.min_log_level);
     kprintf("[LOGGER-MODULE]   Enabled categories: 0x%x\n", logger_state.enabled_categories);
     kprintf("[LOGGER-MODULE]   AI analysis: %s\n",
@@ -677,3 +1772,4 @@ MODULE_EXPORT(logger_log_module_event);
 MODULE_EXPORT(logger_log_error);
 MODULE_EXPORT(logger_print_status);
 MODULE_EXPORT(logger_dump_recent_logs);
+MODULE_EXPORT(logger_export_poll);
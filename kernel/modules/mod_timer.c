@@ -16,6 +16,7 @@
 #include "../modules.h"
 #include "../kernel.h"
 #include "../vga.h"
+#include "../spinlock.h"
 
 // Module metadata
 MODULE_DEFINE("mod_timer", 1, MODULE_TYPE_MISC, MODULE_FLAG_HOT_SWAP | MODULE_FLAG_AI_MONITOR);
@@ -40,6 +41,10 @@ typedef struct timer_module_state {
 } timer_module_state_t;
 
 static timer_module_state_t timer_state;
+
+// Tick count and uptime are written from the timer interrupt and read
+// anywhere; readers retry instead of seeing a torn 64-bit tick count
+static seqlock_t timer_clock_lock = SEQLOCK_INIT("timer.clock");
 static bool timer_module_active = false;
 
 // =============================================================================
@@ -123,7 +128,9 @@ int module_ioctl(uint32_t command, void* argument)
             if (argument) {
                 uint32_t new_freq = *(uint32_t*)argument;
                 if (new_freq >= 100 && new_freq <= 10000) { // Reasonable range
+                    uint32_t flags = write_seqlock_irqsave(&timer_clock_lock);
                     timer_state.timer_frequency = new_freq;
+                    write_sequnlock_irqrestore(&timer_clock_lock, flags);
                     kprintf("[TIMER-MODULE] Frequency changed to %d Hz\n", new_freq);
                     return 0;
                 }
@@ -145,7 +152,11 @@ int module_ioctl(uint32_t command, void* argument)
         case 5: // Get statistics
             if (argument) {
                 timer_module_state_t* stats = (timer_module_state_t*)argument;
-                *stats = timer_state;
+                uint32_t sequence;
+                do {
+                    sequence = read_seqbegin(&timer_clock_lock);
+                    *stats = timer_state;
+                } while (read_seqretry(&timer_clock_lock, sequence));
                 return 0;
             }
             break;
@@ -169,18 +180,24 @@ void timer_tick(void)
 {
     if (!timer_module_active) return;
     
+    bool new_second = false;
+    
+    // Interrupts are already off here
+    write_seqlock(&timer_clock_lock);
     timer_state.timer_ticks++;
     timer_state.timer_interrupts++;
     
     // Update uptime every second (assuming 1000Hz timer)
     if (timer_state.timer_ticks % timer_state.timer_frequency == 0) {
         timer_state.uptime_seconds++;
-        
-        // Print uptime every minute
-        if (timer_state.uptime_seconds % 60 == 0) {
-            kprintf("[TIMER-MODULE] System uptime: %d minutes\n", 
-                    timer_state.uptime_seconds / 60);
-        }
+        new_second = true;
+    }
+    write_sequnlock(&timer_clock_lock);
+    
+    // Print uptime every minute
+    if (new_second && timer_state.uptime_seconds % 60 == 0) {
+        kprintf("[TIMER-MODULE] System uptime: %d minutes\n", 
+                timer_state.uptime_seconds / 60);
     }
 }
 
@@ -199,7 +216,15 @@ uint32_t timer_get_uptime(void)
 uint64_t timer_get_ticks(void)
 {
     if (!timer_module_active) return 0;
-    return timer_state.timer_ticks;
+    
+    uint64_t ticks;
+    uint32_t sequence;
+    do {
+        sequence = read_seqbegin(&timer_clock_lock);
+        ticks = timer_state.timer_ticks;
+    } while (read_seqretry(&timer_clock_lock, sequence));
+    
+    return ticks;
 }
 
 /*
@@ -227,7 +252,7 @@ int timer_run_benchmark(void)
     
     kprintf("[TIMER-MODULE] Running performance benchmark...\n");
     
-    uint64_t start_ticks = timer_state.timer_ticks;
+    uint64_t start_ticks = timer_get_ticks();
     
     // Simulate work (simple counting)
     volatile uint32_t counter = 0;
@@ -235,7 +260,7 @@ int timer_run_benchmark(void)
         counter++;
     }
     
-    uint64_t end_ticks = timer_state.timer_ticks;
+    uint64_t end_ticks = timer_get_ticks();
     uint64_t elapsed_ticks = end_ticks - start_ticks;
     
     timer_state.benchmark_operations++;
@@ -37,6 +37,9 @@
 #define RECURSIVE_PD_INDEX      1023        // Recursive page directory mapping
 #define RECURSIVE_PD_ADDR       0xFFFFF000  // Recursive PD virtual address
 #define TEMP_PAGE_ADDR          0xFFFE0000  // Temporary page mapping address
+#define PAGING_IO_WINDOW_START  0xF0000000  // Device MMIO mappings (paging_map_io)
+#define PAGING_IO_WINDOW_END    0xFF000000
+#define PAGING_IO_WINDOW_RANGES 32          // Window ranges remembered for reuse
 
 // =============================================================================
 // Page Table Entry Structures
@@ -154,6 +157,11 @@ void paging_map_range(page_directory_t* dir, uint32_t virtual_start,
                      uint32_t physical_start, uint32_t size, uint32_t flags);
 void paging_unmap_range(page_directory_t* dir, uint32_t virtual_start, uint32_t size);
 
+// Device memory (uncached, carved from the I/O window)
+void* paging_map_io(uint32_t physical_addr, size_t size);
+void* paging_map_ram(uint32_t physical_addr, size_t size); // Cached, same window
+void paging_unmap_io(void* virtual_addr, size_t size);
+
 // =============================================================================
 // Function Prototypes - Address Space Management
 // =============================================================================
@@ -0,0 +1,171 @@
+/*
+ * =============================================================================
+ * CLKernel - Per-CPU Data Header
+ * =============================================================================
+ * File: percpu.h
+ * Purpose: One data area per CPU, reached through the GS segment
+ *
+ * Every CPU loads GS with its own GDT descriptor whose base is its
+ * percpu_t, so this_cpu_*() compiles to a single instruction on %gs:offset
+ * with no CPU lookup and no lock. Counters that every CPU bumps on hot
+ * paths live here instead of in shared statistics structures; readers add
+ * up all CPUs with percpu_sum().
+ *
+ * 64-bit counters are incremented with add/adc on the local CPU: an
+ * interrupt between the two halves saves and restores the carry, so
+ * nested increments are never lost.
+ * =============================================================================
+ */
+
+#ifndef PERCPU_H
+#define PERCPU_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "smp.h"
+
+// =============================================================================
+// Per-CPU Data Area
+// =============================================================================
+
+typedef struct percpu {
+    struct percpu*  self;               // Linear address of this area
+    uint32_t        cpu;                // CPU index (smp_cpu_id)
+
+    // Scheduler
+    uint64_t        sched_context_switches;
+    uint64_t        sched_messages_sent;
+    uint64_t        sched_messages_delivered;
+    uint32_t        sched_message_sequence; // Per-CPU half of message IDs
+    uint64_t        sched_remote_wakeups;   // Actors handed to another CPU's wake list
+    uint64_t        sched_resched_ipis;     // Reschedule IPIs sent
+    uint64_t        sched_resched_coalesced; // Kicks absorbed by an IPI already in flight
+    uint64_t        sched_event_handlers;   // Event actor handler calls
+    uint64_t        sched_deadline_misses;  // Real-time periods and messages past their deadline
+
+    // Kernel heap
+    uint64_t        heap_allocations;
+    uint64_t        heap_frees;
+    uint64_t        heap_bytes_allocated;
+    uint32_t        heap_live_allocations; // Allocations minus frees (wraps per CPU)
+
+    // Interrupts
+    uint64_t        irq_total;
+    uint64_t        irq_exceptions;
+    uint64_t        irq_hardware;
+    uint64_t        irq_async_messages;
+    uint64_t        irq_lapic_timer;
+} __attribute__((aligned(64))) percpu_t;
+
+extern percpu_t percpu_areas[SMP_MAX_CPUS];
+
+#define PERCPU_FIELD_SIZE(field)    sizeof(((percpu_t*)0)->field)
+
+// =============================================================================
+// This-CPU Accessors
+// =============================================================================
+
+// read/write/add_return take 32-bit fields (or pointers); add takes 32- or
+// 64-bit counters, and dec only 32-bit ones (it adds 0xFFFFFFFF)
+
+#ifdef KERNEL_BUILD
+
+#define this_cpu_read(field) __extension__ ({                               \
+    uint32_t __value;                                                       \
+    asm volatile ("movl %%gs:%c1, %0"                                       \
+                  : "=r" (__value) : "i" (offsetof(percpu_t, field)));      \
+    (__typeof__(((percpu_t*)0)->field))__value; })
+
+#define this_cpu_write(field, value)                                        \
+    asm volatile ("movl %0, %%gs:%c1"                                       \
+                  : : "ri" ((uint32_t)(value)), "i" (offsetof(percpu_t, field)) \
+                  : "memory")
+
+#define this_cpu_add(field, value) do {                                     \
+    if (PERCPU_FIELD_SIZE(field) == 8) {                                    \
+        asm volatile ("addl %0, %%gs:%c1\n\t"                               \
+                      "adcl $0, %%gs:%c2"                                   \
+                      : : "ri" ((uint32_t)(value)),                         \
+                          "i" (offsetof(percpu_t, field)),                  \
+                          "i" (offsetof(percpu_t, field) + 4)               \
+                      : "memory", "cc");                                    \
+    } else {                                                                \
+        asm volatile ("addl %0, %%gs:%c1"                                   \
+                      : : "ri" ((uint32_t)(value)),                         \
+                          "i" (offsetof(percpu_t, field))                   \
+                      : "memory", "cc");                                    \
+    }                                                                       \
+} while (0)
+
+// One xadd, so an interrupt handler on this CPU cannot get the same value
+#define this_cpu_add_return(field, value) __extension__ ({                  \
+    uint32_t __value = (uint32_t)(value);                                   \
+    asm volatile ("xaddl %0, %%gs:%c1"                                      \
+                  : "+r" (__value) : "i" (offsetof(percpu_t, field))        \
+                  : "memory", "cc");                                        \
+    (__typeof__(((percpu_t*)0)->field))(__value + (uint32_t)(value)); })
+
+#else
+
+// Host builds (tools/replay) have no GS area: index by the simulated CPU
+#define this_cpu_read(field)            (percpu_areas[smp_cpu_id()].field)
+#define this_cpu_write(field, value)    (percpu_areas[smp_cpu_id()].field = (value))
+#define this_cpu_add(field, value)      (percpu_areas[smp_cpu_id()].field += (value))
+#define this_cpu_add_return(field, value) (percpu_areas[smp_cpu_id()].field += (value))
+
+#endif
+
+#define this_cpu_inc(field)             this_cpu_add(field, 1)
+#define this_cpu_dec(field)             this_cpu_add(field, -1)
+
+// =============================================================================
+// Cross-CPU Readers
+// =============================================================================
+
+/*
+ * Sum a 64-bit counter over every CPU. Each half-pair is read
+ * high-low-high so a carry on the owning CPU is retried, not torn.
+ */
+static inline uint64_t percpu_sum64(uint32_t offset)
+{
+    uint64_t total = 0;
+
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        const volatile uint32_t* halves =
+            (const volatile uint32_t*)((const uint8_t*)&percpu_areas[cpu] + offset);
+        uint32_t high, low;
+        do {
+            high = halves[1];
+            low = halves[0];
+        } while (high != halves[1]);
+
+        total += ((uint64_t)high << 32) | low;
+    }
+
+    return total;
+}
+
+static inline uint32_t percpu_sum32(uint32_t offset)
+{
+    uint32_t total = 0;
+
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        total += *(const volatile uint32_t*)((const uint8_t*)&percpu_areas[cpu] + offset);
+    }
+
+    return total;
+}
+
+#define percpu_sum(field)                                                   \
+    (PERCPU_FIELD_SIZE(field) == 8 ? percpu_sum64(offsetof(percpu_t, field)) \
+                                   : percpu_sum32(offsetof(percpu_t, field)))
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Install and load this CPU's GS descriptor (BSP after gdt_init, APs at entry)
+void percpu_init_cpu(uint32_t cpu);
+
+#endif // PERCPU_H
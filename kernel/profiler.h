@@ -0,0 +1,107 @@
+/*
+ * =============================================================================
+ * CLKernel - Sampling Profiler Header
+ * =============================================================================
+ * File: profiler.h
+ * Purpose: Interrupt-driven statistical profiler for kernel code
+ *
+ * Each profiling interrupt records the interrupted EIP and a short EBP-chain
+ * backtrace into a per-CPU ring. Rings are drained as text lines on the
+ * serial port and symbolized on the host by tools/profiler/symbolize.py
+ * against build/kernel.elf.
+ * =============================================================================
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "idt.h"
+
+// =============================================================================
+// Profiler Configuration Constants
+// =============================================================================
+
+#define PROFILER_MAX_CPUS           1       // Rings, one per CPU (higher CPUs are not sampled)
+#define PROFILER_RING_SIZE          512     // Samples per CPU ring (power of two)
+#define PROFILER_MAX_DEPTH          8       // Return addresses kept per sample
+#define PROFILER_MAX_FRAME_SIZE     0x4000  // Largest plausible stack frame (bytes)
+#define PROFILER_STACK_LIMIT        0x00400000 // End of kernel heap (actor stacks)
+
+// Sample sources
+#define PROFILER_SOURCE_TIMER       0       // Every Nth PIT tick (IRQ0)
+#define PROFILER_SOURCE_RTC         1       // RTC periodic interrupt (IRQ8), 2-8192 Hz
+
+// RTC periodic rates
+#define PROFILER_RTC_MIN_HZ         2
+#define PROFILER_RTC_MAX_HZ         8192
+#define PROFILER_RTC_DEFAULT_HZ     1024
+
+// Sample flags
+#define PROFILER_SAMPLE_TRUNCATED   0x01    // Backtrace longer than PROFILER_MAX_DEPTH
+
+// =============================================================================
+// Profiler Data Structures
+// =============================================================================
+
+typedef struct profiler_sample {
+    uint32_t        timestamp;          // Low 32 bits of the TSC
+    uint32_t        eip;                // Interrupted instruction
+    uint32_t        actor_id;           // Running actor (0 = kernel)
+    uint8_t         depth;              // Valid entries in callers[]
+    uint8_t         flags;              // PROFILER_SAMPLE_*
+    uint16_t        reserved;
+    uint32_t        callers[PROFILER_MAX_DEPTH]; // Return addresses, innermost first
+} profiler_sample_t;
+
+typedef struct profiler_cpu {
+    profiler_sample_t ring[PROFILER_RING_SIZE];
+    volatile uint32_t head;             // Next slot written by the interrupt
+    volatile uint32_t tail;             // Next slot read by the dumper
+
+    // Statistics
+    uint64_t        samples_taken;      // Samples stored in the ring
+    uint64_t        samples_dropped;    // Samples lost to a full ring
+    uint64_t        stacks_truncated;   // Samples with PROFILER_SAMPLE_TRUNCATED
+} profiler_cpu_t;
+
+typedef struct profiler_state {
+    bool            initialized;
+    volatile bool   active;             // Sampling enabled
+    uint8_t         source;             // PROFILER_SOURCE_*
+    uint32_t        rate;               // Tick divisor (TIMER) or Hz (RTC)
+    uint32_t        tick_countdown;     // Timer ticks until the next sample
+    uint64_t        started_at;         // TSC when sampling started
+
+    profiler_cpu_t  cpus[PROFILER_MAX_CPUS];
+} profiler_state_t;
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Profiler lifecycle
+void profiler_init(void);
+int profiler_start(uint8_t source, uint32_t rate);
+void profiler_stop(void);
+void profiler_reset(void);
+bool profiler_is_active(void);
+
+// Interrupt hooks
+void profiler_timer_tick(interrupt_frame_t* frame);
+void profiler_rtc_irq_handler(interrupt_frame_t* frame);
+
+// Output
+uint32_t profiler_dump_serial(uint32_t max_samples);
+void profiler_print_stats(void);
+
+// Internal functions
+void profiler_record_sample(interrupt_frame_t* frame);
+uint8_t profiler_walk_stack(uint32_t ebp, uint32_t* callers, uint8_t* flags);
+bool profiler_is_kernel_text(uint32_t address);
+void profiler_rtc_enable(uint32_t hz);
+void profiler_rtc_disable(void);
+
+#endif // PROFILER_H
@@ -77,7 +77,7 @@
 
 // Resource types
 #define RESOURCE_MEMORY         0   // Memory usage limit
-#define RESOURCE_CPU_TIME       1   // CPU time limit
+#define RESOURCE_CPU_TIME       1   // CPU bandwidth limit (percent)
 #define RESOURCE_FILE_HANDLES   2   // File handle limit
 #define RESOURCE_NETWORK_CONN   3   // Network connection limit
 #define RESOURCE_CHILD_ACTORS   4   // Child actor limit
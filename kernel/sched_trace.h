@@ -0,0 +1,133 @@
+/*
+ * =============================================================================
+ * CLKernel - Scheduler Event Tracer Header
+ * =============================================================================
+ * File: sched_trace.h
+ * Purpose: Tracepoints for context switches, wakeups, blocks and message
+ *          delivery, with per-priority latency histograms built on them
+ *
+ * Every event is stamped with the TSC and appended to the recording CPU's
+ * overwrite-oldest ring. The same tracepoints feed per-CPU log-linear
+ * (HDR-style) histograms, merged when read, of:
+ * - wakeup-to-run latency: ready-queue entry until the actor runs (cycles)
+ * - message queueing delay: enqueue until the recipient receives (cycles)
+ * - timeslice utilization: share of the CPU's timeslice used per run (%)
+ * one set per actor priority class.
+ * =============================================================================
+ */
+
+#ifndef SCHED_TRACE_H
+#define SCHED_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "scheduler.h"
+#include "smp.h"
+
+// =============================================================================
+// Tracer Configuration Constants
+// =============================================================================
+
+#define SCHED_TRACE_RING_SIZE       512     // Events kept per CPU (power of two)
+#define SCHED_TRACE_CLASSES         5       // ACTOR_PRIORITY_CRITICAL..IDLE
+
+// Event types
+#define SCHED_EVENT_SWITCH          0       // actor = next, arg0 = prev, arg1 = prev state
+#define SCHED_EVENT_WAKEUP          1       // actor woken, arg0 = state it left
+#define SCHED_EVENT_BLOCK           2       // actor stopped, arg0 = new state
+#define SCHED_EVENT_DELIVER         3       // actor = recipient, arg0 = sender, arg1 = delay
+
+// Histograms
+#define SCHED_HIST_WAKEUP_LATENCY   0       // Cycles
+#define SCHED_HIST_QUEUE_DELAY      1       // Cycles
+#define SCHED_HIST_SLICE_USE        2       // Percent of a timeslice
+#define SCHED_HIST_COUNT            3
+
+// Log-linear buckets: values below 2^SUB_BITS are exact; above, each power
+// of two is split into 2^SUB_BITS buckets (under 12.5% relative error)
+#define SCHED_HIST_SUB_BITS         3
+#define SCHED_HIST_SUB_BUCKETS      (1 << SCHED_HIST_SUB_BITS)
+#define SCHED_HIST_BUCKETS          ((32 - SCHED_HIST_SUB_BITS + 1) * SCHED_HIST_SUB_BUCKETS)
+
+// =============================================================================
+// Tracer Data Structures
+// =============================================================================
+
+typedef struct sched_trace_event {
+    uint64_t        timestamp;          // TSC
+    uint8_t         type;               // SCHED_EVENT_*
+    uint8_t         priority;           // Priority class of actor_id
+    uint16_t        cpu;                // CPU that recorded the event
+    uint32_t        actor_id;           // Subject actor
+    uint32_t        arg0;               // Event-specific (see SCHED_EVENT_*)
+    uint32_t        arg1;
+} sched_trace_event_t;
+
+typedef struct sched_histogram {
+    uint32_t        buckets[SCHED_HIST_BUCKETS];
+    uint64_t        count;              // Values recorded
+    uint64_t        sum;                // Sum of values (for the mean)
+    uint32_t        max;                // Largest value recorded
+} sched_histogram_t;
+
+/*
+ * Trace state written by one CPU only (with interrupts off), so
+ * tracepoints never share a cache line or lose a count to another CPU
+ */
+typedef struct sched_trace_cpu {
+    // Event ring (overwrites oldest)
+    sched_trace_event_t ring[SCHED_TRACE_RING_SIZE];
+    uint32_t        head;               // Events ever recorded
+    uint32_t        tail;               // First event not yet exported
+
+    // Latency histograms per priority class
+    sched_histogram_t histograms[SCHED_HIST_COUNT][SCHED_TRACE_CLASSES];
+
+    // Event counters
+    uint64_t        events[4];          // Per SCHED_EVENT_* type
+} sched_trace_cpu_t;
+
+typedef struct sched_trace_state {
+    bool            enabled;            // Record events and histograms
+
+    // Per-CPU rings and histograms, allocated as each CPU comes online
+    sched_trace_cpu_t* cpus[SMP_MAX_CPUS];
+
+    // All CPUs' histograms summed by sched_trace_merge (what readers see)
+    sched_histogram_t histograms[SCHED_HIST_COUNT][SCHED_TRACE_CLASSES];
+
+    // TSC calibration against the scheduler tick (for slice utilization)
+    uint64_t        last_tick_tsc;      // TSC at the previous tick
+    uint32_t        cycles_per_tick;    // Smoothed TSC cycles per tick (0 = unknown)
+} sched_trace_state_t;
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Tracer control
+void sched_trace_init(void);
+void sched_trace_enable(bool enabled);
+void sched_trace_reset(void);
+void sched_trace_cpu_online(uint32_t cpu);
+
+// Tracepoints (called by the scheduler)
+void sched_trace_switch(actor_t* prev, actor_t* next);
+void sched_trace_wakeup(actor_t* actor, uint8_t from_state);
+void sched_trace_block(actor_t* actor, uint8_t new_state);
+void sched_trace_ready(actor_t* actor);
+void sched_trace_deliver(actor_t* recipient, message_t* message);
+void sched_trace_tick(void);
+
+// Histograms
+void sched_hist_record(sched_histogram_t* histogram, uint32_t value);
+uint32_t sched_hist_percentile(sched_histogram_t* histogram, uint32_t per_mille);
+sched_histogram_t* sched_trace_get_histogram(uint8_t metric, uint8_t priority);
+void sched_trace_merge(void);
+
+// Output
+void sched_trace_print_histograms(void);
+uint32_t sched_trace_dump_serial(void);
+
+#endif // SCHED_TRACE_H
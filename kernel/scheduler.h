@@ -20,15 +20,50 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "smp.h"
+#include "spinlock.h"
+#include "handle_table.h"
+
 // =============================================================================
 // Constants and Configuration
 // =============================================================================
 
-#define MAX_ACTORS              256     // Maximum number of concurrent actors
+#define MAX_ACTORS              4096    // Actor table limit (grows in pages of 256)
+#define ACTOR_TABLE_PAGES       (MAX_ACTORS / HANDLE_PAGE_SIZE)
 #define MAX_MESSAGES            1024    // Maximum messages in system
+#define SCHED_MESSAGE_BATCH     32      // Messages moved between a CPU's cache and the shared pool
 #define MAX_MESSAGE_SIZE        4096    // Maximum message payload size
 #define ACTOR_STACK_SIZE        8192    // Default actor stack size
-#define SCHEDULER_TIMESLICE_MS  10      // Time slice in milliseconds
+#define SCHEDULER_TICK_US       1000    // Scheduler tick period
+#define SCHEDULER_TIMESLICE_MS  10      // Time slice on tick-driven CPUs (no local timer)
+#define SCHEDULER_TIMESLICE_US  500     // Time slice on CPUs with a local timer (cpu_timer)
+#define SCHEDULER_BANDWIDTH_PERIOD 100  // CPU bandwidth period in ticks
+#define SCHED_RUNQUEUE_SIZE     MAX_ACTORS // Per-CPU run queue slots (power of two, heap-allocated)
+
+// Actor bodies (entry points) do not run yet: scheduler_schedule does not
+// save or load CPU contexts, so "running" an actor only means it is the
+// CPU's current actor. Work that needs code to execute must be driven
+// from the kernel loop until this is 1.
+#define SCHEDULER_RUNS_ACTOR_BODIES 0
+
+// CPU placement
+#define SCHED_AFFINITY_ALL      ((1u << SMP_MAX_CPUS) - 1) // May run on any CPU
+#define SCHED_CPU_NONE          0xFFFFFFFF // No placement hint
+#define ACTOR_PARTNER_SLOTS     4       // Message partners tracked per actor
+#define SCHED_CHATTY_PERCENT    50      // Partner's share of received messages that makes a pair chatty
+#define SCHED_CHATTY_MIN        16      // Messages received before shares are trusted
+#define SCHED_BALANCE_SLACK     1       // Actors a CPU may hold above the mean after rebalancing
+
+// Earliest-deadline-first class (partitioned: each real-time actor is
+// admitted to one CPU, whose reservations may add up to at most 100%)
+#define SCHED_EDF_MAX           64      // Real-time actors per CPU
+#define SCHED_EDF_NONE          0xFFFFFFFF // actor_t.edf_index when not in a heap
+#define SCHED_EDF_UTIL_SCALE    10000   // Utilization units per CPU (0.01% each)
+
+// Run queue membership (actor_t.rq_state)
+#define SCHED_RQ_NONE           0       // Not queued
+#define SCHED_RQ_QUEUED         1       // Has a live entry in some CPU's run queue
+#define SCHED_RQ_STALE          2       // Removed; its entry is dropped when taken
 
 // Actor states
 #define ACTOR_STATE_CREATED     0       // Actor created but not started
@@ -38,6 +73,7 @@
 #define ACTOR_STATE_FINISHED    4       // Completed execution
 #define ACTOR_STATE_ERROR       5       // Actor encountered error
 #define ACTOR_STATE_SUSPENDED   6       // Suspended by system/user
+#define ACTOR_STATE_THROTTLED   7       // CPU quota spent, parked until refill
 
 // Actor priorities
 #define ACTOR_PRIORITY_CRITICAL 0       // System-critical actors
@@ -57,10 +93,28 @@
 // Data Structures
 // =============================================================================
 
+/*
+ * Actor body
+ */
+typedef void (*actor_entry_t)(void);
+
+/*
+ * Messages received from one sender in the current balancing window
+ */
+typedef struct actor_partner {
+    uint32_t        actor_id;           // Sender
+    uint32_t        messages;           // Count (0 = free slot)
+} actor_partner_t;
+
+#ifndef ACTOR_T_DECLARED
+#define ACTOR_T_DECLARED
+typedef struct actor_context actor_t;
+#endif
+
 /*
  * Actor execution context
  */
-typedef struct actor_context {
+struct actor_context {
     uint32_t        actor_id;           // Unique actor identifier
     uint32_t        parent_id;          // Parent actor ID (0 for kernel)
     
@@ -73,7 +127,7 @@ typedef struct actor_context {
     void*           stack_base;         // Stack memory base
     void*           stack_current;      // Current stack pointer
     size_t          stack_size;         // Stack size in bytes
-    void*           entry_point;        // Actor entry function
+    actor_entry_t   entry_point;        // Actor entry function
     void*           user_data;          // User data pointer
     
     // CPU context (for context switching)
@@ -85,6 +139,7 @@ typedef struct actor_context {
     
     // Message handling
     struct message* message_queue;      // Incoming message queue
+    struct message* message_tail;       // Last queued message (O(1) append)
     uint32_t        queue_size;         // Current queue size
     uint32_t        max_queue_size;     // Maximum queue size
     
@@ -95,6 +150,15 @@ typedef struct actor_context {
     uint64_t        creation_time;      // When actor was created
     uint64_t        last_scheduled;     // Last time actor was scheduled
     
+    // CPU bandwidth control (token bucket)
+    uint32_t        cpu_quota;          // Ticks allowed per period (0 = unlimited)
+    uint32_t        cpu_tokens;         // Ticks left in the current period
+    uint32_t        throttle_count;     // Times parked for exceeding quota
+    
+    // Scheduler tracing (TSC stamps, 0 = not pending)
+    uint64_t        ready_since;        // Joined the ready queue
+    uint64_t        run_since;          // Switched in
+    
     // Memory management
     void*           memory_context;     // Actor memory context
     size_t          memory_limit;       // Memory limit for this actor
@@ -109,10 +173,36 @@ typedef struct actor_context {
     uint32_t        anomaly_count;      // Number of anomalies detected
     bool            ai_monitored;       // Whether AI is monitoring this actor
     
+    // Run queue and mailbox synchronization
+    volatile uint32_t rq_state;         // SCHED_RQ_*
+    spinlock_t      mailbox_lock;       // Guards message_queue/tail/queue_size
+    volatile uint32_t last_cpu;         // CPU it last ran on; wakeups are queued there
+    struct actor_context* wake_next;    // Next in a CPU's wake list
+    
+    // CPU placement
+    uint32_t        affinity;           // CPUs it may run on (bit n = CPU n)
+    volatile uint32_t preferred_cpu;    // Rebalancer's pick for the next wakeup
+    actor_partner_t partners[ACTOR_PARTNER_SLOTS]; // Heaviest senders (under mailbox_lock)
+    uint32_t        partner_messages;   // Messages received this window
+    
+    // Earliest-deadline-first class (rt_period 0 = not real-time). Deadlines
+    // are tick counts, compared wrap-safe.
+    uint32_t        rt_budget;          // Ticks reserved per period
+    uint32_t        rt_period;          // Reservation period in ticks
+    uint32_t        rt_runtime;         // Budget left in the current period
+    uint32_t        rt_deadline;        // End of the current period
+    uint32_t        rt_ready_tick;      // Tick it last joined its CPU's heap
+    uint32_t        rt_cpu;             // CPU it was admitted to
+    uint32_t        mailbox_deadline;   // Earliest queued message deadline (0 = none)
+    uint32_t        edf_key;            // Deadline it is ordered by in its CPU's heap
+    uint32_t        edf_index;          // Position in that heap (SCHED_EDF_NONE = not queued)
+    uint32_t        deadline_misses;    // Periods that ended with budget it waited long enough to use
+    uint32_t        message_deadline_misses; // Messages received after their deadline
+    
     // Linked list pointers
     struct actor_context* next;        // Next in ready queue
     struct actor_context* prev;        // Previous in ready queue
-} actor_t;
+};
 
 /*
  * Inter-actor message
@@ -131,6 +221,7 @@ typedef struct message {
     
     uint64_t        timestamp;          // When message was created
     uint64_t        deadline;           // Message deadline (0 = no deadline)
+    uint64_t        queued_at;          // TSC when queued (queueing delay)
     
     // For synchronous messages
     uint32_t        reply_to;           // Actor expecting reply
@@ -140,7 +231,8 @@ typedef struct message {
 } message_t;
 
 /*
- * Scheduler statistics
+ * Scheduler statistics (context_switches and messages_* are per-CPU
+ * counters, summed in by scheduler_get_statistics)
  */
 typedef struct scheduler_stats {
     uint64_t        context_switches;   // Total context switches
@@ -156,31 +248,80 @@ typedef struct scheduler_stats {
     uint32_t        scheduler_overhead; // Scheduler overhead percentage
     uint32_t        deadlocks_detected; // AI-detected deadlocks
     uint32_t        load_balance_actions;// Load balancing actions taken
+    uint32_t        throttled_actors;   // Actors parked on CPU quota
+    uint64_t        throttle_events;    // Total quota exhaustions
 } scheduler_stats_t;
 
+/*
+ * Per-CPU run queue: a Chase-Lev work-stealing deque of ready actors.
+ * Only the owning CPU pushes at bottom; every CPU (the owner included,
+ * so actors keep rotating round-robin) takes from top with a CAS.
+ */
+typedef struct sched_runqueue {
+    volatile uint32_t top;              // Take/steal end (wraps)
+    volatile uint32_t bottom;           // Owner's push end (wraps)
+    actor_t* volatile* slots;           // SCHED_RUNQUEUE_SIZE entries, allocated at online
+} sched_runqueue_t;
+
+/*
+ * Scheduler state owned by one CPU
+ */
+typedef struct sched_cpu {
+    sched_runqueue_t runqueue;          // Ready actors pushed by this CPU
+    actor_t*        current_actor;      // Actor this CPU is running
+    uint32_t        current_timeslice;  // Ticks into the current slice
+    bool            online;             // Taking part in scheduling
+    bool            local_timer;        // Slices end on this CPU's timer, not on ticks
+    
+    // Cross-CPU wakeups: other CPUs push here, the owner moves them to its run queue
+    actor_t* volatile wake_list;        // LIFO of actors woken for this CPU
+    volatile uint32_t resched_pending;  // Reschedule IPI sent and not yet taken
+    volatile bool   idle;               // Halted in scheduler_cpu_idle
+    
+    // Event actors (event_actor.c) whose mailboxes have messages for this CPU
+    struct event_actor* volatile event_list; // LIFO, taken all at once
+    uint32_t        current_event;      // Event actor whose handler is running (0 = none)
+    
+    // Real-time actors admitted here; the ready ones in a min-heap by deadline
+    spinlock_t      edf_lock;           // Guards the heap and member list
+    actor_t*        edf_heap[SCHED_EDF_MAX];
+    uint32_t        edf_count;          // Ready real-time actors (heap size)
+    actor_t*        edf_members[SCHED_EDF_MAX];
+    uint32_t        edf_member_count;
+    uint32_t        edf_utilization;    // Admitted budget/period, SCHED_EDF_UTIL_SCALE = 100%
+    
+    uint64_t        steals;             // Actors taken from other CPUs
+    uint64_t        idle_polls;         // Schedule attempts that found nothing
+    
+    // Free messages cached for this CPU's sends (owner only, interrupts off)
+    message_t*      free_messages;
+    uint32_t        free_message_count;
+} __attribute__((aligned(64))) sched_cpu_t;
+
 /*
  * Main scheduler context
  */
 typedef struct scheduler_context {
     // Actor management
-    actor_t*        actors[MAX_ACTORS]; // Actor table
-    actor_t*        ready_queue;        // Ready to run actors
-    actor_t*        current_actor;      // Currently running actor
-    uint32_t        next_actor_id;      // Next available actor ID
+    handle_table_t  actor_table;        // Actors by generation-tagged ID
+    sched_cpu_t     cpus[SMP_MAX_CPUS]; // Run queues and current actors
     
     // Message system
-    message_t*      free_messages;      // Pool of free message structures
+    spinlock_t      message_lock;       // Guards free_messages
+    message_t*      free_messages;      // Free messages no CPU has cached
+    uint32_t        free_message_count;
     message_t*      message_pool;       // Message memory pool
     uint32_t        message_count;      // Current message count
     
     // Scheduling state
     bool            scheduler_enabled;  // Whether scheduler is running
-    uint32_t        tick_count;         // Scheduler tick counter
-    uint32_t        current_timeslice;  // Current time slice counter
+    volatile uint32_t tick_count;       // Scheduler tick counter (BSP timer)
+    uint32_t        quota_actors;       // Actors with a CPU quota set
     
     // Statistics and monitoring
     scheduler_stats_t statistics;       // Scheduler statistics
     bool            ai_supervision;     // AI supervision enabled
+    volatile bool   ai_analysis_pending;// Set by timer, consumed by AI actor
     
     // Performance tuning
     uint32_t        context_switch_time;// Average context switch time
@@ -217,6 +358,51 @@ void scheduler_yield(void);
  */
 void scheduler_timer_handler(void);
 
+/*
+ * This CPU's share of a tick: charge the running actor, end its slice
+ */
+void scheduler_cpu_tick(void);
+
+/*
+ * The local timer ended this CPU's slice: rotate to the next ready actor
+ */
+void scheduler_timeslice_expired(void);
+
+/*
+ * Slice length on the running CPU, in microseconds
+ */
+uint32_t scheduler_timeslice_us(void);
+
+/*
+ * Bring a CPU's run queue into scheduling (false if it cannot be allocated)
+ */
+bool scheduler_cpu_online(uint32_t cpu);
+
+/*
+ * Per-CPU scheduling loop for application processors (never returns)
+ */
+void scheduler_cpu_loop(void);
+
+/*
+ * Halt this CPU until it has work (or any interrupt arrives)
+ */
+void scheduler_cpu_idle(void);
+
+/*
+ * Make sure a halted CPU notices work queued for it
+ */
+void scheduler_kick_cpu(uint32_t cpu);
+
+/*
+ * Reschedule IPI handler: pick up actors other CPUs woke for this one
+ */
+void scheduler_reschedule_interrupt(void);
+
+/*
+ * Scheduler state of the running CPU
+ */
+sched_cpu_t* scheduler_this_cpu(void);
+
 // =============================================================================
 // Actor Management Functions
 // =============================================================================
@@ -224,7 +410,7 @@ void scheduler_timer_handler(void);
 /*
  * Create a new actor
  */
-uint32_t actor_create(void* entry_point, void* user_data, 
+uint32_t actor_create(actor_entry_t entry_point, void* user_data, 
                       uint8_t priority, size_t stack_size);
 
 /*
@@ -248,10 +434,42 @@ bool actor_suspend(uint32_t actor_id);
 bool actor_resume(uint32_t actor_id);
 
 /*
- * Get actor by ID
+ * Get actor by ID (NULL once it has terminated, even if its slot is reused)
  */
 actor_t* actor_get(uint32_t actor_id);
 
+/*
+ * Live actor at or after table index *index, advancing *index past it
+ */
+actor_t* actor_next(uint32_t* index);
+
+/*
+ * Limit an actor to a percentage of each bandwidth period (100 = unlimited)
+ */
+bool actor_set_cpu_quota(uint32_t actor_id, uint32_t percent);
+
+/*
+ * Restrict an actor to a set of CPUs (bit n = CPU n)
+ */
+bool actor_set_affinity(uint32_t actor_id, uint32_t mask);
+
+/*
+ * Put an actor in the earliest-deadline-first class with a reservation of
+ * budget ticks every period ticks (budget 0 = back to the normal class).
+ * Fails if no allowed CPU has that much utilization left.
+ */
+bool actor_set_realtime(uint32_t actor_id, uint32_t budget, uint32_t period);
+
+/*
+ * Park an actor that has spent its CPU quota
+ */
+void scheduler_throttle_actor(actor_t* actor);
+
+/*
+ * Refill CPU quotas and unpark throttled actors (once per period)
+ */
+void scheduler_refill_cpu_quotas(void);
+
 /*
  * Get current running actor
  */
@@ -267,6 +485,13 @@ actor_t* actor_get_current(void);
 bool message_send_async(uint32_t recipient_id, uint8_t type, 
                        void* payload, size_t payload_size);
 
+/*
+ * Send asynchronous message that should be handled within deadline_ticks.
+ * A real-time recipient is scheduled by it while it waits in the mailbox.
+ */
+bool message_send_deadline(uint32_t recipient_id, uint8_t type,
+                           void* payload, size_t payload_size, uint32_t deadline_ticks);
+
 /*
  * Send synchronous message (blocks until reply)
  */
@@ -363,7 +588,7 @@ uint32_t actor_get_cpu_usage(uint32_t actor_id);
 // =============================================================================
 
 /*
- * AI-based load balancing
+ * Periodic rebalancer: co-locate chatty actor pairs, spread the rest
  */
 void scheduler_ai_balance_load(void);
 
@@ -377,6 +602,11 @@ bool scheduler_ai_detect_deadlock(void);
  */
 void scheduler_ai_analyze_actors(void);
 
+/*
+ * Consume the timer's request for actor behavior analysis
+ */
+bool scheduler_ai_analysis_due(void);
+
 /*
  * AI-optimized scheduling decisions
  */
@@ -406,12 +636,12 @@ void scheduler_benchmark_performance(void);
 // =============================================================================
 
 /*
- * Check if actor is valid
+ * Check if actor is valid (one slot load and a generation compare)
  */
 static inline bool actor_is_valid(uint32_t actor_id)
 {
     extern scheduler_t kernel_scheduler;
-    return (actor_id < MAX_ACTORS && kernel_scheduler.actors[actor_id] != NULL);
+    return handle_table_lookup(&kernel_scheduler.actor_table, actor_id) != NULL;
 }
 
 /*
@@ -421,9 +651,9 @@ static inline const char* actor_state_name(uint8_t state)
 {
     const char* states[] = {
         "CREATED", "READY", "RUNNING", "BLOCKED", 
-        "FINISHED", "ERROR", "SUSPENDED"
+        "FINISHED", "ERROR", "SUSPENDED", "THROTTLED"
     };
-    return (state < 7) ? states[state] : "UNKNOWN";
+    return (state < 8) ? states[state] : "UNKNOWN";
 }
 
 /*
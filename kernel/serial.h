@@ -0,0 +1,39 @@
+/*
+ * =============================================================================
+ * CLKernel - Serial Port Header
+ * =============================================================================
+ * File: serial.h
+ * Purpose: 16550 UART driver for machine-readable kernel output
+ * =============================================================================
+ */
+
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Serial port base addresses
+#define SERIAL_COM1             0x3F8   // COM1 (QEMU -serial stdio)
+#define SERIAL_COM2             0x2F8   // COM2
+
+// UART register offsets
+#define SERIAL_REG_DATA         0       // Data register (DLAB=0)
+#define SERIAL_REG_INT_ENABLE   1       // Interrupt enable (DLAB=0)
+#define SERIAL_REG_FIFO_CTRL    2       // FIFO control
+#define SERIAL_REG_LINE_CTRL    3       // Line control
+#define SERIAL_REG_MODEM_CTRL   4       // Modem control
+#define SERIAL_REG_LINE_STATUS  5       // Line status
+
+#define SERIAL_LSR_THR_EMPTY    0x20    // Transmit holding register empty
+
+// Function prototypes
+bool serial_init(uint16_t port);
+bool serial_is_ready(void);
+bool serial_transmit_empty(void);
+void serial_write_char(char c);
+void serial_write(const void* data, size_t length);
+void serial_write_string(const char* str);
+
+#endif // SERIAL_H
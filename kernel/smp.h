@@ -0,0 +1,88 @@
+/*
+ * =============================================================================
+ * CLKernel - Symmetric Multiprocessing Header
+ * =============================================================================
+ * File: smp.h
+ * Purpose: Application processor bring-up and CPU identification
+ *
+ * The BSP copies a real-mode trampoline below 1MB and wakes each CPU the
+ * MADT or MP table lists with INIT-SIPI-SIPI (broadcast if neither exists). Each AP claims the next CPU index, switches to
+ * protected mode (and the BSP's page tables), loads the kernel GDT/IDT and
+ * enters the scheduler's per-CPU loop, where it runs or steals actors.
+ * =============================================================================
+ */
+
+#ifndef SMP_H
+#define SMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// SMP Configuration Constants
+// =============================================================================
+
+#define SMP_MAX_CPUS                8       // CPUs the kernel will bring online
+#define SMP_AP_STACK_SIZE           8192    // Boot/idle stack per AP
+#define SMP_TRAMPOLINE_ADDR         0x8000  // Real-mode entry (SIPI vector 0x08)
+#define SMP_TRAMPOLINE_PARAMS       0x8F00  // smp_trampoline_params_t for the APs
+#define SMP_AP_WAIT_MS              100     // How long the BSP waits for APs
+
+// =============================================================================
+// SMP Data Structures
+// =============================================================================
+
+/*
+ * Handed to the trampoline at SMP_TRAMPOLINE_PARAMS (offsets are used by
+ * ap_trampoline.asm)
+ */
+typedef struct smp_trampoline_params {
+    uint32_t        cr3;                // Page directory (0 = paging off)
+    uint32_t        entry;              // smp_ap_main
+    uint32_t        stacks;             // uint32_t[SMP_MAX_CPUS] stack tops
+    volatile uint32_t next_cpu;         // Next CPU index to hand out
+} smp_trampoline_params_t;
+
+/*
+ * One processor
+ */
+typedef struct smp_cpu {
+    uint32_t        index;              // Kernel CPU index (0 = BSP)
+    uint8_t         apic_id;            // Local APIC ID
+    volatile bool   online;             // Running the scheduler loop
+    void*           stack;              // AP boot/idle stack (NULL for the BSP)
+} smp_cpu_t;
+
+typedef struct smp_state {
+    smp_cpu_t       cpus[SMP_MAX_CPUS];
+    volatile uint32_t cpu_count;        // CPUs online
+    uint8_t         apic_to_cpu[256];   // APIC ID -> CPU index
+    bool            enabled;            // Local APIC found and APs started
+} smp_state_t;
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Bring-up (BSP, after the scheduler is initialized)
+void smp_init(void);
+void smp_ap_main(uint32_t cpu);
+
+// CPU identification
+uint32_t smp_cpu_id(void);
+uint32_t smp_cpu_count(void);
+smp_cpu_t* smp_get_cpu(uint32_t cpu);
+
+// Local interrupt control (returns/takes the saved EFLAGS)
+uint32_t cpu_irq_save(void);
+void cpu_irq_restore(uint32_t flags);
+void cpu_relax(void);
+void cpu_halt(void);
+
+// Cross-CPU scheduling: kick a CPU out of cpu_halt
+bool smp_send_reschedule(uint32_t cpu);
+
+// Diagnostics
+void smp_print_status(void);
+
+#endif // SMP_H
@@ -0,0 +1,389 @@
+/*
+ * =============================================================================
+ * CLKernel - Synchronization Primitives Header
+ * =============================================================================
+ * File: spinlock.h
+ * Purpose: Ticket spinlocks, reader-writer locks and seqlocks
+ *
+ * All three spin; none of them sleeps. Any lock that an interrupt handler
+ * may take must be taken with interrupts off everywhere else (the
+ * *_irqsave variants), or the handler can spin forever on a lock its own
+ * CPU holds.
+ *
+ * - spinlock_t: FIFO ticket lock. Waiters are served in arrival order, so
+ *   no CPU starves under contention.
+ * - rwlock_t:   any number of readers or one writer. A waiting writer
+ *   blocks new readers, so writers are not starved by a stream of them.
+ * - seqlock_t:  for read-mostly data such as statistics and clock state.
+ *   Readers take no lock at all; they retry if a writer ran meanwhile:
+ *
+ *       uint32_t seq;
+ *       do {
+ *           seq = read_seqbegin(&lock);
+ *           copy = shared;
+ *       } while (read_seqretry(&lock, seq));
+ *
+ * Building with LOCKSTAT=1 (CONFIG_LOCK_STATS) adds per-lock acquisition
+ * and contention counters; locks set up with the *_init functions are
+ * listed by lock_print_statistics().
+ * =============================================================================
+ */
+
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "smp.h"
+
+#ifdef CONFIG_LOCK_STATS
+#include "kernel.h"
+#endif
+
+// =============================================================================
+// Lock Data Structures
+// =============================================================================
+
+/*
+ * Contention statistics (CONFIG_LOCK_STATS). Updated by the lock holder,
+ * except for rwlock reader counts, which are updated atomically.
+ */
+typedef struct lock_stats {
+    const char*     name;               // Lock name (string literal)
+    uint32_t        acquisitions;       // Times taken
+    uint32_t        contended;          // Times a CPU had to wait
+    uint64_t        spin_cycles;        // TSC cycles spent waiting
+    uint32_t        max_spin_cycles;    // Longest single wait
+    struct lock_stats* next;            // Registered locks list
+} lock_stats_t;
+
+// Ticket halves share one word so trylock can claim a ticket with one CAS
+typedef union spinlock_tickets {
+    uint32_t        word;
+    struct {
+        uint16_t    owner;              // Ticket being served
+        uint16_t    next;               // Next ticket to hand out
+    } half;
+} spinlock_tickets_t;
+
+typedef struct spinlock {
+    volatile spinlock_tickets_t tickets;
+#ifdef CONFIG_LOCK_STATS
+    lock_stats_t    stats;
+#endif
+} spinlock_t;
+
+// rwlock_t state: reader count in the low bits plus two writer flags
+#define RWLOCK_WRITER               0x80000000  // A writer holds the lock
+#define RWLOCK_WRITER_WAITING       0x40000000  // A writer is waiting; no new readers
+#define RWLOCK_READERS_MASK         0x3FFFFFFF
+
+typedef struct rwlock {
+    volatile uint32_t state;
+#ifdef CONFIG_LOCK_STATS
+    lock_stats_t    stats;
+#endif
+} rwlock_t;
+
+typedef struct seqlock {
+    volatile uint32_t sequence;         // Odd while a writer is inside
+    spinlock_t      lock;               // Serializes writers
+} seqlock_t;
+
+#ifdef CONFIG_LOCK_STATS
+#define LOCK_STATS_INIT(lock_name)  , .stats = { .name = (lock_name) }
+#else
+#define LOCK_STATS_INIT(lock_name)
+#endif
+
+// Static initializers (such locks are not listed by lock_print_statistics)
+#define SPINLOCK_INIT(name)         { .tickets = { .word = 0 } LOCK_STATS_INIT(name) }
+#define RWLOCK_INIT(name)           { .state = 0 LOCK_STATS_INIT(name) }
+#define SEQLOCK_INIT(name)          { .sequence = 0, .lock = SPINLOCK_INIT(name) }
+
+#define lock_barrier()              asm volatile ("" : : : "memory")
+
+// =============================================================================
+// Function Declarations
+// =============================================================================
+
+// Setup (names must outlive the lock)
+void spinlock_init(spinlock_t* lock, const char* name);
+void rwlock_init(rwlock_t* lock, const char* name);
+void seqlock_init(seqlock_t* lock, const char* name);
+
+// Contention statistics (empty unless built with CONFIG_LOCK_STATS)
+void lock_stats_register(lock_stats_t* stats, const char* name);
+void lock_print_statistics(void);
+
+// =============================================================================
+// Contention Accounting
+// =============================================================================
+
+#ifdef CONFIG_LOCK_STATS
+
+static inline uint64_t lock_stats_wait_begin(void)
+{
+    return read_timestamp_counter();
+}
+
+static inline void lock_stats_wait_end(lock_stats_t* stats, uint64_t start)
+{
+    uint64_t cycles = read_timestamp_counter() - start;
+
+    stats->contended++;
+    stats->spin_cycles += cycles;
+    if (cycles > stats->max_spin_cycles) {
+        stats->max_spin_cycles = cycles > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)cycles;
+    }
+}
+
+#endif
+
+// =============================================================================
+// Ticket Spinlock
+// =============================================================================
+
+static inline void spin_lock(spinlock_t* lock)
+{
+    uint16_t ticket = __sync_fetch_and_add(&lock->tickets.half.next, 1);
+
+    if (lock->tickets.half.owner != ticket) {
+#ifdef CONFIG_LOCK_STATS
+        uint64_t start = lock_stats_wait_begin();
+#endif
+        while (lock->tickets.half.owner != ticket) {
+            cpu_relax();
+        }
+#ifdef CONFIG_LOCK_STATS
+        lock_stats_wait_end(&lock->stats, start);
+#endif
+    }
+    lock_barrier();
+
+#ifdef CONFIG_LOCK_STATS
+    lock->stats.acquisitions++;
+#endif
+}
+
+/*
+ * Take the lock only if nobody holds or waits for it
+ */
+static inline bool spin_trylock(spinlock_t* lock)
+{
+    spinlock_tickets_t old, new;
+
+    old.word = lock->tickets.word;
+    if (old.half.owner != old.half.next) {
+        return false;
+    }
+
+    new = old;
+    new.half.next++;
+    if (!__sync_bool_compare_and_swap(&lock->tickets.word, old.word, new.word)) {
+        return false;
+    }
+
+#ifdef CONFIG_LOCK_STATS
+    lock->stats.acquisitions++;
+#endif
+    return true;
+}
+
+static inline void spin_unlock(spinlock_t* lock)
+{
+    lock_barrier();
+    // Only the holder writes owner, so a plain store hands the lock on
+    lock->tickets.half.owner = lock->tickets.half.owner + 1;
+}
+
+static inline bool spin_is_locked(spinlock_t* lock)
+{
+    spinlock_tickets_t tickets;
+    tickets.word = lock->tickets.word;
+    return tickets.half.owner != tickets.half.next;
+}
+
+static inline uint32_t spin_lock_irqsave(spinlock_t* lock)
+{
+    uint32_t flags = cpu_irq_save();
+    spin_lock(lock);
+    return flags;
+}
+
+static inline void spin_unlock_irqrestore(spinlock_t* lock, uint32_t flags)
+{
+    spin_unlock(lock);
+    cpu_irq_restore(flags);
+}
+
+// =============================================================================
+// Reader-Writer Lock
+// =============================================================================
+
+static inline void read_lock(rwlock_t* lock)
+{
+#ifdef CONFIG_LOCK_STATS
+    bool waited = false;
+#endif
+
+    for (;;) {
+        uint32_t state = lock->state;
+        if (!(state & (RWLOCK_WRITER | RWLOCK_WRITER_WAITING)) &&
+            __sync_bool_compare_and_swap(&lock->state, state, state + 1)) {
+            break;
+        }
+#ifdef CONFIG_LOCK_STATS
+        waited = true;
+#endif
+        cpu_relax();
+    }
+    lock_barrier();
+
+#ifdef CONFIG_LOCK_STATS
+    // Readers hold the lock together: atomic counts, and no wait cycles
+    __sync_fetch_and_add(&lock->stats.acquisitions, 1);
+    if (waited) {
+        __sync_fetch_and_add(&lock->stats.contended, 1);
+    }
+#endif
+}
+
+static inline void read_unlock(rwlock_t* lock)
+{
+    lock_barrier();
+    __sync_fetch_and_sub(&lock->state, 1);
+}
+
+static inline void write_lock(rwlock_t* lock)
+{
+#ifdef CONFIG_LOCK_STATS
+    bool waited = false;
+    uint64_t start = 0;
+#endif
+
+    for (;;) {
+        uint32_t state = lock->state;
+        if ((state & ~RWLOCK_WRITER_WAITING) == 0) {
+            // Free (possibly with our own waiting flag): take it, clearing the flag
+            if (__sync_bool_compare_and_swap(&lock->state, state, RWLOCK_WRITER)) {
+                break;
+            }
+            continue;
+        }
+        if (!(state & RWLOCK_WRITER_WAITING)) {
+            // Hold off new readers until the current ones drain
+            __sync_bool_compare_and_swap(&lock->state, state, state | RWLOCK_WRITER_WAITING);
+        }
+#ifdef CONFIG_LOCK_STATS
+        if (!waited) {
+            waited = true;
+            start = lock_stats_wait_begin();
+        }
+#endif
+        cpu_relax();
+    }
+    lock_barrier();
+
+#ifdef CONFIG_LOCK_STATS
+    if (waited) {
+        lock_stats_wait_end(&lock->stats, start);
+    }
+    lock->stats.acquisitions++;
+#endif
+}
+
+static inline void write_unlock(rwlock_t* lock)
+{
+    lock_barrier();
+    // Keep a flag set by another waiting writer
+    __sync_fetch_and_and(&lock->state, ~RWLOCK_WRITER);
+}
+
+static inline uint32_t read_lock_irqsave(rwlock_t* lock)
+{
+    uint32_t flags = cpu_irq_save();
+    read_lock(lock);
+    return flags;
+}
+
+static inline void read_unlock_irqrestore(rwlock_t* lock, uint32_t flags)
+{
+    read_unlock(lock);
+    cpu_irq_restore(flags);
+}
+
+static inline uint32_t write_lock_irqsave(rwlock_t* lock)
+{
+    uint32_t flags = cpu_irq_save();
+    write_lock(lock);
+    return flags;
+}
+
+static inline void write_unlock_irqrestore(rwlock_t* lock, uint32_t flags)
+{
+    write_unlock(lock);
+    cpu_irq_restore(flags);
+}
+
+// =============================================================================
+// Sequence Lock
+// =============================================================================
+
+/*
+ * Start a read section; waits out a writer that is already inside
+ */
+static inline uint32_t read_seqbegin(const seqlock_t* lock)
+{
+    uint32_t sequence;
+
+    while ((sequence = lock->sequence) & 1) {
+        cpu_relax();
+    }
+    // x86 does not reorder loads with loads; only the compiler must not
+    lock_barrier();
+    return sequence;
+}
+
+/*
+ * True if a writer ran since read_seqbegin and the data must be re-read
+ */
+static inline bool read_seqretry(const seqlock_t* lock, uint32_t start)
+{
+    lock_barrier();
+    return lock->sequence != start;
+}
+
+static inline void write_seqlock(seqlock_t* lock)
+{
+    spin_lock(&lock->lock);
+    lock->sequence++;
+    lock_barrier();
+}
+
+static inline void write_sequnlock(seqlock_t* lock)
+{
+    lock_barrier();
+    lock->sequence++;
+    spin_unlock(&lock->lock);
+}
+
+/*
+ * Writers that can race with readers in interrupt handlers on the same
+ * CPU must keep interrupts off, or the reader spins on an odd sequence
+ */
+static inline uint32_t write_seqlock_irqsave(seqlock_t* lock)
+{
+    uint32_t flags = cpu_irq_save();
+    write_seqlock(lock);
+    return flags;
+}
+
+static inline void write_sequnlock_irqrestore(seqlock_t* lock, uint32_t flags)
+{
+    write_sequnlock(lock);
+    cpu_irq_restore(flags);
+}
+
+#endif // SPINLOCK_H
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+# =============================================================================
+# CLKernel - Metrics Snapshot Decoder
+# =============================================================================
+# File: metrics_decode.py
+# Purpose: Turn metrics_dump_serial() output (schema + binary snapshot) into
+#          named values, as a table or one JSON object per snapshot
+#
+# Usage:
+#   metrics_decode.py [--json] [--prefix sched.] serial.log
+#
+# The capture must be the raw serial byte stream (e.g. QEMU
+# -serial file:build/serial.log). Every METRICS-BEGIN block is decoded with
+# the most recent METRICS-SCHEMA seen before it; the snapshot format is
+# described in kernel/metrics.h.
+# =============================================================================
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+HEADER = struct.Struct("<IHHIIIIQ")     # metrics_snapshot_header_t
+RECORD = struct.Struct("<HBBQ")         # metrics_record_t
+BUCKET = struct.Struct("<HI")           # metrics_bucket_t
+HIST_TAIL = struct.Struct("<QI")        # histogram sum, max
+
+METRICS_MAGIC = 0x4D4B4C43
+METRICS_FLAG_TRUNCATED = 0x01
+TYPES = ["counter", "gauge", "histogram"]
+HIST_SUB_BITS = 3                       # SCHED_HIST_SUB_BITS
+
+SCHEMA = re.compile(rb"METRICS-SCHEMA schema=(\d+) count=\d+\r?\n")
+METRIC = re.compile(rb"METRIC (\d+) (\w+) (\S+)\r?\n")
+BEGIN = re.compile(rb"METRICS-BEGIN bytes=(\d+)\r?\n")
+
+
+def bucket_limit(index):
+    """Largest value in a histogram bucket (sched_hist_bucket_limit)."""
+    sub = 1 << HIST_SUB_BITS
+    if index < sub:
+        return index
+    shift = index // sub - 1
+    return ((sub + index % sub) << shift) + (1 << shift) - 1
+
+
+def percentile(buckets, count, maximum, per_mille):
+    target = max(1, (count * per_mille + 999) // 1000)
+    seen = 0
+    for index, n in sorted(buckets):
+        seen += n
+        if seen >= target:
+            return min(bucket_limit(index), maximum)
+    return maximum
+
+
+def decode_snapshot(blob, names):
+    magic, version, count, sequence, schema, length, flags, timestamp = HEADER.unpack_from(blob)
+    if magic != METRICS_MAGIC:
+        raise ValueError("bad snapshot magic 0x%08x" % magic)
+    if flags & METRICS_FLAG_TRUNCATED:
+        print("warning: snapshot %d was truncated" % sequence, file=sys.stderr)
+
+    values = {}
+    offset = HEADER.size
+    for _ in range(count):
+        metric_id, metric_type, bucket_count, value = RECORD.unpack_from(blob, offset)
+        offset += RECORD.size
+        name = names.get(metric_id, "metric%d" % metric_id)
+
+        if TYPES[metric_type] != "histogram":
+            values[name] = value
+            continue
+
+        total, maximum = HIST_TAIL.unpack_from(blob, offset)
+        offset += HIST_TAIL.size
+        buckets = []
+        for _ in range(bucket_count):
+            buckets.append(BUCKET.unpack_from(blob, offset))
+            offset += BUCKET.size
+        values[name] = {
+            "count": value,
+            "mean": total // value if value else 0,
+            "p50": percentile(buckets, value, maximum, 500),
+            "p99": percentile(buckets, value, maximum, 990),
+            "max": maximum,
+        }
+
+    return {"sequence": sequence, "schema": schema, "timestamp": timestamp, "values": values}
+
+
+def read_snapshots(data):
+    names = {}
+    position = 0
+    while True:
+        schema = SCHEMA.search(data, position)
+        begin = BEGIN.search(data, position)
+        if not begin:
+            return
+        if schema and schema.start() < begin.start():
+            names = {}
+            for match in METRIC.finditer(data, schema.end(), begin.start()):
+                names[int(match.group(1))] = match.group(3).decode()
+
+        length = int(begin.group(1))
+        blob = data[begin.end():begin.end() + length]
+        if len(blob) < length:
+            print("warning: truncated METRICS block", file=sys.stderr)
+            return
+        yield decode_snapshot(blob, names)
+        position = begin.end() + length
+
+
+def print_table(snapshot, prefix):
+    print("snapshot %d (schema %d, tsc %d)" % (
+        snapshot["sequence"], snapshot["schema"], snapshot["timestamp"]))
+    for name, value in snapshot["values"].items():
+        if not name.startswith(prefix):
+            continue
+        if isinstance(value, dict):
+            if not value["count"]:
+                continue
+            print("  %-36s n=%d mean=%d p50=%d p99=%d max=%d" % (
+                name, value["count"], value["mean"], value["p50"], value["p99"], value["max"]))
+        else:
+            print("  %-36s %d" % (name, value))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode CLKernel metrics snapshots")
+    parser.add_argument("log", help="raw serial capture")
+    parser.add_argument("--json", action="store_true", help="one JSON object per snapshot")
+    parser.add_argument("--prefix", default="", help="only metrics whose name starts with this")
+    args = parser.parse_args()
+
+    with open(args.log, "rb") as capture:
+        snapshots = list(read_snapshots(capture.read()))
+    if not snapshots:
+        sys.exit("no metrics snapshots found")
+
+    for snapshot in snapshots:
+        if args.json:
+            snapshot["values"] = {name: value for name, value in snapshot["values"].items()
+                                  if name.startswith(args.prefix)}
+            print(json.dumps(snapshot))
+        else:
+            print_table(snapshot, args.prefix)
+
+
+if __name__ == "__main__":
+    main()
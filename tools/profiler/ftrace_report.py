@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+# =============================================================================
+# CLKernel - Function Trace Decoder
+# =============================================================================
+# File: ftrace_report.py
+# Purpose: Decode ftrace_dump_serial() records from a serial capture into
+#          per-function latency tables and call-tree latency breakdowns
+#
+# Usage:
+#   ftrace_report.py [--elf build/kernel.elf] [--nm nm] [--subsystem NAME]
+#                    [--tree FUNCTION [--depth N]] serial.log
+#
+# The capture must be the raw serial byte stream (e.g. QEMU
+# -serial file:build/serial.log): records are binary ftrace_record_t
+# (kernel/ftrace.h) framed by FTRACE-BEGIN / FTRACE-END lines. Times are
+# in TSC cycles.
+#
+#   ftrace_report.py --tree message_send_async serial.log
+#
+# prints the average cost of message_send_async split into its callees
+# (actor_add_message, scheduler_add_to_ready_queue, ...).
+# =============================================================================
+
+import argparse
+import collections
+import re
+import struct
+import sys
+
+from symbolize import load_symbols, make_resolver
+
+RECORD = struct.Struct("<QIIIBBH")      # ftrace_record_t
+FTRACE_EVENT_ENTER = 0
+FTRACE_EVENT_EXIT = 1
+SUBSYSTEMS = ["sched", "heap", "module", "ipc"]
+
+BEGIN = re.compile(rb"FTRACE-BEGIN records=(\d+) lost=(\d+)\r?\n")
+
+
+class Call:
+    __slots__ = ("function", "start", "inclusive", "children")
+
+    def __init__(self, function, start):
+        self.function = function
+        self.start = start
+        self.inclusive = 0
+        self.children = []
+
+    @property
+    def exclusive(self):
+        return self.inclusive - sum(child.inclusive for child in self.children)
+
+
+def read_records(data):
+    """Yield decoded records from every FTRACE block in a raw capture."""
+    for match in BEGIN.finditer(data):
+        count = int(match.group(1))
+        if int(match.group(2)):
+            print("warning: %s records were overwritten before the dump"
+                  % match.group(2).decode(), file=sys.stderr)
+        offset = match.end()
+        for _ in range(count):
+            if offset + RECORD.size > len(data):
+                print("warning: truncated FTRACE block", file=sys.stderr)
+                return
+            yield RECORD.unpack_from(data, offset)
+            offset += RECORD.size
+
+
+def build_calls(records, subsystems):
+    """Pair entries with exits per CPU; return completed top-level calls."""
+    stacks = collections.defaultdict(list)
+    roots = []
+    for timestamp, function, call_site, actor, event, subsystem, cpu in records:
+        if subsystem not in subsystems:
+            continue
+        stack = stacks[cpu]
+        if event == FTRACE_EVENT_ENTER:
+            stack.append(Call(function, timestamp))
+            continue
+
+        # Exit: unwind to the matching entry (frames above it lost their exit)
+        depth = len(stack) - 1
+        while depth >= 0 and stack[depth].function != function:
+            depth -= 1
+        if depth < 0:
+            continue
+        while len(stack) > depth:
+            call = stack.pop()
+            call.inclusive = timestamp - call.start
+            (stack[-1].children if stack else roots).append(call)
+    return roots
+
+
+def walk(calls):
+    for call in calls:
+        yield call
+        yield from walk(call.children)
+
+
+def print_table(roots, resolve):
+    stats = collections.defaultdict(lambda: [0, 0, 0, 0])
+    for call in walk(roots):
+        entry = stats[call.function]
+        entry[0] += 1
+        entry[1] += call.inclusive
+        entry[2] += call.exclusive
+        entry[3] = max(entry[3], call.inclusive)
+
+    print("%8s %12s %12s %10s %10s  %s" % ("calls", "total", "self", "avg", "max", "function"))
+    for function, (calls, total, self_time, worst) in sorted(
+            stats.items(), key=lambda item: -item[1][1]):
+        print("%8d %12d %12d %10d %10d  %s" % (
+            calls, total, self_time, total // calls, worst, resolve(function)))
+
+
+def print_tree(roots, resolve, name, max_depth):
+    paths = collections.defaultdict(lambda: [0, 0])
+    instances = 0
+
+    def merge(call, path, depth):
+        key = path + (resolve(call.function),)
+        paths[key][0] += 1
+        paths[key][1] += call.inclusive
+        if depth < max_depth:
+            for child in call.children:
+                merge(child, key, depth + 1)
+
+    for call in walk(roots):
+        if resolve(call.function) == name:
+            merge(call, (), 0)
+            instances += 1
+
+    if not instances:
+        sys.exit("no completed calls to %s" % name)
+
+    children = collections.defaultdict(list)
+    for path in paths:
+        if len(path) > 1:
+            children[path[:-1]].append(path)
+
+    root_total = paths[(name,)][1]
+
+    def show(path):
+        calls, total = paths[path]
+        print("%10d %6.1f%% %6.2fx  %s%s" % (
+            total // instances, 100.0 * total / root_total, calls / instances,
+            "  " * (len(path) - 1), path[-1]))
+        for child in sorted(children[path], key=lambda key: -paths[key][1]):
+            show(child)
+
+    print("%10s %7s %7s  %s" % ("avg", "share", "calls", "function"))
+    show((name,))
+    print("\n%d calls to %s (cycles per call)" % (instances, name))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode CLKernel function traces")
+    parser.add_argument("log", help="raw serial capture")
+    parser.add_argument("--elf", default="build/kernel.elf", help="kernel ELF with symbols")
+    parser.add_argument("--nm", default="nm", help="nm binary (e.g. i686-elf-nm)")
+    parser.add_argument("--subsystem", action="append", choices=SUBSYSTEMS,
+                        help="only these subsystems (repeatable)")
+    parser.add_argument("--tree", metavar="FUNCTION", help="latency breakdown below FUNCTION")
+    parser.add_argument("--depth", type=int, default=4, help="tree depth (default 4)")
+    args = parser.parse_args()
+
+    resolve = make_resolver(*load_symbols(args.elf, args.nm))
+    subsystems = {SUBSYSTEMS.index(name) for name in (args.subsystem or SUBSYSTEMS)}
+
+    with open(args.log, "rb") as capture:
+        roots = build_calls(read_records(capture.read()), subsystems)
+    if not roots:
+        sys.exit("no completed calls found")
+
+    if args.tree:
+        print_tree(roots, resolve, args.tree, args.depth)
+    else:
+        print_table(roots, resolve)
+
+
+if __name__ == "__main__":
+    main()
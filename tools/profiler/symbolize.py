@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+# =============================================================================
+# CLKernel - Profile Symbolizer
+# =============================================================================
+# File: symbolize.py
+# Purpose: Turn "PROF" sample lines captured from the kernel serial port into
+#          flat profiles, call graphs or folded stacks for flame graphs
+#
+# Usage:
+#   symbolize.py [--elf build/kernel.elf] [--nm nm] [--actor ID]
+#                [--flat | --callgraph | --folded] serial.log
+#
+# Samples are produced by profiler_dump_serial() (kernel/core/profiler.c):
+#   PROF <cpu> <actor> <tsc-hex> <flags> <eip-hex> [<caller-hex> ...]
+# Folded output feeds flamegraph.pl directly:
+#   symbolize.py --folded serial.log | flamegraph.pl > kernel.svg
+# =============================================================================
+
+import argparse
+import bisect
+import collections
+import subprocess
+import sys
+
+PROFILER_SAMPLE_TRUNCATED = 0x01
+
+
+def load_symbols(elf, nm):
+    """Return sorted (addresses, names) for the code symbols in elf."""
+    output = subprocess.run([nm, "-n", "--defined-only", elf],
+                            check=True, capture_output=True, text=True).stdout
+    addresses, names = [], []
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) != 3 or fields[1] not in "tTwW":
+            continue
+        addresses.append(int(fields[0], 16))
+        names.append(fields[2])
+    return addresses, names
+
+
+def make_resolver(addresses, names):
+    cache = {}
+
+    def resolve(address):
+        if address not in cache:
+            index = bisect.bisect_right(addresses, address) - 1
+            cache[address] = names[index] if index >= 0 else "0x%x" % address
+        return cache[address]
+
+    return resolve
+
+
+def read_samples(stream, actor_filter):
+    """Yield (actor, flags, [eip, caller, ...]) for every PROF line."""
+    for line in stream:
+        fields = line.split()
+        if len(fields) < 6 or fields[0] != "PROF":
+            continue
+        actor = int(fields[2])
+        if actor_filter is not None and actor != actor_filter:
+            continue
+        flags = int(fields[4])
+        frames = [int(value, 16) for value in fields[5:]]
+        yield actor, flags, frames
+
+
+def symbolize(frames, resolve):
+    """Innermost-first function names; return addresses point past the call."""
+    return [resolve(frames[0])] + [resolve(address - 1) for address in frames[1:]]
+
+
+def print_flat(stacks, total):
+    self_counts = collections.Counter()
+    total_counts = collections.Counter()
+    for (actor, functions), count in stacks.items():
+        self_counts[functions[0]] += count
+        for function in set(functions):
+            total_counts[function] += count
+
+    print("%8s %7s %8s %7s  %s" % ("self", "self%", "total", "total%", "function"))
+    for function, count in sorted(total_counts.items(),
+                                  key=lambda item: (-self_counts[item[0]], -item[1])):
+        print("%8d %6.2f%% %8d %6.2f%%  %s" % (
+            self_counts[function], 100.0 * self_counts[function] / total,
+            count, 100.0 * count / total, function))
+
+
+def print_callgraph(stacks, total):
+    callers = collections.defaultdict(collections.Counter)
+    callees = collections.defaultdict(collections.Counter)
+    total_counts = collections.Counter()
+    for (actor, functions), count in stacks.items():
+        for function in set(functions):
+            total_counts[function] += count
+        for callee, caller in zip(functions, functions[1:]):
+            callers[callee][caller] += count
+            callees[caller][callee] += count
+
+    for function, count in total_counts.most_common():
+        print("%6.2f%% %8d  %s" % (100.0 * count / total, count, function))
+        for caller, edge in callers[function].most_common():
+            print("                   <- %-40s %8d" % (caller, edge))
+        for callee, edge in callees[function].most_common():
+            print("                   -> %-40s %8d" % (callee, edge))
+        print()
+
+
+def print_folded(stacks):
+    folded = collections.Counter()
+    for (actor, functions), count in stacks.items():
+        root = "actor-%d" % actor if actor else "kernel"
+        folded[";".join([root] + list(functions[::-1]))] += count
+    for stack, count in sorted(folded.items()):
+        print("%s %d" % (stack, count))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Symbolize CLKernel profiler samples")
+    parser.add_argument("log", nargs="?", help="serial capture (default: stdin)")
+    parser.add_argument("--elf", default="build/kernel.elf", help="kernel ELF with symbols")
+    parser.add_argument("--nm", default="nm", help="nm binary (e.g. i686-elf-nm)")
+    parser.add_argument("--actor", type=int, help="only samples taken in this actor")
+    mode = parser.add_mutually_exclusive_group()
+    mode.add_argument("--flat", action="store_const", dest="mode", const="flat")
+    mode.add_argument("--callgraph", action="store_const", dest="mode", const="callgraph")
+    mode.add_argument("--folded", action="store_const", dest="mode", const="folded")
+    parser.set_defaults(mode="flat")
+    args = parser.parse_args()
+
+    resolve = make_resolver(*load_symbols(args.elf, args.nm))
+
+    stream = open(args.log, errors="replace") if args.log else sys.stdin
+    stacks = collections.Counter()
+    truncated = 0
+    with stream:
+        for actor, flags, frames in read_samples(stream, args.actor):
+            if flags & PROFILER_SAMPLE_TRUNCATED:
+                truncated += 1
+            stacks[(actor, tuple(symbolize(frames, resolve)))] += 1
+
+    total = sum(stacks.values())
+    if total == 0:
+        sys.exit("no PROF samples found")
+
+    if args.mode == "folded":
+        print_folded(stacks)
+        return
+
+    print("%d samples, %d with truncated backtraces\n" % (total, truncated))
+    if args.mode == "callgraph":
+        print_callgraph(stacks, total)
+    else:
+        print_flat(stacks, total)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,511 @@
+/*
+ * =============================================================================
+ * CLKernel - Event Actor Scaling Benchmark
+ * =============================================================================
+ * File: actor_bench.c
+ * Purpose: Spawn, message and tear down tens of thousands of stackless event
+ *          actors with the real scheduler, handle table and mailbox code,
+ *          one host thread per simulated CPU
+ *
+ * Usage:
+ *   actor_bench [-c N] [-n N] [-m N]
+ *
+ *   -c N     Simulated CPUs (default 2)
+ *   -n N     Event actors (default 10000)
+ *   -m N     Fan-out messages per actor (default 4)
+ *
+ * Actors are spawned round-robin across CPUs. Fan-out has every CPU send
+ * -m messages to each actor homed on the next CPU, so deliveries cross
+ * CPUs. Relay starts one token every BENCH_RELAY_SPAN actors; each
+ * handler passes it on to the next actor, so every actor handles one
+ * message sent by another event actor, and the benchmark checks that
+ * sender_id names that actor. Teardown destroys them all and then checks
+ * that their old IDs no longer accept messages, even once new actors
+ * have reused the slots. A last phase does the same for thread actors,
+ * creating enough to grow their table past its static first page.
+ * =============================================================================
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kernel.h"
+#include "scheduler.h"
+#include "event_actor.h"
+#include "percpu.h"
+#include "smp.h"
+
+// =============================================================================
+// Constants and State
+// =============================================================================
+
+#define BENCH_SEND_BATCH        64      // Messages a CPU sends between handler runs
+#define BENCH_RELAY_SPAN        256     // Actors between relay tokens (hops per token)
+#define BENCH_STALE_CHECKS      1000    // Old IDs probed after teardown
+#define BENCH_THREAD_ACTORS     1000    // Thread actors created (never started)
+#define BENCH_LOOKUPS           1000000 // actor_is_valid calls timed
+
+#define BENCH_PHASE_FAN_OUT     0
+#define BENCH_PHASE_RELAY       1
+
+extern __thread uint32_t host_cpu_id;
+extern uint32_t host_cpu_count;
+extern scheduler_t kernel_scheduler;
+
+/*
+ * One event actor's state (the pointer its handler gets)
+ */
+typedef struct bench_actor {
+    uint32_t        actor_id;
+    uint32_t        next_id;            // Relay successor
+    uint32_t        prev_id;            // Relay predecessor (expected sender)
+    uint32_t        received;           // Messages handled
+} bench_actor_t;
+
+/*
+ * Per-CPU progress, padded so handlers on different CPUs never share a line
+ */
+typedef struct bench_cpu {
+    uint64_t        handled;            // Handler calls on this CPU
+    uint64_t        refused;            // Sends that had to be retried
+    uint32_t        cursor;             // Next fan-out target (index into actors)
+    uint32_t        round;              // Fan-out round
+    bool            sending;            // Has sends left this phase
+} __attribute__((aligned(64))) bench_cpu_t;
+
+typedef struct bench_state {
+    bench_actor_t*  actors;
+    uint32_t        actor_count;
+    uint32_t        fan_out;            // Messages per actor
+
+    uint8_t         phase;              // BENCH_PHASE_*
+    uint64_t        expected;           // Handler calls that end the phase
+    volatile uint64_t sender_mismatches;// Relay messages not from the predecessor
+
+    bench_cpu_t     cpus[SMP_MAX_CPUS];
+    uint64_t        started_at;         // Phase start (ns)
+    volatile uint64_t finished_at;      // Last handler call (ns)
+    volatile bool   done;               // Phase complete
+    volatile bool   stop;               // CPU threads exit
+} bench_state_t;
+
+static bench_state_t bench;
+
+static uint64_t bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// =============================================================================
+// Handler
+// =============================================================================
+
+/*
+ * The only handler: count the message and, in the relay phase, pass the
+ * token on with one hop fewer
+ */
+static void bench_handle(message_t* message, void* state)
+{
+    bench_actor_t* self = (bench_actor_t*)state;
+    self->received++;
+    bench.cpus[host_cpu_id].handled++;
+
+    if (bench.phase != BENCH_PHASE_RELAY || !message->payload) {
+        return;
+    }
+
+    uint32_t hops = *(uint32_t*)message->payload;
+    if (hops != BENCH_RELAY_SPAN && message->sender_id != self->prev_id) {
+        __sync_fetch_and_add(&bench.sender_mismatches, 1);
+    }
+
+    if (--hops > 0) {
+        // Handlers cannot block; the pool only runs short for an instant
+        while (!message_send_async(self->next_id, MSG_TYPE_ASYNC, &hops, sizeof(hops))) {
+            bench.cpus[host_cpu_id].refused++;
+            cpu_relax();
+        }
+    }
+}
+
+// =============================================================================
+// Simulated CPUs
+// =============================================================================
+
+/*
+ * Queue a batch of fan-out messages for actors homed on the next CPU;
+ * false once this CPU has sent all of its share
+ */
+static bool bench_send_fan_out(uint32_t cpu)
+{
+    bench_cpu_t* state = &bench.cpus[cpu];
+    uint32_t target_cpu = (cpu + 1) % host_cpu_count;
+
+    for (uint32_t sent = 0; sent < BENCH_SEND_BATCH; sent++) {
+        if (state->cursor >= bench.actor_count) {
+            if (++state->round == bench.fan_out) {
+                return false;
+            }
+            state->cursor = 0;
+        }
+
+        uint32_t index = state->cursor;
+        if (index % host_cpu_count != target_cpu) {
+            // Skip ahead to the next actor homed on target_cpu
+            index += (target_cpu + host_cpu_count - index % host_cpu_count) % host_cpu_count;
+            if (index >= bench.actor_count) {
+                state->cursor = bench.actor_count;
+                continue;
+            }
+        }
+
+        if (!message_send_async(bench.actors[index].actor_id, MSG_TYPE_ASYNC, NULL, 0)) {
+            state->refused++;
+            state->cursor = index;
+            return true; // Pool or mailbox full: let handlers drain first
+        }
+        state->cursor = index + 1;
+    }
+    return true;
+}
+
+/*
+ * Start one relay token per BENCH_RELAY_SPAN actors (CPU 0 only)
+ */
+static bool bench_send_relay(uint32_t cpu)
+{
+    bench_cpu_t* state = &bench.cpus[cpu];
+    uint32_t hops = BENCH_RELAY_SPAN;
+
+    while (state->cursor + BENCH_RELAY_SPAN <= bench.actor_count) {
+        if (!message_send_async(bench.actors[state->cursor].actor_id, MSG_TYPE_ASYNC,
+                                &hops, sizeof(hops))) {
+            state->refused++;
+            return true;
+        }
+        state->cursor += BENCH_RELAY_SPAN;
+    }
+    return false;
+}
+
+static uint64_t bench_handled(void)
+{
+    uint64_t handled = 0;
+    for (uint32_t cpu = 0; cpu < host_cpu_count; cpu++) {
+        handled += bench.cpus[cpu].handled;
+    }
+    return handled;
+}
+
+/*
+ * One simulated CPU: send this CPU's share, run handlers as their
+ * messages arrive and halt (as scheduler_cpu_loop would) when idle
+ */
+static void* bench_cpu_thread(void* arg)
+{
+    uint32_t cpu = (uint32_t)(uintptr_t)arg;
+    bench_cpu_t* state = &bench.cpus[cpu];
+    host_cpu_id = cpu;
+
+    while (!bench.stop) {
+        uint32_t handled = event_actor_run_pending();
+
+        if (handled && !bench.done && bench_handled() >= bench.expected) {
+            bench.finished_at = bench_now();
+            bench.done = true;
+        }
+
+        if (state->sending) {
+            state->sending = (bench.phase == BENCH_PHASE_RELAY) ? bench_send_relay(cpu)
+                                                                : bench_send_fan_out(cpu);
+            cpu_relax();
+            continue;
+        }
+
+        if (!handled) {
+            scheduler_cpu_idle();
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Run one messaging phase on every CPU until all expected handler calls
+ * are done
+ */
+static void bench_run_phase(uint8_t phase, uint64_t expected)
+{
+    pthread_t threads[SMP_MAX_CPUS];
+
+    bench.phase = phase;
+    bench.expected = expected;
+    bench.done = false;
+    bench.stop = false;
+    for (uint32_t cpu = 0; cpu < host_cpu_count; cpu++) {
+        bench_cpu_t* state = &bench.cpus[cpu];
+        state->handled = 0;
+        state->refused = 0;
+        state->cursor = 0;
+        state->round = 0;
+        state->sending = (phase == BENCH_PHASE_FAN_OUT) || cpu == 0;
+    }
+
+    bench.started_at = bench_now();
+    for (uint32_t cpu = 0; cpu < host_cpu_count; cpu++) {
+        pthread_create(&threads[cpu], NULL, bench_cpu_thread, (void*)(uintptr_t)cpu);
+    }
+
+    struct timespec poll = { 0, 1000000 };
+    while (!bench.done) {
+        nanosleep(&poll, NULL);
+    }
+
+    bench.stop = true;
+    for (uint32_t cpu = 0; cpu < host_cpu_count; cpu++) {
+        smp_send_reschedule(cpu);
+    }
+    for (uint32_t cpu = 0; cpu < host_cpu_count; cpu++) {
+        pthread_join(threads[cpu], NULL);
+    }
+}
+
+static uint64_t bench_refused(void)
+{
+    uint64_t refused = 0;
+    for (uint32_t cpu = 0; cpu < host_cpu_count; cpu++) {
+        refused += bench.cpus[cpu].refused;
+    }
+    return refused;
+}
+
+// =============================================================================
+// Benchmarks
+// =============================================================================
+
+static void bench_spawn(void)
+{
+    uint64_t started = bench_now();
+
+    for (uint32_t i = 0; i < bench.actor_count; i++) {
+        host_cpu_id = i % host_cpu_count; // Spawned actors run on the spawning CPU
+        bench.actors[i].actor_id = event_actor_spawn(bench_handle, &bench.actors[i]);
+        if (!bench.actors[i].actor_id) {
+            fprintf(stderr, "actor_bench: spawn %u failed\n", i);
+            exit(1);
+        }
+    }
+    host_cpu_id = 0;
+
+    uint64_t elapsed = bench_now() - started;
+
+    for (uint32_t i = 0; i < bench.actor_count; i++) {
+        bench_actor_t* actor = &bench.actors[i];
+        actor->next_id = bench.actors[(i + 1) % bench.actor_count].actor_id;
+        actor->prev_id = bench.actors[(i + bench.actor_count - 1) % bench.actor_count].actor_id;
+    }
+
+    printf("[ACTORBENCH] Spawn: %u actors in %.2f ms (%.0f ns each), %u live\n",
+           bench.actor_count, (double)elapsed / 1e6, (double)elapsed / bench.actor_count,
+           event_actor_count());
+}
+
+static void bench_fan_out(void)
+{
+    uint64_t messages = 0;
+    for (uint32_t i = 0; i < bench.actor_count; i++) {
+        messages += bench.fan_out;
+    }
+
+    bench_run_phase(BENCH_PHASE_FAN_OUT, messages);
+
+    double seconds = (double)(bench.finished_at - bench.started_at) / 1e9;
+    printf("[ACTORBENCH] Fan-out: %llu messages (%u per actor, %s) in %.2f ms\n",
+           (unsigned long long)messages, bench.fan_out,
+           host_cpu_count > 1 ? "cross-CPU" : "one CPU", seconds * 1e3);
+    printf("      Throughput %.0f msgs/s, %.0f ns per message, refused sends %llu\n",
+           seconds > 0 ? (double)messages / seconds : 0.0,
+           seconds * 1e9 / (double)messages, (unsigned long long)bench_refused());
+}
+
+static void bench_relay(void)
+{
+    uint32_t tokens = bench.actor_count / BENCH_RELAY_SPAN;
+    if (tokens == 0) {
+        printf("[ACTORBENCH] Relay: skipped (fewer than %d actors)\n", BENCH_RELAY_SPAN);
+        return;
+    }
+
+    uint64_t hops = (uint64_t)tokens * BENCH_RELAY_SPAN;
+    bench.sender_mismatches = 0;
+    bench_run_phase(BENCH_PHASE_RELAY, hops);
+
+    double seconds = (double)(bench.finished_at - bench.started_at) / 1e9;
+    printf("[ACTORBENCH] Relay: %u tokens x %d hops, handler to handler, in %.2f ms\n",
+           tokens, BENCH_RELAY_SPAN, seconds * 1e3);
+    printf("      Throughput %.0f hops/s, wrong sender_id %llu, refused sends %llu\n",
+           seconds > 0 ? (double)hops / seconds : 0.0,
+           (unsigned long long)bench.sender_mismatches, (unsigned long long)bench_refused());
+}
+
+static void bench_teardown(void)
+{
+    uint64_t started = bench_now();
+    for (uint32_t i = 0; i < bench.actor_count; i++) {
+        if (!event_actor_destroy(bench.actors[i].actor_id)) {
+            fprintf(stderr, "actor_bench: destroy %u failed\n", i);
+            exit(1);
+        }
+    }
+    uint64_t elapsed = bench_now() - started;
+
+    printf("[ACTORBENCH] Teardown: %u actors in %.2f ms (%.0f ns each), %u live\n",
+           bench.actor_count, (double)elapsed / 1e6, (double)elapsed / bench.actor_count,
+           event_actor_count());
+
+    // The last actors destroyed are the first slots reused: respawn into
+    // them, then aim messages at their old IDs
+    uint32_t checks = bench.actor_count < BENCH_STALE_CHECKS ? bench.actor_count
+                                                             : BENCH_STALE_CHECKS;
+    static bench_actor_t fresh[BENCH_STALE_CHECKS];
+    uint32_t refused = 0, reused = 0;
+
+    for (uint32_t i = 0; i < checks; i++) {
+        fresh[i].actor_id = event_actor_spawn(bench_handle, &fresh[i]);
+        uint32_t old_id = bench.actors[bench.actor_count - 1 - i].actor_id;
+        if (handle_index(fresh[i].actor_id) == handle_index(old_id)) {
+            reused++;
+        }
+    }
+    for (uint32_t i = 0; i < checks; i++) {
+        uint32_t stale_id = bench.actors[bench.actor_count - 1 - i].actor_id;
+        if (!message_send_async(stale_id, MSG_TYPE_ASYNC, NULL, 0)) {
+            refused++;
+        }
+    }
+    for (uint32_t i = 0; i < checks; i++) {
+        event_actor_destroy(fresh[i].actor_id);
+    }
+
+    printf("      Stale IDs: %u/%u sends refused after %u slots were reused\n",
+           refused, checks, reused);
+}
+
+static void bench_thread_entry(void)
+{
+}
+
+static void bench_thread_actors(void)
+{
+    static uint32_t ids[BENCH_THREAD_ACTORS];
+    static uint32_t fresh[BENCH_THREAD_ACTORS];
+    uint32_t count = BENCH_THREAD_ACTORS < MAX_ACTORS - 1 ? BENCH_THREAD_ACTORS : MAX_ACTORS - 1;
+
+    for (uint32_t i = 0; i < count; i++) {
+        ids[i] = actor_create(bench_thread_entry, NULL, ACTOR_PRIORITY_NORMAL, 0);
+        if (!ids[i]) {
+            fprintf(stderr, "actor_bench: actor_create %u failed\n", i);
+            exit(1);
+        }
+    }
+    uint32_t pages = kernel_scheduler.actor_table.capacity / HANDLE_PAGE_SIZE;
+
+    // Validation cost on live IDs (one slot load and a compare)
+    uint32_t valid = 0;
+    uint64_t started = bench_now();
+    for (uint32_t i = 0; i < BENCH_LOOKUPS; i++) {
+        valid += actor_is_valid(ids[i % count]);
+    }
+    uint64_t elapsed = bench_now() - started;
+
+    for (uint32_t i = 0; i < count; i++) {
+        actor_terminate(ids[i]);
+    }
+
+    // The last actors terminated are the first slots reused
+    uint32_t refused = 0, reused = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        fresh[i] = actor_create(bench_thread_entry, NULL, ACTOR_PRIORITY_NORMAL, 0);
+        if (handle_index(fresh[i]) == handle_index(ids[count - 1 - i])) {
+            reused++;
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (!actor_is_valid(ids[i]) && !message_send_async(ids[i], MSG_TYPE_ASYNC, NULL, 0)) {
+            refused++;
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        actor_terminate(fresh[i]);
+    }
+
+    printf("[ACTORBENCH] Thread actors: %u created in %u table pages, %.1f ns per ID check, "
+           "%u checks failed\n", count, pages, (double)elapsed / BENCH_LOOKUPS,
+           BENCH_LOOKUPS - valid);
+    printf("      Stale IDs: %u/%u refused after %u slots were reused\n",
+           refused, count, reused);
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(int argc, char* argv[])
+{
+    uint32_t actors = 10000, fan_out = 4;
+    host_cpu_count = 2;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (i + 1 < argc && strcmp(arg, "-c") == 0) {
+            host_cpu_count = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(arg, "-n") == 0) {
+            actors = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(arg, "-m") == 0) {
+            fan_out = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "usage: actor_bench [-c CPUS] [-n ACTORS] [-m MESSAGES]\n");
+            return 2;
+        }
+    }
+
+    if (host_cpu_count == 0 || host_cpu_count > SMP_MAX_CPUS) {
+        fprintf(stderr, "actor_bench: need 1..%d CPUs\n", SMP_MAX_CPUS);
+        return 2;
+    }
+    if (actors == 0 || actors > EVENT_ACTOR_MAX || fan_out == 0 ||
+        fan_out > EVENT_ACTOR_QUEUE_LIMIT) {
+        fprintf(stderr, "actor_bench: need 1..%d actors and 1..%d messages per actor\n",
+                EVENT_ACTOR_MAX, EVENT_ACTOR_QUEUE_LIMIT);
+        return 2;
+    }
+
+    bench.actor_count = actors;
+    bench.fan_out = fan_out;
+    bench.actors = calloc(actors, sizeof(bench_actor_t));
+
+    scheduler_init();
+    for (uint32_t cpu = 1; cpu < host_cpu_count; cpu++) {
+        scheduler_cpu_online(cpu);
+    }
+    kernel_scheduler.scheduler_enabled = true;
+
+    printf("[ACTORBENCH] %u CPU(s), %u event actors: %u bytes each "
+           "(a thread actor takes %u plus a %d-byte stack)\n",
+           host_cpu_count, actors, (unsigned)(sizeof(event_actor_t) + sizeof(handle_slot_t)),
+           (unsigned)sizeof(actor_t), ACTOR_STACK_SIZE);
+
+    bench_spawn();
+    bench_fan_out();
+    bench_relay();
+    bench_teardown();
+    bench_thread_actors();
+
+    free(bench.actors);
+    return 0;
+}
@@ -0,0 +1,283 @@
+/*
+ * =============================================================================
+ * CLKernel - Host Replay Kernel Service Shims
+ * =============================================================================
+ * File: host_shims.c
+ * Purpose: libc-backed implementations of the kernel services used by the
+ *          AI supervisor and scheduler when built as a Linux user-space library
+ *
+ * Everything here replaces code that lives in the boot-only parts of the
+ * kernel (VGA console, serial port, heap, module loader, sandboxing,
+ * rdtsc stub, CPU identification, local timers, reschedule IPIs).
+ * =============================================================================
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "kernel.h"
+#include "heap.h"
+#include "modules.h"
+#include "sandboxing.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "smp.h"
+#include "percpu.h"
+#include "cpu_timer.h"
+
+// =============================================================================
+// Shim State
+// =============================================================================
+
+// Console output is dropped unless the replay driver asks for it
+bool host_kprintf_enabled = false;
+
+// Simulated CPU the calling thread is running scheduler code on (the
+// replay driver switches it on one thread; msg_bench runs a thread per CPU)
+__thread uint32_t host_cpu_id = 0;
+uint32_t host_cpu_count = 1;
+
+// Per-CPU areas, indexed by host_cpu_id instead of through GS
+percpu_t percpu_areas[SMP_MAX_CPUS];
+
+// Reschedule IPIs: a halted CPU thread sleeps until its flag is raised
+static pthread_mutex_t host_ipi_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t host_ipi_wakeup = PTHREAD_COND_INITIALIZER;
+static bool host_ipi_pending[SMP_MAX_CPUS];
+
+static heap_stats_t host_heap_stats;
+static module_stats_t host_module_stats;
+
+// =============================================================================
+// Core Kernel Services
+// =============================================================================
+
+/*
+ * Kernel console output, forwarded to stdout when enabled
+ */
+int kprintf(const char* format, ...)
+{
+    if (!host_kprintf_enabled) {
+        return 0;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int written = vprintf(format, args);
+    va_end(args);
+
+    return written;
+}
+
+/*
+ * Kernel panic: report and abort, whatever the kprintf setting
+ */
+void kernel_panic(const char* message, const char* file, int line)
+{
+    fprintf(stderr, "*** KERNEL PANIC: %s (%s:%d)\n", message, file, line);
+    abort();
+}
+
+/*
+ * CPU timestamp counter (nanoseconds where rdtsc is unavailable)
+ */
+uint64_t read_timestamp_counter(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/*
+ * Serial port: never present on the host, so trace dumps write nothing
+ */
+bool serial_is_ready(void)
+{
+    return false;
+}
+
+void serial_write_char(char c)
+{
+    (void)c;
+}
+
+void serial_write_string(const char* str)
+{
+    (void)str;
+}
+
+void serial_write(const void* data, size_t length)
+{
+    (void)data;
+    (void)length;
+}
+
+/*
+ * CPU identification: each host thread sets host_cpu_id for the simulated
+ * CPU it is running the scheduler for
+ */
+uint32_t smp_cpu_id(void)
+{
+    return host_cpu_id;
+}
+
+uint32_t smp_cpu_count(void)
+{
+    return host_cpu_count;
+}
+
+/*
+ * Local interrupt control (nothing interrupts the replay driver)
+ */
+uint32_t cpu_irq_save(void)
+{
+    return 0;
+}
+
+void cpu_irq_restore(uint32_t flags)
+{
+    (void)flags;
+}
+
+/*
+ * Spin-wait hint. Host CPU threads can be preempted while holding a
+ * lock, so a spinner gives up its time slice instead of burning it.
+ */
+void cpu_relax(void)
+{
+    sched_yield();
+}
+
+/*
+ * Halt: sleep until a reschedule IPI arrives, then run its handler the
+ * way the interrupt would (nothing else wakes a host CPU)
+ */
+void cpu_halt(void)
+{
+    uint32_t cpu = host_cpu_id;
+
+    pthread_mutex_lock(&host_ipi_lock);
+    while (!host_ipi_pending[cpu]) {
+        pthread_cond_wait(&host_ipi_wakeup, &host_ipi_lock);
+    }
+    host_ipi_pending[cpu] = false;
+    pthread_mutex_unlock(&host_ipi_lock);
+
+    scheduler_reschedule_interrupt();
+}
+
+/*
+ * Reschedule IPI: raise the target's flag and wake its thread
+ */
+bool smp_send_reschedule(uint32_t cpu)
+{
+    if (cpu >= host_cpu_count) {
+        return false;
+    }
+
+    pthread_mutex_lock(&host_ipi_lock);
+    host_ipi_pending[cpu] = true;
+    pthread_cond_broadcast(&host_ipi_wakeup);
+    pthread_mutex_unlock(&host_ipi_lock);
+    return true;
+}
+
+/*
+ * Local timers (none on the host: replay slices stay tick-driven)
+ */
+void cpu_timer_slice_begin(void)
+{
+}
+
+/*
+ * Kernel heap allocation on top of libc; memory is zeroed like fresh
+ * kernel BSS so replays are deterministic. Requests the kernel heap
+ * would refuse (empty, or above HEAP_MAX_BLOCK_SIZE) fail here too, so
+ * code that only works with libc's allocator shows up on the host.
+ */
+void* kmalloc(size_t size)
+{
+    if (size == 0 || size > HEAP_MAX_BLOCK_SIZE) {
+        return NULL;
+    }
+    return calloc(1, size);
+}
+
+void* kcalloc(size_t count, size_t size)
+{
+    if (size != 0 && count > HEAP_MAX_BLOCK_SIZE / size) {
+        return NULL;
+    }
+    return kmalloc(count * size);
+}
+
+/*
+ * Free kernel heap allocation
+ */
+void kfree(void* ptr)
+{
+    free(ptr);
+}
+
+// =============================================================================
+// Subsystem Statistics and Controls
+// =============================================================================
+
+/*
+ * Heap statistics (all zero: the host heap is not modelled)
+ */
+heap_stats_t* heap_get_statistics(void)
+{
+    return &host_heap_stats;
+}
+
+/*
+ * Module system statistics (no modules are loaded on the host)
+ */
+module_stats_t* module_get_statistics(void)
+{
+    return &host_module_stats;
+}
+
+/*
+ * Module suspension (no modules are loaded on the host)
+ */
+bool module_suspend(uint32_t module_id)
+{
+    (void)module_id;
+    return false;
+}
+
+/*
+ * Sandbox resource limits (no sandboxes exist on the host)
+ */
+int sandboxing_set_resource_limit(uint32_t module_id, uint8_t resource_type, uint32_t limit)
+{
+    (void)module_id;
+    (void)resource_type;
+    (void)limit;
+    return -2;
+}
+
+/*
+ * Actor suspension. Declared by the scheduler but not implemented in the
+ * kernel yet; park the actor the same way an intervention would.
+ */
+bool actor_suspend(uint32_t actor_id)
+{
+    actor_t* actor = actor_get(actor_id);
+    if (!actor || actor_id == 0) {
+        return false;
+    }
+
+    actor->state = ACTOR_STATE_SUSPENDED;
+    return true;
+}
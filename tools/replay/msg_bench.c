@@ -0,0 +1,476 @@
+/*
+ * =============================================================================
+ * CLKernel - Cross-CPU Messaging Benchmark
+ * =============================================================================
+ * File: msg_bench.c
+ * Purpose: Measure actor message latency and throughput across CPUs with the
+ *          real scheduler and mailbox code, one host thread per simulated CPU
+ *
+ * Usage:
+ *   msg_bench [-c N] [-n N] [-m N] [-p N]
+ *
+ *   -c N     Simulated CPUs (default 2)
+ *   -n N     Ping-pong round trips (default 20000)
+ *   -m N     Messages per fan-in producer (default 200000)
+ *   -p N     Fan-in producers (default one per CPU other than the sink's)
+ *
+ * Ping-pong bounces one message between an actor pinned to CPU 0 and one
+ * pinned to the last CPU, so every message wakes a blocked actor on the
+ * other CPU (through its wake list, with a reschedule IPI when it is
+ * halted) and reports the round trip time. It then runs again unpinned,
+ * where wakeup placement should notice the chatty pair and put both on
+ * one CPU. Fan-in has producers pinned to CPUs 1..N-1 all sending to one
+ * sink actor pinned to CPU 0 and reports delivered messages per second. Each thread runs what scheduler_cpu_loop runs on an AP; a host
+ * "IPI" is a condition variable signal, so absolute latencies are those
+ * of a futex wakeup rather than of the local APIC.
+ * =============================================================================
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kernel.h"
+#include "scheduler.h"
+#include "percpu.h"
+#include "smp.h"
+
+// =============================================================================
+// Constants and State
+// =============================================================================
+
+#define BENCH_SEND_BATCH        64      // Messages a producer sends per turn
+#define BENCH_MAX_PRODUCERS     64
+
+#define BENCH_PING              0
+#define BENCH_PONG              1
+#define BENCH_PRODUCER          2
+#define BENCH_SINK              3
+
+extern __thread uint32_t host_cpu_id;
+extern uint32_t host_cpu_count;
+extern scheduler_t kernel_scheduler;
+
+/*
+ * One benchmark actor (its user_data)
+ */
+typedef struct bench_actor {
+    uint8_t         kind;               // BENCH_*
+    uint32_t        home_cpu;           // CPU it is created and started on
+    uint32_t        final_cpu;          // CPU it last ran on when the phase ended
+    uint32_t        actor_id;
+    uint32_t        peer_id;            // Pong partner or fan-in sink
+
+    // Ping
+    bool            outstanding;        // A ping is in flight
+    uint64_t        sent_at;            // When it left (ns)
+    uint32_t        rounds;             // Round trips completed
+
+    // Producer / sink
+    uint64_t        sent;               // Messages queued
+    uint64_t        retries;            // Sends refused (pool or mailbox full)
+    uint64_t        received;           // Messages taken
+} bench_actor_t;
+
+typedef struct bench_state {
+    bench_actor_t   actors[BENCH_MAX_PRODUCERS + 2];
+    uint32_t        actor_count;
+
+    uint32_t        target_rounds;      // Ping-pong round trips
+    uint64_t*       rtt;                // Round trip times (ns)
+    uint64_t        target_messages;    // Fan-in messages per producer
+    uint64_t        sink_expected;      // Fan-in messages the sink waits for
+
+    uint64_t        started_at;         // First message (ns)
+    uint64_t        finished_at;        // Last message (ns)
+    volatile bool   done;               // Phase complete
+    volatile bool   stop;               // CPU threads exit
+} bench_state_t;
+
+static bench_state_t bench;
+
+static uint64_t bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// =============================================================================
+// Actor Bodies
+// =============================================================================
+
+/*
+ * Entry point for benchmark actors (never executed: without saved
+ * contexts the CPU threads run bench_run_actor for whoever is current)
+ */
+static void bench_actor_entry(void)
+{
+}
+
+static void bench_run_ping(bench_actor_t* self)
+{
+    for (;;) {
+        if (!self->outstanding && self->rounds < bench.target_rounds) {
+            self->sent_at = bench_now();
+            if (!message_send_async(self->peer_id, MSG_TYPE_ASYNC, NULL, 0)) {
+                scheduler_yield();
+                return;
+            }
+            self->outstanding = true;
+        }
+
+        message_t* message = message_wait(0);
+        if (!message) {
+            return; // Blocked until the pong arrives
+        }
+        message_free(message);
+
+        bench.rtt[self->rounds++] = bench_now() - self->sent_at;
+        self->outstanding = false;
+
+        if (self->rounds == bench.target_rounds) {
+            bench.done = true;
+        }
+    }
+}
+
+static void bench_run_pong(bench_actor_t* self)
+{
+    for (;;) {
+        message_t* message = message_wait(0);
+        if (!message) {
+            return;
+        }
+
+        uint32_t sender = message->sender_id;
+        message_free(message);
+
+        // The pool is shared with nobody else in this phase; just retry
+        while (!message_send_async(sender, MSG_TYPE_ASYNC, NULL, 0)) {
+            if (bench.stop) return;
+            cpu_relax();
+        }
+        self->sent++;
+    }
+}
+
+static void bench_run_producer(bench_actor_t* self)
+{
+    for (uint32_t i = 0; i < BENCH_SEND_BATCH && self->sent < bench.target_messages; i++) {
+        if (!message_send_async(self->peer_id, MSG_TYPE_ASYNC, NULL, 0)) {
+            self->retries++;
+            cpu_relax(); // Back off until the sink drains
+            break;
+        }
+        self->sent++;
+    }
+
+    if (self->sent == bench.target_messages) {
+        message_wait(0); // Done: block for good
+        return;
+    }
+
+    scheduler_yield();
+}
+
+static void bench_run_sink(bench_actor_t* self)
+{
+    while (!bench.stop) {
+        message_t* message = message_wait(0);
+        if (!message) {
+            return;
+        }
+        message_free(message);
+
+        if (self->received++ == 0) {
+            bench.started_at = bench_now();
+        }
+        if (self->received == bench.sink_expected) {
+            bench.finished_at = bench_now();
+            bench.done = true;
+        }
+    }
+}
+
+// =============================================================================
+// Simulated CPUs
+// =============================================================================
+
+static void bench_run_actor(actor_t* actor)
+{
+    bench_actor_t* self = (bench_actor_t*)actor->user_data;
+
+    switch (self->kind) {
+        case BENCH_PING:     bench_run_ping(self); break;
+        case BENCH_PONG:     bench_run_pong(self); break;
+        case BENCH_PRODUCER: bench_run_producer(self); break;
+        case BENCH_SINK:     bench_run_sink(self); break;
+    }
+}
+
+/*
+ * Whether this CPU has a benchmark actor to run. The kernel actor only
+ * stands for the boot context on CPU 0 and is treated as idle.
+ */
+static bool bench_runnable(actor_t* current, uint32_t cpu)
+{
+    return current && current->actor_id != 0 && current->user_data &&
+           current->state == ACTOR_STATE_RUNNING && current->last_cpu == cpu;
+}
+
+/*
+ * One simulated CPU: start its actors, then what scheduler_cpu_loop does
+ */
+static void* bench_cpu_thread(void* arg)
+{
+    uint32_t cpu = (uint32_t)(uintptr_t)arg;
+    host_cpu_id = cpu;
+
+    for (uint32_t i = 0; i < bench.actor_count; i++) {
+        if (bench.actors[i].home_cpu == cpu) {
+            actor_start(bench.actors[i].actor_id);
+        }
+    }
+
+    while (!bench.stop) {
+        actor_t* current = actor_get_current();
+        if (!bench_runnable(current, cpu)) {
+            scheduler_schedule();
+
+            current = actor_get_current();
+            if (!bench_runnable(current, cpu)) {
+                scheduler_cpu_idle();
+                continue;
+            }
+        }
+
+        bench_run_actor(current);
+    }
+
+    return NULL;
+}
+
+/*
+ * Create a benchmark actor on its home CPU (started by that CPU's
+ * thread), optionally pinned there
+ */
+static bench_actor_t* bench_add_actor(uint8_t kind, uint32_t cpu, bool pinned)
+{
+    bench_actor_t* self = &bench.actors[bench.actor_count++];
+    memset(self, 0, sizeof(*self));
+    self->kind = kind;
+    self->home_cpu = cpu;
+
+    host_cpu_id = cpu; // actor_create places the actor on the creating CPU
+    self->actor_id = actor_create(bench_actor_entry, self, ACTOR_PRIORITY_NORMAL, 0);
+    host_cpu_id = 0;
+
+    if (pinned) {
+        actor_set_affinity(self->actor_id, 1u << cpu);
+    }
+    return self;
+}
+
+/*
+ * Run the created actors on every CPU until the phase is done, then
+ * stop the threads and free the actors
+ */
+static void bench_run_phase(void)
+{
+    pthread_t threads[SMP_MAX_CPUS];
+
+    bench.done = false;
+    bench.stop = false;
+
+    for (uint32_t cpu = 0; cpu < host_cpu_count; cpu++) {
+        pthread_create(&threads[cpu], NULL, bench_cpu_thread, (void*)(uintptr_t)cpu);
+    }
+
+    struct timespec poll = { 0, 1000000 };
+    while (!bench.done) {
+        nanosleep(&poll, NULL);
+    }
+
+    bench.stop = true;
+    for (uint32_t cpu = 0; cpu < host_cpu_count; cpu++) {
+        smp_send_reschedule(cpu);
+    }
+    for (uint32_t cpu = 0; cpu < host_cpu_count; cpu++) {
+        pthread_join(threads[cpu], NULL);
+    }
+
+    for (uint32_t i = 0; i < bench.actor_count; i++) {
+        bench.actors[i].final_cpu = actor_get(bench.actors[i].actor_id)->last_cpu;
+        actor_terminate(bench.actors[i].actor_id);
+    }
+    bench.actor_count = 0;
+}
+
+// =============================================================================
+// Reporting
+// =============================================================================
+
+typedef struct bench_counters {
+    uint64_t        remote_wakeups;
+    uint64_t        ipis;
+    uint64_t        coalesced;
+    uint64_t        steals;
+} bench_counters_t;
+
+static void bench_snapshot(bench_counters_t* counters)
+{
+    counters->remote_wakeups = percpu_sum(sched_remote_wakeups);
+    counters->ipis = percpu_sum(sched_resched_ipis);
+    counters->coalesced = percpu_sum(sched_resched_coalesced);
+    counters->steals = 0;
+    for (uint32_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        counters->steals += kernel_scheduler.cpus[cpu].steals;
+    }
+}
+
+static void bench_print_counters(const bench_counters_t* before, uint64_t messages)
+{
+    bench_counters_t after;
+    bench_snapshot(&after);
+
+    uint64_t wakeups = after.remote_wakeups - before->remote_wakeups;
+    uint64_t ipis = after.ipis - before->ipis;
+
+    printf("      Remote wakeups: %llu (%.2f per message), IPIs: %llu, coalesced: %llu, steals: %llu\n",
+           (unsigned long long)wakeups, messages ? (double)wakeups / (double)messages : 0.0,
+           (unsigned long long)ipis,
+           (unsigned long long)(after.coalesced - before->coalesced),
+           (unsigned long long)(after.steals - before->steals));
+}
+
+static int bench_compare_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// =============================================================================
+// Benchmarks
+// =============================================================================
+
+static void bench_ping_pong(uint32_t rounds, bool pinned)
+{
+    bench_counters_t before;
+    bench_snapshot(&before);
+
+    bench.target_rounds = rounds;
+    bench.rtt = calloc(rounds, sizeof(uint64_t));
+
+    uint32_t far_cpu = host_cpu_count - 1;
+    bench_actor_t* pong = bench_add_actor(BENCH_PONG, far_cpu, pinned);
+    bench_actor_t* ping = bench_add_actor(BENCH_PING, 0, pinned);
+    ping->peer_id = pong->actor_id;
+
+    bench_run_phase();
+
+    qsort(bench.rtt, rounds, sizeof(uint64_t), bench_compare_u64);
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < rounds; i++) {
+        total += bench.rtt[i];
+    }
+
+    printf("[MSGBENCH] Ping-pong CPU 0 <-> CPU %u, %s: %u round trips, ended on CPUs %u/%u\n",
+           far_cpu, pinned ? "pinned" : "unpinned", rounds, ping->final_cpu, pong->final_cpu);
+    printf("      RTT mean %.2f us, p50 %.2f us, p99 %.2f us, max %.2f us\n",
+           (double)total / rounds / 1000.0, (double)bench.rtt[rounds / 2] / 1000.0,
+           (double)bench.rtt[(uint64_t)rounds * 99 / 100] / 1000.0,
+           (double)bench.rtt[rounds - 1] / 1000.0);
+    bench_print_counters(&before, (uint64_t)rounds * 2);
+
+    free(bench.rtt);
+    bench.rtt = NULL;
+}
+
+static void bench_fan_in(uint32_t producers, uint64_t messages)
+{
+    bench_counters_t before;
+    bench_snapshot(&before);
+
+    bench.target_messages = messages;
+    bench.sink_expected = messages * producers;
+
+    bench_actor_t* sink = bench_add_actor(BENCH_SINK, 0, true);
+    // Measure delivery, not the default 64-message backpressure limit
+    actor_get(sink->actor_id)->max_queue_size = MAX_MESSAGES;
+
+    for (uint32_t i = 0; i < producers; i++) {
+        uint32_t cpu = host_cpu_count > 1 ? 1 + i % (host_cpu_count - 1) : 0;
+        bench_actor_t* producer = bench_add_actor(BENCH_PRODUCER, cpu, true);
+        producer->peer_id = sink->actor_id;
+    }
+
+    bench_run_phase();
+
+    uint64_t retries = 0;
+    for (uint32_t i = 0; i < producers; i++) {
+        retries += bench.actors[1 + i].retries;
+    }
+
+    double seconds = (double)(bench.finished_at - bench.started_at) / 1e9;
+    printf("[MSGBENCH] Fan-in %u -> 1 (sink on CPU 0): %llu messages in %.3f s\n",
+           producers, (unsigned long long)bench.sink_expected, seconds);
+    printf("      Throughput %.0f msgs/s, refused sends %llu\n",
+           seconds > 0 ? (double)bench.sink_expected / seconds : 0.0,
+           (unsigned long long)retries);
+    bench_print_counters(&before, bench.sink_expected);
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(int argc, char* argv[])
+{
+    uint32_t rounds = 20000, producers = 0;
+    uint64_t messages = 200000;
+    host_cpu_count = 2;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (i + 1 < argc && strcmp(arg, "-c") == 0) {
+            host_cpu_count = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(arg, "-n") == 0) {
+            rounds = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(arg, "-m") == 0) {
+            messages = strtoull(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(arg, "-p") == 0) {
+            producers = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "usage: msg_bench [-c CPUS] [-n ROUNDS] [-m MESSAGES] [-p PRODUCERS]\n");
+            return 2;
+        }
+    }
+
+    if (host_cpu_count == 0 || host_cpu_count > SMP_MAX_CPUS) {
+        fprintf(stderr, "msg_bench: need 1..%d CPUs\n", SMP_MAX_CPUS);
+        return 2;
+    }
+    if (producers == 0) {
+        producers = host_cpu_count > 1 ? host_cpu_count - 1 : 1;
+    }
+    if (rounds == 0 || messages == 0 || producers > BENCH_MAX_PRODUCERS) {
+        fprintf(stderr, "msg_bench: need rounds, messages and 1..%d producers\n",
+                BENCH_MAX_PRODUCERS);
+        return 2;
+    }
+
+    scheduler_init();
+    for (uint32_t cpu = 1; cpu < host_cpu_count; cpu++) {
+        scheduler_cpu_online(cpu);
+    }
+    kernel_scheduler.scheduler_enabled = true;
+
+    printf("[MSGBENCH] %u CPU(s)\n", host_cpu_count);
+    bench_ping_pong(rounds, true);
+    bench_ping_pong(rounds, false);
+    bench_fan_in(producers, messages);
+    return 0;
+}
@@ -0,0 +1,565 @@
+/*
+ * =============================================================================
+ * CLKernel - Host Trace Replay Driver
+ * =============================================================================
+ * File: replay.c
+ * Purpose: Replay recorded or synthetic traces through the AI supervisor and
+ *          scheduler on a Linux host and report detection accuracy, detection
+ *          latency, scheduling outcomes and replay throughput
+ *
+ * Usage:
+ *   ai_replay [-v] [-a ARL] [-c N] TRACE    Replay a trace and report
+ *   ai_replay -g TRACE [-e N] [-s N] [-r N] Generate a labelled synthetic trace
+ *
+ *   -v       Print kernel console output
+ *   -a ARL   Change-point false alarm rate (samples between false alarms)
+ *   -c N     Simulated CPUs, each with its own run queue (default 1)
+ *   -e N     Synthetic entities (default 200, at most REPLAY_MAX_ENTITIES)
+ *   -s N     Samples per entity (default 1000)
+ *   -r N     Generator seed (default 1)
+ * =============================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kernel.h"
+#include "scheduler.h"
+#include "sched_trace.h"
+#include "percpu.h"
+#include "ai_supervisor.h"
+#include "replay.h"
+
+// =============================================================================
+// Constants and State
+// =============================================================================
+
+#define REPLAY_MAX_ENTITIES     1024    // Trace entity IDs per entity type
+#define REPLAY_SYNTH_ACTORS     16      // Scheduler actors in synthetic traces
+#define REPLAY_SYNTH_ANOMALOUS  10      // Percent of entities given an anomaly
+
+extern bool host_kprintf_enabled;
+extern __thread uint32_t host_cpu_id;
+extern uint32_t host_cpu_count;
+extern ai_supervisor_t kernel_ai_supervisor;
+extern scheduler_t kernel_scheduler;
+
+/*
+ * Ground truth and detection outcome for one trace entity
+ */
+typedef struct replay_entity {
+    uint32_t        samples;            // Samples replayed
+    uint32_t        onset;              // Sample index of first anomalous label
+    uint8_t         label;              // Label of the latest sample
+    uint8_t         truth;              // First anomalous label seen
+    bool            detected;           // Detected at or after onset
+    bool            type_matched;       // Detection reported the labelled type
+    uint32_t        latency;            // Samples from onset to detection
+    uint32_t        false_alarms;       // Detections while labelled normal
+} replay_entity_t;
+
+static replay_entity_t replay_entities[2][REPLAY_MAX_ENTITIES];
+static uint32_t replay_actor_map[REPLAY_MAX_ENTITIES];
+
+// =============================================================================
+// Synthetic Trace Generation
+// =============================================================================
+
+static uint64_t replay_rng_state;
+
+/*
+ * xorshift64 pseudo-random generator
+ */
+static uint32_t replay_rand(void)
+{
+    replay_rng_state ^= replay_rng_state << 13;
+    replay_rng_state ^= replay_rng_state >> 7;
+    replay_rng_state ^= replay_rng_state << 17;
+    return (uint32_t)(replay_rng_state >> 32);
+}
+
+/*
+ * Approximately normal noise with the given deviation (Irwin-Hall, n = 12)
+ */
+static int32_t replay_noise(uint32_t deviation)
+{
+    int64_t sum = 0;
+    for (int i = 0; i < 12; i++) {
+        sum += replay_rand() >> 16;
+    }
+    sum -= 6 * 65536;
+    return (int32_t)((sum * (int64_t)deviation) / 65536);
+}
+
+/*
+ * Clamp a noisy value at zero
+ */
+static uint32_t replay_level(uint32_t base, uint32_t deviation)
+{
+    int64_t value = (int64_t)base + replay_noise(deviation);
+    return (value < 0) ? 0 : (uint32_t)value;
+}
+
+/*
+ * Append one event to the output trace
+ */
+static void replay_emit(FILE* out, uint32_t* count, uint8_t kind, uint8_t label,
+                        uint32_t entity_id, uint32_t a0, uint32_t a1,
+                        uint32_t a2, uint32_t a3)
+{
+    replay_event_t event = {
+        .kind = kind, .entity_type = 0, .label = label, .reserved = 0,
+        .entity_id = entity_id, .args = { a0, a1, a2, a3 }
+    };
+    fwrite(&event, sizeof(event), 1, out);
+    (*count)++;
+}
+
+/*
+ * Generate a labelled synthetic trace. Each entity reports steady noisy
+ * memory/CPU/message levels; REPLAY_SYNTH_ANOMALOUS percent of them switch
+ * to a CPU spike, memory leak or infinite loop at a random onset. Samples
+ * are interleaved entity by entity, with a detection pass and scheduler
+ * activity after every round.
+ */
+static int replay_generate(const char* path, uint32_t entities, uint32_t samples, uint32_t seed)
+{
+    FILE* out = fopen(path, "wb");
+    if (!out) {
+        perror(path);
+        return 1;
+    }
+
+    replay_rng_state = 0x9E3779B97F4A7C15ULL ^ seed;
+
+    replay_trace_header_t header = {
+        .magic = REPLAY_TRACE_MAGIC, .version = REPLAY_TRACE_VERSION,
+        .reserved = 0, .event_count = 0
+    };
+    fwrite(&header, sizeof(header), 1, out);
+
+    static uint32_t memory_base[REPLAY_MAX_ENTITIES];
+    static uint32_t cpu_base[REPLAY_MAX_ENTITIES];
+    static uint32_t message_base[REPLAY_MAX_ENTITIES];
+    static uint32_t onset[REPLAY_MAX_ENTITIES];
+    static uint8_t kind[REPLAY_MAX_ENTITIES];
+    uint32_t count = 0;
+
+    for (uint32_t e = 0; e < entities; e++) {
+        memory_base[e] = 64 * 1024 + (replay_rand() % (4 * 1024 * 1024));
+        cpu_base[e] = 5 + replay_rand() % 30;
+        message_base[e] = 2 + replay_rand() % 20;
+        onset[e] = UINT32_MAX;
+        kind[e] = REPLAY_LABEL_NORMAL;
+
+        if (replay_rand() % 100 < REPLAY_SYNTH_ANOMALOUS) {
+            static const uint8_t kinds[3] = {
+                ANOMALY_CPU_SPIKE, ANOMALY_MEMORY_LEAK, ANOMALY_INFINITE_LOOP
+            };
+            kind[e] = kinds[replay_rand() % 3] + 1;
+            onset[e] = samples / 4 + replay_rand() % (samples / 2 + 1);
+        }
+    }
+
+    for (uint32_t a = 1; a <= REPLAY_SYNTH_ACTORS; a++) {
+        replay_emit(out, &count, REPLAY_EVENT_SPAWN, 0, a, ACTOR_PRIORITY_NORMAL, 0, 0, 0);
+    }
+    replay_emit(out, &count, REPLAY_EVENT_QUOTA, 0, 1, 5, 0, 0, 0);
+
+    for (uint32_t s = 0; s < samples; s++) {
+        for (uint32_t e = 0; e < entities; e++) {
+            uint32_t memory = replay_level(memory_base[e], memory_base[e] / 50);
+            uint32_t cpu = replay_level(cpu_base[e], 3);
+            uint32_t messages = replay_level(message_base[e], 2);
+            uint8_t label = REPLAY_LABEL_NORMAL;
+
+            if (s >= onset[e]) {
+                uint32_t age = s - onset[e];
+                label = kind[e];
+
+                switch (kind[e] - 1) {
+                    case ANOMALY_CPU_SPIKE:
+                        cpu = replay_level(90, 3);
+                        break;
+                    case ANOMALY_MEMORY_LEAK:
+                        memory += (memory_base[e] / 50) * (age + 1);
+                        break;
+                    case ANOMALY_INFINITE_LOOP:
+                        cpu = replay_level(97, 2);
+                        messages = 0;
+                        break;
+                }
+            }
+
+            if (cpu > 100) cpu = 100;
+            replay_emit(out, &count, REPLAY_EVENT_SAMPLE, label, e + 1, memory, cpu, 0, messages);
+        }
+
+        replay_emit(out, &count, REPLAY_EVENT_DETECT, 0, 0, 0, 0, 0, 0);
+        replay_emit(out, &count, REPLAY_EVENT_TICK, 0, 0, 10, 0, 0, 0);
+        for (int m = 0; m < 4; m++) {
+            uint32_t actor = 1 + replay_rand() % REPLAY_SYNTH_ACTORS;
+            replay_emit(out, &count, REPLAY_EVENT_SEND, 0, actor, 16, 0, 0, 0);
+        }
+    }
+
+    header.event_count = count;
+    fseek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+    fclose(out);
+
+    printf("[REPLAY] Generated %u events (%u entities x %u samples) in %s\n",
+           count, entities, samples, path);
+    return 0;
+}
+
+// =============================================================================
+// Trace Replay
+// =============================================================================
+
+/*
+ * Entry point for replayed actors (never executed on the host)
+ */
+static void replay_actor_entry(void)
+{
+}
+
+/*
+ * Score the anomalies raised by a detection pass against ground truth
+ * and release their slots
+ */
+static void replay_collect_anomalies(void)
+{
+    for (uint32_t i = 0; i < MAX_ANOMALY_TYPES; i++) {
+        if (!kernel_ai_supervisor.anomaly_active[i]) continue;
+
+        anomaly_detection_t* anomaly = &kernel_ai_supervisor.anomalies[i];
+        kernel_ai_supervisor.anomaly_active[i] = false;
+
+        if (anomaly->entity_type > 1 || anomaly->entity_id >= REPLAY_MAX_ENTITIES) continue;
+        replay_entity_t* entity = &replay_entities[anomaly->entity_type][anomaly->entity_id];
+
+        if (entity->label == REPLAY_LABEL_NORMAL) {
+            entity->false_alarms++;
+        } else if (!entity->detected) {
+            entity->detected = true;
+            entity->latency = entity->samples - entity->onset;
+        }
+
+        if (entity->label != REPLAY_LABEL_NORMAL && anomaly->anomaly_type + 1 == entity->label) {
+            entity->type_matched = true;
+        }
+    }
+
+    kernel_ai_supervisor.anomaly_count = 0;
+}
+
+/*
+ * Run the current actor's share of work: drain its message queue
+ */
+static void replay_run_current_actor(void)
+{
+    message_t* message;
+    while ((message = message_receive()) != NULL) {
+        message_free(message);
+    }
+}
+
+/*
+ * One tick on every simulated CPU: the boot CPU takes the timer interrupt,
+ * the others take their local timer's tick and then do what
+ * scheduler_cpu_loop does (slices stay tick-driven in replay)
+ */
+static void replay_tick(void)
+{
+    host_cpu_id = 0;
+    scheduler_timer_handler();
+    replay_run_current_actor();
+
+    for (uint32_t cpu = 1; cpu < host_cpu_count; cpu++) {
+        host_cpu_id = cpu;
+        scheduler_cpu_tick();
+
+        actor_t* current = actor_get_current();
+        if (!current || current->state != ACTOR_STATE_RUNNING) {
+            scheduler_schedule();
+        }
+        replay_run_current_actor();
+    }
+
+    host_cpu_id = 0;
+}
+
+/*
+ * Replay one event
+ */
+static void replay_event(const replay_event_t* event)
+{
+    uint32_t id = event->entity_id;
+    static uint8_t payload[MAX_MESSAGE_SIZE];
+
+    switch (event->kind) {
+        case REPLAY_EVENT_SAMPLE: {
+            if (event->entity_type <= 1 && id < REPLAY_MAX_ENTITIES) {
+                replay_entity_t* entity = &replay_entities[event->entity_type][id];
+                if (event->label != REPLAY_LABEL_NORMAL && entity->truth == REPLAY_LABEL_NORMAL) {
+                    entity->truth = event->label;
+                    entity->onset = entity->samples;
+                }
+                entity->label = event->label;
+                entity->samples++;
+            }
+            ai_update_behavior_pattern(event->entity_type, id, event->args[0],
+                                       event->args[1], event->args[2], event->args[3]);
+            break;
+        }
+
+        case REPLAY_EVENT_TICK:
+            for (uint32_t t = 0; t < event->args[0]; t++) {
+                replay_tick();
+            }
+            break;
+
+        case REPLAY_EVENT_SPAWN:
+            if (id < REPLAY_MAX_ENTITIES) {
+                replay_actor_map[id] = actor_create(replay_actor_entry, NULL,
+                                                    (uint8_t)event->args[0], 0);
+                actor_start(replay_actor_map[id]);
+            }
+            break;
+
+        case REPLAY_EVENT_EXIT:
+            if (id < REPLAY_MAX_ENTITIES && replay_actor_map[id]) {
+                actor_terminate(replay_actor_map[id]);
+                replay_actor_map[id] = 0;
+            }
+            break;
+
+        case REPLAY_EVENT_SEND:
+            if (id < REPLAY_MAX_ENTITIES && replay_actor_map[id]) {
+                uint32_t size = event->args[0];
+                if (size > MAX_MESSAGE_SIZE) size = MAX_MESSAGE_SIZE;
+                message_send_async(replay_actor_map[id], MSG_TYPE_ASYNC,
+                                   size ? payload : NULL, size);
+            }
+            break;
+
+        case REPLAY_EVENT_QUOTA:
+            if (id < REPLAY_MAX_ENTITIES && replay_actor_map[id]) {
+                actor_set_cpu_quota(replay_actor_map[id], event->args[0]);
+            }
+            break;
+
+        case REPLAY_EVENT_DETECT:
+            ai_detect_anomalies();
+            replay_collect_anomalies();
+            break;
+    }
+}
+
+/*
+ * Print detection accuracy, latency and scheduler outcome
+ */
+static void replay_report(uint64_t events, double seconds)
+{
+    uint32_t anomalous = 0, detected = 0, matched = 0, normal = 0;
+    uint64_t latency_sum = 0, false_alarms = 0, normal_samples = 0;
+
+    for (uint32_t type = 0; type < 2; type++) {
+        for (uint32_t id = 0; id < REPLAY_MAX_ENTITIES; id++) {
+            replay_entity_t* entity = &replay_entities[type][id];
+            if (entity->samples == 0) continue;
+
+            false_alarms += entity->false_alarms;
+            if (entity->truth == REPLAY_LABEL_NORMAL) {
+                normal++;
+                normal_samples += entity->samples;
+                continue;
+            }
+
+            normal_samples += entity->onset;
+            anomalous++;
+            if (entity->detected) {
+                detected++;
+                latency_sum += entity->latency;
+            }
+            if (entity->type_matched) matched++;
+        }
+    }
+
+    printf("[REPLAY] %llu events in %.3f s (%.2f M events/s)\n",
+           (unsigned long long)events, seconds, seconds > 0 ? events / seconds / 1e6 : 0.0);
+    printf("[REPLAY] Detection: %u/%u anomalous entities detected, %u with matching type\n",
+           detected, anomalous, matched);
+    if (detected > 0) {
+        printf("[REPLAY] Mean detection latency: %.1f samples\n", (double)latency_sum / detected);
+    }
+    printf("[REPLAY] False alarms: %llu over %llu normal samples (%u normal entities)\n",
+           (unsigned long long)false_alarms, (unsigned long long)normal_samples, normal);
+    printf("[REPLAY] AI pool: %u patterns tracked, %u KB in %u chunks\n",
+           kernel_ai_supervisor.pattern_count,
+           (uint32_t)(kernel_ai_supervisor.ai_memory_size / 1024),
+           kernel_ai_supervisor.ai_pool_chunk_count);
+
+    scheduler_stats_t* stats = scheduler_get_statistics();
+    printf("[REPLAY] Scheduler: %llu ticks, %llu context switches, %llu messages delivered, "
+           "%llu throttle events\n",
+           (unsigned long long)kernel_scheduler.tick_count,
+           (unsigned long long)stats->context_switches,
+           (unsigned long long)stats->messages_delivered,
+           (unsigned long long)stats->throttle_events);
+
+    for (uint32_t cpu = 0; cpu < host_cpu_count; cpu++) {
+        sched_cpu_t* state = &kernel_scheduler.cpus[cpu];
+        printf("[REPLAY]   cpu %u: %llu context switches, %llu steals, %llu idle polls\n",
+               cpu, (unsigned long long)percpu_areas[cpu].sched_context_switches,
+               (unsigned long long)state->steals, (unsigned long long)state->idle_polls);
+    }
+
+    for (uint32_t id = 0; id < REPLAY_MAX_ENTITIES; id++) {
+        actor_t* actor = replay_actor_map[id] ? actor_get(replay_actor_map[id]) : NULL;
+        if (!actor) continue;
+        printf("[REPLAY]   actor %u (kernel %u): cpu %llu ticks, %llu messages, quota %u/%u\n",
+               id, actor->actor_id, (unsigned long long)actor->cpu_time_used,
+               (unsigned long long)actor->messages_received,
+               actor->cpu_quota, SCHEDULER_BANDWIDTH_PERIOD);
+    }
+
+    for (uint8_t priority = 0; priority < SCHED_TRACE_CLASSES; priority++) {
+        sched_histogram_t* wakeup = sched_trace_get_histogram(SCHED_HIST_WAKEUP_LATENCY, priority);
+        sched_histogram_t* delay = sched_trace_get_histogram(SCHED_HIST_QUEUE_DELAY, priority);
+        if (!wakeup->count && !delay->count) continue;
+        printf("[REPLAY]   class %u: wakeup p50/p99 %u/%u cycles, queue delay p50/p99 %u/%u cycles\n",
+               priority,
+               sched_hist_percentile(wakeup, 500), sched_hist_percentile(wakeup, 990),
+               sched_hist_percentile(delay, 500), sched_hist_percentile(delay, 990));
+    }
+}
+
+/*
+ * Load and replay a trace file
+ */
+static int replay_trace(const char* path, uint32_t false_alarm_rate)
+{
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+
+    replay_trace_header_t header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+        header.magic != REPLAY_TRACE_MAGIC || header.version != REPLAY_TRACE_VERSION) {
+        fprintf(stderr, "%s: not a version %d replay trace\n", path, REPLAY_TRACE_VERSION);
+        fclose(in);
+        return 1;
+    }
+
+    replay_event_t* events = malloc((size_t)header.event_count * sizeof(replay_event_t));
+    if (!events || fread(events, sizeof(replay_event_t), header.event_count, in) != header.event_count) {
+        fprintf(stderr, "%s: truncated trace\n", path);
+        free(events);
+        fclose(in);
+        return 1;
+    }
+    fclose(in);
+
+    scheduler_init();
+    for (uint32_t cpu = 1; cpu < host_cpu_count; cpu++) {
+        scheduler_cpu_online(cpu);
+    }
+    ai_supervisor_init();
+    ai_set_auto_intervention(false);
+    if (false_alarm_rate > 0) {
+        ai_set_change_false_alarm_rate(false_alarm_rate);
+    }
+    kernel_scheduler.scheduler_enabled = true;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint32_t i = 0; i < header.event_count; i++) {
+        replay_event(&events[i]);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) +
+                     (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    replay_report(header.event_count, seconds);
+    free(events);
+
+    // Samples with nowhere to go mean the supervisor could not allocate
+    // pattern records (the shim heap refuses what the kernel heap would)
+    bool sampled = false;
+    for (uint32_t id = 0; id < REPLAY_MAX_ENTITIES && !sampled; id++) {
+        sampled = replay_entities[0][id].samples || replay_entities[1][id].samples;
+    }
+    if (sampled && kernel_ai_supervisor.pattern_count == 0) {
+        fprintf(stderr, "%s: AI supervisor tracked no patterns (pool allocation failed)\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(int argc, char* argv[])
+{
+    const char* generate_path = NULL;
+    const char* trace_path = NULL;
+    uint32_t entities = 200, samples = 1000, seed = 1, false_alarm_rate = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (strcmp(arg, "-v") == 0) {
+            host_kprintf_enabled = true;
+        } else if (strcmp(arg, "-g") == 0 && has_value) {
+            generate_path = argv[++i];
+        } else if (strcmp(arg, "-e") == 0 && has_value) {
+            entities = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "-s") == 0 && has_value) {
+            samples = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "-r") == 0 && has_value) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "-a") == 0 && has_value) {
+            false_alarm_rate = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "-c") == 0 && has_value) {
+            host_cpu_count = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (arg[0] != '-' && !trace_path) {
+            trace_path = arg;
+        } else {
+            trace_path = NULL;
+            generate_path = NULL;
+            break;
+        }
+    }
+
+    if (generate_path) {
+        if (entities == 0 || entities >= REPLAY_MAX_ENTITIES || samples == 0) {
+            fprintf(stderr, "ai_replay: need 1..%d entities and at least one sample\n",
+                    REPLAY_MAX_ENTITIES - 1);
+            return 2;
+        }
+        return replay_generate(generate_path, entities, samples, seed);
+    }
+
+    if (host_cpu_count == 0 || host_cpu_count > SMP_MAX_CPUS) {
+        fprintf(stderr, "ai_replay: need 1..%d CPUs\n", SMP_MAX_CPUS);
+        return 2;
+    }
+
+    if (!trace_path) {
+        fprintf(stderr, "usage: ai_replay [-v] [-a ARL] [-c CPUS] TRACE\n"
+                        "       ai_replay -g TRACE [-e ENTITIES] [-s SAMPLES] [-r SEED]\n");
+        return 2;
+    }
+
+    return replay_trace(trace_path, false_alarm_rate);
+}
@@ -0,0 +1,55 @@
+/*
+ * =============================================================================
+ * CLKernel - Host Trace Replay
+ * =============================================================================
+ * File: replay.h
+ * Purpose: Binary trace format for replaying actor, memory and message
+ *          activity through the AI supervisor and scheduler on a Linux host
+ *
+ * A trace is a replay_trace_header_t followed by event_count fixed-size
+ * replay_event_t records, little-endian, in replay order.
+ * =============================================================================
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+
+// =============================================================================
+// Trace Format
+// =============================================================================
+
+#define REPLAY_TRACE_MAGIC      0x50524C43  // "CLRP"
+#define REPLAY_TRACE_VERSION    1
+
+// Event kinds (meaning of args[] per kind)
+#define REPLAY_EVENT_SAMPLE     0       // Behavior sample: memory, cpu, io, messages
+#define REPLAY_EVENT_TICK       1       // Timer ticks: args[0] = tick count
+#define REPLAY_EVENT_SPAWN      2       // Create and start actor: args[0] = priority
+#define REPLAY_EVENT_EXIT       3       // Terminate actor
+#define REPLAY_EVENT_SEND       4       // Async message to actor: args[0] = payload bytes
+#define REPLAY_EVENT_QUOTA      5       // CPU quota: args[0] = percent
+#define REPLAY_EVENT_DETECT     6       // Run anomaly detection over all patterns
+
+// Ground-truth labels on SAMPLE events
+#define REPLAY_LABEL_NORMAL     0       // Entity behaving normally
+                                        // Otherwise ANOMALY_* + 1
+
+typedef struct __attribute__((packed)) replay_trace_header {
+    uint32_t        magic;              // REPLAY_TRACE_MAGIC
+    uint16_t        version;            // REPLAY_TRACE_VERSION
+    uint16_t        reserved;
+    uint32_t        event_count;        // Events following the header
+} replay_trace_header_t;
+
+typedef struct __attribute__((packed)) replay_event {
+    uint8_t         kind;               // REPLAY_EVENT_*
+    uint8_t         entity_type;        // AI entity type (0 = actor, 1 = module)
+    uint8_t         label;              // REPLAY_LABEL_* ground truth
+    uint8_t         reserved;
+    uint32_t        entity_id;          // Trace entity / actor ID
+    uint32_t        args[4];            // Kind-specific arguments
+} replay_event_t;
+
+#endif // REPLAY_H
@@ -0,0 +1,44 @@
+/*
+ * =============================================================================
+ * CLKernel - Host Replay Kernel Header Shim
+ * =============================================================================
+ * File: kernel.h
+ * Purpose: Stand-in for kernel/kernel.h when building kernel subsystems as a
+ *          Linux user-space library (see tools/replay)
+ *
+ * Only the kernel services used by the replayed subsystems are declared here;
+ * host_shims.c implements them on top of libc.
+ * =============================================================================
+ */
+
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define MAX_MODULES             64          // Maximum loadable modules
+#define MAX_ACTORS              4096        // Maximum async actors
+
+// Forward declarations - actual definitions in scheduler.h
+#ifndef ACTOR_T_DECLARED
+#define ACTOR_T_DECLARED
+typedef struct actor_context actor_t;
+#endif
+
+// Console output (discarded unless the replay driver enables it)
+int kprintf(const char* format, ...);
+
+// Fatal errors end the host process
+void kernel_panic(const char* message, const char* file, int line);
+#define PANIC(msg) kernel_panic(msg, __FILE__, __LINE__)
+
+// CPU timestamp counter
+uint64_t read_timestamp_counter(void);
+
+// Memory management
+void* kmalloc(size_t size);
+void kfree(void* ptr);
+
+#endif // KERNEL_H